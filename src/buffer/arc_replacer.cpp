@@ -0,0 +1,200 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.cpp
+//
+// Identification: src/buffer/arc_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/arc_replacer.h"
+
+#include <algorithm>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+ArcReplacer::ArcReplacer(size_t num_frames) : capacity_(num_frames), frames_(num_frames) {}
+
+void ArcReplacer::CheckFrameId(frame_id_t frame_id) const {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= capacity_) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "ArcReplacer frame_id out of range");
+  }
+}
+
+auto ArcReplacer::LruEvictable(List list) -> std::list<frame_id_t>::reverse_iterator {
+  auto it = resident_[list].rbegin();
+  while (it != resident_[list].rend() && !frames_[*it].evictable_) {
+    ++it;
+  }
+  return it;
+}
+
+void ArcReplacer::AddGhost(List list, page_id_t page_id) {
+  ghost_lists_[list].push_front(page_id);
+  ghosts_[page_id] = {list, ghost_lists_[list].begin()};
+}
+
+void ArcReplacer::DropLruGhost(List list) {
+  ghosts_.erase(ghost_lists_[list].back());
+  ghost_lists_[list].pop_back();
+}
+
+void ArcReplacer::TrimGhosts() {
+  // |T1| + |B1| <= c, |T1| + |T2| + |B1| + |B2| <= 2c
+  while (!ghost_lists_[T1].empty() && resident_[T1].size() + ghost_lists_[T1].size() > capacity_) {
+    DropLruGhost(T1);
+  }
+  auto total = [&] {
+    return resident_[T1].size() + resident_[T2].size() + ghost_lists_[T1].size() + ghost_lists_[T2].size();
+  };
+  while (!ghost_lists_[T2].empty() && total() > 2 * capacity_) {
+    DropLruGhost(T2);
+  }
+  while (!ghost_lists_[T1].empty() && total() > 2 * capacity_) {
+    DropLruGhost(T1);
+  }
+}
+
+auto ArcReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (evictable_count_ == 0) {
+    return false;
+  }
+  // T1 比目标大小 p 大的时候淘汰 T1 的 LRU 帧, 否则淘汰 T2 的; 选中的链表里都是被固定的帧时换另一个链表
+  List list = resident_[T1].size() > target_ ? T1 : T2;
+  auto victim = LruEvictable(list);
+  if (victim == resident_[list].rend()) {
+    list = list == T1 ? T2 : T1;
+    victim = LruEvictable(list);
+  }
+  *frame_id = *victim;
+  Frame &frame = frames_[*frame_id];
+  resident_[list].erase(std::next(victim).base());
+  AddGhost(list, frame.page_id_);
+  frame = Frame{};
+  evictable_count_--;
+  TrimGhosts();
+  return true;
+}
+
+void ArcReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id);
+  Frame &frame = frames_[frame_id];
+  if (frame.tracked_) {
+    // 命中: 移动到 T2 的 MRU 端
+    resident_[T2].splice(resident_[T2].begin(), resident_[frame.list_], frame.pos_);
+    frame.list_ = T2;
+    frame.page_id_ = page_id;
+    return;
+  }
+  // 缺页: 在 B1 中说明 T1 太小, 在 B2 中说明 T2 太小, 按照两个幽灵链表大小的比例调整 p
+  List list = T1;
+  auto ghost = ghosts_.find(page_id);
+  if (ghost != ghosts_.end()) {
+    size_t b1 = ghost_lists_[T1].size();
+    size_t b2 = ghost_lists_[T2].size();
+    if (ghost->second.list_ == T1) {
+      target_ = std::min(capacity_, target_ + std::max<size_t>(1, b2 / b1));
+    } else {
+      size_t delta = std::max<size_t>(1, b1 / b2);
+      target_ = target_ > delta ? target_ - delta : 0;
+    }
+    ghost_lists_[ghost->second.list_].erase(ghost->second.pos_);
+    ghosts_.erase(ghost);
+    list = T2;
+  }
+  resident_[list].push_front(frame_id);
+  frame.page_id_ = page_id;
+  frame.tracked_ = true;
+  frame.evictable_ = true;
+  frame.list_ = list;
+  frame.pos_ = resident_[list].begin();
+  evictable_count_++;
+  TrimGhosts();
+}
+
+void ArcReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id);
+  Frame &frame = frames_[frame_id];
+  if (!frame.tracked_ || frame.evictable_ == set_evictable) {
+    return;
+  }
+  frame.evictable_ = set_evictable;
+  if (set_evictable) {
+    evictable_count_++;
+  } else {
+    evictable_count_--;
+  }
+}
+
+void ArcReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id);
+  Frame &frame = frames_[frame_id];
+  if (!frame.tracked_) {
+    return;
+  }
+  if (!frame.evictable_) {
+    throw Exception(ExceptionType::INVALID, "ArcReplacer cannot remove a non-evictable frame");
+  }
+  resident_[frame.list_].erase(frame.pos_);
+  frame = Frame{};
+  evictable_count_--;
+}
+
+auto ArcReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return evictable_count_;
+}
+
+auto ArcReplacer::GetTarget() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return target_;
+}
+
+auto ArcReplacer::EvictionOrder(size_t max_frames) -> std::vector<frame_id_t> {
+  std::scoped_lock<std::mutex> lock(latch_);
+  std::vector<frame_id_t> order;
+  // 模拟连续的 Evict: 每淘汰一个 T1 的帧 |T1| 减一, p 在没有缺页的时候不变
+  size_t t1_size = resident_[T1].size();
+  std::list<frame_id_t>::reverse_iterator next[2] = {resident_[T1].rbegin(), resident_[T2].rbegin()};
+  auto skip_pinned = [&](List list) {
+    while (next[list] != resident_[list].rend() && !frames_[*next[list]].evictable_) {
+      ++next[list];
+    }
+  };
+  while (order.size() < max_frames) {
+    skip_pinned(T1);
+    skip_pinned(T2);
+    List list = t1_size > target_ ? T1 : T2;
+    if (next[list] == resident_[list].rend()) {
+      list = list == T1 ? T2 : T1;
+      if (next[list] == resident_[list].rend()) {
+        break;
+      }
+    }
+    order.push_back(*next[list]);
+    ++next[list];
+    if (list == T1) {
+      t1_size--;
+    }
+  }
+  return order;
+}
+
+void ArcReplacer::Resize(size_t num_frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  frames_.resize(num_frames);
+  capacity_ = num_frames;
+  target_ = std::min(target_, capacity_);
+  TrimGhosts();
+}
+
+}  // namespace bustub
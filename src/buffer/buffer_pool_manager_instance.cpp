@@ -11,7 +11,23 @@
 //===----------------------------------------------------------------------===//
 
 #include "include/buffer/buffer_pool_manager_instance.h"
+#include <sys/mman.h>
+#include <algorithm>
+#include <cassert>
 #include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "common/exception.h"
@@ -21,131 +37,1471 @@
 namespace bustub {
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k,
-                                                     LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
-  // we allocate a consecutive memory space for the buffer pool
-  pages_ = new Page[pool_size_];
-  page_table_ = new ExtendibleHashTable<page_id_t, frame_id_t>(bucket_size_);
-  replacer_ = new LRUKReplacer(pool_size, replacer_k);
+                                                     LogManager *log_manager, EvictionPolicyType policy)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, replacer_k, log_manager, policy) {}
 
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, size_t num_instances, size_t instance_index,
+                                                     DiskManager *disk_manager, size_t replacer_k,
+                                                     LogManager *log_manager, EvictionPolicyType policy)
+    : num_instances_(num_instances),
+      instance_index_(instance_index),
+      next_page_id_(static_cast<page_id_t>(instance_index)),
+      disk_manager_(disk_manager),
+      page_size_(disk_manager->GetPageSize()),
+      log_manager_(log_manager) {
+  BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
+  BUSTUB_ASSERT(
+      instance_index < num_instances,
+      "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 1.");
+  BUSTUB_ASSERT(pool_size > 0 && pool_size <= MAX_POOL_SIZE, "invalid buffer pool size");
+  page_table_ = new PageTable(pool_size);
+  replacer_ = MakeEvictionPolicy(policy, pool_size, replacer_k).release();
   // Initially, every page is in the free list.
-  for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_.emplace_back(static_cast<int>(i));
+  Grow(pool_size);
+  // 重新打开的数据库从空闲页面表记录的位置继续分配新的页面号
+  page_id_t next_page_id = disk_manager_->GetFreePageMap()->GetNextPageId();
+  while (next_page_id > next_page_id_ && static_cast<size_t>(next_page_id) % num_instances_ != instance_index_) {
+    next_page_id++;
   }
-  // LOG_INFO("pool_size is [%d]", (int)pool_size_);
+  next_page_id_ = std::max<page_id_t>(next_page_id_, next_page_id);
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
-  delete page_table_;
+  warm_start_stop_ = true;
+  WaitForWarmStart();
+  delete warm_start_thread_;
+  StopBackgroundWriter();
+  {
+    std::scoped_lock<std::mutex> lock(prefetch_latch_);
+    prefetch_stop_ = true;
+  }
+  prefetch_cv_.notify_all();
+  if (prefetch_thread_ != nullptr) {
+    prefetch_thread_->join();
+    delete prefetch_thread_;
+  }
+  for (auto &chunk : chunks_) {
+    FreeChunk(chunk);
+  }
+  for (auto &leaf : frame_dir_) {
+    delete[] leaf.load();
+  }
+  delete page_table_.load();
   delete replacer_;
 }
 
+auto BufferPoolManagerInstance::AllocateChunk(size_t first_frame, size_t num_frames) -> FrameChunk {
+  // 所有帧的数据放在一块按页对齐的连续内存里, 可以直接用于 O_DIRECT; 超过一个大页时按大页对齐, 让内核用透明大页映射,
+  // 减少大缓冲池的 TLB 缺失
+  size_t bytes = num_frames * page_size_;
+  size_t alignment = bytes >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : BUSTUB_PAGE_SIZE;
+  bytes = (bytes + alignment - 1) / alignment * alignment;
+  auto *data = static_cast<char *>(std::aligned_alloc(alignment, bytes));
+  if (data == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate the frames of the buffer pool");
+  }
+#ifdef MADV_HUGEPAGE
+  if (alignment == HUGE_PAGE_SIZE) {
+    madvise(data, bytes, MADV_HUGEPAGE);
+  }
+#endif
+  memset(data, 0, bytes);
+  // 描述符和数据分开存放, Page 按缓存行对齐, 相邻帧的 pin_count_ 不会落在同一个缓存行里
+  auto *pages = static_cast<Page *>(::operator new(num_frames * sizeof(Page), std::align_val_t{alignof(Page)}));
+  for (size_t i = 0; i < num_frames; i++) {
+    new (&pages[i]) Page(data + i * page_size_, page_size_, static_cast<frame_id_t>(first_frame + i));
+  }
+  return {first_frame, num_frames, data, pages, new FrameState[num_frames]};
+}
+
+void BufferPoolManagerInstance::FreeChunk(const FrameChunk &chunk) {
+  for (size_t i = 0; i < chunk.num_frames_; i++) {
+    chunk.pages_[i].~Page();
+  }
+  ::operator delete(chunk.pages_, std::align_val_t{alignof(Page)});
+  delete[] chunk.states_;
+  std::free(chunk.data_);
+}
+
+auto BufferPoolManagerInstance::Grow(size_t pool_size) -> PageTable * {
+  size_t old_size = pool_size_;
+  size_t allocated = chunks_.empty() ? 0 : chunks_.back().first_frame_ + chunks_.back().num_frames_;
+  // 上次缩小时留在最后一个块里的帧直接重用, 超出的部分分配一个新的块
+  if (pool_size > allocated) {
+    FrameChunk chunk = AllocateChunk(allocated, pool_size - allocated);
+    for (size_t i = 0; i < chunk.num_frames_; i++) {
+      size_t frame = chunk.first_frame_ + i;
+      FrameRef *leaf = frame_dir_[frame / FRAME_DIR_LEAF_SIZE].load();
+      if (leaf == nullptr) {
+        leaf = new FrameRef[FRAME_DIR_LEAF_SIZE];
+        frame_dir_[frame / FRAME_DIR_LEAF_SIZE] = leaf;
+      }
+      leaf[frame % FRAME_DIR_LEAF_SIZE] = {&chunk.pages_[i], &chunk.states_[i]};
+    }
+    chunks_.push_back(chunk);
+  }
+  replacer_->Resize(pool_size);
+  // 页表按照帧数分配, 帧数超过页表的容量时换一个更大的页表, 旧的页表可能还有无锁的读者, 由调用者释放
+  PageTable *old_table = nullptr;
+  if (pool_size > page_table_.load()->GetMaxEntries()) {
+    auto *table = new PageTable(pool_size);
+    for (size_t i = 0; i < old_size; i++) {
+      page_id_t page_id = PageOf(static_cast<frame_id_t>(i))->page_id_;
+      if (page_id != INVALID_PAGE_ID) {
+        table->Insert(page_id, static_cast<frame_id_t>(i));
+      }
+    }
+    old_table = page_table_.exchange(table);
+  }
+  for (size_t i = old_size; i < pool_size; i++) {
+    free_list_.emplace_back(static_cast<frame_id_t>(i));
+  }
+  pool_size_ = pool_size;
+  return old_table;
+}
+
+auto BufferPoolManagerInstance::Resize(size_t pool_size) -> bool {
+  BUSTUB_ASSERT(pool_size > 0 && pool_size <= MAX_POOL_SIZE, "invalid buffer pool size");
+  std::scoped_lock<std::mutex> resize_lock(resize_latch_);
+  std::unique_lock<std::mutex> lock(latch_);
+  size_t old_size = pool_size_;
+  if (pool_size >= old_size) {
+    PageTable *old_table = Grow(pool_size);
+    lock.unlock();
+    if (old_table != nullptr) {
+      WaitForUnlatchedReaders();
+      delete old_table;
+    }
+    return true;
+  }
+  // 先占用所有要释放的帧: 被固定的, 或者正在进行 I/O 的帧 pin_count_ 都不为 0, 这时放弃缩小
+  for (size_t i = pool_size; i < old_size; i++) {
+    int expected = 0;
+    if (!PageOf(static_cast<frame_id_t>(i))->pin_count_.compare_exchange_strong(expected, -1)) {
+      for (size_t j = pool_size; j < i; j++) {
+        PageOf(static_cast<frame_id_t>(j))->pin_count_ = 0;
+      }
+      return false;
+    }
+  }
+  // 和 LoadPage 一样标记为正在进行 I/O, 然后释放 latch_ 写回脏页: 查找这些页面的线程等待写回完成,
+  // 替换器不能淘汰这些帧, 空闲链表里的帧也先拿出来, 其他线程的 GetFrame 不会等待它们
+  std::vector<std::pair<page_id_t, frame_id_t>> dirty;
+  for (size_t i = pool_size; i < old_size; i++) {
+    auto frame = static_cast<frame_id_t>(i);
+    Page *page = PageOf(frame);
+    StateOf(frame).io_in_progress_ = true;
+    if (page->page_id_ == INVALID_PAGE_ID) {
+      continue;
+    }
+    replacer_->SetEvictable(frame, false);
+    StateOf(frame).replacer_pinned_ = true;
+    if (page->is_dirty_) {
+      dirty.emplace_back(page->page_id_, frame);
+    }
+  }
+  free_list_.remove_if([pool_size](frame_id_t frame) { return static_cast<size_t>(frame) >= pool_size; });
+  lock.unlock();
+  std::sort(dirty.begin(), dirty.end());
+  bool written = WriteRunsToDisk(dirty);
+  lock.lock();
+  // 写回失败的时候放弃缩小, 这些帧恢复原样, 没有写回的页面仍然是脏的
+  if (!written) {
+    for (size_t i = pool_size; i < old_size; i++) {
+      auto frame = static_cast<frame_id_t>(i);
+      Page *page = PageOf(frame);
+      if (page->page_id_ == INVALID_PAGE_ID) {
+        free_list_.push_back(frame);
+      } else {
+        replacer_->SetEvictable(frame, true);
+        StateOf(frame).replacer_pinned_ = false;
+      }
+      page->pin_count_ = 0;
+      StateOf(frame).io_in_progress_ = false;
+      StateOf(frame).io_cv_.notify_all();
+    }
+    return false;
+  }
+  // 把页面从页表和替换器中删除, 重置这些帧; 等待的线程重新查找的时候找不到这些页面, 从磁盘读入写回的内容
+  for (size_t i = pool_size; i < old_size; i++) {
+    auto frame = static_cast<frame_id_t>(i);
+    Page *page = PageOf(frame);
+    if (page->page_id_ != INVALID_PAGE_ID) {
+      replacer_->SetEvictable(frame, true);
+      replacer_->Remove(frame);
+      page_table_.load()->Remove(page->page_id_);
+    }
+    StateOf(frame).io_in_progress_ = false;
+    StateOf(frame).io_cv_.notify_all();
+    page->page_id_ = INVALID_PAGE_ID;
+    page->is_dirty_ = false;
+    page->ResetMemory();
+    StateOf(frame).unrecorded_hits_ = 0;
+    StateOf(frame).replacer_pinned_ = false;
+  }
+  replacer_->Resize(pool_size);
+  pool_size_ = pool_size;
+  // 完全落在新大小之外的块可以释放了, 但是要等到之前开始的无锁读者都结束以后
+  std::vector<FrameChunk> released;
+  while (!chunks_.empty() && chunks_.back().first_frame_ >= pool_size) {
+    released.push_back(chunks_.back());
+    chunks_.pop_back();
+  }
+  std::vector<FrameRef *> released_leaves;
+  size_t allocated = chunks_.back().first_frame_ + chunks_.back().num_frames_;
+  for (size_t leaf = (allocated + FRAME_DIR_LEAF_SIZE - 1) / FRAME_DIR_LEAF_SIZE; leaf < FRAME_DIR_SIZE; leaf++) {
+    if (frame_dir_[leaf].load() != nullptr) {
+      released_leaves.push_back(frame_dir_[leaf].exchange(nullptr));
+    }
+  }
+  // 留在最后一个块里的帧不会被任何人访问, 恢复成空闲帧的状态, 以后扩大的时候直接重用
+  for (size_t i = pool_size; i < allocated; i++) {
+    PageOf(static_cast<frame_id_t>(i))->pin_count_ = 0;
+  }
+  lock.unlock();
+  WaitForUnlatchedReaders();
+  for (auto &chunk : released) {
+    FreeChunk(chunk);
+  }
+  for (FrameRef *leaf : released_leaves) {
+    delete[] leaf;
+  }
+  return true;
+}
+
+auto BufferPoolManagerInstance::EnterUnlatched() -> std::atomic<uint32_t> * {
+  size_t stripe = std::hash<std::thread::id>()(std::this_thread::get_id()) % NUM_READER_STRIPES;
+  std::atomic<uint32_t> *active = &reader_stripes_[stripe].active_[reader_epoch_.load() & 1];
+  active->fetch_add(1);
+  return active;
+}
+
+void BufferPoolManagerInstance::WaitForUnlatchedReaders() {
+  // 翻转 epoch 之后新的读者都计入另一组计数器, 之前的读者计入的这一组计数器一定会降到 0
+  uint32_t epoch = reader_epoch_.fetch_add(1);
+  for (auto &stripe : reader_stripes_) {
+    while (stripe.active_[epoch & 1].load() != 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+
 /**
  * 将page_id的值指向新的id也就是下一个id值，如果没有frames那么设置为空
  *
  */
 auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
-  // 当前的帧有剩余可以从空闲帧中进行获取相关的帧,然后进行page_table_的添加操作
-  // 设置相关的pages数组中的相应的值，page_id_和pin_count_值
-  std::scoped_lock<std::mutex> lock(latch_);
-  // 获取相关的空闲的帧
-  frame_id_t free = GetFrame();
-  // 没有找到设置返回值和page_id
-  if (free == -1) {
-    page_id = nullptr;
+  return NewPgWithStrategyImp(page_id, nullptr);
+}
+
+auto BufferPoolManagerInstance::NewPgWithStrategyImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * {
+  return NewPgInExtentImp(page_id, nullptr, strategy);
+}
+
+auto BufferPoolManagerInstance::NewPgInExtentImp(page_id_t *page_id, page_id_t *extent_owner,
+                                                 BufferAccessStrategy *strategy) -> Page * {
+  std::unique_lock<std::mutex> lock(latch_);
+  // 先找到可以使用的帧, 没有的话不分配页面号
+  BufferAccessStrategy::Slot *slot = nullptr;
+  frame_id_t frame = GetFrame(strategy, &slot);
+  if (frame == -1) {
+    no_free_frames_.Add();
     return nullptr;
   }
-  // 找到相关的帧，进行分配页面
-  *page_id = AllocatePage();
-  ChangeFrameToNewPage(free, *page_id);
-  return &pages_[free];
+  // 找到相关的帧，进行分配页面; 新页面不需要从磁盘读取, 直接清零
+  // 区里的页面都是第一次分配出去的, 不会是重用的页面
+  bool reused = false;
+  *page_id = extent_owner == nullptr ? AllocatePage(&reused) : AllocateExtentPage(extent_owner);
+  if (slot != nullptr) {
+    slot->page_id_ = *page_id;
+  }
+  Page *page = LoadPage(lock, frame, *page_id, false);
+  if (page == nullptr) {
+    DeallocatePage(*page_id);
+    return nullptr;
+  }
+  // 重用的页面在磁盘上还有被删除之前的内容, 必须写回清零之后的内容
+  page->is_dirty_ = reused;
+  return page;
 }
 
 auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
-  std::scoped_lock<std::mutex> lock(latch_);
+  return FetchPgWithStrategyImp(page_id, nullptr);
+}
+
+auto BufferPoolManagerInstance::FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+  if (page_id < 0) {
+    return nullptr;
+  }
+  ValidatePageId(page_id);
+  // 命中的时候不需要获取 latch_
+  std::atomic<uint32_t> *reader = EnterUnlatched();
+  Page *page = TryPinResident(page_id);
+  reader->fetch_sub(1);
+  if (page != nullptr) {
+    hits_.Add();
+    return page;
+  }
+  std::unique_lock<std::mutex> lock(latch_);
   frame_id_t cur = -1;
   // 如果找到相关的对应页面需要进行相关的LRU和pin_count_设置
-  if (page_table_->Find(page_id, cur)) {
-    pages_[cur].pin_count_++;
-    replacer_->RecordAccess(cur);
-    replacer_->SetEvictable(cur, false);
-    return &pages_[cur];
+  if (FindFrame(lock, page_id, &cur)) {
+    hits_.Add();
+    PinFrame(cur);
+    return PageOf(cur);
   }
   // 如果没有找到,那么需要进行更新操作,找到一个新的帧进行替换
-  cur = GetFrame();
+  BufferAccessStrategy::Slot *slot = nullptr;
+  cur = GetFrame(strategy, &slot);
   if (cur == -1) {  // 没有找到新的帧
+    no_free_frames_.Add();
     LOG_INFO("内存不够等待缓冲区释放");
     Debug();
     return nullptr;
   }
-  // 找到新的帧进行初始话的过程
-  ChangeFrameToNewPage(cur, page_id);
-  return &pages_[cur];
+  if (slot != nullptr) {
+    slot->page_id_ = page_id;
+  }
+  misses_.Add();
+  return LoadPage(lock, cur, page_id, true);
+}
+
+auto BufferPoolManagerInstance::FetchPgsImp(const std::vector<page_id_t> &page_ids) -> std::vector<Page *> {
+  if (std::any_of(page_ids.begin(), page_ids.end(), [](page_id_t page_id) { return page_id < 0; })) {
+    return {};
+  }
+  std::vector<Page *> pages(page_ids.size(), nullptr);
+  // 先走不需要 latch_ 的命中路径
+  std::vector<size_t> misses;
+  std::atomic<uint32_t> *reader = EnterUnlatched();
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    ValidatePageId(page_ids[i]);
+    pages[i] = TryPinResident(page_ids[i]);
+    if (pages[i] != nullptr) {
+      hits_.Add();
+    } else {
+      misses.push_back(i);
+    }
+  }
+  reader->fetch_sub(1);
+  if (misses.empty()) {
+    return pages;
+  }
+
+  std::unique_lock<std::mutex> lock(latch_);
+  // 固定在这期间被读入的页面. 等待 I/O 的时候会释放 latch_, 之前确认不在缓冲池里的页面可能已经被别人读入了,
+  // 所以一直重新检查, 直到完整的一遍检查中间没有等待过
+  bool waited = true;
+  while (waited) {
+    waited = false;
+    std::vector<size_t> absent;
+    for (size_t i : misses) {
+      page_id_t page_id = page_ids[i];
+      frame_id_t frame = -1;
+      bool resident = page_table_.load()->Find(page_id, &frame);
+      if (resident && !StateOf(frame).io_in_progress_) {
+        hits_.Add();
+        PinFrame(frame);
+        pages[i] = PageOf(frame);
+        continue;
+      }
+      auto it = evicting_.find(page_id);
+      if (resident || it != evicting_.end()) {
+        pin_waits_.Add();
+        StateOf(resident ? frame : it->second).io_cv_.wait(lock);
+        waited = true;
+      }
+      absent.push_back(i);
+    }
+    misses = std::move(absent);
+  }
+
+  // 在同一次持有 latch_ 的时候为所有缺失的页面占用帧, 同一个页面只占用一个帧; 帧不够的时候全部放弃
+  std::unordered_map<page_id_t, frame_id_t> claimed;
+  for (size_t i : misses) {
+    if (claimed.count(page_ids[i]) > 0) {
+      continue;
+    }
+    frame_id_t frame = GetFrame();
+    if (frame == -1) {
+      no_free_frames_.Add();
+      for (const auto &[page_id, claimed_frame] : claimed) {
+        ReturnFrame(claimed_frame);
+      }
+      for (Page *page : pages) {
+        if (page != nullptr) {
+          UnpinFrame(page->frame_id_, true);
+        }
+      }
+      return {};
+    }
+    claimed[page_ids[i]] = frame;
+  }
+  std::vector<PendingLoad> loads;
+  for (const auto &[page_id, frame] : claimed) {
+    misses_.Add();
+    loads.push_back(BeginLoad(frame, page_id));
+  }
+  // 重复出现的页面每出现一次固定一次
+  for (size_t i : misses) {
+    Page *page = PageOf(claimed[page_ids[i]]);
+    if (std::find(pages.begin(), pages.end(), page) != pages.end()) {
+      page->pin_count_++;
+    }
+    pages[i] = page;
+  }
+
+  lock.unlock();
+  WriteBackVictims(&loads);
+  ReadBatchFromDisk(&loads);
+  lock.lock();
+  std::unordered_set<frame_id_t> failed;
+  for (const auto &load : loads) {
+    if (load.write_failed_ || load.read_failed_) {
+      failed.insert(load.frame_);
+    } else {
+      FinishLoad(load);
+    }
+  }
+  if (failed.empty()) {
+    return pages;
+  }
+  // 有页面没能读入的时候整个请求失败, 和帧不够的时候一样释放所有的 pin. 失败的帧只留下 BeginLoad 的 pin, 由
+  // AbortLoad 释放
+  for (Page *page : pages) {
+    if (failed.erase(page->frame_id_) == 0) {
+      UnpinFrame(page->frame_id_, true);
+    }
+  }
+  for (const auto &load : loads) {
+    if (load.write_failed_ || load.read_failed_) {
+      AbortLoad(load);
+    }
+  }
+  return {};
+}
+
+auto BufferPoolManagerInstance::NewPgsImp(size_t n) -> std::vector<Page *> {
+  std::unique_lock<std::mutex> lock(latch_);
+  // 先占用所有的帧, 帧不够的时候还没有分配页面号, 直接放弃
+  std::vector<frame_id_t> frames;
+  for (size_t i = 0; i < n; i++) {
+    frame_id_t frame = GetFrame();
+    if (frame == -1) {
+      no_free_frames_.Add();
+      for (frame_id_t claimed : frames) {
+        ReturnFrame(claimed);
+      }
+      return {};
+    }
+    frames.push_back(frame);
+  }
+  std::vector<PendingLoad> loads;
+  std::vector<Page *> pages;
+  std::vector<bool> reused(n, false);
+  for (size_t i = 0; i < n; i++) {
+    bool page_reused = false;
+    loads.push_back(BeginLoad(frames[i], AllocatePage(&page_reused)));
+    pages.push_back(PageOf(frames[i]));
+    reused[i] = page_reused;
+  }
+
+  lock.unlock();
+  WriteBackVictims(&loads);
+  bool failed = false;
+  for (const auto &load : loads) {
+    if (load.write_failed_) {
+      failed = true;
+    } else {
+      PageOf(load.frame_)->ResetMemory();
+    }
+  }
+  lock.lock();
+  // 有被淘汰的页面没能写回的时候整个请求失败: 这些帧恢复原来的页面, 其他的帧放回空闲链表, 分配的页面号都释放
+  if (failed) {
+    for (const auto &load : loads) {
+      AbortLoad(load);
+      DeallocatePage(load.page_id_);
+    }
+    return {};
+  }
+  for (size_t i = 0; i < n; i++) {
+    pages[i]->is_dirty_ = reused[i];
+    FinishLoad(loads[i]);
+  }
+  return pages;
+}
+
+void BufferPoolManagerInstance::PinFrame(frame_id_t frame_id) {
+  PageOf(frame_id)->pin_count_++;
+  replacer_->RecordAccess(frame_id, PageOf(frame_id)->page_id_);
+  replacer_->SetEvictable(frame_id, false);
+  StateOf(frame_id).replacer_pinned_ = true;
+}
+
+void BufferPoolManagerInstance::ReturnFrame(frame_id_t frame_id) {
+  Page *page = PageOf(frame_id);
+  if (page->page_id_ == INVALID_PAGE_ID) {
+    free_list_.push_front(frame_id);
+  } else {
+    // 帧里还是被淘汰之前的页面, 映射也没有删除, 重新交给替换器就可以了
+    replacer_->RecordAccess(frame_id, page->page_id_);
+    replacer_->SetEvictable(frame_id, true);
+    StateOf(frame_id).replacer_pinned_ = false;
+  }
+  page->pin_count_ = 0;
+}
+
+auto BufferPoolManagerInstance::TryPinResident(page_id_t page_id) -> Page * {
+  frame_id_t frame = -1;
+  if (!page_table_.load()->Find(page_id, &frame)) {
+    return nullptr;
+  }
+  Page *page = PageOf(frame);
+  // pin_count_ 为 -1 说明这个帧正在 latch_ 下被重新分配
+  int pins = page->pin_count_.load();
+  do {
+    if (pins < 0) {
+      return nullptr;
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pins, pins + 1));
+  // 查到的映射可能已经过期: 固定之后再确认这个帧上还是这个页面, 并且没有正在进行的 I/O
+  if (page->page_id_ == page_id && !StateOf(frame).io_in_progress_) {
+    StateOf(frame).unrecorded_hits_++;
+    return page;
+  }
+  UnpinFrame(frame, false);
+  return nullptr;
+}
+
+auto BufferPoolManagerInstance::GetFrame() -> frame_id_t {
+  // 如果有空闲的帧直接返回,没有的话进行删除相应的帧
+  if (!free_list_.empty()) {
+    frame_id_t frame = free_list_.front();
+    free_list_.pop_front();
+    // 空闲帧上只可能有快速路径上校验失败的临时 pin, 它们很快就会被撤销
+    int expected = 0;
+    while (!PageOf(frame)->pin_count_.compare_exchange_weak(expected, -1)) {
+      expected = 0;
+      std::this_thread::yield();
+    }
+    return frame;
+  }
+  size_t second_chances = 0;
+  std::vector<frame_id_t> victim;
+  while (!(victim = replacer_->EvictionOrder(1)).empty()) {
+    frame_id_t frame = victim[0];
+    // 没有记录到替换器里的命中相当于 CLOCK 的访问位: 补记一次访问, 给这个帧一次机会
+    if (second_chances < pool_size_ && StateOf(frame).unrecorded_hits_.exchange(0) > 0) {
+      replacer_->RecordAccess(frame, PageOf(frame)->page_id_);
+      second_chances++;
+      continue;
+    }
+    // EvictionOrder 对有的策略只是近似的, 以 Evict 实际选出的帧为准
+    if (!replacer_->Evict(&frame)) {
+      break;
+    }
+    FrameState &state = StateOf(frame);
+    // 先设置 replacer_pinned_ 再尝试占用, 占用失败时固定这个帧的线程在 Unpin 的时候一定能看到它
+    state.replacer_pinned_ = true;
+    int expected = 0;
+    if (PageOf(frame)->pin_count_.compare_exchange_strong(expected, -1)) {
+      return frame;
+    }
+    // 帧已经被快速路径固定了, 放回替换器, 等它的 pin 降为 0 的时候重新变成可淘汰的
+    replacer_->RecordAccess(frame, PageOf(frame)->page_id_);
+    replacer_->SetEvictable(frame, false);
+  }
+  return -1;
+}
+
+auto BufferPoolManagerInstance::GetFrame(BufferAccessStrategy *strategy, BufferAccessStrategy::Slot **slot)
+    -> frame_id_t {
+  if (strategy == nullptr) {
+    return GetFrame();
+  }
+  BufferAccessStrategy::Slot &next = strategy->NextSlot();
+  frame_id_t frame = -1;
+  // 环里这个位置的帧属于本实例, 没有被固定, 并且还是环自己放进去的页面(没有被别人重新分配过), 才可以直接重用.
+  // 替换器里不可淘汰或者正在进行 I/O 的帧都不能动
+  if (next.owner_ == this && next.frame_id_ != -1 && static_cast<size_t>(next.frame_id_) < pool_size_) {
+    Page *page = PageOf(next.frame_id_);
+    FrameState &state = StateOf(next.frame_id_);
+    int expected = 0;
+    if (page->page_id_ == next.page_id_ && !state.replacer_pinned_ && !state.io_in_progress_ &&
+        page->pin_count_.compare_exchange_strong(expected, -1)) {
+      replacer_->Remove(next.frame_id_);
+      frame = next.frame_id_;
+    }
+  }
+  // 不能重用的话按照正常的方式找一个帧, 放进环里代替原来的帧
+  if (frame == -1) {
+    frame = GetFrame();
+    if (frame == -1) {
+      return -1;
+    }
+  }
+  next.owner_ = this;
+  next.frame_id_ = frame;
+  next.page_id_ = INVALID_PAGE_ID;
+  *slot = &next;
+  return frame;
+}
+
+auto BufferPoolManagerInstance::FindFrame(std::unique_lock<std::mutex> &lock, page_id_t page_id, frame_id_t *frame_id)
+    -> bool {
+  while (true) {
+    if (page_table_.load()->Find(page_id, frame_id)) {
+      // 页面正在被读入这个帧, 等待读取完成之后重新查找
+      if (StateOf(*frame_id).io_in_progress_) {
+        pin_waits_.Add();
+        StateOf(*frame_id).io_cv_.wait(lock);
+        continue;
+      }
+      return true;
+    }
+    // 页面刚被淘汰, 还在写回磁盘, 写回完成之前从磁盘读到的是旧的数据
+    auto it = evicting_.find(page_id);
+    if (it == evicting_.end()) {
+      return false;
+    }
+    pin_waits_.Add();
+    StateOf(it->second).io_cv_.wait(lock);
+  }
+}
+
+auto BufferPoolManagerInstance::LoadPage(std::unique_lock<std::mutex> &lock, frame_id_t frame, page_id_t page_id,
+                                         bool read_from_disk) -> Page * {
+  std::vector<PendingLoad> loads{BeginLoad(frame, page_id)};
+  Page *page = PageOf(frame);
+  // 释放 latch_ 进行磁盘 I/O, 其他线程的命中不会被阻塞
+  lock.unlock();
+  WriteBackVictims(&loads);
+  if (read_from_disk) {
+    ReadBatchFromDisk(&loads);
+  } else if (!loads[0].write_failed_) {
+    page->ResetMemory();
+  }
+  lock.lock();
+  // 和批量读入一样, I/O 失败的时候放弃这个帧
+  if (loads[0].write_failed_ || loads[0].read_failed_) {
+    AbortLoad(loads[0]);
+    return nullptr;
+  }
+  FinishLoad(loads[0]);
+  return page;
+}
+
+auto BufferPoolManagerInstance::BeginLoad(frame_id_t frame, page_id_t page_id) -> PendingLoad {
+  Page *page = PageOf(frame);
+  FrameState &state = StateOf(frame);
+  // 在 latch_ 下完成所有元数据的修改: 删除旧页面的映射, 建立新页面的映射, 固定这个帧并标记为正在进行 I/O
+  page_id_t victim = page->page_id_;
+  bool write_back = victim != INVALID_PAGE_ID && page->is_dirty_;
+  if (victim != INVALID_PAGE_ID) {
+    page_table_.load()->Remove(victim);
+    evictions_.Add();
+  }
+  if (write_back) {
+    evicting_[victim] = frame;
+    dirty_writebacks_.Add();
+  }
+  page->page_id_ = page_id;
+  page->is_dirty_ = false;
+  state.io_in_progress_ = true;
+  state.unrecorded_hits_ = 0;
+  state.replacer_pinned_ = true;
+  page_table_.load()->Insert(page_id, frame);
+  // 记录一次LRU-K次数, 设置为不可删除的
+  replacer_->RecordAccess(frame, page_id);
+  replacer_->SetEvictable(frame, false);
+  // 最后才把 pin_count_ 从 -1 改成 1, 之后快速路径上的固定一定能看到新的 page_id_ 和 I/O 标记
+  page->pin_count_ = 1;
+  return {frame, page_id, victim, write_back, false, false};
+}
+
+void BufferPoolManagerInstance::FinishLoad(const PendingLoad &load) {
+  if (load.write_back_) {
+    evicting_.erase(load.victim_);
+  }
+  StateOf(load.frame_).io_in_progress_ = false;
+  StateOf(load.frame_).io_cv_.notify_all();
+}
+
+void BufferPoolManagerInstance::AbortLoad(const PendingLoad &load) {
+  Page *page = PageOf(load.frame_);
+  page_table_.load()->Remove(load.page_id_);
+  if (load.write_failed_) {
+    // 帧里还是被淘汰的页面, 恢复它的映射并保留脏位, 以后淘汰或者刷盘的时候再写回
+    page->page_id_ = load.victim_;
+    page->is_dirty_ = true;
+    page_table_.load()->Insert(load.victim_, load.frame_);
+    FinishLoad(load);
+    UnpinFrame(load.frame_, true);
+    return;
+  }
+  page->page_id_ = INVALID_PAGE_ID;
+  page->is_dirty_ = false;
+  page->ResetMemory();
+  FinishLoad(load);
+  // 和删除页面一样放回空闲链表; 快速路径上校验失败的临时 pin 由 GetFrame 等待撤销
+  replacer_->SetEvictable(load.frame_, true);
+  replacer_->Remove(load.frame_);
+  StateOf(load.frame_).unrecorded_hits_ = 0;
+  StateOf(load.frame_).replacer_pinned_ = false;
+  page->pin_count_--;
+  free_list_.push_back(load.frame_);
+}
+
+void BufferPoolManagerInstance::ReadBatchFromDisk(std::vector<PendingLoad> *loads) {
+  std::sort(loads->begin(), loads->end(),
+            [](const PendingLoad &a, const PendingLoad &b) { return a.page_id_ < b.page_id_; });
+  // 页面号连续的一段页面用一个请求读入, 长度大于 1 的段先读到 buffer 里再复制到各自的帧
+  std::vector<std::pair<size_t, size_t>> runs;
+  size_t buffer_pages = 0;
+  for (size_t begin = 0; begin < loads->size();) {
+    // 被淘汰的页面没能写回的帧里还是那个页面, 不能读入
+    if ((*loads)[begin].write_failed_) {
+      begin++;
+      continue;
+    }
+    size_t end = begin + 1;
+    while (end < loads->size() && !(*loads)[end].write_failed_ &&
+           (*loads)[end].page_id_ == (*loads)[end - 1].page_id_ + 1) {
+      end++;
+    }
+    runs.emplace_back(begin, end);
+    buffer_pages += end - begin > 1 ? end - begin : 0;
+    begin = end;
+  }
+  // 按页对齐, O_DIRECT 的读可以直接读进来
+  AlignedBuffer buffer = AllocateAlignedPages(buffer_pages, page_size_);
+  std::vector<DiskRequest> requests;
+  std::vector<char *> run_data;
+  auto start = std::chrono::steady_clock::now();
+  size_t buffer_offset = 0;
+  for (auto [begin, end] : runs) {
+    DiskRequest request;
+    request.page_id_ = (*loads)[begin].page_id_;
+    request.num_pages_ = end - begin;
+    if (end - begin == 1) {
+      request.data_ = PageOf((*loads)[begin].frame_)->GetData();
+    } else {
+      request.data_ = buffer.get() + buffer_offset;
+      buffer_offset += (end - begin) * page_size_;
+    }
+    request.callback_ = [this, start](bool) { read_latency_.Record(std::chrono::steady_clock::now() - start); };
+    run_data.push_back(request.data_);
+    requests.push_back(std::move(request));
+  }
+  auto futures = GetDiskScheduler()->ScheduleBatch(std::move(requests));
+  for (size_t r = 0; r < runs.size(); r++) {
+    auto [begin, end] = runs[r];
+    if (!futures[r].get()) {
+      for (size_t i = begin; i < end; i++) {
+        (*loads)[i].read_failed_ = true;
+      }
+      continue;
+    }
+    for (size_t i = begin; end - begin > 1 && i < end; i++) {
+      memcpy(PageOf((*loads)[i].frame_)->GetData(), run_data[r] + (i - begin) * page_size_, page_size_);
+    }
+  }
+}
+
+void BufferPoolManagerInstance::WriteBackVictims(std::vector<PendingLoad> *loads) {
+  lsn_t max_lsn = INVALID_LSN;
+  for (const auto &load : *loads) {
+    if (load.write_back_) {
+      max_lsn = std::max(max_lsn, PageOf(load.frame_)->GetLSN());
+    }
+  }
+  ForceLog(max_lsn);
+  std::vector<DiskRequest> requests;
+  std::vector<PendingLoad *> written;
+  auto start = std::chrono::steady_clock::now();
+  for (auto &load : *loads) {
+    if (!load.write_back_) {
+      continue;
+    }
+    DiskRequest request;
+    request.is_write_ = true;
+    request.data_ = PageOf(load.frame_)->GetData();
+    request.page_id_ = load.victim_;
+    request.callback_ = [this, start](bool) { write_latency_.Record(std::chrono::steady_clock::now() - start); };
+    requests.push_back(std::move(request));
+    written.push_back(&load);
+  }
+  if (requests.empty()) {
+    return;
+  }
+  // 写回完成之前帧里还是被淘汰的页面, 不能读入新的页面
+  auto futures = GetDiskScheduler()->ScheduleBatch(std::move(requests));
+  for (size_t r = 0; r < futures.size(); r++) {
+    written[r]->write_failed_ = !futures[r].get();
+  }
+}
+
+auto BufferPoolManagerInstance::GetDiskScheduler() -> DiskScheduler * {
+  std::call_once(disk_scheduler_once_, [this] { disk_scheduler_ = std::make_unique<DiskScheduler>(disk_manager_); });
+  return disk_scheduler_.get();
+}
+
+void BufferPoolManagerInstance::FlushFrame(std::unique_lock<std::mutex> &lock, frame_id_t frame_id) {
+  Page *page = PageOf(frame_id);
+  if (!page->is_dirty_) {
+    return;
+  }
+  // 固定这个帧防止写盘期间被淘汰; 先清除脏位, 写盘期间的修改在 Unpin 的时候会重新设置脏位
+  page_id_t page_id = page->page_id_;
+  page->pin_count_++;
+  replacer_->SetEvictable(frame_id, false);
+  StateOf(frame_id).replacer_pinned_ = true;
+  page->is_dirty_ = false;
+  lock.unlock();
+  WriteToDisk(page_id, page);
+  flushes_.Add();
+  lock.lock();
+  UnpinFrame(frame_id, true);
+}
+
+auto BufferPoolManagerInstance::UnpinFrame(frame_id_t frame_id, bool latch_held) -> bool {
+  auto &pins = PageOf(frame_id)->pin_count_;
+  int old = pins.load();
+  do {
+    if (old <= 0) {
+      return false;
+    }
+  } while (!pins.compare_exchange_weak(old, old - 1));
+  // 替换器里这个帧可能被标记为不可淘汰, 最后一个 pin 释放之后需要在 latch_ 下重新设置
+  if (old == 1 && StateOf(frame_id).replacer_pinned_) {
+    if (latch_held) {
+      OnFrameUnpinned(frame_id);
+    } else {
+      std::scoped_lock<std::mutex> lock(latch_);
+      OnFrameUnpinned(frame_id);
+    }
+  }
+  return true;
+}
+
+void BufferPoolManagerInstance::OnFrameUnpinned(frame_id_t frame_id) {
+  Page *page = PageOf(frame_id);
+  // 拿到 latch_ 之前帧可能又被固定了, 或者被删除了; 这种情况由之后的 Unpin 或者删除负责
+  if (page->pin_count_ != 0 || page->page_id_ == INVALID_PAGE_ID) {
+    return;
+  }
+  FrameState &state = StateOf(frame_id);
+  if (state.unrecorded_hits_.exchange(0) > 0) {
+    replacer_->RecordAccess(frame_id, page->page_id_);
+  }
+  replacer_->SetEvictable(frame_id, true);
+  state.replacer_pinned_ = false;
 }
 
 auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
   frame_id_t frame = -1;
-  // 如果不再page_table_中或者是pin_count_==0直接返回false
-  if (!page_table_->Find(page_id, frame)) {  // 没有找到直接返回false
-    return false;
+  // 页面没有被调用者固定的时候帧可能被 Resize 释放, 所以整个过程都要登记为无锁的读者
+  std::atomic<uint32_t> *reader = EnterUnlatched();
+  // 调用者持有这个页面的 pin, 页面不会被替换; 无锁查找可能因为并发的删除漏掉这个页面, 这时在 latch_ 下再查一次
+  if (!page_table_.load()->Find(page_id, &frame) || PageOf(frame)->page_id_ != page_id) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    // 如果不再page_table_中直接返回false
+    if (!page_table_.load()->Find(page_id, &frame)) {
+      reader->fetch_sub(1);
+      return false;
+    }
   }
   // 修改相关的帧的脏位
   if (is_dirty) {
-    pages_[frame].is_dirty_ = is_dirty;
+    PageOf(frame)->is_dirty_ = true;
   }
-  if (pages_[frame].pin_count_ == 0) {
-    return false;
+  // 对相关的frame的pin_count_-1, pin_count_==0 的时候返回false
+  bool unpinned = UnpinFrame(frame, false);
+  reader->fetch_sub(1);
+  return unpinned;
+}
+
+void BufferPoolManagerInstance::ReleasePage(Page *page, bool is_dirty) {
+  // 守卫持有 pin, 页面不会被替换, 帧号直接从页面中获得, 不需要查页表;
+  // 减到 0 之后帧可能被 Resize 释放, 所以要登记为无锁的读者
+  std::atomic<uint32_t> *reader = EnterUnlatched();
+  if (is_dirty) {
+    page->is_dirty_ = true;
   }
-  // 对相关的frame的pin_count_-1
-  pages_[frame].pin_count_--;
-  // 如果pin_count_==0,可以将replacer_的设置为相关的true,可以进行删除
-  if (pages_[frame].pin_count_ == 0) {
-    replacer_->SetEvictable(frame, true);
+  frame_id_t frame = page->frame_id_;
+  if (page->pin_count_.fetch_sub(1) == 1 && StateOf(frame).replacer_pinned_) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    // 拿到 latch_ 之前帧可能已经被缩小释放了
+    if (static_cast<size_t>(frame) < pool_size_) {
+      OnFrameUnpinned(frame);
+    }
   }
-  // Debug();
-  return true;
+  reader->fetch_sub(1);
 }
 
 auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
+  std::unique_lock<std::mutex> lock(latch_);
   frame_id_t frame = -1;
-  if (page_table_->Find(page_id, frame)) {
-    if (pages_[frame].is_dirty_) {
-      disk_manager_->WritePage(pages_[frame].page_id_, pages_[frame].GetData());
-      pages_[frame].is_dirty_ = false;
-    }
+  if (!FindFrame(lock, page_id, &frame)) {
+    return false;
   }
+  FlushFrame(lock, frame);
   return true;
 }
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
-  for (size_t i = 0; i < pool_size_; ++i) {
-    if (pages_[i].page_id_ != INVALID_PAGE_ID) {
-      FlushPgImp(pages_[i].page_id_);
+  std::vector<std::pair<page_id_t, frame_id_t>> dirty;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (size_t i = 0; i < pool_size_; ++i) {
+      // 正在进行 I/O 的帧要么是刚读入的干净页面, 要么是新页面, 不需要刷新
+      auto frame = static_cast<frame_id_t>(i);
+      Page *page = PageOf(frame);
+      if (page->page_id_ != INVALID_PAGE_ID && !StateOf(frame).io_in_progress_ && page->is_dirty_) {
+        dirty.emplace_back(page->page_id_, frame);
+      }
     }
   }
+  // 按页面号排序, 页面号连续的一段脏页用一次 WritePages 写回; 每一批最多固定 FLUSH_BATCH_SIZE 个帧,
+  // 刷盘期间其他线程仍然有帧可以使用
+  std::sort(dirty.begin(), dirty.end());
+  for (size_t begin = 0; begin < dirty.size(); begin += FLUSH_BATCH_SIZE) {
+    size_t end = std::min<size_t>(dirty.size(), begin + FLUSH_BATCH_SIZE);
+    std::vector<std::pair<page_id_t, frame_id_t>> batch;
+    std::unique_lock<std::mutex> lock(latch_);
+    for (size_t i = begin; i < end; i++) {
+      auto [page_id, frame] = dirty[i];
+      // 收集之后帧可能被缩小释放, 或者页面被淘汰 (淘汰时已经写回了), 或者已经被别的线程刷新了
+      if (static_cast<size_t>(frame) >= pool_size_) {
+        continue;
+      }
+      Page *page = PageOf(frame);
+      if (page->page_id_ != page_id || StateOf(frame).io_in_progress_ || !page->is_dirty_) {
+        continue;
+      }
+      // 和 FlushFrame 一样固定这个帧并先清除脏位, 写盘期间的修改在 Unpin 的时候会重新设置脏位
+      page->pin_count_++;
+      replacer_->SetEvictable(frame, false);
+      StateOf(frame).replacer_pinned_ = true;
+      page->is_dirty_ = false;
+      batch.emplace_back(page_id, frame);
+    }
+    lock.unlock();
+    WriteRunsToDisk(batch);
+    lock.lock();
+    for (auto [page_id, frame] : batch) {
+      UnpinFrame(frame, true);
+    }
+  }
+  // 写回的页面只是交给了操作系统, 同步一次之后才持久化
+  disk_manager_->Sync();
 }
 
 auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
+  if (page_id < 0) {
+    return false;
+  }
+  std::unique_lock<std::mutex> lock(latch_);
   frame_id_t cur = -1;
-  // 不在page_table_中进行不用删除，直接返回true
-  if (!page_table_->Find(page_id, cur)) {
+  // 不在page_table_中进行不用删除, 只需要释放磁盘上的页面
+  if (!FindFrame(lock, page_id, &cur)) {
+    DeallocatePage(page_id);
     return true;
   }
-  // 当前的pin_count_ != 0不应该进行删除操作
-  if (pages_[cur].pin_count_ != 0) {
+  // 当前的pin_count_ != 0不应该进行删除操作; 把 pin_count_ 改成 -1 占用这个帧, 快速路径就不能再固定它了
+  int expected = 0;
+  if (!PageOf(cur)->pin_count_.compare_exchange_strong(expected, -1)) {
     return false;
   }
-  // 删除page_table_和LRU,将帧进行添加到free_list_
+  // 删除page_table_和LRU,将帧进行添加到free_list_, 同时重置帧的元数据, 被删除的页面不需要写回.
+  // 最后一个 pin 刚释放的帧在替换器里可能还是不可淘汰的, 先设置为可淘汰再删除
+  replacer_->SetEvictable(cur, true);
   replacer_->Remove(cur);
-  page_table_->Remove(page_id);
+  page_table_.load()->Remove(page_id);
+  PageOf(cur)->page_id_ = INVALID_PAGE_ID;
+  PageOf(cur)->is_dirty_ = false;
+  PageOf(cur)->ResetMemory();
+  StateOf(cur).unrecorded_hits_ = 0;
+  StateOf(cur).replacer_pinned_ = false;
+  PageOf(cur)->pin_count_ = 0;
   free_list_.push_back(cur);
   DeallocatePage(page_id);
   return true;
 }
 
-auto BufferPoolManagerInstance::AllocatePage() -> page_id_t { return next_page_id_++; }
+void BufferPoolManagerInstance::StartBackgroundWriter(std::chrono::milliseconds interval, size_t max_pages,
+                                                      double dirty_ratio) {
+  std::scoped_lock<std::mutex> lock(bgwriter_latch_);
+  if (bgwriter_thread_ != nullptr) {
+    return;
+  }
+  bgwriter_stop_ = false;
+  bgwriter_thread_ = new std::thread([this, interval, max_pages, dirty_ratio] {
+    std::unique_lock<std::mutex> lock(bgwriter_latch_);
+    while (!bgwriter_cv_.wait_for(lock, interval, [this] { return bgwriter_stop_; })) {
+      // 写盘的时候不持有 bgwriter_latch_, 否则 StopBackgroundWriter 要等到这一轮写完才能返回
+      lock.unlock();
+      BackgroundWriterRound(max_pages, dirty_ratio);
+      lock.lock();
+    }
+  });
+}
+
+void BufferPoolManagerInstance::StopBackgroundWriter() {
+  std::thread *thread;
+  {
+    std::scoped_lock<std::mutex> lock(bgwriter_latch_);
+    if (bgwriter_thread_ == nullptr) {
+      return;
+    }
+    bgwriter_stop_ = true;
+    thread = bgwriter_thread_;
+    bgwriter_thread_ = nullptr;
+  }
+  bgwriter_cv_.notify_all();
+  thread->join();
+  delete thread;
+}
+
+auto BufferPoolManagerInstance::BackgroundWriterRound(size_t max_pages, double dirty_ratio) -> size_t {
+  std::vector<frame_id_t> frames;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    size_t dirty = 0;
+    for (size_t i = 0; i < pool_size_; ++i) {
+      if (PageOf(static_cast<frame_id_t>(i))->is_dirty_) {
+        dirty++;
+      }
+    }
+    if (dirty == 0 || static_cast<double>(dirty) < dirty_ratio * static_cast<double>(pool_size_)) {
+      return 0;
+    }
+    // 按照替换器的淘汰顺序挑选脏页, 这些帧是马上就要被淘汰的, 提前写回之后淘汰时就不需要在 Fetch 路径上写盘了
+    for (frame_id_t frame : replacer_->EvictionOrder(pool_size_)) {
+      if (frames.size() >= max_pages) {
+        break;
+      }
+      if (!PageOf(frame)->is_dirty_) {
+        continue;
+      }
+      // 固定住这个帧, 写盘的时候不持有 latch_, 也不能让它被淘汰. 这里不调用 RecordAccess, 不影响替换策略的访问历史
+      PageOf(frame)->pin_count_++;
+      replacer_->SetEvictable(frame, false);
+      StateOf(frame).replacer_pinned_ = true;
+      frames.push_back(frame);
+    }
+  }
+
+  for (frame_id_t frame : frames) {
+    Page *page = PageOf(frame);
+    // 持有页面的读锁写盘, 写盘期间其他线程不能修改这个页面; 清除脏位也要在释放读锁之前完成,
+    // 否则读锁释放后的修改对应的脏位可能被这里清掉
+    page->RLatch();
+    WriteToDisk(page->GetPageId(), page);
+    flushes_.Add();
+    {
+      std::scoped_lock<std::mutex> lock(latch_);
+      page->is_dirty_ = false;
+    }
+    page->RUnlatch();
+  }
+
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (frame_id_t frame : frames) {
+    UnpinFrame(frame, true);
+  }
+  return frames.size();
+}
+
+void BufferPoolManagerInstance::PrefetchPages(const std::vector<page_id_t> &page_ids) {
+  std::scoped_lock<std::mutex> lock(prefetch_latch_);
+  for (page_id_t page_id : page_ids) {
+    // 预读只是一个提示, 队列满了直接丢弃
+    if (page_id < 0 || prefetch_queue_.size() >= static_cast<size_t>(PREFETCH_QUEUE_SIZE)) {
+      continue;
+    }
+    ValidatePageId(page_id);
+    prefetch_queue_.push_back(page_id);
+  }
+  if (prefetch_queue_.empty()) {
+    return;
+  }
+  if (prefetch_thread_ == nullptr) {
+    prefetch_thread_ = new std::thread([this] {
+      std::unique_lock<std::mutex> lock(prefetch_latch_);
+      while (true) {
+        prefetch_cv_.wait(lock, [this] { return prefetch_stop_ || !prefetch_queue_.empty(); });
+        if (prefetch_stop_) {
+          return;
+        }
+        // 一次取走队列里所有的页面, 它们的读请求一起交给磁盘调度器
+        std::vector<page_id_t> page_ids(prefetch_queue_.begin(), prefetch_queue_.end());
+        prefetch_queue_.clear();
+        lock.unlock();
+        PrefetchBatch(page_ids);
+        lock.lock();
+      }
+    });
+  }
+  prefetch_cv_.notify_one();
+}
+
+auto BufferPoolManagerInstance::PrefetchBatch(const std::vector<page_id_t> &page_ids) -> size_t {
+  std::unique_lock<std::mutex> lock(latch_);
+  std::vector<PendingLoad> loads;
+  for (page_id_t page_id : page_ids) {
+    frame_id_t frame = -1;
+    // 已经在缓冲池里(或者正在被读入, 包括这一批前面的页面), 以及正在写回的页面都不需要预读
+    if (page_table_.load()->Find(page_id, &frame) || evicting_.count(page_id) > 0) {
+      continue;
+    }
+    // 只使用空闲的或者可以淘汰的帧, 没有的话放弃剩下的页面
+    frame = GetFrame();
+    if (frame == -1) {
+      break;
+    }
+    loads.push_back(BeginLoad(frame, page_id));
+  }
+  if (loads.empty()) {
+    return 0;
+  }
+  lock.unlock();
+  WriteBackVictims(&loads);
+  ReadBatchFromDisk(&loads);
+  lock.lock();
+  size_t prefetched = 0;
+  for (const auto &load : loads) {
+    if (load.write_failed_ || load.read_failed_) {
+      AbortLoad(load);
+      continue;
+    }
+    FinishLoad(load);
+    // 读入之后不保持固定, 这个页面和其他没有被固定的页面一样可以被淘汰
+    UnpinFrame(load.frame_, true);
+    prefetched++;
+  }
+  return prefetched;
+}
+
+auto BufferPoolManagerInstance::SaveResidentPages(const std::string &file_name) -> bool {
+  std::vector<WarmStartEntry> pages;
+  page_id_t next_page_id;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    // 可以淘汰的帧按照淘汰顺序从最冷的开始, 被固定的帧正在被使用, 放在最后
+    std::vector<frame_id_t> order = replacer_->EvictionOrder(pool_size_);
+    std::vector<bool> listed(pool_size_, false);
+    for (frame_id_t frame : order) {
+      listed[frame] = true;
+    }
+    for (size_t i = 0; i < pool_size_; i++) {
+      if (!listed[i]) {
+        order.push_back(static_cast<frame_id_t>(i));
+      }
+    }
+    for (frame_id_t frame : order) {
+      page_id_t page_id = PageOf(frame)->page_id_;
+      if (page_id != INVALID_PAGE_ID) {
+        pages.push_back({page_id, static_cast<uint32_t>(std::max<size_t>(replacer_->AccessCount(frame), 1))});
+      }
+    }
+    next_page_id = next_page_id_;
+  }
+  // 先写到临时文件再改名, 中途崩溃不会留下写了一半的文件
+  std::string tmp_file_name = file_name + ".tmp";
+  std::ofstream out(tmp_file_name, std::ios::binary | std::ios::trunc);
+  auto num_pages = static_cast<uint32_t>(pages.size());
+  out.write(reinterpret_cast<const char *>(&WARM_START_MAGIC), sizeof(WARM_START_MAGIC));
+  out.write(reinterpret_cast<const char *>(&next_page_id), sizeof(next_page_id));
+  out.write(reinterpret_cast<const char *>(&num_pages), sizeof(num_pages));
+  out.write(reinterpret_cast<const char *>(pages.data()),
+            static_cast<std::streamsize>(pages.size() * sizeof(WarmStartEntry)));
+  out.close();
+  if (!out) {
+    std::remove(tmp_file_name.c_str());
+    return false;
+  }
+  return std::rename(tmp_file_name.c_str(), file_name.c_str()) == 0;
+}
+
+auto BufferPoolManagerInstance::WarmStart(const std::string &file_name) -> bool {
+  std::ifstream in(file_name, std::ios::binary);
+  uint32_t magic = 0;
+  page_id_t next_page_id = 0;
+  uint32_t num_pages = 0;
+  in.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+  in.read(reinterpret_cast<char *>(&next_page_id), sizeof(next_page_id));
+  in.read(reinterpret_cast<char *>(&num_pages), sizeof(num_pages));
+  if (!in || magic != WARM_START_MAGIC || num_pages > MAX_POOL_SIZE) {
+    return false;
+  }
+  std::vector<WarmStartEntry> pages(num_pages);
+  in.read(reinterpret_cast<char *>(pages.data()), static_cast<std::streamsize>(pages.size() * sizeof(WarmStartEntry)));
+  if (!in) {
+    return false;
+  }
+  // 只载入属于本实例的页面
+  pages.erase(std::remove_if(pages.begin(), pages.end(),
+                             [this](const WarmStartEntry &entry) {
+                               return entry.page_id_ < 0 ||
+                                      static_cast<size_t>(entry.page_id_) % num_instances_ != instance_index_;
+                             }),
+              pages.end());
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (warm_start_thread_ != nullptr) {
+    return false;
+  }
+  // 分配器跳过文件里的所有页面号, 新建的页面不会和重新载入的页面冲突
+  for (const auto &entry : pages) {
+    next_page_id = std::max(next_page_id, entry.page_id_ + 1);
+  }
+  while (static_cast<size_t>(next_page_id) % num_instances_ != instance_index_) {
+    next_page_id++;
+  }
+  page_id_t current = next_page_id_;
+  while (current < next_page_id && !next_page_id_.compare_exchange_weak(current, next_page_id)) {
+  }
+  warm_start_thread_ = new std::thread([this, pages = std::move(pages)] { LoadResidentPages(pages); });
+  return true;
+}
+
+void BufferPoolManagerInstance::WaitForWarmStart() {
+  std::thread *thread;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    thread = warm_start_thread_;
+  }
+  if (thread != nullptr && thread->joinable()) {
+    thread->join();
+  }
+}
+
+void BufferPoolManagerInstance::LoadResidentPages(const std::vector<WarmStartEntry> &pages) {
+  std::vector<WarmStartEntry> sorted = pages;
+  std::sort(sorted.begin(), sorted.end(),
+            [](const WarmStartEntry &a, const WarmStartEntry &b) { return a.page_id_ < b.page_id_; });
+  AlignedBuffer buffer = AllocateAlignedPages(WARM_START_BATCH_SIZE, page_size_);
+  std::unordered_map<page_id_t, frame_id_t> loaded;
+  bool out_of_frames = false;
+  size_t begin = 0;
+  while (begin < sorted.size() && !out_of_frames && !warm_start_stop_) {
+    // 一批页面号连续的页面, 用一次顺序读读入
+    size_t end = begin + 1;
+    while (end < sorted.size() && end - begin < static_cast<size_t>(WARM_START_BATCH_SIZE) &&
+           sorted[end].page_id_ == sorted[end - 1].page_id_ + 1) {
+      end++;
+    }
+    // 在 latch_ 下为不在缓冲池里的页面占用空闲帧, 和 LoadPage 一样建立映射并标记为正在进行 I/O;
+    // 帧保持固定, 但是在重放访问历史之前不交给替换器
+    std::vector<std::pair<size_t, frame_id_t>> batch;
+    std::unique_lock<std::mutex> lock(latch_);
+    for (size_t i = begin; i < end; i++) {
+      page_id_t page_id = sorted[i].page_id_;
+      frame_id_t frame = -1;
+      if (page_table_.load()->Find(page_id, &frame) || evicting_.count(page_id) > 0) {
+        continue;
+      }
+      if (free_list_.empty()) {
+        out_of_frames = true;
+        break;
+      }
+      frame = GetFrame();
+      Page *page = PageOf(frame);
+      FrameState &state = StateOf(frame);
+      page->page_id_ = page_id;
+      page->is_dirty_ = false;
+      state.io_in_progress_ = true;
+      state.unrecorded_hits_ = 0;
+      state.replacer_pinned_ = true;
+      page_table_.load()->Insert(page_id, frame);
+      page->pin_count_ = 1;
+      batch.emplace_back(i - begin, frame);
+    }
+    lock.unlock();
+    bool read = true;
+    if (!batch.empty()) {
+      // 只读第一个到最后一个需要的页面
+      size_t first = batch.front().first;
+      size_t last = batch.back().first;
+      auto start = std::chrono::steady_clock::now();
+      read = disk_manager_->ReadPages(sorted[begin + first].page_id_, last - first + 1, buffer.get());
+      read_latency_.Record(std::chrono::steady_clock::now() - start);
+      for (size_t i = 0; read && i < batch.size(); i++) {
+        auto [offset, frame] = batch[i];
+        memcpy(PageOf(frame)->GetData(), buffer.get() + (offset - first) * page_size_, page_size_);
+      }
+    }
+    lock.lock();
+    for (auto [offset, frame] : batch) {
+      Page *page = PageOf(frame);
+      if (!read) {
+        // 读失败的页面不能当作已经载入: 删除映射, 帧放回空闲链表. 这些帧还没有交给替换器,
+        // 快速路径上校验失败的临时 pin 由 GetFrame 等待撤销
+        page_table_.load()->Remove(page->page_id_);
+        page->page_id_ = INVALID_PAGE_ID;
+        page->ResetMemory();
+        StateOf(frame).replacer_pinned_ = false;
+        page->pin_count_--;
+        free_list_.push_back(frame);
+      } else {
+        loaded[sorted[begin + offset].page_id_] = frame;
+      }
+      StateOf(frame).io_in_progress_ = false;
+      StateOf(frame).io_cv_.notify_all();
+    }
+    lock.unlock();
+    begin = end;
+  }
+
+  // 按照保存的顺序(最冷的在前)重放访问历史: 第 round 轮给记录了 round 次以上访问的页面各补记一次访问,
+  // 这样每个页面最近 k 次访问的先后关系和保存的时候一致
+  std::scoped_lock<std::mutex> lock(latch_);
+  uint32_t rounds = 0;
+  for (const auto &entry : pages) {
+    rounds = std::max(rounds, entry.accesses_);
+  }
+  for (uint32_t round = 0; round < rounds; round++) {
+    for (const auto &entry : pages) {
+      auto it = loaded.find(entry.page_id_);
+      if (it != loaded.end() && entry.accesses_ > round) {
+        replacer_->RecordAccess(it->second, entry.page_id_);
+        replacer_->SetEvictable(it->second, false);
+      }
+    }
+  }
+  // 放开重新载入时的固定, 没有被其他线程固定的页面变成可以淘汰的
+  for (const auto &[page_id, frame] : loaded) {
+    UnpinFrame(frame, true);
+  }
+}
+
+auto BufferPoolManagerInstance::GetStats() -> BufferPoolStats {
+  BufferPoolStats stats;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    stats.pool_size_ = pool_size_;
+    for (size_t i = 0; i < pool_size_; i++) {
+      Page *page = PageOf(static_cast<frame_id_t>(i));
+      if (page->page_id_ != INVALID_PAGE_ID) {
+        stats.resident_pages_++;
+        stats.dirty_pages_ += page->is_dirty_ ? 1 : 0;
+      }
+    }
+  }
+  stats.hits_ = hits_.Load();
+  stats.misses_ = misses_.Load();
+  stats.evictions_ = evictions_.Load();
+  stats.dirty_writebacks_ = dirty_writebacks_.Load();
+  stats.flushes_ = flushes_.Load();
+  stats.pin_waits_ = pin_waits_.Load();
+  stats.no_free_frames_ = no_free_frames_.Load();
+  stats.read_latency_ = read_latency_.Load();
+  stats.write_latency_ = write_latency_.Load();
+  return stats;
+}
+
+auto BufferPoolManagerInstance::GetResidentPages() -> std::vector<page_id_t> {
+  std::scoped_lock<std::mutex> lock(latch_);
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < pool_size_; i++) {
+    page_id_t page_id = PageOf(static_cast<frame_id_t>(i))->page_id_;
+    if (page_id != INVALID_PAGE_ID) {
+      page_ids.push_back(page_id);
+    }
+  }
+  return page_ids;
+}
+
+void BufferPoolManagerInstance::WriteToDisk(page_id_t page_id, Page *page) {
+  ForceLog(page->GetLSN());
+  auto start = std::chrono::steady_clock::now();
+  disk_manager_->WritePage(page_id, page->GetData());
+  write_latency_.Record(std::chrono::steady_clock::now() - start);
+}
+
+void BufferPoolManagerInstance::ForceLog(lsn_t lsn) {
+  // 只有页面的 LSN 超过已经持久化的日志时才需要等待日志刷盘
+  if (enable_logging && log_manager_ != nullptr && lsn > log_manager_->GetPersistentLSN()) {
+    log_manager_->Flush(lsn);
+  }
+}
+
+auto BufferPoolManagerInstance::WriteRunsToDisk(const std::vector<std::pair<page_id_t, frame_id_t>> &frames) -> bool {
+  // 整批页面写盘之前按最大的 LSN 刷一次日志
+  lsn_t max_lsn = INVALID_LSN;
+  for (const auto &[page_id, frame_id] : frames) {
+    max_lsn = std::max(max_lsn, PageOf(frame_id)->GetLSN());
+  }
+  ForceLog(max_lsn);
+  bool success = true;
+  for (size_t begin = 0; begin < frames.size();) {
+    std::vector<const char *> pages{PageOf(frames[begin].second)->GetData()};
+    size_t end = begin + 1;
+    while (end < frames.size() && frames[end].first == frames[end - 1].first + 1) {
+      pages.push_back(PageOf(frames[end].second)->GetData());
+      end++;
+    }
+    auto start = std::chrono::steady_clock::now();
+    success = disk_manager_->WritePages(frames[begin].first, pages) && success;
+    write_latency_.Record(std::chrono::steady_clock::now() - start);
+    flushes_.Add(end - begin);
+    begin = end;
+  }
+  return success;
+}
+
+auto BufferPoolManagerInstance::AllocatePage(bool *reused) -> page_id_t {
+  // 先重用被释放的页面, 没有的话才扩展数据库文件
+  FreePageMap *free_page_map = disk_manager_->GetFreePageMap();
+  page_id_t page_id = free_page_map->Allocate(num_instances_, instance_index_);
+  if (reused != nullptr) {
+    *reused = page_id != INVALID_PAGE_ID;
+  }
+  if (page_id != INVALID_PAGE_ID) {
+    ValidatePageId(page_id);
+    return page_id;
+  }
+  // 每次跳过 num_instances_ 个页面,保证本实例分配的页面都满足 page_id % num_instances_ == instance_index_
+  page_id_t next_page_id = next_page_id_.fetch_add(static_cast<page_id_t>(num_instances_));
+  ValidatePageId(next_page_id);
+  free_page_map->NoteAllocated(next_page_id);
+  return next_page_id;
+}
+
+auto BufferPoolManagerInstance::AllocateExtentPage(page_id_t *extent_owner) -> page_id_t {
+  ExtentMap *extent_map = disk_manager_->GetExtentMap();
+  page_id_t page_id = INVALID_PAGE_ID;
+  if (*extent_owner != INVALID_PAGE_ID) {
+    page_id = extent_map->Allocate(*extent_owner, num_instances_, instance_index_);
+  }
+  if (page_id != INVALID_PAGE_ID) {
+    ValidatePageId(page_id);
+    return page_id;
+  }
+  // 对象的区用完了, 从下一个页面号开始为它保留 EXTENT_PAGES 个本实例的页面; 新对象以第一个页面命名
+  auto stride = static_cast<page_id_t>(num_instances_);
+  page_id_t first_page = next_page_id_.fetch_add(stride * static_cast<page_id_t>(EXTENT_PAGES));
+  ValidatePageId(first_page);
+  disk_manager_->GetFreePageMap()->NoteAllocated(first_page + stride * static_cast<page_id_t>(EXTENT_PAGES - 1));
+  if (*extent_owner == INVALID_PAGE_ID) {
+    *extent_owner = first_page;
+  }
+  extent_map->AddExtent(*extent_owner, first_page, num_instances_);
+  return extent_map->Allocate(*extent_owner, num_instances_, instance_index_);
+}
+
+void BufferPoolManagerInstance::DeallocatePage(page_id_t page_id) {
+  // 区里还没有分配出去的页面会由区分配, 不能同时放进空闲页面表
+  if (disk_manager_->GetExtentMap()->IsReserved(page_id)) {
+    return;
+  }
+  // 释放的页面记录在空闲页面表里, 之后的 NewPage 会先重用它; 从来没有分配过的页面号由 Free 忽略
+  disk_manager_->GetFreePageMap()->Free(page_id);
+}
+
+void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
+  assert(page_id % num_instances_ == instance_index_);  // allocated pages mod back to this BPI
+}
 
 }  // namespace bustub
@@ -0,0 +1,54 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.cpp
+//
+// Identification: src/buffer/buffer_pool_stats.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_stats.h"
+
+#include <string>
+
+namespace bustub {
+
+auto LatencyHistogram::BucketLabel(size_t bucket) -> std::string {
+  if (bucket == 0) {
+    return "<1us";
+  }
+  // 第 i 个桶的上界是 2^i 微秒, 最后一个桶没有上界
+  bool last = bucket == NUM_BUCKETS - 1;
+  uint64_t bound = uint64_t{1} << (last ? bucket - 1 : bucket);
+  std::string prefix = last ? ">=" : "<";
+  if (bound >= 1000 && bound % 1000 == 0) {
+    return prefix + std::to_string(bound / 1000) + "ms";
+  }
+  if (bound >= 1000) {
+    return prefix + std::to_string(bound / 1000) + "." + std::to_string(bound % 1000 / 100) + "ms";
+  }
+  return prefix + std::to_string(bound) + "us";
+}
+
+auto BufferPoolStats::operator+=(const BufferPoolStats &other) -> BufferPoolStats & {
+  pool_size_ += other.pool_size_;
+  resident_pages_ += other.resident_pages_;
+  dirty_pages_ += other.dirty_pages_;
+  hits_ += other.hits_;
+  misses_ += other.misses_;
+  evictions_ += other.evictions_;
+  dirty_writebacks_ += other.dirty_writebacks_;
+  flushes_ += other.flushes_;
+  pin_waits_ += other.pin_waits_;
+  no_free_frames_ += other.no_free_frames_;
+  for (size_t i = 0; i < LatencyHistogram::NUM_BUCKETS; i++) {
+    read_latency_[i] += other.read_latency_[i];
+    write_latency_[i] += other.write_latency_[i];
+  }
+  return *this;
+}
+
+}  // namespace bustub
@@ -0,0 +1,294 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// clock_pro_replacer.cpp
+//
+// Identification: src/buffer/clock_pro_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/clock_pro_replacer.h"
+
+#include <algorithm>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+ClockProReplacer::ClockProReplacer(size_t num_frames)
+    : capacity_(num_frames),
+      cold_target_(1),
+      frames_(num_frames),
+      hand_hot_(clock_.end()),
+      hand_cold_(clock_.end()),
+      hand_test_(clock_.end()) {}
+
+void ClockProReplacer::CheckFrameId(frame_id_t frame_id) const {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= capacity_) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "ClockProReplacer frame_id out of range");
+  }
+}
+
+auto ClockProReplacer::Next(NodeIter it) -> NodeIter {
+  ++it;
+  return it == clock_.end() ? clock_.begin() : it;
+}
+
+auto ClockProReplacer::InsertAtHead(const Node &node) -> NodeIter {
+  if (clock_.empty()) {
+    auto it = clock_.insert(clock_.end(), node);
+    hand_hot_ = hand_cold_ = hand_test_ = it;
+    return it;
+  }
+  return clock_.insert(hand_hot_, node);
+}
+
+void ClockProReplacer::MoveHandsOff(NodeIter it) {
+  // 只剩一个节点的时候指针没有地方可以移动, 节点被删除后整个环为空
+  NodeIter next = clock_.size() == 1 ? clock_.end() : Next(it);
+  for (NodeIter *hand : {&hand_hot_, &hand_cold_, &hand_test_}) {
+    if (*hand == it) {
+      *hand = next;
+    }
+  }
+}
+
+void ClockProReplacer::MoveToHead(NodeIter it) {
+  if (clock_.size() == 1) {
+    return;
+  }
+  MoveHandsOff(it);
+  clock_.splice(hand_hot_, clock_, it);
+}
+
+void ClockProReplacer::EraseNonResident(NodeIter it) {
+  MoveHandsOff(it);
+  nonresident_.erase(it->page_id_);
+  clock_.erase(it);
+  nonresident_count_--;
+}
+
+void ClockProReplacer::ShrinkColdTarget() {
+  if (cold_target_ > 1) {
+    cold_target_--;
+  }
+}
+
+void ClockProReplacer::RunHandHot() {
+  // 每个热页面最多被经过两次 (第一次清除引用位, 第二次降级), 用步数限制防止全部热页面都被固定时死循环
+  size_t steps = 0;
+  size_t limit = 2 * clock_.size() + 1;
+  while (hot_count_ > HotTarget() && steps++ < limit) {
+    NodeIter it = hand_hot_;
+    hand_hot_ = Next(it);
+    if (it->frame_id_ == -1) {
+      EraseNonResident(it);
+      ShrinkColdTarget();
+    } else if (it->hot_) {
+      if (it->ref_) {
+        it->ref_ = false;
+      } else {
+        it->hot_ = false;
+        hot_count_--;
+      }
+    } else if (it->test_) {
+      // 测试期内没有被再次访问, 说明冷页面不需要那么多
+      it->test_ = false;
+      ShrinkColdTarget();
+    }
+  }
+}
+
+void ClockProReplacer::RunHandTest() {
+  while (nonresident_count_ > capacity_) {
+    NodeIter it = hand_test_;
+    hand_test_ = Next(it);
+    if (it->frame_id_ == -1) {
+      EraseNonResident(it);
+      ShrinkColdTarget();
+    } else if (!it->hot_ && it->test_) {
+      it->test_ = false;
+      ShrinkColdTarget();
+    }
+  }
+}
+
+auto ClockProReplacer::EvictNode(NodeIter it) -> frame_id_t {
+  frame_id_t frame_id = it->frame_id_;
+  frames_[frame_id] = Frame{};
+  evictable_count_--;
+  warm_ = true;
+  if (it->hot_) {
+    hot_count_--;
+    it->hot_ = false;
+    it->test_ = false;
+  }
+  if (!it->test_) {
+    MoveHandsOff(it);
+    clock_.erase(it);
+    return frame_id;
+  }
+  // 测试期内被淘汰的冷页面保留为非驻留页面, 在测试期内重新加载说明冷页面太少
+  it->frame_id_ = -1;
+  it->ref_ = false;
+  nonresident_[it->page_id_] = it;
+  nonresident_count_++;
+  RunHandTest();
+  return frame_id;
+}
+
+auto ClockProReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (evictable_count_ == 0) {
+    return false;
+  }
+  size_t steps = 0;
+  size_t limit = 3 * clock_.size() + 1;
+  while (steps++ < limit) {
+    NodeIter it = hand_cold_;
+    if (it->frame_id_ == -1 || it->hot_ || !frames_[it->frame_id_].evictable_) {
+      hand_cold_ = Next(it);
+      continue;
+    }
+    if (!it->ref_) {
+      hand_cold_ = Next(it);
+      *frame_id = EvictNode(it);
+      return true;
+    }
+    it->ref_ = false;
+    if (it->test_) {
+      // 测试期内被再次访问的冷页面升级为热页面
+      it->hot_ = true;
+      it->test_ = false;
+      hot_count_++;
+      MoveToHead(it);
+      RunHandHot();
+    } else {
+      it->test_ = true;
+      MoveToHead(it);
+    }
+  }
+  // 冷页面都被固定了, 淘汰冷指针之后第一个可以淘汰的帧
+  NodeIter it = hand_cold_;
+  while (it->frame_id_ == -1 || !frames_[it->frame_id_].evictable_) {
+    it = Next(it);
+  }
+  hand_cold_ = Next(it);
+  *frame_id = EvictNode(it);
+  return true;
+}
+
+void ClockProReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id);
+  Frame &frame = frames_[frame_id];
+  if (frame.tracked_) {
+    frame.node_->ref_ = true;
+    return;
+  }
+  NodeIter it;
+  auto ghost = nonresident_.find(page_id);
+  if (ghost != nonresident_.end()) {
+    it = ghost->second;
+    nonresident_.erase(ghost);
+    nonresident_count_--;
+    cold_target_ = std::min(capacity_, cold_target_ + 1);
+    *it = Node{page_id, frame_id, true, false, false};
+    hot_count_++;
+    MoveToHead(it);
+  } else {
+    bool hot = !warm_ && hot_count_ < HotTarget();
+    it = InsertAtHead(Node{page_id, frame_id, hot, false, !hot});
+    if (hot) {
+      hot_count_++;
+    }
+  }
+  frame.tracked_ = true;
+  frame.evictable_ = true;
+  frame.node_ = it;
+  evictable_count_++;
+  RunHandHot();
+}
+
+void ClockProReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id);
+  Frame &frame = frames_[frame_id];
+  if (!frame.tracked_ || frame.evictable_ == set_evictable) {
+    return;
+  }
+  frame.evictable_ = set_evictable;
+  if (set_evictable) {
+    evictable_count_++;
+  } else {
+    evictable_count_--;
+  }
+}
+
+void ClockProReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id);
+  Frame &frame = frames_[frame_id];
+  if (!frame.tracked_) {
+    return;
+  }
+  if (!frame.evictable_) {
+    throw Exception(ExceptionType::INVALID, "ClockProReplacer cannot remove a non-evictable frame");
+  }
+  NodeIter it = frame.node_;
+  if (it->hot_) {
+    hot_count_--;
+  }
+  MoveHandsOff(it);
+  clock_.erase(it);
+  frame = Frame{};
+  evictable_count_--;
+}
+
+auto ClockProReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return evictable_count_;
+}
+
+auto ClockProReplacer::GetColdTarget() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return cold_target_;
+}
+
+auto ClockProReplacer::EvictionOrder(size_t max_frames) -> std::vector<frame_id_t> {
+  std::scoped_lock<std::mutex> lock(latch_);
+  std::vector<frame_id_t> order;
+  if (clock_.empty()) {
+    return order;
+  }
+  // 近似冷指针的顺序: 先是引用位为 0 的冷页面, 然后是引用位为 1 的冷页面, 最后是热页面
+  auto collect = [&](bool hot, bool ref) {
+    NodeIter it = hand_cold_;
+    do {
+      if (order.size() < max_frames && it->frame_id_ != -1 && it->hot_ == hot && it->ref_ == ref &&
+          frames_[it->frame_id_].evictable_) {
+        order.push_back(it->frame_id_);
+      }
+      it = Next(it);
+    } while (it != hand_cold_);
+  };
+  collect(false, false);
+  collect(false, true);
+  collect(true, false);
+  collect(true, true);
+  return order;
+}
+
+void ClockProReplacer::Resize(size_t num_frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  frames_.resize(num_frames);
+  capacity_ = num_frames;
+  cold_target_ = std::max<size_t>(1, std::min(cold_target_, capacity_));
+  RunHandTest();
+  RunHandHot();
+}
+
+}  // namespace bustub
@@ -0,0 +1,52 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// eviction_policy.cpp
+//
+// Identification: src/buffer/eviction_policy.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/eviction_policy.h"
+
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_pro_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/two_queue_replacer.h"
+#include "common/exception.h"
+
+namespace bustub {
+
+auto MakeEvictionPolicy(EvictionPolicyType type, size_t num_frames, size_t k) -> std::unique_ptr<EvictionPolicy> {
+  switch (type) {
+    case EvictionPolicyType::LRU_K:
+      return std::make_unique<LRUKReplacer>(num_frames, k);
+    case EvictionPolicyType::ARC:
+      return std::make_unique<ArcReplacer>(num_frames);
+    case EvictionPolicyType::TWO_QUEUE:
+      return std::make_unique<TwoQueueReplacer>(num_frames);
+    case EvictionPolicyType::CLOCK_PRO:
+      return std::make_unique<ClockProReplacer>(num_frames);
+  }
+  throw Exception(ExceptionType::INVALID, "unknown eviction policy");
+}
+
+auto ParseEvictionPolicyType(const std::string &name, EvictionPolicyType *type) -> bool {
+  if (name == "lru-k") {
+    *type = EvictionPolicyType::LRU_K;
+  } else if (name == "arc") {
+    *type = EvictionPolicyType::ARC;
+  } else if (name == "2q") {
+    *type = EvictionPolicyType::TWO_QUEUE;
+  } else if (name == "clock-pro") {
+    *type = EvictionPolicyType::CLOCK_PRO;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace bustub
@@ -13,117 +13,109 @@
 #include "include/buffer/lru_k_replacer.h"
 #include <algorithm>
 #include <cstddef>
-#include <cstdlib>
-#include <iterator>
-#include <memory>
-#include "../include/container/hash/extendible_hash_table.h"
+#include <utility>
 #include "common/config.h"
 #include "common/exception.h"
 #include "common/logger.h"
 
 namespace bustub {
 
-LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k) : replacer_size_(num_frames), k_(k) { num_ = 0; }
-
-LRUKReplacer::~LRUKReplacer() {
-  cache_.clear();
-  cach_.clear();
-  hist_.clear();
+LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k)
+    : replacer_size_(num_frames), k_(k), frames_(num_frames, FrameHistory(k)) {
+  BUSTUB_ASSERT(k > 0, "LRU-K needs to look back at least one access");
 }
 
+LRUKReplacer::~LRUKReplacer() = default;
+
 auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
   std::scoped_lock<std::mutex> lock(latch_);
-  auto lam = [](Node node) { return !node.replace_; };
-  auto cur = std::find_if(hist_.begin(), hist_.end(), lam);
-  bool ans = false;
-  if (cur == hist_.end()) {
-    cur = std::find_if(cach_.begin(), cach_.end(), lam);
-    if (cur != cach_.end()) {  // cur find in cach_
-      *frame_id = cur->frame_;
-      cache_.erase(cur->frame_);
-      cach_.erase(cur);
-      ans = true;
-      num_--;
-    }
-  } else {  // cur find in hist_
-    *frame_id = cur->frame_;
-    cache_.erase(cur->frame_);
-    hist_.erase(cur);
-    ans = true;
-    num_--;
+  if (evictable_.empty()) {
+    return false;
   }
-  return ans;
+  // set 中第一个元素就是后向k距离最大的帧
+  *frame_id = std::get<2>(*evictable_.begin());
+  evictable_.erase(evictable_.begin());
+  frames_[*frame_id].Reset();
+  return true;
 }
 
 void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
   std::scoped_lock<std::mutex> lock(latch_);
-  if (static_cast<size_t>(frame_id) > replacer_size_) {
-    throw Exception(ExceptionType::OUT_OF_MEMORY, "LRUKReplacerAccess out frame_id");
+  CheckFrameId(frame_id);
+  auto &frame = frames_[frame_id];
+  if (!frame.tracked_) {  // 没有找到需要进行创建,新的帧默认是可以被驱逐的
+    frame.tracked_ = true;
+    frame.evictable_ = true;
+    frame.Record(current_timestamp_++);
+    evictable_.insert(KeyOf(frame_id));
+    return;
   }
-  auto f = cache_.find(frame_id);
-  if (f != cache_.end()) {  // 查找到已有的
-    size_t cnt = ++f->second->cnt_;
-    bool v = f->second->replace_;
-    if (cnt == k_) {  // hist移动到cach
-      hist_.erase(f->second);
-      cach_.emplace_back(Node(frame_id, cnt, v));
-      cache_[frame_id] = std::prev(cach_.end());
-    } else if (cnt > k_) {  // cach_ 使用LRU
-      cach_.erase(f->second);
-      cach_.emplace_back(Node(frame_id, cnt, v));
-      cache_[frame_id] = std::prev(cach_.end());
-    }
-  } else {  // 没有找到需要进行创建
-            // 如果当前已经满了需要进行删除
-    Node node(frame_id);
-    hist_.push_back(node);
-    cache_[frame_id] = std::prev(hist_.end());
-    num_++;
+  if (!frame.evictable_) {  // 不可驱逐的帧不在 set 中,只需要更新访问历史
+    frame.Record(current_timestamp_++);
+    return;
   }
+  // 可驱逐的帧需要更新在 set 中的位置,复用原来的节点避免重新分配内存
+  auto node = evictable_.extract(KeyOf(frame_id));
+  frame.Record(current_timestamp_++);
+  node.value() = KeyOf(frame_id);
+  evictable_.insert(std::move(node));
 }
+
 void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
   std::scoped_lock<std::mutex> lock(latch_);
-  if (static_cast<size_t>(frame_id) > replacer_size_) {
-    throw Exception(ExceptionType::OUT_OF_MEMORY, "LRUKReplacerAccess out frame_id");
+  CheckFrameId(frame_id);
+  auto &frame = frames_[frame_id];
+  if (!frame.tracked_ || frame.evictable_ == set_evictable) {
+    return;
   }
-  auto f = cache_.find(frame_id);
-  if (f != cache_.end()) {
-    bool v = f->second->replace_;
-    if (!v && !set_evictable) {  // false false
-      f->second->replace_ = true;
-      num_--;
-    }
-    if (v && set_evictable) {
-      f->second->replace_ = false;
-      num_++;
-    }
+  frame.evictable_ = set_evictable;
+  if (set_evictable) {
+    evictable_.insert(KeyOf(frame_id));
+  } else {
+    evictable_.erase(KeyOf(frame_id));
   }
 }
 
 void LRUKReplacer::Remove(frame_id_t frame_id) {
   std::scoped_lock<std::mutex> lock(latch_);
-  if (static_cast<size_t>(frame_id) > replacer_size_) {
-    throw Exception(ExceptionType::OUT_OF_MEMORY, "LRUKReplacerAccess out frame_id");
+  CheckFrameId(frame_id);
+  auto &frame = frames_[frame_id];
+  if (!frame.tracked_) {
+    return;
   }
-  auto f = cache_.find(frame_id);
-  if (f != cache_.end()) {
-    if (f->second->replace_) {
-      throw Exception(ExceptionType::OUT_OF_MEMORY, "LRUKReplacerAccess not remove");
-    }
-    size_t n = f->second->cnt_;
-    if (n >= k_) {
-      cach_.erase(f->second);
-    } else {
-      hist_.erase(f->second);
-    }
-    cache_.erase(frame_id);
-    num_--;
+  if (!frame.evictable_) {
+    throw Exception(ExceptionType::INVALID, "LRUKReplacer cannot remove a non-evictable frame");
   }
+  evictable_.erase(KeyOf(frame_id));
+  frame.Reset();
 }
 
 auto LRUKReplacer::Size() -> size_t {
   std::scoped_lock<std::mutex> lock(latch_);
-  return num_;
+  return evictable_.size();
+}
+
+auto LRUKReplacer::EvictionOrder(size_t max_frames) -> std::vector<frame_id_t> {
+  std::scoped_lock<std::mutex> lock(latch_);
+  std::vector<frame_id_t> frames;
+  frames.reserve(std::min(max_frames, evictable_.size()));
+  for (auto it = evictable_.begin(); it != evictable_.end() && frames.size() < max_frames; ++it) {
+    frames.push_back(std::get<2>(*it));
+  }
+  return frames;
+}
+
+auto LRUKReplacer::AccessCount(frame_id_t frame_id) -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id);
+  const auto &frame = frames_[frame_id];
+  return frame.tracked_ ? std::min(frame.count_, k_) : 1;
+}
+
+void LRUKReplacer::Resize(size_t num_frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  frames_.resize(num_frames, FrameHistory(k_));
+  replacer_size_ = num_frames;
 }
 
 }  // namespace bustub
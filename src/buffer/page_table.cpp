@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.cpp
+//
+// Identification: src/buffer/page_table.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+namespace bustub {
+
+PageTable::PageTable(size_t max_entries) : max_entries_(max_entries) {
+  // 负载因子不超过 1/2, 线性探测的查找长度比较短
+  size_t bits = 3;
+  while ((static_cast<size_t>(1) << bits) < 2 * max_entries) {
+    bits++;
+  }
+  capacity_ = static_cast<size_t>(1) << bits;
+  shift_ = 64 - bits;
+  slots_ = new std::atomic<uint64_t>[capacity_];
+  for (size_t i = 0; i < capacity_; i++) {
+    slots_[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+  }
+}
+
+PageTable::~PageTable() { delete[] slots_; }
+
+auto PageTable::Find(page_id_t page_id, frame_id_t *frame_id) const -> bool {
+  size_t mask = capacity_ - 1;
+  for (size_t i = Home(page_id), probes = 0; probes < capacity_; i = (i + 1) & mask, probes++) {
+    uint64_t slot = slots_[i].load(std::memory_order_acquire);
+    if (slot == EMPTY_SLOT) {
+      return false;
+    }
+    if (PageOf(slot) == page_id) {
+      *frame_id = FrameOf(slot);
+      return true;
+    }
+  }
+  return false;
+}
+
+auto PageTable::SlotOf(page_id_t page_id) const -> size_t {
+  size_t mask = capacity_ - 1;
+  for (size_t i = Home(page_id), probes = 0; probes < capacity_; i = (i + 1) & mask, probes++) {
+    uint64_t slot = slots_[i].load(std::memory_order_relaxed);
+    if (slot == EMPTY_SLOT) {
+      return capacity_;
+    }
+    if (PageOf(slot) == page_id) {
+      return i;
+    }
+  }
+  return capacity_;
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  BUSTUB_ASSERT(page_id != INVALID_PAGE_ID, "cannot map the invalid page id");
+  size_t mask = capacity_ - 1;
+  size_t i = Home(page_id);
+  while (true) {
+    uint64_t slot = slots_[i].load(std::memory_order_relaxed);
+    if (slot == EMPTY_SLOT || PageOf(slot) == page_id) {
+      if (slot == EMPTY_SLOT) {
+        BUSTUB_ASSERT(size_ < capacity_ / 2, "page table holds more pages than the buffer pool has frames");
+        size_++;
+      }
+      slots_[i].store(Pack(page_id, frame_id), std::memory_order_release);
+      return;
+    }
+    i = (i + 1) & mask;
+  }
+}
+
+auto PageTable::Remove(page_id_t page_id) -> bool {
+  size_t hole = SlotOf(page_id);
+  if (hole == capacity_) {
+    return false;
+  }
+  // 删除时把后面同一个探测序列上的元素往前移, 保证查找遇到空槽就可以停止, 不需要墓碑
+  size_t mask = capacity_ - 1;
+  for (size_t j = (hole + 1) & mask;; j = (j + 1) & mask) {
+    uint64_t slot = slots_[j].load(std::memory_order_relaxed);
+    if (slot == EMPTY_SLOT) {
+      break;
+    }
+    size_t home = Home(PageOf(slot));
+    // home 在 (hole, j] 之间的元素不能移动到 hole, 否则从 home 开始的查找会错过它
+    bool stays = hole <= j ? (hole < home && home <= j) : (hole < home || home <= j);
+    if (!stays) {
+      // 先写入新的位置再清空旧的位置, 并发的查找至多漏掉这个元素, 不会看到不存在的映射
+      slots_[hole].store(slot, std::memory_order_release);
+      hole = j;
+    }
+  }
+  slots_[hole].store(EMPTY_SLOT, std::memory_order_release);
+  size_--;
+  return true;
+}
+
+}  // namespace bustub
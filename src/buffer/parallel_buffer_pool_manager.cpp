@@ -0,0 +1,250 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/parallel_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <string>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                                                     size_t replacer_k, LogManager *log_manager,
+                                                     EvictionPolicyType policy) {
+  BUSTUB_ASSERT(num_instances > 0, "a parallel buffer pool needs at least one instance");
+  // Allocate and create individual BufferPoolManagerInstances
+  instances_.reserve(num_instances);
+  for (size_t i = 0; i < num_instances; i++) {
+    instances_.push_back(new BufferPoolManagerInstance(pool_size, num_instances, i, disk_manager, replacer_k,
+                                                       log_manager, policy));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  for (auto *instance : instances_) {
+    delete instance;
+  }
+}
+
+auto ParallelBufferPoolManager::GetPoolSize() -> size_t {
+  size_t pool_size = 0;
+  for (auto *instance : instances_) {
+    pool_size += instance->GetPoolSize();
+  }
+  return pool_size;
+}
+
+auto ParallelBufferPoolManager::Resize(size_t pool_size) -> bool {
+  bool resized = true;
+  for (auto *instance : instances_) {
+    resized = instance->Resize(pool_size) && resized;
+  }
+  return resized;
+}
+
+auto ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance * {
+  // 每个实例只分配 page_id % num_instances == instance_index 的页面,所以取模就能找到页面所在的分片
+  return instances_[static_cast<size_t>(page_id) % instances_.size()];
+}
+
+void ParallelBufferPoolManager::StartBackgroundWriter(std::chrono::milliseconds interval, size_t max_pages,
+                                                      double dirty_ratio) {
+  for (auto *instance : instances_) {
+    instance->StartBackgroundWriter(interval, max_pages, dirty_ratio);
+  }
+}
+
+void ParallelBufferPoolManager::StopBackgroundWriter() {
+  for (auto *instance : instances_) {
+    instance->StopBackgroundWriter();
+  }
+}
+
+void ParallelBufferPoolManager::PrefetchPages(const std::vector<page_id_t> &page_ids) {
+  if (page_ids.empty()) {
+    return;
+  }
+  std::vector<std::vector<page_id_t>> shards(instances_.size());
+  for (page_id_t page_id : page_ids) {
+    if (page_id >= 0) {
+      shards[static_cast<size_t>(page_id) % instances_.size()].push_back(page_id);
+    }
+  }
+  for (size_t i = 0; i < instances_.size(); i++) {
+    if (!shards[i].empty()) {
+      instances_[i]->PrefetchPages(shards[i]);
+    }
+  }
+}
+
+auto ParallelBufferPoolManager::SaveResidentPages(const std::string &file_name) -> bool {
+  bool saved = true;
+  for (size_t i = 0; i < instances_.size(); i++) {
+    saved = instances_[i]->SaveResidentPages(file_name + "." + std::to_string(i)) && saved;
+  }
+  return saved;
+}
+
+auto ParallelBufferPoolManager::WarmStart(const std::string &file_name) -> bool {
+  bool started = true;
+  for (size_t i = 0; i < instances_.size(); i++) {
+    started = instances_[i]->WarmStart(file_name + "." + std::to_string(i)) && started;
+  }
+  return started;
+}
+
+void ParallelBufferPoolManager::WaitForWarmStart() {
+  for (auto *instance : instances_) {
+    instance->WaitForWarmStart();
+  }
+}
+
+auto ParallelBufferPoolManager::GetStats() -> BufferPoolStats {
+  BufferPoolStats stats;
+  for (auto *instance : instances_) {
+    stats += instance->GetStats();
+  }
+  return stats;
+}
+
+auto ParallelBufferPoolManager::GetResidentPages() -> std::vector<page_id_t> {
+  std::vector<page_id_t> page_ids;
+  for (auto *instance : instances_) {
+    auto resident = instance->GetResidentPages();
+    page_ids.insert(page_ids.end(), resident.begin(), resident.end());
+  }
+  return page_ids;
+}
+
+auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) -> Page * {
+  // 负数的页面号 (比如 INVALID_PAGE_ID) 不属于任何实例, 不能取模分片
+  if (page_id < 0) {
+    return nullptr;
+  }
+  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+}
+
+auto ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
+  if (page_id < 0) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+auto ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) -> bool {
+  if (page_id < 0) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+auto ParallelBufferPoolManager::FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+  if (strategy == nullptr || page_id < 0) {
+    return FetchPgImp(page_id);
+  }
+  return GetBufferPoolManager(page_id)->FetchPage(page_id, *strategy);
+}
+
+auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) -> Page * {
+  return NewPgWithStrategyImp(page_id, nullptr);
+}
+
+auto ParallelBufferPoolManager::NewPgWithStrategyImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * {
+  // 从一个轮转的起点开始依次询问每个实例,直到某个实例有空闲的帧;下一次调用从下一个实例开始
+  size_t num_instances = instances_.size();
+  size_t start = next_instance_.fetch_add(1) % num_instances;
+  for (size_t i = 0; i < num_instances; i++) {
+    BufferPoolManagerInstance *instance = instances_[(start + i) % num_instances];
+    Page *page = strategy == nullptr ? instance->NewPage(page_id) : instance->NewPage(page_id, *strategy);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  return nullptr;
+}
+
+auto ParallelBufferPoolManager::NewPgInExtentImp(page_id_t *page_id, page_id_t *extent_owner,
+                                                 BufferAccessStrategy *strategy) -> Page * {
+  // 对象的区都由它的 owner 页面所在的实例保留, 先问这个实例, 新对象从轮转的起点开始
+  size_t num_instances = instances_.size();
+  size_t start = *extent_owner == INVALID_PAGE_ID ? next_instance_.fetch_add(1) % num_instances
+                                                  : static_cast<size_t>(*extent_owner) % num_instances;
+  for (size_t i = 0; i < num_instances; i++) {
+    BufferPoolManagerInstance *instance = instances_[(start + i) % num_instances];
+    Page *page = instance->NewPageInExtent(page_id, extent_owner, strategy);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  return nullptr;
+}
+
+auto ParallelBufferPoolManager::FetchPgsImp(const std::vector<page_id_t> &page_ids) -> std::vector<Page *> {
+  // 按照所属的实例分组, 记录每个页面在结果中的位置
+  std::vector<std::vector<page_id_t>> shards(instances_.size());
+  std::vector<std::vector<size_t>> positions(instances_.size());
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    if (page_ids[i] < 0) {
+      return {};
+    }
+    size_t shard = static_cast<size_t>(page_ids[i]) % instances_.size();
+    shards[shard].push_back(page_ids[i]);
+    positions[shard].push_back(i);
+  }
+  std::vector<Page *> pages(page_ids.size(), nullptr);
+  for (size_t shard = 0; shard < instances_.size(); shard++) {
+    if (shards[shard].empty()) {
+      continue;
+    }
+    std::vector<Page *> fetched = instances_[shard]->FetchPages(shards[shard]);
+    if (fetched.empty()) {
+      for (size_t i = 0; i < pages.size(); i++) {
+        if (pages[i] != nullptr) {
+          UnpinPgImp(page_ids[i], false);
+        }
+      }
+      return {};
+    }
+    for (size_t j = 0; j < fetched.size(); j++) {
+      pages[positions[shard][j]] = fetched[j];
+    }
+  }
+  return pages;
+}
+
+auto ParallelBufferPoolManager::NewPgsImp(size_t n) -> std::vector<Page *> {
+  size_t num_instances = instances_.size();
+  size_t start = next_instance_.fetch_add(1) % num_instances;
+  for (size_t i = 0; i < num_instances; i++) {
+    std::vector<Page *> pages = instances_[(start + i) % num_instances]->NewPages(n);
+    if (!pages.empty() || n == 0) {
+      return pages;
+    }
+  }
+  return BufferPoolManager::NewPgsImp(n);
+}
+
+auto ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
+  if (page_id < 0) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPgsImp() {
+  for (auto *instance : instances_) {
+    instance->FlushAllPages();
+  }
+}
+
+}  // namespace bustub
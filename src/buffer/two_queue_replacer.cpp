@@ -0,0 +1,174 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_queue_replacer.cpp
+//
+// Identification: src/buffer/two_queue_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/two_queue_replacer.h"
+
+#include <algorithm>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+TwoQueueReplacer::TwoQueueReplacer(size_t num_frames)
+    : capacity_(num_frames),
+      kin_(std::max<size_t>(1, num_frames / 4)),
+      kout_(std::max<size_t>(1, num_frames / 2)),
+      frames_(num_frames) {}
+
+void TwoQueueReplacer::CheckFrameId(frame_id_t frame_id) const {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= capacity_) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "TwoQueueReplacer frame_id out of range");
+  }
+}
+
+auto TwoQueueReplacer::OldestEvictable(Queue queue) -> std::list<frame_id_t>::reverse_iterator {
+  auto it = queues_[queue].rbegin();
+  while (it != queues_[queue].rend() && !frames_[*it].evictable_) {
+    ++it;
+  }
+  return it;
+}
+
+auto TwoQueueReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (evictable_count_ == 0) {
+    return false;
+  }
+  Queue queue = queues_[A1IN].size() > kin_ ? A1IN : AM;
+  auto victim = OldestEvictable(queue);
+  if (victim == queues_[queue].rend()) {
+    queue = queue == A1IN ? AM : A1IN;
+    victim = OldestEvictable(queue);
+  }
+  *frame_id = *victim;
+  Frame &frame = frames_[*frame_id];
+  queues_[queue].erase(std::next(victim).base());
+  // 只有从 A1in 淘汰的页面才记录到 A1out 中, A1out 满了就丢掉最老的记录
+  if (queue == A1IN) {
+    a1out_.push_front(frame.page_id_);
+    a1out_index_[frame.page_id_] = a1out_.begin();
+    if (a1out_.size() > kout_) {
+      a1out_index_.erase(a1out_.back());
+      a1out_.pop_back();
+    }
+  }
+  frame = Frame{};
+  evictable_count_--;
+  return true;
+}
+
+void TwoQueueReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id);
+  Frame &frame = frames_[frame_id];
+  if (frame.tracked_) {
+    // A1in 中的命中不做处理, Am 中的命中移动到队头
+    if (frame.queue_ == AM) {
+      queues_[AM].splice(queues_[AM].begin(), queues_[AM], frame.pos_);
+    }
+    frame.page_id_ = page_id;
+    return;
+  }
+  Queue queue = A1IN;
+  auto ghost = a1out_index_.find(page_id);
+  if (ghost != a1out_index_.end()) {
+    a1out_.erase(ghost->second);
+    a1out_index_.erase(ghost);
+    queue = AM;
+  }
+  queues_[queue].push_front(frame_id);
+  frame.page_id_ = page_id;
+  frame.tracked_ = true;
+  frame.evictable_ = true;
+  frame.queue_ = queue;
+  frame.pos_ = queues_[queue].begin();
+  evictable_count_++;
+}
+
+void TwoQueueReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id);
+  Frame &frame = frames_[frame_id];
+  if (!frame.tracked_ || frame.evictable_ == set_evictable) {
+    return;
+  }
+  frame.evictable_ = set_evictable;
+  if (set_evictable) {
+    evictable_count_++;
+  } else {
+    evictable_count_--;
+  }
+}
+
+void TwoQueueReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id);
+  Frame &frame = frames_[frame_id];
+  if (!frame.tracked_) {
+    return;
+  }
+  if (!frame.evictable_) {
+    throw Exception(ExceptionType::INVALID, "TwoQueueReplacer cannot remove a non-evictable frame");
+  }
+  queues_[frame.queue_].erase(frame.pos_);
+  frame = Frame{};
+  evictable_count_--;
+}
+
+auto TwoQueueReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return evictable_count_;
+}
+
+auto TwoQueueReplacer::EvictionOrder(size_t max_frames) -> std::vector<frame_id_t> {
+  std::scoped_lock<std::mutex> lock(latch_);
+  std::vector<frame_id_t> order;
+  // 模拟连续的 Evict: 每淘汰一个 A1in 的帧, A1in 的大小减一
+  size_t a1in_size = queues_[A1IN].size();
+  std::list<frame_id_t>::reverse_iterator next[2] = {queues_[A1IN].rbegin(), queues_[AM].rbegin()};
+  auto skip_pinned = [&](Queue queue) {
+    while (next[queue] != queues_[queue].rend() && !frames_[*next[queue]].evictable_) {
+      ++next[queue];
+    }
+  };
+  while (order.size() < max_frames) {
+    skip_pinned(A1IN);
+    skip_pinned(AM);
+    Queue queue = a1in_size > kin_ ? A1IN : AM;
+    if (next[queue] == queues_[queue].rend()) {
+      queue = queue == A1IN ? AM : A1IN;
+      if (next[queue] == queues_[queue].rend()) {
+        break;
+      }
+    }
+    order.push_back(*next[queue]);
+    ++next[queue];
+    if (queue == A1IN) {
+      a1in_size--;
+    }
+  }
+  return order;
+}
+
+void TwoQueueReplacer::Resize(size_t num_frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  frames_.resize(num_frames);
+  capacity_ = num_frames;
+  kin_ = std::max<size_t>(1, num_frames / 4);
+  kout_ = std::max<size_t>(1, num_frames / 2);
+  while (a1out_.size() > kout_) {
+    a1out_index_.erase(a1out_.back());
+    a1out_.pop_back();
+  }
+}
+
+}  // namespace bustub
@@ -1,7 +1,11 @@
+#include <algorithm>
+#include <cctype>
 #include <optional>
 #include <shared_mutex>
 #include <string>
 #include <tuple>
+#include <unordered_set>
+#include <vector>
 
 #include "binder/binder.h"
 #include "binder/bound_expression.h"
@@ -12,6 +16,7 @@
 #include "binder/statement/select_statement.h"
 #include "binder/statement/set_show_statement.h"
 #include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
 #include "catalog/schema.h"
 #include "catalog/table_generator.h"
 #include "common/bustub_instance.h"
@@ -32,6 +37,7 @@
 #include "recovery/checkpoint_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_compressed.h"
 #include "storage/disk/disk_manager_memory.h"
 #include "type/value_factory.h"
 
@@ -41,21 +47,33 @@ auto BustubInstance::MakeExecutorContext(Transaction *txn) -> std::unique_ptr<Ex
   return std::make_unique<ExecutorContext>(txn, catalog_, buffer_pool_manager_, txn_manager_, lock_manager_);
 }
 
-BustubInstance::BustubInstance(const std::string &db_file_name) {
+BustubInstance::BustubInstance(const std::string &db_file_name, size_t bpm_instances, EvictionPolicyType policy,
+                               size_t pool_size, bool direct_io, size_t segment_pages, bool compress,
+                               size_t page_size) {
   // TODO(chi): revisit this when designing the recovery project.
 
   enable_logging = false;
 
   // Storage related.
-  disk_manager_ = new DiskManager(db_file_name);
+  if (compress) {
+    disk_manager_ = new DiskManagerCompressed(db_file_name, page_size);
+  } else {
+    disk_manager_ = new DiskManager(db_file_name, direct_io, segment_pages, page_size);
+  }
 
   // Log related.
   log_manager_ = new LogManager(disk_manager_);
 
-  // We need more frames for GenerateTestTable to work. Therefore, we use 128 instead of the default
-  // buffer pool size specified in `config.h`.
+  // We need more frames for GenerateTestTable to work. Therefore, the pool size defaults to 128 instead of the
+  // buffer pool size specified in `config.h`. When the pool is sharded, every shard gets pool_size frames.
   try {
-    buffer_pool_manager_ = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
+    if (bpm_instances > 1) {
+      buffer_pool_manager_ = new ParallelBufferPoolManager(bpm_instances, pool_size, disk_manager_, LRUK_REPLACER_K,
+                                                           log_manager_, policy);
+    } else {
+      buffer_pool_manager_ =
+          new BufferPoolManagerInstance(pool_size, disk_manager_, LRUK_REPLACER_K, log_manager_, policy);
+    }
   } catch (NotImplementedException &e) {
     std::cerr << "BufferPoolManager is not implemented, only mock tables are supported." << std::endl;
     buffer_pool_manager_ = nullptr;
@@ -129,6 +147,8 @@ void BustubInstance::CmdDisplayHelp(ResultWriter &writer) {
 
 \dt: show all tables
 \di: show all indices
+\resize <frames>: resize the buffer pool (every shard of it) to the given number of frames
+\bpm: show the buffer pool counters, and how many pages of every table and index are resident
 \help: show this message again
 
 BusTub shell currently only supports a small set of Postgres queries. We'll set
@@ -142,6 +162,111 @@ see the execution plan of your query.
   WriteOneCell(help, writer);
 }
 
+void BustubInstance::CmdResizeBufferPool(const std::string &pool_size, ResultWriter &writer) {
+  if (buffer_pool_manager_ == nullptr) {
+    throw Exception("the buffer pool is not available");
+  }
+  if (pool_size.empty() || pool_size.size() > 9 ||
+      !std::all_of(pool_size.begin(), pool_size.end(), [](char c) { return std::isdigit(c) != 0; })) {
+    throw Exception(fmt::format("invalid buffer pool size: {}", pool_size));
+  }
+  size_t frames = std::stoul(pool_size);
+  if (frames == 0 || frames > BufferPoolManagerInstance::MAX_POOL_SIZE) {
+    throw Exception(fmt::format("invalid buffer pool size: {}", pool_size));
+  }
+  bool resized;
+  if (auto *parallel = dynamic_cast<ParallelBufferPoolManager *>(buffer_pool_manager_); parallel != nullptr) {
+    resized = parallel->Resize(frames);
+  } else {
+    resized = dynamic_cast<BufferPoolManagerInstance *>(buffer_pool_manager_)->Resize(frames);
+  }
+  if (!resized) {
+    throw Exception("failed to shrink the buffer pool, some of the frames to release are pinned");
+  }
+  WriteOneCell(fmt::format("Buffer pool resized to {} frames", buffer_pool_manager_->GetPoolSize()), writer);
+}
+
+void BustubInstance::CmdDisplayBufferPool(ResultWriter &writer) {
+  if (buffer_pool_manager_ == nullptr) {
+    throw Exception("the buffer pool is not available");
+  }
+  // Take the resident set before walking the tables and indexes, which may read some of their pages.
+  auto resident_pages = buffer_pool_manager_->GetResidentPages();
+  std::unordered_set<page_id_t> resident(resident_pages.begin(), resident_pages.end());
+  auto stats = buffer_pool_manager_->GetStats();
+
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  writer.WriteHeaderCell("counter");
+  writer.WriteHeaderCell("value");
+  writer.EndHeader();
+  auto write_counter = [&writer](const std::string &name, const std::string &value) {
+    writer.BeginRow();
+    writer.WriteCell(name);
+    writer.WriteCell(value);
+    writer.EndRow();
+  };
+  write_counter("pool_size", fmt::format("{}", stats.pool_size_));
+  write_counter("resident_pages", fmt::format("{}", stats.resident_pages_));
+  write_counter("dirty_pages", fmt::format("{}", stats.dirty_pages_));
+  write_counter("hits", fmt::format("{}", stats.hits_));
+  write_counter("misses", fmt::format("{}", stats.misses_));
+  write_counter("hit_ratio", fmt::format("{:.4f}", stats.HitRatio()));
+  write_counter("evictions", fmt::format("{}", stats.evictions_));
+  write_counter("dirty_writebacks", fmt::format("{}", stats.dirty_writebacks_));
+  write_counter("flushes", fmt::format("{}", stats.flushes_));
+  write_counter("pin_waits", fmt::format("{}", stats.pin_waits_));
+  write_counter("no_free_frames", fmt::format("{}", stats.no_free_frames_));
+  writer.EndTable();
+
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  writer.WriteHeaderCell("io_latency");
+  writer.WriteHeaderCell("reads");
+  writer.WriteHeaderCell("writes");
+  writer.EndHeader();
+  for (size_t i = 0; i < LatencyHistogram::NUM_BUCKETS; i++) {
+    if (stats.read_latency_[i] == 0 && stats.write_latency_[i] == 0) {
+      continue;
+    }
+    writer.BeginRow();
+    writer.WriteCell(LatencyHistogram::BucketLabel(i));
+    writer.WriteCell(fmt::format("{}", stats.read_latency_[i]));
+    writer.WriteCell(fmt::format("{}", stats.write_latency_[i]));
+    writer.EndRow();
+  }
+  writer.EndTable();
+
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  writer.WriteHeaderCell("name");
+  writer.WriteHeaderCell("kind");
+  writer.WriteHeaderCell("pages");
+  writer.WriteHeaderCell("resident");
+  writer.EndHeader();
+  auto write_object = [&](const std::string &name, const std::string &kind, const std::vector<page_id_t> &page_ids) {
+    auto count = std::count_if(page_ids.begin(), page_ids.end(),
+                               [&resident](page_id_t page_id) { return resident.count(page_id) > 0; });
+    writer.BeginRow();
+    writer.WriteCell(name);
+    writer.WriteCell(kind);
+    writer.WriteCell(fmt::format("{}", page_ids.size()));
+    writer.WriteCell(fmt::format("{}", count));
+    writer.EndRow();
+  };
+  std::shared_lock<std::shared_mutex> l(catalog_lock_);
+  for (const auto &table_name : catalog_->GetTableNames()) {
+    const auto *table_info = catalog_->GetTable(table_name);
+    if (table_info->table_ != nullptr) {
+      write_object(table_name, "table", table_info->table_->GetPageIds());
+    }
+    for (auto *index_info : catalog_->GetTableIndexes(table_name)) {
+      write_object(index_info->name_, "index", index_info->index_->GetPageIds());
+    }
+  }
+  writer.EndTable();
+}
+
 void BustubInstance::ExecuteSql(const std::string &sql, ResultWriter &writer) {
   auto txn = txn_manager_->Begin();
   ExecuteSqlTxn(sql, writer, txn);
@@ -164,6 +289,14 @@ void BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
       CmdDisplayHelp(writer);
       return;
     }
+    if (sql == "\\bpm") {
+      CmdDisplayBufferPool(writer);
+      return;
+    }
+    if (StringUtil::StartsWith(sql, "\\resize ")) {
+      CmdResizeBufferPool(sql.substr(8), writer);
+      return;
+    }
     throw Exception(fmt::format("unsupported internal command: {}", sql));
   }
 
@@ -352,10 +485,22 @@ void BustubInstance::GenerateMockTable() {
   delete txn;
 }
 
+void BustubInstance::EnableWarmStart(const std::string &file_name) {
+  if (buffer_pool_manager_ == nullptr) {
+    return;
+  }
+  warm_start_file_ = file_name;
+  buffer_pool_manager_->WarmStart(file_name);
+}
+
 BustubInstance::~BustubInstance() {
   if (enable_logging) {
     log_manager_->StopFlushThread();
   }
+  if (!warm_start_file_.empty()) {
+    buffer_pool_manager_->FlushAllPages();
+    buffer_pool_manager_->SaveResidentPages(warm_start_file_);
+  }
   delete execution_engine_;
   delete catalog_;
   delete checkpoint_manager_;
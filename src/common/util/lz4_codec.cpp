@@ -0,0 +1,182 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz4_codec.cpp
+//
+// Identification: src/common/util/lz4_codec.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/lz4_codec.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace bustub {
+
+namespace {
+
+constexpr size_t MIN_MATCH = 4;
+/** The last bytes of the input are always literals. */
+constexpr size_t LAST_LITERALS = 5;
+/** No match starts in the last MF_LIMIT bytes of the input. */
+constexpr size_t MF_LIMIT = 12;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr int HASH_BITS = 12;
+
+auto Read32(const uint8_t *p) -> uint32_t {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+auto Hash(uint32_t sequence) -> uint32_t { return (sequence * 2654435761U) >> (32 - HASH_BITS); }
+
+/** Writes the sequences of the compressed data, failing once they no longer fit. */
+class SequenceWriter {
+ public:
+  SequenceWriter(uint8_t *dst, size_t capacity) : dst_(dst), capacity_(capacity) {}
+
+  /** Write literals followed by a match, or by nothing for the last sequence (match_length 0). */
+  auto Write(const uint8_t *literals, size_t literal_length, size_t offset, size_t match_length) -> bool {
+    size_t needed = 1 + literal_length / 255 + 1 + literal_length + 2 + match_length / 255 + 1;
+    if (size_ + needed > capacity_) {
+      return false;
+    }
+    uint8_t &token = dst_[size_++];
+    token = static_cast<uint8_t>(std::min<size_t>(literal_length, 15) << 4);
+    WriteLength(literal_length);
+    memcpy(dst_ + size_, literals, literal_length);
+    size_ += literal_length;
+    if (match_length == 0) {
+      return true;
+    }
+    dst_[size_++] = static_cast<uint8_t>(offset);
+    dst_[size_++] = static_cast<uint8_t>(offset >> 8);
+    token |= static_cast<uint8_t>(std::min<size_t>(match_length - MIN_MATCH, 15));
+    WriteLength(match_length - MIN_MATCH);
+    return true;
+  }
+
+  auto GetSize() const -> size_t { return size_; }
+
+ private:
+  /** The part of a length that does not fit in its 4 bits of the token, in bytes of 255 and a last smaller one. */
+  void WriteLength(size_t length) {
+    if (length < 15) {
+      return;
+    }
+    for (length -= 15; length >= 255; length -= 255) {
+      dst_[size_++] = 255;
+    }
+    dst_[size_++] = static_cast<uint8_t>(length);
+  }
+
+  uint8_t *dst_;
+  size_t capacity_;
+  size_t size_{0};
+};
+
+}  // namespace
+
+auto Lz4Codec::Compress(const char *src, size_t size, char *dst, size_t capacity) -> size_t {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  SequenceWriter writer(reinterpret_cast<uint8_t *>(dst), capacity);
+  size_t anchor = 0;
+  if (size > MF_LIMIT) {
+    // 记录每个 4 字节前缀最后出现的位置 + 1, 0 表示还没有出现过
+    std::vector<uint32_t> table(1 << HASH_BITS, 0);
+    size_t ip = 0;
+    while (ip < size - MF_LIMIT) {
+      uint32_t sequence = Read32(in + ip);
+      uint32_t &entry = table[Hash(sequence)];
+      size_t candidate = entry;
+      entry = static_cast<uint32_t>(ip + 1);
+      if (candidate == 0 || ip - (candidate - 1) > MAX_OFFSET || Read32(in + candidate - 1) != sequence) {
+        ip++;
+        continue;
+      }
+      size_t ref = candidate - 1;
+      // 匹配向前延伸到上一个序列的结尾, 向后延伸到最后的字面量之前
+      while (ip > anchor && ref > 0 && in[ip - 1] == in[ref - 1]) {
+        ip--;
+        ref--;
+      }
+      size_t length = 0;
+      while (ip + length < size - LAST_LITERALS && in[ip + length] == in[ref + length]) {
+        length++;
+      }
+      if (!writer.Write(in + anchor, ip - anchor, ip - ref, length)) {
+        return 0;
+      }
+      ip += length;
+      anchor = ip;
+    }
+  }
+  if (!writer.Write(in + anchor, size - anchor, 0, 0)) {
+    return 0;
+  }
+  return writer.GetSize();
+}
+
+auto Lz4Codec::Decompress(const char *src, size_t size, char *dst, size_t capacity) -> size_t {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  auto *out = reinterpret_cast<uint8_t *>(dst);
+  size_t ip = 0;
+  size_t op = 0;
+  // 长度超过 4 位的部分跟在后面, 每个字节最多 255, 最后一个字节小于 255
+  auto read_length = [&](size_t *length) -> bool {
+    if (*length < 15) {
+      return true;
+    }
+    uint8_t byte;
+    do {
+      if (ip >= size) {
+        return false;
+      }
+      byte = in[ip++];
+      *length += byte;
+    } while (byte == 255);
+    return true;
+  };
+  while (ip < size) {
+    uint8_t token = in[ip++];
+    size_t literal_length = token >> 4;
+    if (!read_length(&literal_length) || literal_length > size - ip || literal_length > capacity - op) {
+      return 0;
+    }
+    memcpy(out + op, in + ip, literal_length);
+    ip += literal_length;
+    op += literal_length;
+    // 最后一个序列只有字面量
+    if (ip == size) {
+      return op;
+    }
+    if (size - ip < 2) {
+      return 0;
+    }
+    size_t offset = in[ip] | (static_cast<size_t>(in[ip + 1]) << 8);
+    ip += 2;
+    size_t match_length = token & 15;
+    if (offset == 0 || offset > op || !read_length(&match_length)) {
+      return 0;
+    }
+    match_length += MIN_MATCH;
+    if (match_length > capacity - op) {
+      return 0;
+    }
+    // 匹配可以和自己重叠, 逐字节复制
+    for (size_t i = 0; i < match_length; i++) {
+      out[op + i] = out[op - offset + i];
+    }
+    op += match_length;
+  }
+  return 0;
+}
+
+}  // namespace bustub
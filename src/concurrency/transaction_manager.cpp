@@ -33,6 +33,11 @@ auto TransactionManager::Begin(Transaction *txn, IsolationLevel isolation_level)
   txn_map_mutex.lock();
   txn_map[txn->GetTransactionId()] = txn;
   txn_map_mutex.unlock();
+
+  if (enable_logging && log_manager_ != nullptr) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::BEGIN);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(&log_record));
+  }
   return txn;
 }
 
@@ -52,6 +57,14 @@ void TransactionManager::Commit(Transaction *txn) {
   }
   write_set->clear();
 
+  // Wait until the commit record is durable. Transactions committing at the same time share one log flush.
+  if (enable_logging && log_manager_ != nullptr) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::COMMIT);
+    lsn_t lsn = log_manager_->AppendLogRecord(&log_record);
+    txn->SetPrevLSN(lsn);
+    log_manager_->Flush(lsn);
+  }
+
   // Release all the locks.
   ReleaseLocks(txn);
   // Release the global transaction latch.
@@ -102,6 +115,11 @@ void TransactionManager::Abort(Transaction *txn) {
   table_write_set->clear();
   index_write_set->clear();
 
+  if (enable_logging && log_manager_ != nullptr) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ABORT);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(&log_record));
+  }
+
   // Release all the locks.
   ReleaseLocks(txn);
   // Release the global transaction latch.
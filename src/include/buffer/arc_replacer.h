@@ -0,0 +1,110 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.h
+//
+// Identification: src/include/buffer/arc_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/eviction_policy.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ArcReplacer implements the Adaptive Replacement Cache policy (Megiddo and Modha, FAST 2003).
+ *
+ * Resident frames live in one of two LRU lists: T1 holds pages seen once since they were loaded, T2 pages seen at
+ * least twice. Two ghost lists remember the ids of pages recently evicted from T1 (B1) and T2 (B2). A miss on a page
+ * in B1 means T1 was too small and grows the target size p of T1; a miss on a page in B2 shrinks it. Eviction takes
+ * the LRU frame of T1 while T1 is larger than p, and the LRU frame of T2 otherwise. Ghosts are trimmed so that
+ * |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c for c frames.
+ *
+ * The buffer pool evicts before it knows which page it will load, so the tie rule of the original REPLACE, which
+ * looks at whether the missing page is in B2, is not applied. Non-evictable frames are skipped.
+ */
+class ArcReplacer : public EvictionPolicy {
+ public:
+  /**
+   * @brief Create a new ArcReplacer.
+   * @param num_frames the maximum number of frames the replacer will be required to store
+   */
+  explicit ArcReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(ArcReplacer);
+
+  ~ArcReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  auto EvictionOrder(size_t max_frames) -> std::vector<frame_id_t> override;
+
+  void Resize(size_t num_frames) override;
+
+  /** @return the current target size of T1 */
+  auto GetTarget() -> size_t;
+
+ private:
+  enum List { T1 = 0, T2 = 1 };
+
+  struct Frame {
+    page_id_t page_id_{INVALID_PAGE_ID};
+    bool tracked_{false};
+    bool evictable_{false};
+    List list_{T1};
+    std::list<frame_id_t>::iterator pos_;
+  };
+
+  struct Ghost {
+    List list_;
+    std::list<page_id_t>::iterator pos_;
+  };
+
+  void CheckFrameId(frame_id_t frame_id) const;
+
+  /** @return the least recently used evictable frame of list, or resident_[list].rend() */
+  auto LruEvictable(List list) -> std::list<frame_id_t>::reverse_iterator;
+
+  /** Remember page_id as evicted from list, at the MRU end of its ghost list. */
+  void AddGhost(List list, page_id_t page_id);
+
+  void DropLruGhost(List list);
+
+  /** Trim the ghost lists down to the bounds of ARC. */
+  void TrimGhosts();
+
+  size_t capacity_;
+  /** The target size of T1. */
+  size_t target_{0};
+  size_t evictable_count_{0};
+  std::mutex latch_;
+  std::vector<Frame> frames_;
+  /** T1 and T2, most recently used first. */
+  std::list<frame_id_t> resident_[2];
+  /** B1 and B2, most recently evicted first. */
+  std::list<page_id_t> ghost_lists_[2];
+  std::unordered_map<page_id_t, Ghost> ghosts_;
+};
+
+}  // namespace bustub
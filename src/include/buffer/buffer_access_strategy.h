@@ -0,0 +1,68 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+class BufferPoolManagerInstance;
+
+/**
+ * BufferAccessStrategy confines a bulk operation (a sequential scan, a bulk insert, building an index) to a small
+ * private ring of frames.
+ *
+ * Pages that the operation misses on are read into the frames of its ring, which the buffer pool recycles in a
+ * round robin manner as long as they are unpinned and still hold the page the ring put there. Only when the frame
+ * at the current position of the ring cannot be recycled does the buffer pool take a frame the normal way and add
+ * it to the ring. A scan of a table much larger than the pool therefore evicts about one ring worth of pages instead
+ * of the whole pool. Hits on pages that are already resident are served normally.
+ *
+ * A strategy belongs to one operation and is not thread-safe. It must not outlive the buffer pool it is used with.
+ */
+class BufferAccessStrategy {
+ public:
+  /** One position of the ring: a frame of a buffer pool instance and the page the ring put in it. */
+  struct Slot {
+    BufferPoolManagerInstance *owner_{nullptr};
+    frame_id_t frame_id_{-1};
+    page_id_t page_id_{INVALID_PAGE_ID};
+  };
+
+  /**
+   * @brief Create a strategy with an empty ring.
+   * @param ring_size the number of frames the operation may use
+   */
+  explicit BufferAccessStrategy(size_t ring_size = RING_BUFFER_SIZE) : ring_(ring_size == 0 ? 1 : ring_size) {}
+
+  DISALLOW_COPY_AND_MOVE(BufferAccessStrategy);
+
+  /** @return the number of frames in the ring */
+  auto GetRingSize() const -> size_t { return ring_.size(); }
+
+  /** @brief Advance to the next position of the ring, whose frame the buffer pool should recycle next. */
+  auto NextSlot() -> Slot & {
+    current_ = (current_ + 1) % ring_.size();
+    return ring_[current_];
+  }
+
+ private:
+  std::vector<Slot> ring_;
+  size_t current_{0};
+};
+
+}  // namespace bustub
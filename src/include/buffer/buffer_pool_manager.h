@@ -14,12 +14,17 @@
 
 #include <list>
 #include <mutex>  // NOLINT
+#include <string>
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_stats.h"
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
@@ -31,6 +36,8 @@ class BufferPoolManager {
   enum class CallbackType { BEFORE, AFTER };
   using bufferpool_callback_fn = void (*)(enum CallbackType, const page_id_t page_id);
 
+  friend class BasicPageGuard;
+
   BufferPoolManager() = default;
   /**
    * Destroys an existing BufferPoolManager.
@@ -84,9 +91,191 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Fetch a page for a bulk operation. A miss reads the page into a frame of the ring of strategy instead of
+   * evicting from the whole pool. See BufferAccessStrategy.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the operation
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPage(page_id_t page_id, BufferAccessStrategy &strategy) -> Page * {
+    return FetchPgWithStrategyImp(page_id, &strategy);
+  }
+
+  /**
+   * Create a new page for a bulk operation, in a frame of the ring of strategy. See BufferAccessStrategy.
+   * @param[out] page_id id of created page
+   * @param strategy the access strategy of the operation
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPage(page_id_t *page_id, BufferAccessStrategy &strategy) -> Page * {
+    return NewPgWithStrategyImp(page_id, &strategy);
+  }
+
+  /**
+   * Fetch a page and pin it for as long as the returned guard lives. See BasicPageGuard.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the operation, nullptr for a normal fetch
+   * @return the guard of the page, empty if page_id cannot be fetched
+   */
+  auto FetchPageBasic(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) -> BasicPageGuard {
+    BufferPoolManager *owner = OwnerOf(page_id);
+    return {owner, owner->FetchPgWithStrategyImp(page_id, strategy)};
+  }
+
+  /**
+   * Fetch a page, pin it and take its read latch for as long as the returned guard lives. See ReadPageGuard.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the operation, nullptr for a normal fetch
+   * @return the guard of the page, empty if page_id cannot be fetched
+   */
+  auto FetchPageRead(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) -> ReadPageGuard {
+    BufferPoolManager *owner = OwnerOf(page_id);
+    return {owner, owner->FetchPgWithStrategyImp(page_id, strategy)};
+  }
+
+  /**
+   * Fetch a page, pin it and take its write latch for as long as the returned guard lives. See WritePageGuard.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the operation, nullptr for a normal fetch
+   * @return the guard of the page, empty if page_id cannot be fetched
+   */
+  auto FetchPageWrite(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) -> WritePageGuard {
+    BufferPoolManager *owner = OwnerOf(page_id);
+    return {owner, owner->FetchPgWithStrategyImp(page_id, strategy)};
+  }
+
+  /**
+   * Create a new page and pin it for as long as the returned guard lives. See BasicPageGuard.
+   * @param[out] page_id id of created page
+   * @param strategy the access strategy of the operation, nullptr for a normal new page
+   * @return the guard of the page, empty if no new pages could be created
+   */
+  auto NewPageGuarded(page_id_t *page_id, BufferAccessStrategy *strategy = nullptr) -> BasicPageGuard {
+    Page *page = NewPgWithStrategyImp(page_id, strategy);
+    return {page == nullptr ? this : OwnerOf(*page_id), page};
+  }
+
+  /**
+   * Create a new page for an object, e.g. a table or an index, in one of the extents reserved for it, so that the
+   * pages of the object are next to each other on disk. A new extent is reserved when the ones of the object are used
+   * up. See ExtentMap.
+   * @param[out] page_id id of created page
+   * @param[in,out] extent_owner the object, identified by a page id that is stable for it such as its first page;
+   * INVALID_PAGE_ID for a new object, in which case it is set to the id of the created page
+   * @param strategy the access strategy of the operation, nullptr for a normal new page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPageInExtent(page_id_t *page_id, page_id_t *extent_owner, BufferAccessStrategy *strategy = nullptr)
+      -> Page * {
+    return NewPgInExtentImp(page_id, extent_owner, strategy);
+  }
+
+  /**
+   * Create a new page in an extent of an object like NewPageInExtent(), pinned for as long as the returned guard
+   * lives. See BasicPageGuard.
+   * @param[out] page_id id of created page
+   * @param[in,out] extent_owner the object, INVALID_PAGE_ID for a new object
+   * @param strategy the access strategy of the operation, nullptr for a normal new page
+   * @return the guard of the page, empty if no new pages could be created
+   */
+  auto NewPageInExtentGuarded(page_id_t *page_id, page_id_t *extent_owner, BufferAccessStrategy *strategy = nullptr)
+      -> BasicPageGuard {
+    Page *page = NewPgInExtentImp(page_id, extent_owner, strategy);
+    return {page == nullptr ? this : OwnerOf(*page_id), page};
+  }
+
+  /**
+   * Fetch several pages at once, e.g. the pages touched by a split or merge of an index. The resident pages are
+   * pinned and the frames for the missing ones are claimed under one acquisition of the latch of the buffer pool, and
+   * the misses are read in batches. All pages are pinned, or none: if there are not enough frames for the missing
+   * pages, the pages pinned so far are unpinned again.
+   * @param page_ids ids of the pages to be fetched, a page id may appear more than once
+   * @return the pages in the order of page_ids, empty if they cannot all be fetched
+   */
+  auto FetchPages(const std::vector<page_id_t> &page_ids) -> std::vector<Page *> { return FetchPgsImp(page_ids); }
+
+  /**
+   * Fetch several pages at once like FetchPages(), each pinned for as long as its guard lives.
+   * @param page_ids ids of the pages to be fetched
+   * @return the guards of the pages in the order of page_ids, empty if they cannot all be fetched
+   */
+  auto FetchPagesBasic(const std::vector<page_id_t> &page_ids) -> std::vector<BasicPageGuard> {
+    std::vector<BasicPageGuard> guards;
+    std::vector<Page *> pages = FetchPgsImp(page_ids);
+    guards.reserve(pages.size());
+    for (size_t i = 0; i < pages.size(); i++) {
+      guards.emplace_back(OwnerOf(page_ids[i]), pages[i]);
+    }
+    return guards;
+  }
+
+  /**
+   * Create several new pages at once, claiming all their frames under one acquisition of the latch of the buffer
+   * pool. All pages are created, or none.
+   * @param n number of pages to create
+   * @return the new pages, empty if n pages could not be created
+   */
+  auto NewPages(size_t n) -> std::vector<Page *> { return NewPgsImp(n); }
+
   /** @return size of the buffer pool */
   virtual auto GetPoolSize() -> size_t = 0;
 
+  /** @return the size of the pages of the database in bytes, which every page layout is sized for */
+  virtual auto GetPageSize() -> size_t = 0;
+
+  /**
+   * Ask the buffer pool to load pages in the background, e.g. the next pages of a scan.
+   * The pages are read into free or evictable frames and are left unpinned; a later FetchPage of a prefetched page
+   * is a hit. Prefetching is a hint: requests for resident pages, or that find no frame to load into, are dropped.
+   * Prefetched pages do not go into the ring of a BufferAccessStrategy, so scans that use one should not prefetch.
+   * The default implementation does nothing.
+   * @param page_ids ids of the pages to load
+   */
+  virtual void PrefetchPages(__attribute__((unused)) const std::vector<page_id_t> &page_ids) {}
+
+  /**
+   * Ask the buffer pool to load the n pages starting at page id first in the background. See PrefetchPages.
+   * @param first id of the first page to load
+   * @param n number of consecutive page ids to load
+   */
+  void Prefetch(page_id_t first, size_t n) {
+    std::vector<page_id_t> page_ids(n);
+    for (size_t i = 0; i < n; i++) {
+      page_ids[i] = first + static_cast<page_id_t>(i);
+    }
+    PrefetchPages(page_ids);
+  }
+
+  /**
+   * Write the ids of the resident pages, with their access history, to a sidecar file, e.g. on clean shutdown after
+   * FlushAllPages(). A later WarmStart() from that file brings the same pages back into the pool.
+   * The default implementation writes nothing.
+   * @param file_name the sidecar file
+   * @return false if the file could not be written
+   */
+  virtual auto SaveResidentPages(__attribute__((unused)) const std::string &file_name) -> bool { return false; }
+
+  /**
+   * Reload the pages saved by SaveResidentPages() in the background, while the buffer pool serves requests.
+   * The default implementation loads nothing.
+   * @param file_name the sidecar file
+   * @return false if the file could not be read
+   */
+  virtual auto WarmStart(__attribute__((unused)) const std::string &file_name) -> bool { return false; }
+
+  /**
+   * @return a snapshot of the hit, miss, eviction and I/O counters of the buffer pool. The default implementation
+   * counts nothing.
+   */
+  virtual auto GetStats() -> BufferPoolStats { return {}; }
+
+  /**
+   * @return the ids of the pages that are resident in the buffer pool, in no particular order. The default
+   * implementation returns none.
+   */
+  virtual auto GetResidentPages() -> std::vector<page_id_t> { return {}; }
+
  protected:
   /**
    * Grading function. Do not modify!
@@ -141,5 +330,106 @@ class BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   virtual void FlushAllPgsImp() = 0;
+
+  /**
+   * Fetch several pages, all of them or none. The default fetches the pages one by one.
+   * @param page_ids ids of the pages to be fetched
+   * @return the pages in the order of page_ids, empty if they cannot all be fetched
+   */
+  virtual auto FetchPgsImp(const std::vector<page_id_t> &page_ids) -> std::vector<Page *> {
+    std::vector<Page *> pages;
+    for (page_id_t page_id : page_ids) {
+      Page *page = FetchPgImp(page_id);
+      if (page == nullptr) {
+        UnpinAll(pages, false);
+        return {};
+      }
+      pages.push_back(page);
+    }
+    return pages;
+  }
+
+  /**
+   * Create several new pages, all of them or none. The default creates the pages one by one; if it runs out of
+   * frames, the pages created so far are deleted again.
+   * @param n number of pages to create
+   * @return the new pages, empty if n pages could not be created
+   */
+  virtual auto NewPgsImp(size_t n) -> std::vector<Page *> {
+    std::vector<Page *> pages;
+    for (size_t i = 0; i < n; i++) {
+      page_id_t page_id;
+      Page *page = NewPgImp(&page_id);
+      if (page == nullptr) {
+        UnpinAll(pages, false);
+        for (Page *created : pages) {
+          DeletePgImp(created->GetPageId());
+        }
+        return {};
+      }
+      pages.push_back(page);
+    }
+    return pages;
+  }
+
+  /** Unpin each of pages once, e.g. to undo a batch that could not be completed. */
+  void UnpinAll(const std::vector<Page *> &pages, bool is_dirty) {
+    for (Page *page : pages) {
+      UnpinPgImp(page->GetPageId(), is_dirty);
+    }
+  }
+
+  /**
+   * Unpin a page pinned by a page guard. The guard still holds the pin, so an implementation can go straight to the
+   * frame of the page. The default looks the page up like UnpinPage().
+   * @param page the page to unpin
+   * @param is_dirty true if the page was modified through the guard
+   */
+  virtual void ReleasePage(Page *page, bool is_dirty) { UnpinPgImp(page->GetPageId(), is_dirty); }
+
+  /**
+   * @return the buffer pool that holds page_id, which page guards unpin through. The default is this buffer pool; a
+   * parallel buffer pool returns its instance, so guards skip the routing when they unpin.
+   */
+  virtual auto OwnerOf(__attribute__((unused)) page_id_t page_id) -> BufferPoolManager * { return this; }
+
+  /**
+   * Fetch the requested page, confining misses to the ring of strategy. The default ignores the strategy.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy, nullptr for a normal fetch
+   * @return the requested page
+   */
+  virtual auto FetchPgWithStrategyImp(page_id_t page_id, __attribute__((unused)) BufferAccessStrategy *strategy)
+      -> Page * {
+    return FetchPgImp(page_id);
+  }
+
+  /**
+   * Creates a new page in a frame of the ring of strategy. The default ignores the strategy.
+   * @param[out] page_id id of created page
+   * @param strategy the access strategy, nullptr for a normal new page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual auto NewPgWithStrategyImp(page_id_t *page_id, __attribute__((unused)) BufferAccessStrategy *strategy)
+      -> Page * {
+    return NewPgImp(page_id);
+  }
+
+  /**
+   * Creates a new page in an extent of extent_owner. The default ignores the extents and only names a new owner
+   * after its first page.
+   * @param[out] page_id id of created page
+   * @param[in,out] extent_owner the object the page is for, INVALID_PAGE_ID for a new object
+   * @param strategy the access strategy, nullptr for a normal new page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual auto NewPgInExtentImp(page_id_t *page_id, page_id_t *extent_owner, BufferAccessStrategy *strategy)
+      -> Page * {
+    Page *page = NewPgWithStrategyImp(page_id, strategy);
+    if (page != nullptr && *extent_owner == INVALID_PAGE_ID) {
+      *extent_owner = *page_id;
+    }
+    return page;
+  }
 };
 }  // namespace bustub
@@ -12,17 +12,27 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <list>
+#include <memory>
 #include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
-#include "buffer/lru_k_replacer.h"
+#include "buffer/eviction_policy.h"
+#include "buffer/page_table.h"
 #include "common/config.h"
 #include "common/logger.h"
-#include "container/hash/extendible_hash_table.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_scheduler.h"
 #include "storage/page/page.h"
 
 namespace bustub {
@@ -38,26 +48,129 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param disk_manager the disk manager
    * @param replacer_k the lookback constant k for the LRU-K replacer
    * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param policy the replacement policy
    */
   BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, EvictionPolicyType policy = EvictionPolicyType::LRU_K);
+
+  /**
+   * @brief Creates a new BufferPoolManagerInstance that is one shard of a ParallelBufferPoolManager.
+   * @param pool_size the size of the buffer pool
+   * @param num_instances total number of BPIs in the parallel BPM
+   * @param instance_index index of this BPI in the parallel BPM
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer
+   * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param policy the replacement policy
+   */
+  BufferPoolManagerInstance(size_t pool_size, size_t num_instances, size_t instance_index, DiskManager *disk_manager,
+                            size_t replacer_k = LRUK_REPLACER_K, LogManager *log_manager = nullptr,
+                            EvictionPolicyType policy = EvictionPolicyType::LRU_K);
 
   /**
    * @brief Destroy an existing BufferPoolManagerInstance.
    */
   ~BufferPoolManagerInstance() override;
 
+  /** The largest pool an instance can grow to. */
+  static constexpr size_t MAX_POOL_SIZE = 1 << 20;
+
   /** @brief Return the size (number of frames) of the buffer pool. */
   auto GetPoolSize() -> size_t override { return pool_size_; }
 
-  /** @brief Return the pointer to all the pages in the buffer pool. */
-  auto GetPages() -> Page * { return pages_; }
+  /** @brief Return the page size of the database, the size of the page data of every frame. */
+  auto GetPageSize() -> size_t override { return page_size_; }
+
+  /**
+   * @brief Return the page in a frame of the buffer pool.
+   * @param frame_id a frame id in [0, GetPoolSize())
+   */
+  auto GetPageInFrame(frame_id_t frame_id) -> Page * { return PageOf(frame_id); }
+
+  /**
+   * @brief Grow or shrink the buffer pool while it is in use.
+   *
+   * Growing adds frames to the free list. Shrinking drains the frames at the end of the pool: their pages are
+   * written back if dirty and dropped from the pool, then the frames are released. Shrinking fails without changing
+   * anything if one of those frames is pinned or has I/O in progress. The dirty pages are written back in runs with
+   * the pool latch released, while the frames are marked I/O in progress so that threads looking their pages up wait;
+   * if a write fails, shrinking is given up and the pages stay resident and dirty.
+   *
+   * Frames are allocated in chunks, one per growth, and a chunk is freed once the pool shrinks below its first
+   * frame, so Page pointers never move while the pool is resized.
+   *
+   * @param pool_size the new number of frames, at least 1 and at most MAX_POOL_SIZE
+   * @return false if the pool could not be shrunk because a frame to release is in use, or a dirty page of one could
+   * not be written back
+   */
+  auto Resize(size_t pool_size) -> bool;
+
+  /**
+   * @brief Start the background writer thread of this instance.
+   *
+   * Every interval the writer wakes up and, if at least dirty_ratio of the frames are dirty, writes up to
+   * max_pages dirty and unpinned pages back to disk, taking them in the order the replacer would evict them.
+   * The pages stay resident, so the next eviction of those frames does not have to write on the fetch path.
+   * Calling this while the writer is already running has no effect.
+   *
+   * @param interval how long the writer sleeps between two rounds
+   * @param max_pages the maximum number of pages written in one round
+   * @param dirty_ratio the fraction of dirty frames below which a round writes nothing
+   */
+  void StartBackgroundWriter(std::chrono::milliseconds interval = bgwriter_interval,
+                             size_t max_pages = BGWRITER_MAX_PAGES, double dirty_ratio = BGWRITER_DIRTY_RATIO);
+
+  /**
+   * @brief Stop the background writer thread and wait for it to exit. Does nothing if the writer is not running.
+   */
+  void StopBackgroundWriter();
+
+  /**
+   * @brief Queue pages to be read into free or evictable frames by the prefetch thread of this instance, which is
+   * started on the first call. The pages are left unpinned. Requests beyond PREFETCH_QUEUE_SIZE pending pages are
+   * dropped.
+   * @param page_ids ids of the pages to load, all owned by this instance
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids) override;
+
+  /**
+   * @brief Write the resident pages to a sidecar file: their ids, coldest first, with the number of accesses the
+   * replacer remembers for each, and the next page id of the allocator. The file is written under a temporary name
+   * and then renamed, so a crash never leaves a torn file behind.
+   * @param file_name the sidecar file
+   * @return false if the file could not be written
+   */
+  auto SaveResidentPages(const std::string &file_name) -> bool override;
+
+  /**
+   * @brief Reload the pages saved by SaveResidentPages() on a background thread.
+   *
+   * The allocator first skips every page id in the file, so new pages never collide with reloaded ones. The pages
+   * of this instance are then read in page id order, each run of consecutive ids with one sequential read, into
+   * free frames only: the reload never evicts a page the workload brought in, and stops when the free frames run
+   * out. Reloaded pages stay pinned until the whole set is in; then their access history is replayed in the saved
+   * order and they become evictable.
+   *
+   * @param file_name the sidecar file
+   * @return false if the file could not be read or a warm start was started already
+   */
+  auto WarmStart(const std::string &file_name) -> bool override;
+
+  /** @brief Wait until the reload started by WarmStart() is done. Returns at once if there is none. */
+  void WaitForWarmStart();
+
+  /** @brief Return a snapshot of the counters of this instance. */
+  auto GetStats() -> BufferPoolStats override;
+
+  /** @brief Return the ids of the pages in the frames of this instance. */
+  auto GetResidentPages() -> std::vector<page_id_t> override;
 
   void Debug() {
     LOG_INFO("当前的缓冲区里面是：");
     for (size_t i = 0; i < pool_size_; i++) {
-      LOG_INFO("page id is [%d], is_dirty is [%d], pin_count is [%d]", pages_[i].GetPageId(), pages_[i].is_dirty_,
-               pages_[i].pin_count_);
+      Page *page = PageOf(static_cast<frame_id_t>(i));
+      LOG_INFO("page id is [%d], is_dirty is [%d], pin_count is [%d]", page->GetPageId(),
+               static_cast<int>(page->IsDirty()), page->GetPinCount());
     }
   }
 
@@ -117,6 +230,14 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   auto UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool override;
 
+  /**
+   * @brief Unpin a page pinned by a page guard. The page knows its frame, so this is one atomic decrement of the pin
+   * count; latch_ is only taken when the last pin of a frame the replacer holds as non-evictable goes away.
+   * @param page the page to unpin
+   * @param is_dirty true if the page should be marked as dirty
+   */
+  void ReleasePage(Page *page, bool is_dirty) override;
+
   /**
    * TODO(P1): Add implementation
    *
@@ -133,19 +254,70 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /**
    * TODO(P1): Add implementation
    *
-   * @brief Flush all the pages in the buffer pool to disk.
+   * @brief Flush all the pages in the buffer pool to disk, then make them durable with DiskManager::Sync().
+   *
+   * The dirty pages are written in page id order, FLUSH_BATCH_SIZE at a time, and every run of consecutive page ids in
+   * a batch is written with one DiskManager::WritePages(), so a flush of many dirty pages is mostly large sequential
+   * writes.
    */
   void FlushAllPgsImp() override;
 
+  /**
+   * @brief Fetch the requested page. Like FetchPgImp(), but a miss recycles the frame at the next position of the
+   * ring of strategy if it can, and otherwise adds the frame it takes to the ring.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy, nullptr for a normal fetch
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /**
+   * @brief Create a new page. Like NewPgImp(), but in a frame of the ring of strategy.
+   * @param[out] page_id id of created page
+   * @param strategy the access strategy, nullptr for a normal new page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPgWithStrategyImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /**
+   * @brief Create a new page like NewPgWithStrategyImp(), taking its page id from an extent of extent_owner of this
+   * instance, or from a new extent of EXTENT_PAGES pages of this instance.
+   * @param[out] page_id id of created page
+   * @param[in,out] extent_owner the object the page is for, INVALID_PAGE_ID for a new object; nullptr to allocate the
+   * page outside of any extent
+   * @param strategy the access strategy, nullptr for a normal new page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPgInExtentImp(page_id_t *page_id, page_id_t *extent_owner, BufferAccessStrategy *strategy)
+      -> Page * override;
+
+  /**
+   * @brief Fetch several pages, all of them or none. Resident pages are pinned on the unlatched hit path first. The
+   * misses then take latch_ once: pages that became resident meanwhile are pinned, and a frame is claimed for each
+   * page that is still missing. The victims are written back and the misses are read with latch_ released, runs of
+   * consecutive page ids with one DiskManager::ReadPages() call each.
+   * @param page_ids ids of the pages to be fetched
+   * @return the pages in the order of page_ids, empty if there are not enough frames for the missing ones
+   */
+  auto FetchPgsImp(const std::vector<page_id_t> &page_ids) -> std::vector<Page *> override;
+
+  /**
+   * @brief Create n new pages, claiming their frames under one acquisition of latch_.
+   * @param n number of pages to create
+   * @return the new pages, empty if there are fewer than n free or evictable frames
+   */
+  auto NewPgsImp(size_t n) -> std::vector<Page *> override;
+
   /**
    * TODO(P1): Add implementation
    *
-   * @brief Delete a page from the buffer pool. If page_id is not in the buffer pool, do nothing and return true.
+   * @brief Delete a page from the buffer pool. If page_id is not in the buffer pool, only deallocate it and return
+   * true.
    * If the page is pinned and cannot be deleted, return false immediately.
    * After deleting the page from the page table, stop tracking the frame in the replacer and add the frame
    * back to the free list. Also, reset the page's memory and metadata.
    * Finally, you should call DeallocatePage() to
-   * imitate freeing the page on the disk.
+   * free the page on the disk, so that a later NewPage() can reuse it.
    *
    * @param page_id id of page to be deleted
    * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
@@ -154,76 +326,369 @@ class BufferPoolManagerInstance : public BufferPoolManager {
 
   /**
    * 创建一个缓冲池管理实例,其中pool_size代表着缓冲池能够存储多少个页, *pages_是一个pool_size大小的页面的缓冲池
-   * next_page_id_ 获取下一个可以分配的页面下标值，bucket_size_代表map的桶的大小
+   * next_page_id_ 获取下一个可以分配的页面下标值
    * page_table_ 根据当前需要的page查找frame_id_t所在的位置，如果没有需要将硬盘中的数据加载到缓冲池中
    * replacer_size_ 根据当前的frame_id_t 的情况适当的进行更新
    * free_list_存储了没有分配的frame_id
    */
-  /** Number of pages in the buffer pool. */
-  const size_t pool_size_;
+  /** Number of pages in the buffer pool. Changed by Resize() under latch_. */
+  std::atomic<size_t> pool_size_{0};
+  /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
+  const size_t num_instances_ = 1;
+  /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
+  const size_t instance_index_ = 0;
   /** The next page id to be allocated  */
   std::atomic<page_id_t> next_page_id_ = 0;
-  /** Bucket size for the extendible hash table */
-  const size_t bucket_size_ = 4;
-  /** Array of buffer pool pages. */
-  Page *pages_;
-  /** Page table for keeping track of buffer pool pages. */
-  ExtendibleHashTable<page_id_t, frame_id_t> *page_table_;
-  /** Replacer to find unpinned pages for replacement. */
-  LRUKReplacer *replacer_;
+  /**
+   * Page table for keeping track of buffer pool pages. Lock-free for readers, written under latch_. Resize()
+   * replaces it with a bigger one when the pool outgrows it.
+   */
+  std::atomic<PageTable *> page_table_{nullptr};
+  /** Replacer to find unpinned pages for replacement, LRU-K unless another policy was asked for. */
+  EvictionPolicy *replacer_;
   /** List of free frames that don't have any pages on them. */
   std::list<frame_id_t> free_list_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
-  /** Pointer to the log manager. Please ignore this for P1. */
-  LogManager *log_manager_ __attribute__((__unused__));
+  /** The page size of the database, from the disk manager. */
+  const size_t page_size_;
+  /** Pointer to the log manager, nullptr if the pool does not log. */
+  LogManager *log_manager_;
   /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
   std::mutex latch_;
 
+  /** The background writer thread, nullptr if it is not running. */
+  std::thread *bgwriter_thread_{nullptr};
+  /** Protects bgwriter_stop_, and wakes the background writer up when it has to stop. */
+  std::mutex bgwriter_latch_;
+  std::condition_variable bgwriter_cv_;
+  bool bgwriter_stop_{false};
+
+  /**
+   * @brief One round of the background writer: write up to max_pages dirty, unpinned pages that are next in the
+   * eviction order, if at least dirty_ratio of the frames are dirty.
+   * @return the number of pages written
+   */
+  auto BackgroundWriterRound(size_t max_pages, double dirty_ratio) -> size_t;
+
+  /** The prefetch thread, nullptr until the first prefetch request. */
+  std::thread *prefetch_thread_{nullptr};
+  /** Protects prefetch_queue_ and prefetch_stop_. */
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
+  /** Pages waiting to be prefetched. */
+  std::deque<page_id_t> prefetch_queue_;
+  bool prefetch_stop_{false};
+
+  /**
+   * @brief Read the pages that are not resident into free or evictable frames and leave them unpinned. The reads
+   * are in flight together on the disk scheduler. Pages beyond the frames that can be claimed are skipped.
+   * @return the number of pages read
+   */
+  auto PrefetchBatch(const std::vector<page_id_t> &page_ids) -> size_t;
+
+  /**
+   * Counters of GetStats(). They are striped per thread, so counting on the hit path, which does not take latch_,
+   * does not make the threads contend on a shared cache line.
+   */
+  StripedCounter hits_;
+  StripedCounter misses_;
+  StripedCounter evictions_;
+  StripedCounter dirty_writebacks_;
+  StripedCounter flushes_;
+  StripedCounter pin_waits_;
+  StripedCounter no_free_frames_;
+  LatencyHistogram read_latency_;
+  LatencyHistogram write_latency_;
+
+  /**
+   * @brief Write a page to disk, counting the latency in write_latency_. The log is forced up to the page LSN first.
+   * @param page_id the page id to write the frame to, which is the victim's when the frame is being evicted
+   * @param page the frame holding the page
+   */
+  void WriteToDisk(page_id_t page_id, Page *page);
+
+  /**
+   * @brief Write-ahead rule: make the log durable up to lsn before a page with that LSN goes to disk. Does nothing
+   * unless logging is enabled, or if the log is already durable that far.
+   */
+  void ForceLog(lsn_t lsn);
+
   /**
-   * @brief Allocate a page on disk. Caller should acquire the latch before calling this function.
+   * @brief Write the pinned frames to disk, one DiskManager::WritePages() per run of consecutive page ids.
+   * @param frames the page id and frame of every page, sorted by page id
+   * @return false if any of the runs could not be written
+   */
+  auto WriteRunsToDisk(const std::vector<std::pair<page_id_t, frame_id_t>> &frames) -> bool;
+
+  /** Magic number at the start of a warm start file, "BPWS". */
+  static constexpr uint32_t WARM_START_MAGIC = 0x53575042;
+  /** One page of a warm start file. */
+  struct WarmStartEntry {
+    page_id_t page_id_;
+    uint32_t accesses_;
+  };
+  /** Reloads the pages of WarmStart(), nullptr if no warm start was started. Set under latch_. */
+  std::thread *warm_start_thread_{nullptr};
+  /** Tells the warm start thread to stop reading, set by the destructor. */
+  std::atomic<bool> warm_start_stop_{false};
+
+  /**
+   * @brief Body of the warm start thread: read the pages into free frames in page id order, then replay their
+   * access history.
+   * @param pages the pages of this instance, in the order they were saved
+   */
+  void LoadResidentPages(const std::vector<WarmStartEntry> &pages);
+
+  /**
+   * @brief Allocate a page on disk, reusing a page of this instance from the free page map of the disk manager before
+   * extending the database. Caller should acquire the latch before calling this function.
+   * @param[out] reused set to true if the page was freed before, so that the disk still holds its old content
+   * @return the id of the allocated page
+   */
+  auto AllocatePage(bool *reused = nullptr) -> page_id_t;
+
+  /**
+   * @brief Allocate the next page of an extent of extent_owner of this instance, reserving a new extent of
+   * EXTENT_PAGES pages past the pages allocated so far if they are used up. Caller should acquire the latch before
+   * calling this function.
+   * @param[in,out] extent_owner the object the page is for, set to the page for a new object
    * @return the id of the allocated page
    */
-  auto AllocatePage() -> page_id_t;
+  auto AllocateExtentPage(page_id_t *extent_owner) -> page_id_t;
 
   /**
-   * @brief Deallocate a page on disk. Caller should acquire the latch before calling this function.
+   * @brief Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions to
+   * validate input data and ensure that a parallel BPM is routing requests to the correct BPI.
+   * @param page_id
+   */
+  void ValidatePageId(page_id_t page_id) const;
+
+  /**
+   * @brief Deallocate a page on disk by marking it free in the free page map of the disk manager. Caller should
+   * acquire the latch before calling this function.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id);
 
-  // 如果有空闲的帧直接返回,没有的话进行删除相应的帧
-  auto GetFrame() -> frame_id_t {
-    frame_id_t ans = -1;
-    if (!free_list_.empty()) {
-      ans = *free_list_.begin();
-      free_list_.pop_front();
-    } else {
-      replacer_->Evict(&ans);
-    }
-    return ans;
+  /**
+   * @brief Take a frame from the free list, or else evict one, and claim it by moving its pin count from 0 to -1.
+   * Caller must hold latch_.
+   * @return the claimed frame, or -1 if every frame is pinned
+   */
+  auto GetFrame() -> frame_id_t;
+
+  /**
+   * @brief Get a frame for a miss of an operation using strategy: recycle the frame at the next position of its ring
+   * if it belongs to this instance, is unpinned and still holds the page the ring put there, or else take one with
+   * GetFrame(). The ring position is left pointing at the returned frame, its page id is set by the caller.
+   * Caller must hold latch_.
+   * @return the claimed frame and its ring slot, or -1 if every frame is pinned
+   */
+  auto GetFrame(BufferAccessStrategy *strategy, BufferAccessStrategy::Slot **slot) -> frame_id_t;
+
+  /** Per-frame state that lives next to the Page book-keeping fields, padded to a cache line like Page. */
+  struct alignas(64) FrameState {
+    /** True while the page of the frame is read in or its victim is written back. Written under latch_. */
+    std::atomic<bool> io_in_progress_{false};
+    /** Signalled, with latch_ held, when io_in_progress_ goes back to false. */
+    std::condition_variable io_cv_;
+    /** Hits served without latch_ that have not been recorded in the replacer yet. */
+    std::atomic<uint32_t> unrecorded_hits_{0};
+    /**
+     * True if the replacer may hold the frame as non-evictable. Unpinning the frame to 0 only has to take latch_ to
+     * make it evictable again while this is set; hits that pin the frame without latch_ leave the replacer alone.
+     */
+    std::atomic<bool> replacer_pinned_{false};
+  };
+
+  /** A run of frames allocated together by one growth of the pool. */
+  struct FrameChunk {
+    size_t first_frame_;
+    size_t num_frames_;
+    /** The page data of the frames, one BUSTUB_PAGE_SIZE aligned arena. */
+    char *data_;
+    Page *pages_;
+    FrameState *states_;
+  };
+  /** Where the Page and FrameState of a frame live. */
+  struct FrameRef {
+    Page *page_;
+    FrameState *state_;
+  };
+  static constexpr size_t FRAME_DIR_LEAF_SIZE = 1024;
+  static constexpr size_t FRAME_DIR_SIZE = MAX_POOL_SIZE / FRAME_DIR_LEAF_SIZE;
+  /** Size of a transparent huge page with 4 KiB base pages, the alignment of arenas that span one. */
+  static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+  /** The allocated chunks in frame order, the last one may extend past pool_size_. Protected by latch_. */
+  std::vector<FrameChunk> chunks_;
+  /**
+   * Two-level directory from frame id to FrameRef, frame_dir_[frame / FRAME_DIR_LEAF_SIZE][frame %
+   * FRAME_DIR_LEAF_SIZE]. Written under latch_, read without it for frames found in the page table.
+   */
+  std::atomic<FrameRef *> frame_dir_[FRAME_DIR_SIZE]{};
+
+  auto PageOf(frame_id_t frame_id) const -> Page * {
+    return frame_dir_[frame_id / FRAME_DIR_LEAF_SIZE].load()[frame_id % FRAME_DIR_LEAF_SIZE].page_;
   }
-  void ChangeFrameToNewPage(frame_id_t frame_id, page_id_t page_id) {
-    // 如果需要释放的帧的脏位是true,那么需要进行将本页进行刷新到相应的地方
-    if (pages_[frame_id].IsDirty()) {
-      FlushPgImp(pages_[frame_id].page_id_);
-    }
-    // 对于需要释放的帧我们需要删除原有的page_table_
-    page_table_->Remove(pages_[frame_id].page_id_);
-    // 对新的帧和页表进行初始化
-    pages_[frame_id].page_id_ = page_id;
-    pages_[frame_id].is_dirty_ = false;
-    pages_[frame_id].pin_count_ = 1;
-    // 读取相应的页面到缓冲区的页面中
-    disk_manager_->ReadPage(page_id, pages_[frame_id].GetData());
-    // 插入新的内容到page_table_中
-    page_table_->Insert(page_id, frame_id);
-    // 记录一次LRU-K次数
-    replacer_->RecordAccess(frame_id);
-    // 设置为不可删除的
-    replacer_->SetEvictable(frame_id, false);
+
+  auto StateOf(frame_id_t frame_id) const -> FrameState & {
+    return *frame_dir_[frame_id / FRAME_DIR_LEAF_SIZE].load()[frame_id % FRAME_DIR_LEAF_SIZE].state_;
   }
+
+  /**
+   * @brief Allocate the frames [first_frame, first_frame + num_frames). Their page data goes into one zeroed arena,
+   * aligned to BUSTUB_PAGE_SIZE and backed by transparent huge pages when it spans at least one; their Page and
+   * FrameState descriptors go into separate arrays.
+   */
+  auto AllocateChunk(size_t first_frame, size_t num_frames) -> FrameChunk;
+
+  /** @brief Free the page data and the descriptors of a chunk. */
+  static void FreeChunk(const FrameChunk &chunk);
+
+  /** Serializes Resize(), which releases latch_ while it waits for unlatched readers. */
+  std::mutex resize_latch_;
+
+  /**
+   * @brief Add frames [pool_size_, pool_size) to the free list, allocating a chunk for the frames past the last
+   * chunk. Caller must hold latch_ and resize_latch_ (or be the constructor).
+   * @return the page table the pool outgrew, which the caller deletes once no unlatched reader can use it, or nullptr
+   */
+  auto Grow(size_t pool_size) -> PageTable *;
+
+  /**
+   * Threads that touch frames or the page table without latch_ (the hit paths of FetchPage and UnpinPage) count
+   * themselves in one of these stripes, under the parity of reader_epoch_ they saw. Resize() flips the epoch and
+   * waits for the previous parity to drain before it frees frames or a page table, without making readers share
+   * one counter.
+   */
+  struct alignas(64) ReaderStripe {
+    std::atomic<uint32_t> active_[2]{};
+  };
+  static constexpr size_t NUM_READER_STRIPES = 16;
+  ReaderStripe reader_stripes_[NUM_READER_STRIPES];
+  std::atomic<uint32_t> reader_epoch_{0};
+
+  /** @brief Register the calling thread as an unlatched reader. @return the counter to decrement when done */
+  auto EnterUnlatched() -> std::atomic<uint32_t> *;
+
+  /** @brief Wait until every unlatched reader that started before this call is done. */
+  void WaitForUnlatchedReaders();
+  /** Dirty pages that were evicted and are still being written back, mapped to the frame doing the write. */
+  std::unordered_map<page_id_t, frame_id_t> evicting_;
+
+  /**
+   * @brief Pin page_id without taking latch_ if it is resident and no I/O is in progress on it.
+   * @return the pinned page, or nullptr if the caller has to take the latched path
+   */
+  auto TryPinResident(page_id_t page_id) -> Page *;
+
+  /**
+   * @brief Drop one pin of the frame. If it was the last pin and the replacer may hold the frame as non-evictable,
+   * make it evictable again, taking latch_ unless latch_held.
+   * @return false if the pin count was already <= 0
+   */
+  auto UnpinFrame(frame_id_t frame_id, bool latch_held) -> bool;
+
+  /**
+   * @brief Called with latch_ held after a frame lost its last pin: record the hits that bypassed the replacer and
+   * let the replacer evict the frame, if it is still unpinned and holds a page.
+   */
+  void OnFrameUnpinned(frame_id_t frame_id);
+
+  /**
+   * @brief Look up the frame of page_id, waiting for in-flight I/O on that page to finish first.
+   *
+   * Waits while the page is being read into its frame, or while it is being written back from the frame it was
+   * evicted from. Caller must hold latch_ through lock, which is released while waiting.
+   *
+   * @param lock the held latch_
+   * @param page_id id of the page to look up
+   * @param[out] frame_id the frame holding page_id, if it is resident
+   * @return true if page_id is resident and no I/O is in progress on it, false if it is not resident
+   */
+  auto FindFrame(std::unique_lock<std::mutex> &lock, page_id_t page_id, frame_id_t *frame_id) -> bool;
+
+  /**
+   * @brief Map page_id to a frame claimed by GetFrame() and load the page with latch_ released.
+   *
+   * The frame is pinned and marked I/O in progress while latch_ is held. Then the latch is dropped to write back
+   * the dirty victim and to read the page from disk (or zero the frame for a new page) on the disk scheduler, and
+   * retaken to clear the I/O flag and wake the threads waiting on the frame. Caller must hold latch_ through lock.
+   *
+   * @param lock the held latch_
+   * @param frame the frame returned by GetFrame()
+   * @param page_id id of the page to load
+   * @param read_from_disk true to read the page from disk, false to zero the frame for a new page
+   * @return the page, pinned once, or nullptr if the victim could not be written back or the page could not be read;
+   * the load is then given up with AbortLoad()
+   */
+  auto LoadPage(std::unique_lock<std::mutex> &lock, frame_id_t frame, page_id_t page_id, bool read_from_disk)
+      -> Page *;
+
+  /** A page mapped to a claimed frame by BeginLoad(), whose I/O is still to be done. */
+  struct PendingLoad {
+    frame_id_t frame_;
+    page_id_t page_id_;
+    /** The page evicted from the frame, INVALID_PAGE_ID if the frame was free. */
+    page_id_t victim_;
+    /** True if the victim is dirty and has to be written back before the frame is reused. */
+    bool write_back_;
+    /** Set by WriteBackVictims() if the victim could not be written back: the frame still holds it. */
+    bool write_failed_;
+    /** Set by ReadBatchFromDisk() if the page could not be read. */
+    bool read_failed_;
+  };
+
+  /**
+   * @brief The latched half of LoadPage() before the I/O: unmap the victim, map page_id to the frame, pin the frame
+   * and mark it I/O in progress. Caller must hold latch_.
+   */
+  auto BeginLoad(frame_id_t frame, page_id_t page_id) -> PendingLoad;
+
+  /** @brief The latched half of LoadPage() after the I/O: clear the I/O flag and wake the waiters. */
+  void FinishLoad(const PendingLoad &load);
+
+  /**
+   * @brief Give up a load whose I/O failed, in place of FinishLoad(): unmap the page, then either map the victim back
+   * to the frame, still dirty, if it could not be written back, or put the frame back on the free list. Releases the
+   * pin of BeginLoad(); the caller must have released any other pin it holds on the frame. Caller must hold latch_.
+   */
+  void AbortLoad(const PendingLoad &load);
+
+  /**
+   * @brief Read the pages of loads from disk into their frames, runs of consecutive page ids with one request each.
+   * All the requests are in flight together on the disk scheduler. Loads whose victim could not be written back are
+   * skipped, loads whose read failed are marked read_failed_. Called with latch_ released; sorts loads by page id.
+   */
+  void ReadBatchFromDisk(std::vector<PendingLoad> *loads);
+
+  /**
+   * @brief Write back the dirty victims of loads, all in flight together on the disk scheduler, and wait for them.
+   * Loads whose victim could not be written back are marked write_failed_. Called with latch_ released.
+   */
+  void WriteBackVictims(std::vector<PendingLoad> *loads);
+
+  /** @brief Return the disk scheduler of the batched I/O, starting it on first use. */
+  auto GetDiskScheduler() -> DiskScheduler *;
+
+  /** Runs the I/O of FetchPages() and NewPages(), nullptr until the first batch. */
+  std::unique_ptr<DiskScheduler> disk_scheduler_;
+  std::once_flag disk_scheduler_once_;
+
+  /** @brief Pin a resident frame on the latched path and tell the replacer it is in use. Caller must hold latch_. */
+  void PinFrame(frame_id_t frame_id);
+
+  /**
+   * @brief Give back a frame claimed by GetFrame() that was not loaded after all: a free frame goes back to the free
+   * list, an evicted one back to the replacer with its page still in it. Caller must hold latch_.
+   */
+  void ReturnFrame(frame_id_t frame_id);
+
+  /**
+   * @brief Write the page in frame_id to disk if it is dirty. The frame is pinned during the write, which is done
+   * with latch_ released. Caller must hold latch_ through lock.
+   */
+  void FlushFrame(std::unique_lock<std::mutex> &lock, frame_id_t frame_id);
 };
 }  // namespace bustub
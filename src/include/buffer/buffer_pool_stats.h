@@ -0,0 +1,132 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.h
+//
+// Identification: src/include/buffer/buffer_pool_stats.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace bustub {
+
+/**
+ * StripedCounter is a counter that many threads increment concurrently. Every thread adds to its own cache-line
+ * padded stripe, so increments on the hit path of the buffer pool never contend on one cache line; reading the
+ * counter sums up the stripes.
+ */
+class StripedCounter {
+ public:
+  static constexpr size_t NUM_STRIPES = 16;
+
+  /** Add n to the stripe of the calling thread. */
+  void Add(uint64_t n = 1) { stripes_[ThreadStripe()].value_.fetch_add(n, std::memory_order_relaxed); }
+
+  /** @return the sum of all the stripes */
+  auto Load() const -> uint64_t {
+    uint64_t sum = 0;
+    for (const auto &stripe : stripes_) {
+      sum += stripe.value_.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+ private:
+  struct alignas(64) Stripe {
+    std::atomic<uint64_t> value_{0};
+  };
+
+  /** Threads are assigned stripes round robin on their first increment. */
+  static auto ThreadStripe() -> size_t {
+    static std::atomic<size_t> next_stripe{0};
+    thread_local size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % NUM_STRIPES;
+    return stripe;
+  }
+
+  Stripe stripes_[NUM_STRIPES];
+};
+
+/**
+ * LatencyHistogram counts latencies in power-of-two buckets of microseconds: bucket 0 holds latencies below 1us,
+ * bucket i latencies in [2^(i-1), 2^i) us, and the last bucket everything from 2^(NUM_BUCKETS-2) us up.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr size_t NUM_BUCKETS = 16;
+  using Buckets = std::array<uint64_t, NUM_BUCKETS>;
+
+  /** Count one latency. */
+  void Record(std::chrono::nanoseconds latency) {
+    auto micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+    size_t bucket = 0;
+    while (micros > 0 && bucket < NUM_BUCKETS - 1) {
+      micros >>= 1;
+      bucket++;
+    }
+    buckets_[bucket].Add();
+  }
+
+  /** @return the number of latencies counted in every bucket */
+  auto Load() const -> Buckets {
+    Buckets buckets{};
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+      buckets[i] = buckets_[i].Load();
+    }
+    return buckets;
+  }
+
+  /** @return a label for the range of a bucket, e.g. "<1us", "<512us" or "<1.0ms" */
+  static auto BucketLabel(size_t bucket) -> std::string;
+
+ private:
+  StripedCounter buckets_[NUM_BUCKETS];
+};
+
+/** A snapshot of the counters of a buffer pool, see BufferPoolManager::GetStats(). */
+struct BufferPoolStats {
+  /** The number of frames. */
+  size_t pool_size_{0};
+  /** Frames holding a page. */
+  size_t resident_pages_{0};
+  /** Frames holding a page that differs from its copy on disk. */
+  size_t dirty_pages_{0};
+  /** Fetches of a page that was resident. */
+  uint64_t hits_{0};
+  /** Fetches that had to read the page from disk. */
+  uint64_t misses_{0};
+  /** Pages evicted to make room for another page. */
+  uint64_t evictions_{0};
+  /** Evicted pages that were dirty, and had to be written back before the frame could be reused. */
+  uint64_t dirty_writebacks_{0};
+  /** Dirty pages written by FlushPage, FlushAllPages, the background writer and shrinking the pool. */
+  uint64_t flushes_{0};
+  /** Fetches that waited for another thread to finish reading the page or writing it back. */
+  uint64_t pin_waits_{0};
+  /** Fetches and new pages that failed because every frame was pinned. */
+  uint64_t no_free_frames_{0};
+  /** Latency of the disk reads of the buffer pool. */
+  LatencyHistogram::Buckets read_latency_{};
+  /** Latency of the disk writes of the buffer pool. */
+  LatencyHistogram::Buckets write_latency_{};
+
+  /** @return the fraction of fetches that hit, 0 if there was none */
+  auto HitRatio() const -> double {
+    return hits_ + misses_ == 0 ? 0 : static_cast<double>(hits_) / static_cast<double>(hits_ + misses_);
+  }
+
+  /** Add the counters of another buffer pool, e.g. of another instance of a parallel buffer pool. */
+  auto operator+=(const BufferPoolStats &other) -> BufferPoolStats &;
+};
+
+}  // namespace bustub
@@ -0,0 +1,139 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// clock_pro_replacer.h
+//
+// Identification: src/include/buffer/clock_pro_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/eviction_policy.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ClockProReplacer implements the CLOCK-Pro replacement policy (Jiang, Chen and Zhang, USENIX ATC 2005).
+ *
+ * All the pages, resident or not, sit on one circular list, newest in front of the hot hand. Resident pages are hot
+ * or cold. A cold page is in its test period from when it is loaded (or its reference bit is cleared) until the hot
+ * hand passes it; a cold page referenced during its test period is promoted to hot, and a cold page evicted during
+ * its test period stays on the list as a non-resident page so that reloading it soon counts as a reuse.
+ *
+ * - The cold hand looks for the victim among the resident cold pages.
+ * - The hot hand demotes hot pages whose reference bit is clear while there are more hot pages than m - m_c, and
+ *   ends the test periods it passes.
+ * - The test hand keeps the number of non-resident pages at most m.
+ *
+ * The cold size target m_c grows when a non-resident page in its test period is reloaded and shrinks when a test
+ * period ends unused. Non-evictable frames are skipped by the cold hand; if no cold frame can be evicted, the first
+ * evictable frame after the cold hand is taken. EvictionOrder only approximates the order of the hands.
+ */
+class ClockProReplacer : public EvictionPolicy {
+ public:
+  /**
+   * @brief Create a new ClockProReplacer.
+   * @param num_frames the maximum number of frames the replacer will be required to store
+   */
+  explicit ClockProReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(ClockProReplacer);
+
+  ~ClockProReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  auto EvictionOrder(size_t max_frames) -> std::vector<frame_id_t> override;
+
+  void Resize(size_t num_frames) override;
+
+  /** @return the current target number of resident cold pages */
+  auto GetColdTarget() -> size_t;
+
+ private:
+  struct Node {
+    page_id_t page_id_;
+    /** The frame holding the page, -1 for a non-resident page. */
+    frame_id_t frame_id_;
+    bool hot_;
+    bool ref_;
+    bool test_;
+  };
+
+  using NodeIter = std::list<Node>::iterator;
+
+  struct Frame {
+    bool tracked_{false};
+    bool evictable_{false};
+    NodeIter node_;
+  };
+
+  void CheckFrameId(frame_id_t frame_id) const;
+
+  /** @return the node after it on the clock, wrapping around */
+  auto Next(NodeIter it) -> NodeIter;
+
+  /** Insert a node at the head of the list, i.e. right in front of the hot hand. */
+  auto InsertAtHead(const Node &node) -> NodeIter;
+
+  /** Move every hand that points at it to the next node, before it is moved or erased. */
+  void MoveHandsOff(NodeIter it);
+
+  void MoveToHead(NodeIter it);
+
+  /** Erase a node from the clock, which must not be resident. */
+  void EraseNonResident(NodeIter it);
+
+  void ShrinkColdTarget();
+
+  /** @return m_h = m - m_c, the target number of hot pages */
+  auto HotTarget() const -> size_t { return capacity_ > cold_target_ ? capacity_ - cold_target_ : 0; }
+
+  /** Run the hot hand until there are at most m - m_c hot pages. */
+  void RunHandHot();
+
+  /** Run the test hand until there are at most m non-resident pages. */
+  void RunHandTest();
+
+  /** Make the resident node non-resident, or erase it if it is not in its test period. @return its frame */
+  auto EvictNode(NodeIter it) -> frame_id_t;
+
+  size_t capacity_;
+  /** m_c, the target number of resident cold pages. */
+  size_t cold_target_;
+  size_t hot_count_{0};
+  size_t nonresident_count_{0};
+  size_t evictable_count_{0};
+  /** Set once the first frame is evicted. Until then the pool is filling up and new pages become hot. */
+  bool warm_{false};
+  std::mutex latch_;
+  std::vector<Frame> frames_;
+  std::list<Node> clock_;
+  NodeIter hand_hot_;
+  NodeIter hand_cold_;
+  NodeIter hand_test_;
+  /** The non-resident pages by page id. */
+  std::unordered_map<page_id_t, NodeIter> nonresident_;
+};
+
+}  // namespace bustub
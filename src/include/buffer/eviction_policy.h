@@ -0,0 +1,110 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// eviction_policy.h
+//
+// Identification: src/include/buffer/eviction_policy.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** The replacement policies a BufferPoolManagerInstance can be constructed with. */
+enum class EvictionPolicyType { LRU_K, ARC, TWO_QUEUE, CLOCK_PRO };
+
+/**
+ * EvictionPolicy is the interface between the buffer pool and its replacement policy.
+ *
+ * The buffer pool reports every access to a frame together with the page the frame holds, and whether the frame
+ * may be evicted (i.e. is unpinned). The policy picks the victim among the evictable frames. Policies that keep
+ * history of evicted pages (ARC, 2Q, CLOCK-Pro) key that history by page id, which is why accesses carry one.
+ *
+ * A frame is tracked from its first recorded access until it is evicted or removed, and starts out evictable.
+ * All the methods throw ExceptionType::OUT_OF_RANGE for frame ids outside of [0, num_frames).
+ */
+class EvictionPolicy {
+ public:
+  EvictionPolicy() = default;
+  virtual ~EvictionPolicy() = default;
+
+  /**
+   * @brief Pick a victim among the evictable frames, and stop tracking it.
+   * @param[out] frame_id id of the evicted frame
+   * @return true if a frame was evicted, false if no frame is evictable
+   */
+  virtual auto Evict(frame_id_t *frame_id) -> bool = 0;
+
+  /**
+   * @brief Record an access to a frame. The first access of an untracked frame means page_id was just loaded into
+   * it.
+   * @param frame_id the accessed frame
+   * @param page_id the page the frame holds
+   */
+  virtual void RecordAccess(frame_id_t frame_id, page_id_t page_id) = 0;
+
+  /**
+   * @brief Mark a tracked frame evictable or non-evictable. Does nothing for untracked frames.
+   */
+  virtual void SetEvictable(frame_id_t frame_id, bool set_evictable) = 0;
+
+  /**
+   * @brief Stop tracking an evictable frame without remembering its page, e.g. because the page was deleted.
+   * Does nothing for untracked frames, throws ExceptionType::INVALID for non-evictable frames.
+   */
+  virtual void Remove(frame_id_t frame_id) = 0;
+
+  /** @return the number of evictable frames */
+  virtual auto Size() -> size_t = 0;
+
+  /**
+   * @brief Return evictable frames in the order the policy expects to evict them, without evicting anything.
+   * Policies whose choice depends on state that eviction itself changes may only approximate that order.
+   * @param max_frames the maximum number of frames to return
+   * @return at most max_frames evictable frame ids, the next victim first
+   */
+  virtual auto EvictionOrder(size_t max_frames) -> std::vector<frame_id_t> = 0;
+
+  /**
+   * @brief Return how many accesses of a tracked frame the policy remembers. The buffer pool saves it with the
+   * resident pages so that a warm start can replay the history. Policies that do not count accesses report 1.
+   * @param frame_id the frame
+   * @return the number of remembered accesses, at least 1
+   */
+  virtual auto AccessCount(__attribute__((unused)) frame_id_t frame_id) -> size_t { return 1; }
+
+  /**
+   * @brief Change the number of frames of the buffer pool. When shrinking, the frames that go away must not be
+   * tracked any more. History of evicted pages is trimmed to the bounds of the new size.
+   * @param num_frames the new number of frames
+   */
+  virtual void Resize(size_t num_frames) = 0;
+};
+
+/**
+ * @brief Create a replacement policy.
+ * @param type which policy to create
+ * @param num_frames the number of frames of the buffer pool
+ * @param k the lookback constant, only used by LRU-K
+ */
+auto MakeEvictionPolicy(EvictionPolicyType type, size_t num_frames, size_t k) -> std::unique_ptr<EvictionPolicy>;
+
+/**
+ * @brief Parse the name of a replacement policy: "lru-k", "arc", "2q" or "clock-pro".
+ * @param[out] type the parsed policy
+ * @return false if name is not a known policy
+ */
+auto ParseEvictionPolicyType(const std::string &name, EvictionPolicyType *type) -> bool;
+
+}  // namespace bustub
@@ -12,19 +12,16 @@
 
 #pragma once
 
-#include <algorithm>
 #include <cstddef>
-#include <limits>
-#include <list>
-#include <memory>
 #include <mutex>  // NOLINT
-#include <unordered_map>
-#include <utility>
+#include <set>
+#include <tuple>
 #include <vector>
-#include "../common/config.h"
+#include "buffer/eviction_policy.h"
+#include "common/config.h"
+#include "common/exception.h"
 #include "common/logger.h"
 #include "common/macros.h"
-#include "nodes/nodes.hpp"
 
 namespace bustub {
 
@@ -35,11 +32,14 @@ namespace bustub {
  * of all frames. Backward k-distance is computed as the difference in time between
  * current timestamp and the timestamp of kth previous access.
  *
- * A frame with less than k hist_orical references is given
+ * A frame with less than k historical references is given
  * +inf as its backward k-distance. When multiple frames have +inf backward k-distance,
  * classical LRU algorithm is used to choose victim.
+ *
+ * Every frame keeps its last k access timestamps in a ring buffer, and the evictable frames are kept in a set
+ * ordered by backward k-distance, so Evict, RecordAccess, SetEvictable and Remove are all O(log n).
  */
-class LRUKReplacer {
+class LRUKReplacer : public EvictionPolicy {
  public:
   /**
    *
@@ -57,7 +57,7 @@ class LRUKReplacer {
    *
    * @brief Destroys the LRUReplacer.
    */
-  ~LRUKReplacer();
+  ~LRUKReplacer() override;
 
   /**
    * TODO(P1): Add implementation
@@ -65,23 +65,23 @@ class LRUKReplacer {
    * @brief Find the frame with largest backward k-distance and evict that frame. Only frames
    * that are marked as 'evictable' are candidates for eviction.
    *
-   * A frame with less than k hist_orical references is given +inf as its backward k-distance.
+   * A frame with less than k historical references is given +inf as its backward k-distance.
    * If multiple frames have inf backward k-distance, then evict the frame with the earliest
    * timestamp overall.
    *
    * Successful eviction of a frame should decrement the size of replacer and remove the frame's
-   * access hist_ory.
+   * access history.
    *
    * @param[out] frame_id id of frame that is evicted.
    * @return true if a frame is evicted successfully, false if no frames can be evicted.
    */
-  auto Evict(frame_id_t *frame_id) -> bool;
+  auto Evict(frame_id_t *frame_id) -> bool override;
 
   /**
    * TODO(P1): Add implementation
    *
    * @brief Record the event that the given frame id is accessed at current timestamp.
-   * Create a new entry for access hist_ory if frame id has not been seen before.
+   * Create a new entry for access history if frame id has not been seen before.
    *
    * If frame id is invalid (ie. larger than replacer_size_), throw an exception. You can
    * also use BUSTUB_ASSERT to abort the process if frame id is invalid.
@@ -90,6 +90,11 @@ class LRUKReplacer {
    */
   void RecordAccess(frame_id_t frame_id);
 
+  /** @brief EvictionPolicy::RecordAccess. LRU-K keeps no history of evicted pages, so the page id is unused. */
+  void RecordAccess(frame_id_t frame_id, __attribute__((unused)) page_id_t page_id) override {
+    RecordAccess(frame_id);
+  }
+
   /**
    * TODO(P1): Add implementation
    *
@@ -107,12 +112,12 @@ class LRUKReplacer {
    * @param frame_id id of frame whose 'evictable' status will be modified
    * @param set_evictable whether the given frame is evictable or not
    */
-  void SetEvictable(frame_id_t frame_id, bool set_evictable);
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
 
   /**
    * TODO(P1): Add implementation
    *
-   * @brief Remove an evictable frame from replacer, along with its access hist_ory.
+   * @brief Remove an evictable frame from replacer, along with its access history.
    * This function should also decrement replacer's size if removal is successful.
    *
    * Note that this is different from evicting a frame, which always remove the frame
@@ -126,7 +131,7 @@ class LRUKReplacer {
    *
    * @param frame_id id of frame to be removed
    */
-  void Remove(frame_id_t frame_id);
+  void Remove(frame_id_t frame_id) override;
 
   /**
    * TODO(P1): Add implementation
@@ -135,39 +140,99 @@ class LRUKReplacer {
    *
    * @return size_t
    */
-  auto Size() -> size_t;
+  auto Size() -> size_t override;
 
-  class Node {
-   public:
-    size_t cnt_;
-    bool replace_;
-    frame_id_t frame_;
-    explicit Node(frame_id_t frame, size_t cnt = 1, bool replace = false)
-        : cnt_(cnt), replace_(replace), frame_(frame) {}
-  };
+  /**
+   * @brief Return the evictable frames in the order Evict would pick them, without evicting anything.
+   *
+   * This is used by the background writer of the buffer pool to clean the frames that are about to be evicted.
+   *
+   * @param max_frames the maximum number of frames to return
+   * @return at most max_frames evictable frame ids, the next victim first
+   */
+  auto EvictionOrder(size_t max_frames) -> std::vector<frame_id_t> override;
+
+  /** @brief EvictionPolicy::AccessCount. LRU-K remembers at most the last k accesses of a frame. */
+  auto AccessCount(frame_id_t frame_id) -> size_t override;
+
+  /** @brief EvictionPolicy::Resize. LRU-K keeps no history of evicted pages, only the frame table changes size. */
+  void Resize(size_t num_frames) override;
 
   void Debug() {
-    for (const auto [k, v] : cache_) {
-      LOG_INFO("frame [%d], Node(%d,%d,%d)\n", k, v->frame_, static_cast<int>(v->cnt_), v->replace_);
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (size_t i = 0; i < frames_.size(); i++) {
+      if (frames_[i].tracked_) {
+        LOG_INFO("frame [%d], accesses [%d], evictable [%d], k-th timestamp [%d]\n", static_cast<int>(i),
+                 static_cast<int>(frames_[i].count_), frames_[i].evictable_,
+                 static_cast<int>(frames_[i].OldestTimestamp()));
+      }
     }
-    for (auto node : hist_) {
-      LOG_INFO("Node(%d,%d,%d)\n", node.frame_, static_cast<int>(node.cnt_), node.replace_);
+  }
+
+ private:
+  /**
+   * The access history of a single frame. The last k access timestamps are kept in a ring buffer that is allocated
+   * once for every frame, so recording an access never allocates memory.
+   */
+  class FrameHistory {
+   public:
+    explicit FrameHistory(size_t k) : timestamps_(k, 0) {}
+
+    /** Append an access at the given timestamp, overwriting the oldest one once k accesses are recorded. */
+    void Record(size_t timestamp) {
+      timestamps_[head_] = timestamp;
+      head_ = (head_ + 1) % timestamps_.size();
+      count_++;
     }
-    for (auto node : cach_) {
-      LOG_INFO("Node(%d,%d,%d)\n", node.frame_, static_cast<int>(node.cnt_), node.replace_);
+
+    /** @return true if the frame has been accessed at least k times, i.e. its backward k-distance is finite */
+    auto HasK() const -> bool { return count_ >= timestamps_.size(); }
+
+    /**
+     * @return the timestamp of the k-th previous access if the frame has k accesses, otherwise the timestamp of its
+     * earliest access. Either way it is the oldest entry in the ring buffer.
+     */
+    auto OldestTimestamp() const -> size_t { return HasK() ? timestamps_[head_] : timestamps_[0]; }
+
+    /** Forget the whole access history. */
+    void Reset() {
+      count_ = 0;
+      head_ = 0;
+      evictable_ = false;
+      tracked_ = false;
     }
+
+    std::vector<size_t> timestamps_;
+    size_t head_{0};
+    size_t count_{0};
+    bool evictable_{false};
+    bool tracked_{false};
+  };
+
+  /**
+   * Ordering key of an evictable frame. Frames with less than k accesses (+inf backward k-distance) sort before
+   * frames with k accesses; within each group the frame with the oldest timestamp sorts first, so the first key in
+   * the set is always the victim.
+   */
+  using EvictionKey = std::tuple<bool, size_t, frame_id_t>;
+
+  auto KeyOf(frame_id_t frame_id) const -> EvictionKey {
+    const auto &frame = frames_[frame_id];
+    return {frame.HasK(), frame.OldestTimestamp(), frame_id};
   }
 
- private:
-  // TODO(student): implement me! You can replace these member variables as you like.
-  // Remove maybe_unused if you start using them.
-  size_t replacer_size_;  // 标记当前最大包含可驱逐和不可驱逐的数目
-  size_t k_;              // 如果访问次数大于等于k_将hist_中的数据放到cach_中
+  void CheckFrameId(frame_id_t frame_id) const {
+    if (frame_id < 0 || static_cast<size_t>(frame_id) >= replacer_size_) {
+      throw Exception(ExceptionType::OUT_OF_RANGE, "LRUKReplacer frame_id out of range");
+    }
+  }
+
+  size_t current_timestamp_{0};  // 逻辑时钟,每次访问加一
+  size_t replacer_size_;         // 标记当前最大包含可驱逐和不可驱逐的数目
+  size_t k_;
   std::mutex latch_;
-  // 历史队列双链表存储没有到达K的cache_
-  std::unordered_map<frame_id_t, std::list<Node>::iterator> cache_;
-  std::list<Node> hist_, cach_;  // hist_中的元素使用FIFO进行删除begin,cach_元素使用LRU进行删除begin
-  size_t num_;                   // 可被驱逐的帧的数目
+  std::vector<FrameHistory> frames_;  // 按照 frame_id 下标存储每个帧的访问历史
+  std::set<EvictionKey> evictable_;   // 所有可驱逐的帧,begin() 就是下一个被驱逐的帧
 };
 
 }  // namespace bustub
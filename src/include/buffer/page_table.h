@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.h
+//
+// Identification: src/include/buffer/page_table.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * PageTable maps the ids of the resident pages of a buffer pool to the frames holding them.
+ *
+ * It is an open-addressing hash table with linear probing over a fixed array of atomic slots, sized for the number
+ * of frames of the pool. Every slot holds a whole (page id, frame id) pair in one 64-bit word, so a reader always
+ * sees a mapping that existed at some point.
+ *
+ * Find() is lock-free and may run concurrently with writers. Insert() and Remove() must be serialized by the caller
+ * (the buffer pool latch). A concurrent Find() can miss an entry that Remove() is shifting back over the slot being
+ * probed, so a negative answer from an unlatched Find() must be confirmed under the latch; a positive answer may
+ * be stale and must be validated against the frame.
+ */
+class PageTable {
+ public:
+  /**
+   * @brief Create a page table that holds up to max_entries mappings.
+   * @param max_entries the maximum number of mappings, i.e. the number of frames of the buffer pool
+   */
+  explicit PageTable(size_t max_entries);
+
+  ~PageTable();
+
+  DISALLOW_COPY_AND_MOVE(PageTable);
+
+  /**
+   * @brief Look up the frame of a page. Lock-free.
+   * @param page_id the page to look up
+   * @param[out] frame_id the frame mapped to page_id, if found
+   * @return true if a mapping for page_id was found
+   */
+  auto Find(page_id_t page_id, frame_id_t *frame_id) const -> bool;
+
+  /**
+   * @brief Map page_id to frame_id, replacing the existing mapping of page_id if any. Writers must be serialized.
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * @brief Remove the mapping of page_id. Writers must be serialized.
+   * @return true if page_id was mapped
+   */
+  auto Remove(page_id_t page_id) -> bool;
+
+  /** @return the number of mappings the table was sized for */
+  auto GetMaxEntries() const -> size_t { return max_entries_; }
+
+ private:
+  static constexpr uint64_t EMPTY_SLOT = ~static_cast<uint64_t>(0);
+
+  static auto Pack(page_id_t page_id, frame_id_t frame_id) -> uint64_t {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  }
+  static auto PageOf(uint64_t slot) -> page_id_t { return static_cast<page_id_t>(slot >> 32); }
+  static auto FrameOf(uint64_t slot) -> frame_id_t { return static_cast<frame_id_t>(slot & 0xFFFFFFFF); }
+
+  /** The slot page_id hashes to (Fibonacci hashing, page ids are mostly sequential). */
+  auto Home(page_id_t page_id) const -> size_t {
+    return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(page_id)) * 0x9E3779B97F4A7C15ULL) >>
+                               shift_);
+  }
+
+  /** The index of the slot holding page_id, or capacity_ if page_id is not in the table. Writers only. */
+  auto SlotOf(page_id_t page_id) const -> size_t;
+
+  size_t max_entries_;
+  size_t capacity_;
+  size_t shift_;
+  size_t size_{0};
+  std::atomic<uint64_t> *slots_;
+};
+
+}  // namespace bustub
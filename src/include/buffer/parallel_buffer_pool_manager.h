@@ -0,0 +1,217 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/parallel_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "common/config.h"
+#include "common/macros.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * ParallelBufferPoolManager shards the buffer pool over several BufferPoolManagerInstances.
+ *
+ * Every instance owns its own frames, page table, replacer and latch. A page id is mapped to the instance
+ * `page_id % num_instances`, and each instance only allocates page ids of its own residue class, so a page always
+ * lives in exactly one shard and operations on different shards never contend on the same latch.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * @brief Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of BufferPoolManagerInstances to shard over
+   * @param pool_size the pool size of each BufferPoolManagerInstance
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer of every instance
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param policy the replacement policy of every instance
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            size_t replacer_k = LRUK_REPLACER_K, LogManager *log_manager = nullptr,
+                            EvictionPolicyType policy = EvictionPolicyType::LRU_K);
+
+  /**
+   * @brief Destroys an existing ParallelBufferPoolManager and all of its instances.
+   */
+  ~ParallelBufferPoolManager() override;
+
+  DISALLOW_COPY_AND_MOVE(ParallelBufferPoolManager);
+
+  /** @brief Return the total number of frames over all the instances. */
+  auto GetPoolSize() -> size_t override;
+
+  /** @brief Return the page size of the database, which all the instances share. */
+  auto GetPageSize() -> size_t override { return instances_[0]->GetPageSize(); }
+
+  /**
+   * @brief Resize every instance to pool_size frames, see BufferPoolManagerInstance::Resize.
+   * @param pool_size the new number of frames of each instance
+   * @return false if some instance could not be shrunk; the other instances are resized anyway
+   */
+  auto Resize(size_t pool_size) -> bool;
+
+  /** @brief Return the number of instances the pool is sharded over. */
+  auto GetNumInstances() const -> size_t { return instances_.size(); }
+
+  /**
+   * @brief Return the instance responsible for the given page id.
+   * @param page_id id of the page
+   * @return the BufferPoolManagerInstance that owns page_id
+   */
+  auto GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance *;
+
+  /**
+   * @brief Start the background writer of every instance. See BufferPoolManagerInstance::StartBackgroundWriter,
+   * max_pages and dirty_ratio apply to each instance separately.
+   */
+  void StartBackgroundWriter(std::chrono::milliseconds interval = bgwriter_interval,
+                             size_t max_pages = BGWRITER_MAX_PAGES, double dirty_ratio = BGWRITER_DIRTY_RATIO);
+
+  /** @brief Stop the background writer of every instance. */
+  void StopBackgroundWriter();
+
+  /**
+   * @brief Split the pages by the instance that owns them and prefetch them there.
+   * @param page_ids ids of the pages to load
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids) override;
+
+  /**
+   * @brief Save the resident pages of every instance, instance i to the file file_name.i.
+   * @return false if the file of some instance could not be written
+   */
+  auto SaveResidentPages(const std::string &file_name) -> bool override;
+
+  /**
+   * @brief Warm start every instance from the file its SaveResidentPages() wrote.
+   * @return false if the file of some instance could not be read; the other instances are warm started anyway
+   */
+  auto WarmStart(const std::string &file_name) -> bool override;
+
+  /** @brief Wait until the warm start of every instance is done. */
+  void WaitForWarmStart();
+
+  /** @brief Return the sum of the counters of all the instances. */
+  auto GetStats() -> BufferPoolStats override;
+
+  /** @brief Return the resident pages of all the instances. */
+  auto GetResidentPages() -> std::vector<page_id_t> override;
+
+ protected:
+  /** @brief Return the instance that owns page_id, so page guards unpin there directly. */
+  auto OwnerOf(page_id_t page_id) -> BufferPoolManager * override { return GetBufferPoolManager(page_id); }
+
+  /**
+   * @brief Fetch the requested page from the instance that owns it.
+   * @param page_id id of page to be fetched
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPgImp(page_id_t page_id) -> Page * override;
+
+  /**
+   * @brief Unpin the target page in the instance that owns it.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  auto UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool override;
+
+  /**
+   * @brief Flush the target page to disk through the instance that owns it.
+   * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+   * @return false if the page could not be found in the page table, true otherwise
+   */
+  auto FlushPgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * @brief Create a new page. Instances are asked in a round robin manner, starting at a different instance on
+   * every call, until one of them has a frame to spare.
+   * @param[out] page_id id of created page
+   * @return nullptr if no instance could create a new page, otherwise pointer to the new page
+   */
+  auto NewPgImp(page_id_t *page_id) -> Page * override;
+
+  /**
+   * @brief Fetch the requested page from the instance that owns it, with the access strategy of a bulk operation.
+   * The ring of the strategy may hold frames of several instances.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy, nullptr for a normal fetch
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /**
+   * @brief Create a new page like NewPgImp(), with the access strategy of a bulk operation.
+   * @param[out] page_id id of created page
+   * @param strategy the access strategy, nullptr for a normal new page
+   * @return nullptr if no instance could create a new page, otherwise pointer to the new page
+   */
+  auto NewPgWithStrategyImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /**
+   * @brief Create a new page in an extent of extent_owner. The extents of an object are reserved by the instance of
+   * its owner page id, which is asked first; the other instances are asked in turn if it has no free frame.
+   * @param[out] page_id id of created page
+   * @param[in,out] extent_owner the object the page is for, INVALID_PAGE_ID for a new object
+   * @param strategy the access strategy, nullptr for a normal new page
+   * @return nullptr if no instance could create a new page, otherwise pointer to the new page
+   */
+  auto NewPgInExtentImp(page_id_t *page_id, page_id_t *extent_owner, BufferAccessStrategy *strategy)
+      -> Page * override;
+
+  /**
+   * @brief Split the pages by the instance that owns them and fetch each shard as one batch there. If some shard
+   * cannot be fetched, the shards fetched so far are unpinned again.
+   * @param page_ids ids of the pages to be fetched
+   * @return the pages in the order of page_ids, empty if they cannot all be fetched
+   */
+  auto FetchPgsImp(const std::vector<page_id_t> &page_ids) -> std::vector<Page *> override;
+
+  /**
+   * @brief Create n new pages in one instance, asked in a round robin manner like NewPgImp(). If no instance has n
+   * frames to spare, the pages are spread over the instances one by one.
+   * @param n number of pages to create
+   * @return the new pages, empty if n pages could not be created
+   */
+  auto NewPgsImp(size_t n) -> std::vector<Page *> override;
+
+  /**
+   * @brief Delete a page from the instance that owns it.
+   * @param page_id id of page to be deleted
+   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   */
+  auto DeletePgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * @brief Flush all the pages of every instance to disk.
+   */
+  void FlushAllPgsImp() override;
+
+ private:
+  /** The shards of the buffer pool, indexed by page_id % num_instances. */
+  std::vector<BufferPoolManagerInstance *> instances_;
+  /** The instance the next NewPage call starts its round robin search at. */
+  std::atomic<size_t> next_instance_{0};
+};
+
+}  // namespace bustub
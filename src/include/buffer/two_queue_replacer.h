@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_queue_replacer.h
+//
+// Identification: src/include/buffer/two_queue_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/eviction_policy.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * TwoQueueReplacer implements the full 2Q replacement policy (Johnson and Shasha, VLDB 1994).
+ *
+ * A page loaded for the first time goes into A1in, a FIFO of at most Kin = c / 4 frames; hits in A1in are ignored,
+ * so a page touched a few times in a short burst does not look hot. Pages pushed out of A1in are remembered in the
+ * ghost FIFO A1out of Kout = c / 2 page ids. A page that is loaded again while it is in A1out has proven to be hot
+ * and goes into Am, an LRU list of the remaining frames. Eviction takes the oldest frame of A1in while A1in is
+ * over Kin, otherwise the least recently used frame of Am. Non-evictable frames are skipped.
+ */
+class TwoQueueReplacer : public EvictionPolicy {
+ public:
+  /**
+   * @brief Create a new TwoQueueReplacer.
+   * @param num_frames the maximum number of frames the replacer will be required to store
+   */
+  explicit TwoQueueReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(TwoQueueReplacer);
+
+  ~TwoQueueReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  auto EvictionOrder(size_t max_frames) -> std::vector<frame_id_t> override;
+
+  void Resize(size_t num_frames) override;
+
+ private:
+  enum Queue { A1IN = 0, AM = 1 };
+
+  struct Frame {
+    page_id_t page_id_{INVALID_PAGE_ID};
+    bool tracked_{false};
+    bool evictable_{false};
+    Queue queue_{A1IN};
+    std::list<frame_id_t>::iterator pos_;
+  };
+
+  void CheckFrameId(frame_id_t frame_id) const;
+
+  /** @return the oldest evictable frame of queue, or queues_[queue].rend() */
+  auto OldestEvictable(Queue queue) -> std::list<frame_id_t>::reverse_iterator;
+
+  size_t capacity_;
+  /** Kin, the size A1in is kept at. */
+  size_t kin_;
+  /** Kout, the number of page ids A1out remembers. */
+  size_t kout_;
+  size_t evictable_count_{0};
+  std::mutex latch_;
+  std::vector<Frame> frames_;
+  /** A1in and Am, newest first. */
+  std::list<frame_id_t> queues_[2];
+  /** A1out, newest first. */
+  std::list<page_id_t> a1out_;
+  std::unordered_map<page_id_t, std::list<page_id_t>::iterator> a1out_index_;
+};
+
+}  // namespace bustub
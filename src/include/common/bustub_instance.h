@@ -22,6 +22,7 @@
 #include <utility>
 #include <vector>
 
+#include "buffer/eviction_policy.h"
 #include "catalog/catalog.h"
 #include "common/config.h"
 #include "common/util/string_util.h"
@@ -211,7 +212,23 @@ class BustubInstance {
   auto MakeExecutorContext(Transaction *txn) -> std::unique_ptr<ExecutorContext>;
 
  public:
-  explicit BustubInstance(const std::string &db_file_name);
+  /**
+   * Create a BusTub instance on the given database file.
+   * @param db_file_name the database file
+   * @param bpm_instances the number of shards of the buffer pool, 1 means a single BufferPoolManagerInstance
+   * @param policy the replacement policy of the buffer pool
+   * @param pool_size the number of frames of the buffer pool, or of every shard of it
+   * @param direct_io true to open the database file with O_DIRECT, so that the buffer pool is the only page cache
+   * @param segment_pages the number of pages of each segment file of the database, 0 for a single file
+   * @param compress true to store the pages compressed, see DiskManagerCompressed; direct_io and segment_pages are
+   * ignored then
+   * @param page_size the page size of a new database, from BUSTUB_PAGE_SIZE to BUSTUB_MAX_PAGE_SIZE; an existing
+   * database keeps the page size it was created with
+   */
+  explicit BustubInstance(const std::string &db_file_name, size_t bpm_instances = 1,
+                          EvictionPolicyType policy = EvictionPolicyType::LRU_K, size_t pool_size = 128,
+                          bool direct_io = false, size_t segment_pages = 0, bool compress = false,
+                          size_t page_size = BUSTUB_PAGE_SIZE);
 
   ~BustubInstance();
 
@@ -239,6 +256,13 @@ class BustubInstance {
    */
   void GenerateMockTable();
 
+  /**
+   * Reload the pages listed in the given sidecar file into the buffer pool in the background, and save the resident
+   * pages to it again when this instance is destroyed, so that the next start does not begin with a cold pool.
+   * @param file_name the sidecar file, see BufferPoolManager::SaveResidentPages
+   */
+  void EnableWarmStart(const std::string &file_name);
+
   // TODO(chi): change to unique_ptr. Currently they're directly referenced by recovery test, so
   // we cannot do anything on them until someone decides to refactor the recovery test.
 
@@ -268,8 +292,12 @@ class BustubInstance {
   void CmdDisplayTables(ResultWriter &writer);
   void CmdDisplayIndices(ResultWriter &writer);
   void CmdDisplayHelp(ResultWriter &writer);
+  void CmdResizeBufferPool(const std::string &pool_size, ResultWriter &writer);
+  void CmdDisplayBufferPool(ResultWriter &writer);
   void WriteOneCell(const std::string &cell, ResultWriter &writer);
   std::unordered_map<std::string, std::string> session_variables_;
+  /** The sidecar file the resident pages are saved to on destruction, empty if warm start is disabled. */
+  std::string warm_start_file_;
 };
 
 }  // namespace bustub
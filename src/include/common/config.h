@@ -27,15 +27,31 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** The background writer of the buffer pool wakes up every BGWRITER_INTERVAL milliseconds. */
+extern std::chrono::milliseconds bgwriter_interval;
+
 static constexpr int INVALID_PAGE_ID = -1;                                           // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                            // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                               // invalid log sequence number
 static constexpr int HEADER_PAGE_ID = 0;                                             // the header page id
-static constexpr int BUSTUB_PAGE_SIZE = 4096;                                        // size of a data page in byte
+static constexpr int BUSTUB_PAGE_SIZE = 4096;                                        // default and min page size
+static constexpr int BUSTUB_MAX_PAGE_SIZE = 65536;                                   // max page size of a database
 static constexpr int BUFFER_POOL_SIZE = 10;                                          // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * BUSTUB_PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                               // size of extendible hash bucket
-static constexpr int LRUK_REPLACER_K = 10;  // lookback window for lru-k replacer
+static constexpr int LRUK_REPLACER_K = 10;             // lookback window for lru-k replacer
+static constexpr int BGWRITER_MAX_PAGES = 16;          // max dirty pages the background writer flushes per round
+static constexpr double BGWRITER_DIRTY_RATIO = 0.1;    // min fraction of dirty frames before the writer flushes
+static constexpr int PREFETCH_QUEUE_SIZE = 64;         // max pending prefetch requests per buffer pool instance
+static constexpr int RING_BUFFER_SIZE = 16;            // default number of frames of a buffer access strategy
+static constexpr int WARM_START_BATCH_SIZE = 32;       // max pages a warm start reads with one sequential read
+static constexpr int DISK_SCHEDULER_QUEUE_DEPTH = 64;  // max requests a disk scheduler keeps in flight
+static constexpr int DISK_SCHEDULER_WORKERS = 4;       // I/O threads of a disk scheduler without io_uring
+static constexpr int FLUSH_BATCH_SIZE = 64;            // max dirty pages FlushAllPages pins and writes at a time
+static constexpr int DISK_MAX_SEGMENTS = 8192;         // max segment files of a segmented database file
+static constexpr int DISK_PREALLOCATE_PAGES = 256;     // pages a disk manager preallocates at a time as files grow
+static constexpr uint32_t EXTENT_PAGES = 64;           // pages reserved at a time for a table or an index
+static constexpr size_t COMPRESSED_SLOT_SIZE = 256;    // granularity of the slots of compressed pages
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
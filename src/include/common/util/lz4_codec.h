@@ -0,0 +1,42 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz4_codec.h
+//
+// Identification: src/include/common/util/lz4_codec.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace bustub {
+
+/**
+ * Lz4Codec compresses small buffers such as pages in the LZ4 block format: a sequence of literal runs and back
+ * references of at least 4 bytes into the last 64 KiB, found through a hash table of 4-byte prefixes. It trades ratio
+ * for speed, like LZ4, and its output can be decoded by any LZ4 block decoder.
+ */
+class Lz4Codec {
+ public:
+  /**
+   * @brief Compress size bytes of src into dst.
+   * @param capacity the size of dst
+   * @return the size of the compressed data, or 0 if it does not fit in capacity bytes
+   */
+  static auto Compress(const char *src, size_t size, char *dst, size_t capacity) -> size_t;
+
+  /**
+   * @brief Decompress size bytes of compressed data from src into dst.
+   * @param capacity the size of dst
+   * @return the size of the decompressed data, or 0 if src is not valid compressed data or does not fit in capacity
+   * bytes
+   */
+  static auto Decompress(const char *src, size_t size, char *dst, size_t capacity) -> size_t;
+};
+
+}  // namespace bustub
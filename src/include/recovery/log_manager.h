@@ -16,6 +16,7 @@
 #include <condition_variable>  // NOLINT
 #include <future>              // NOLINT
 #include <mutex>               // NOLINT
+#include <thread>              // NOLINT
 
 #include "recovery/log_record.h"
 #include "storage/disk/disk_manager.h"
@@ -25,6 +26,12 @@ namespace bustub {
 /**
  * LogManager maintains a separate thread that is awakened whenever the log buffer is full or whenever a timeout
  * happens. When the thread is awakened, the log buffer's content is written into the disk log file.
+ *
+ * The log is double buffered: records are appended to log_buffer_ while the flush thread writes and syncs
+ * flush_buffer_, and the two are swapped at every flush. The flush thread wakes up every log_timeout, when the log
+ * buffer is full, or when Flush() asks for the log up to an LSN, e.g. for a commit or for a page the buffer pool
+ * writes back. Flush() waits only for the flush that covers its LSN, so the transactions that commit while a flush
+ * is in progress are all made durable by the next one, with a single write and sync of the log file.
  */
 class LogManager {
  public:
@@ -35,6 +42,7 @@ class LogManager {
   }
 
   ~LogManager() {
+    StopFlushThread();
     delete[] log_buffer_;
     delete[] flush_buffer_;
     log_buffer_ = nullptr;
@@ -46,27 +54,51 @@ class LogManager {
 
   auto AppendLogRecord(LogRecord *log_record) -> lsn_t;
 
+  /**
+   * @brief Make the log durable up to and including lsn, waiting for the flush that covers it. Without a flush
+   * thread the calling thread flushes the log itself.
+   * @param lsn the LSN of a record, e.g. of a commit record or of the last change to a page; LSNs that were not
+   * handed out yet are clamped to the last one that was
+   */
+  void Flush(lsn_t lsn);
+
   inline auto GetNextLSN() -> lsn_t { return next_lsn_; }
   inline auto GetPersistentLSN() -> lsn_t { return persistent_lsn_; }
   inline void SetPersistentLSN(lsn_t lsn) { persistent_lsn_ = lsn; }
   inline auto GetLogBuffer() -> char * { return log_buffer_; }
 
  private:
-  // TODO(students): you may add your own member variables
+  /**
+   * Swap the buffers and write the records of the full one to the log file, with latch_ released meanwhile. Only
+   * one thread flushes at a time.
+   */
+  void FlushBuffer(std::unique_lock<std::mutex> *lock);
 
   /** The atomic counter which records the next log sequence number. */
   std::atomic<lsn_t> next_lsn_;
   /** The log records before and including the persistent lsn have been written to disk. */
   std::atomic<lsn_t> persistent_lsn_;
 
+  /** The buffer records are appended to, holding log_buffer_size_ bytes. */
   char *log_buffer_;
+  /** The buffer being written to the log file, if flushing_. */
   char *flush_buffer_;
+  size_t log_buffer_size_{0};
 
+  /** Protects the buffers and everything below. */
   std::mutex latch_;
 
-  std::thread *flush_thread_ __attribute__((__unused__));
+  std::thread *flush_thread_{nullptr};
+  /** True while a thread writes flush_buffer_ to the log file. */
+  bool flushing_{false};
+  /** The highest LSN a Flush() is waiting for, INVALID_LSN if none. */
+  lsn_t flush_requested_lsn_{INVALID_LSN};
+  bool stop_{false};
 
+  /** Wakes up the flush thread. */
   std::condition_variable cv_;
+  /** Notified when a flush completes, for appenders waiting for room and Flush() waiting for its LSN. */
+  std::condition_variable flushed_cv_;
 
   DiskManager *disk_manager_ __attribute__((__unused__));
 };
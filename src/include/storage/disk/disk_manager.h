@@ -13,50 +13,166 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
+#include <cstdlib>
 #include <fstream>
 #include <future>  // NOLINT
-#include <mutex>   // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <vector>
 
 #include "common/config.h"
+#include "storage/disk/extent_map.h"
+#include "storage/disk/free_page_map.h"
 
 namespace bustub {
 
+/** Frees the memory of an AlignedBuffer. */
+struct AlignedFree {
+  void operator()(char *data) const { std::free(data); }  // NOLINT
+};
+
+/** Page data on the heap, aligned to BUSTUB_PAGE_SIZE so that it can be read and written with O_DIRECT. */
+using AlignedBuffer = std::unique_ptr<char, AlignedFree>;
+
+/**
+ * @brief Allocate BUSTUB_PAGE_SIZE aligned memory for num_pages pages of page_size bytes.
+ * @throws Exception if the memory cannot be allocated
+ */
+auto AllocateAlignedPages(size_t num_pages, size_t page_size = BUSTUB_PAGE_SIZE) -> AlignedBuffer;
+
+/** @return true if data starts on a BUSTUB_PAGE_SIZE boundary */
+inline auto IsPageAligned(const void *data) -> bool {
+  return reinterpret_cast<uintptr_t>(data) % BUSTUB_PAGE_SIZE == 0;
+}
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Pages are read and written with positional pread/pwrite on one file descriptor, so any number of threads can do
+ * page I/O at the same time. A write is handed to the OS and is not durable until the next Sync().
+ *
+ * With direct I/O the database file is opened with O_DIRECT, so pages move between the disk and the caller's buffer
+ * without being cached, and copied, by the kernel page cache; the buffer pool is then the only cache of the pages.
+ * O_DIRECT needs page aligned buffers: the frames of the buffer pool are, and other buffers are bounced through an
+ * aligned copy.
+ *
+ * Pages are addressed with 64-bit offsets. The database file can be split into segment files of segment_pages pages
+ * each: db_file holds the first segment and db_file.1, db_file.2, ... the next ones, created as pages are written to
+ * them. Space is preallocated with fallocate, DISK_PREALLOCATE_PAGES pages at a time, as the files grow.
+ *
+ * The free page map and the extent map of the database are kept next to it, in the .fsm and .ext files, and are
+ * written by Sync().
+ *
+ * The page size of a database, a power of two from BUSTUB_PAGE_SIZE to BUSTUB_MAX_PAGE_SIZE, is chosen when the
+ * database file is created and recorded in the header page of the free page map, so that the database is reopened
+ * with the same page size whatever the caller asks for.
  */
 class DiskManager {
  public:
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param direct_io true to bypass the kernel page cache with O_DIRECT; falls back to buffered I/O if the file
+   * system does not support it
+   * @param segment_pages the number of pages of each segment file, 0 to keep the whole database in db_file
+   * @param page_size the page size of a new database; an existing one keeps the page size it was created with
+   * @throws Exception if page_size is not a power of two from BUSTUB_PAGE_SIZE to BUSTUB_MAX_PAGE_SIZE
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool direct_io = false, size_t segment_pages = 0,
+                       size_t page_size = BUSTUB_PAGE_SIZE);
 
   /** FOR TEST / LEADERBOARD ONLY, used by DiskManagerMemory */
   DiskManager() = default;
 
-  virtual ~DiskManager() = default;
+  /** Closes the database file if ShutDown() was not called. */
+  virtual ~DiskManager();
 
   /**
-   * Shut down the disk manager and close all the file resources.
+   * Shut down the disk manager: make the written pages durable and close all the file resources.
    */
   void ShutDown();
 
+  /**
+   * Make every page written so far durable with fdatasync, then write and sync the changes of the free page map and
+   * the extent map.
+   */
+  virtual void Sync();
+
   /**
    * Write a page to the database file.
    * @param page_id id of the page
    * @param page_data raw page data
+   * @return false if the page could not be written
    */
-  virtual void WritePage(page_id_t page_id, const char *page_data);
+  virtual auto WritePage(page_id_t page_id, const char *page_data) -> bool;
+
+  /**
+   * Write a run of consecutive pages, whose data may be scattered in memory, with vectored pwritev calls.
+   * Falls back to one WritePage() per page if GetFileDescriptor() is -1.
+   * @param first_page id of the first page
+   * @param pages the data of the pages first_page, first_page + 1, ...
+   * @return false if any of the pages could not be written
+   */
+  virtual auto WritePages(page_id_t first_page, const std::vector<const char *> &pages) -> bool;
 
   /**
    * Read a page from the database file.
    * @param page_id id of the page
    * @param[out] page_data output buffer
+   * @return false if the page could not be read; a page past the end of the file reads as zeros and is no error
+   */
+  virtual auto ReadPage(page_id_t page_id, char *page_data) -> bool;
+
+  /**
+   * Read a run of consecutive pages from the database file with one sequential read.
+   * @param first_page id of the first page
+   * @param num_pages number of pages to read
+   * @param[out] data output buffer of num_pages * GetPageSize() bytes
+   * @return false if any of the pages could not be read
+   */
+  virtual auto ReadPages(page_id_t first_page, size_t num_pages, char *data) -> bool;
+
+  /**
+   * @return the file descriptor of the (first segment of the) database file, or -1 if page I/O has to go through
+   * ReadPages() and WritePage(), e.g. because a subclass keeps the pages elsewhere. If it is not -1, a DiskScheduler
+   * may issue asynchronous page I/O on the files given by LocatePages().
    */
-  virtual void ReadPage(page_id_t page_id, char *page_data);
+  virtual auto GetFileDescriptor() -> int { return segments_ == nullptr ? -1 : segments_[0].fd_.load(); }
+
+  /**
+   * Find the file that holds a run of consecutive pages.
+   * @param first_page id of the first page
+   * @param num_pages number of pages
+   * @param create true to create the segment file if it does not exist yet, and preallocate space for the pages
+   * @param[out] offset offset of the first page in the file
+   * @return the file descriptor, or -1 if the pages span two segments or their segment file does not exist
+   */
+  auto LocatePages(page_id_t first_page, size_t num_pages, bool create, int64_t *offset) -> int;
+
+  /** @return the map of the free pages of the database, which new pages are allocated from */
+  auto GetFreePageMap() -> FreePageMap * { return &free_page_map_; }
+
+  /** @return the map of the extents reserved for the tables and indexes of the database */
+  auto GetExtentMap() -> ExtentMap * { return &extent_map_; }
+
+  /** @return the size of the pages of the database in bytes */
+  auto GetPageSize() const -> size_t { return page_size_; }
+
+  /** @return the number of pages of each segment file, 0 if the database is not segmented */
+  auto GetSegmentPages() const -> size_t { return segment_pages_; }
+
+  /** @return true if the database file was opened with O_DIRECT, so every I/O on it needs page aligned buffers */
+  auto IsDirectIo() const -> bool { return direct_io_; }
+
+  /**
+   * Account for a page written straight to the file descriptor by a DiskScheduler: count the write, grow the cached
+   * file size and make the next Sync() cover it.
+   * @param page_id id of the written page
+   */
+  void OnPageWritten(page_id_t page_id);
 
   /**
    * Flush the entire log buffer into disk.
@@ -72,7 +188,7 @@ class DiskManager {
    * @param offset offset of the log entry in the file
    * @return true if the read was successful, false otherwise
    */
-  auto ReadLog(char *log_data, int size, int offset) -> bool;
+  auto ReadLog(char *log_data, int size, int64_t offset) -> bool;
 
   /** @return the number of disk flushes */
   auto GetNumFlushes() const -> int;
@@ -80,6 +196,9 @@ class DiskManager {
   /** @return true iff the in-memory content has not been flushed yet */
   auto GetFlushState() const -> bool;
 
+  /** @return the number of database file syncs that reached the disk */
+  auto GetNumSyncs() const -> int { return num_syncs_; }
+
   /** @return the number of disk writes */
   auto GetNumWrites() const -> int;
 
@@ -93,19 +212,62 @@ class DiskManager {
   inline auto HasFlushLogFuture() -> bool { return flush_log_f_ != nullptr; }
 
  protected:
-  auto GetFileSize(const std::string &file_name) -> int;
+  /**
+   * Creates a disk manager without a database file, for the subclasses that keep the pages elsewhere.
+   * @param page_size the page size of the pages
+   * @throws Exception if page_size is not a power of two from BUSTUB_PAGE_SIZE to BUSTUB_MAX_PAGE_SIZE
+   */
+  explicit DiskManager(size_t page_size);
+
+  /** One segment file of the database. */
+  struct Segment {
+    // file descriptor, -1 if the segment file was not created yet or is closed
+    std::atomic<int> fd_{-1};
+    // bytes preallocated with fallocate from the start of the file
+    std::atomic<int64_t> allocated_{0};
+  };
+
+  auto GetFileSize(const std::string &file_name) -> int64_t;
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // descriptor of the log file used to fdatasync what log_io_ wrote, -1 if not open
+  int log_fd_{-1};
+  /**
+   * Read size bytes at offset of the file fd with pread, retrying short reads. Bytes past the end of the file read as
+   * zeros, and so does everything if fd is -1.
+   * @return false if pread failed; the bytes it did not read are zeroed
+   */
+  auto ReadAt(int fd, int64_t offset, char *data, size_t size) -> bool;
+  /** @return the file name of a segment */
+  auto SegmentFileName(size_t segment) const -> std::string;
+  /** @return the number of pages from page_id to the end of its segment */
+  auto PagesLeftInSegment(page_id_t page_id) const -> size_t;
+  auto SegmentBytes() const -> int64_t { return static_cast<int64_t>(segment_pages_) * page_size_; }
+  /** Preallocate the space of segment up to at least end, rounded up to DISK_PREALLOCATE_PAGES pages. */
+  void Preallocate(Segment *segment, int fd, int64_t end);
+  void CloseSegments();
+  bool direct_io_{false};
+  size_t page_size_{BUSTUB_PAGE_SIZE};
   std::string file_name_;
+  size_t segment_pages_{0};
+  // the segments, nullptr for DiskManagerMemory; only the first open_segments_ of the num_segments_ ones are open
+  std::unique_ptr<Segment[]> segments_;
+  size_t num_segments_{0};
+  std::atomic<size_t> open_segments_{0};
+  // serializes creating segment files
+  std::mutex segments_latch_;
+  FreePageMap free_page_map_;
+  ExtentMap extent_map_;
+  // size of the db file, kept here so that reads do not stat the file; only grows
+  std::atomic<int64_t> db_file_size_{0};
+  // true if pages were written since the last Sync()
+  std::atomic<bool> needs_sync_{false};
   int num_flushes_{0};
-  int num_writes_{0};
+  std::atomic<int> num_writes_{0};
+  std::atomic<int> num_syncs_{0};
   bool flush_log_{false};
   std::future<void> *flush_log_f_{nullptr};
-  // With multiple buffer pool instances, need to protect file access
-  std::mutex db_io_latch_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,108 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_compressed.h
+//
+// Identification: src/include/storage/disk/disk_manager_compressed.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>  // NOLINT
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * DiskManagerCompressed stores every page of the database file compressed with Lz4Codec, so that fewer bytes are
+ * read and written per page. The buffer pool sees uncompressed pages as usual.
+ *
+ * A compressed page is written to a slot of the database file whose size is a multiple of COMPRESSED_SLOT_SIZE, and
+ * a page that does not compress is stored as is. The page map, kept in the .pmap file next to the database, records
+ * the slot of each page. A page is never overwritten in place: it is written to a free slot, and its old slot becomes
+ * free once Sync() has made the page map that no longer points to it durable. After a restart the pages are the ones
+ * of the last Sync(), and the free slots are the gaps between the slots of the page map.
+ *
+ * Pages go through ReadPages() and WritePage() only: GetFileDescriptor() is -1, so a DiskScheduler does not read
+ * the compressed file directly. Direct I/O and segment files are not supported.
+ */
+class DiskManagerCompressed : public DiskManager {
+ public:
+  /**
+   * Creates a new disk manager that writes compressed pages to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param page_size the page size of a new database, as for DiskManager
+   */
+  explicit DiskManagerCompressed(const std::string &db_file, size_t page_size = BUSTUB_PAGE_SIZE);
+
+  /** Closes the page map. */
+  ~DiskManagerCompressed() override;
+
+  auto WritePage(page_id_t page_id, const char *page_data) -> bool override;
+
+  /** @return false if the page could not be read or does not decompress */
+  auto ReadPage(page_id_t page_id, char *page_data) -> bool override;
+
+  auto ReadPages(page_id_t first_page, size_t num_pages, char *data) -> bool override;
+
+  /** Sync the database file, then write and sync the changes of the page map and free the slots it released. */
+  void Sync() override;
+
+  auto GetFileDescriptor() -> int override { return -1; }
+
+  /** @return the number of bytes of the slots the pages are stored in, a measure of the compression */
+  auto GetStoredBytes() const -> uint64_t { return stored_bytes_; }
+
+ private:
+  /** Where a page is stored. */
+  struct Slot {
+    /** Offset in the database file, -1 if the page was never written. */
+    int64_t offset_;
+    /** Size of the slot, a multiple of COMPRESSED_SLOT_SIZE. */
+    uint32_t capacity_;
+    /** Size of the stored page, the page size if it is not compressed. */
+    uint32_t length_;
+  };
+
+  static constexpr size_t SLOTS_PER_PAGE = BUSTUB_PAGE_SIZE / sizeof(Slot);
+  /** Magic number at the start of the header page of the page map, "BPMP". */
+  static constexpr uint32_t MAGIC = 0x504d5042;
+
+  /** Load the page map from its file, or start an empty one. */
+  void OpenPageMap(const std::string &file_name, bool reset);
+  /** @return a free slot of at least capacity bytes. Caller must hold latch_. */
+  auto AllocateSlot(uint32_t capacity) -> int64_t;
+  /** Add a slot to the free slots. Caller must hold latch_. */
+  void AddFreeSlot(int64_t offset, uint32_t capacity);
+  /** Write the changed pages of the page map and sync it. */
+  auto FlushPageMap() -> bool;
+
+  /** Protects everything below except stored_bytes_. */
+  std::mutex latch_;
+  /** The slot of each page id. */
+  std::vector<Slot> slots_;
+  /** dirty_[i] is true if page i of the page map changed since the last Sync(). */
+  std::vector<bool> dirty_;
+  /** Free slots by size, then offset. */
+  std::multimap<uint32_t, int64_t> free_slots_;
+  /** Slots released since the last Sync(), free once the page map is durable. */
+  std::vector<std::pair<int64_t, uint32_t>> released_slots_;
+  /** The end of the last slot of the database file. */
+  int64_t file_end_{0};
+  int page_map_fd_{-1};
+  std::atomic<uint64_t> stored_bytes_{0};
+};
+
+}  // namespace bustub
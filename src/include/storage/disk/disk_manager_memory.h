@@ -9,6 +9,9 @@
 // Copyright (c) 2015-2020, Carnegie Mellon University Database Group
 //
 //===----------------------------------------------------------------------===//
+
+#pragma once
+
 #include <fstream>
 #include <future>  // NOLINT
 #include <string>
@@ -20,11 +23,16 @@ namespace bustub {
 
 /**
  * DiskManagerMemory replicates the utility of DiskManager on memory. It is primarily used for
- * data structure performance testing.
+ * data structure performance testing. Its pages can have any of the page sizes of DiskManager.
  */
 class DiskManagerMemory : public DiskManager {
  public:
-  explicit DiskManagerMemory(size_t pages);
+  /**
+   * @param pages the number of pages the memory holds
+   * @param page_size the size of the pages, as for DiskManager
+   * @throws Exception if page_size is not a power of two from BUSTUB_PAGE_SIZE to BUSTUB_MAX_PAGE_SIZE
+   */
+  explicit DiskManagerMemory(size_t pages, size_t page_size = BUSTUB_PAGE_SIZE);
 
   ~DiskManagerMemory() override { delete[] memory_; }
 
@@ -32,18 +40,30 @@ class DiskManagerMemory : public DiskManager {
    * Write a page to the database file.
    * @param page_id id of the page
    * @param page_data raw page data
+   * @return false if the page is not one of the pages of the memory
    */
-  void WritePage(page_id_t page_id, const char *page_data) override;
+  auto WritePage(page_id_t page_id, const char *page_data) -> bool override;
 
   /**
    * Read a page from the database file.
    * @param page_id id of the page
    * @param[out] page_data output buffer
+   * @return false if the page is not one of the pages of the memory
+   */
+  auto ReadPage(page_id_t page_id, char *page_data) -> bool override;
+
+  /**
+   * Read a run of consecutive pages, one ReadPage() at a time.
+   * @param first_page id of the first page
+   * @param num_pages number of pages to read
+   * @param[out] data output buffer of num_pages * GetPageSize() bytes
+   * @return false if any of the pages could not be read
    */
-  void ReadPage(page_id_t page_id, char *page_data) override;
+  auto ReadPages(page_id_t first_page, size_t num_pages, char *data) -> bool override;
 
  private:
   char *memory_;
+  size_t pages_;
 };
 
 }  // namespace bustub
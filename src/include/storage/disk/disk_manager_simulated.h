@@ -0,0 +1,108 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_simulated.h
+//
+// Identification: src/include/storage/disk/disk_manager_simulated.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+/**
+ * The cost model of the device simulated by DiskManagerSimulated.
+ */
+struct SimulatedDevice {
+  /** Time from issuing an I/O that does not continue the previous one until its data starts to move. */
+  std::chrono::microseconds random_latency_{0};
+  /** Time from issuing an I/O that starts where the previous one ended until its data starts to move. */
+  std::chrono::microseconds sequential_latency_{0};
+  /** Time a Sync() takes. */
+  std::chrono::microseconds sync_latency_{0};
+  /** Bytes per second the device moves, shared by all the I/Os in flight; 0 for no limit. */
+  uint64_t bandwidth_{0};
+  /** Max I/Os in flight; more wait for one of them to complete. */
+  size_t queue_depth_{1};
+
+  /** @return a local NVMe SSD: tens of microseconds per I/O, deep queue, a few GB/s */
+  static auto Nvme() -> SimulatedDevice {
+    return {std::chrono::microseconds(80), std::chrono::microseconds(20), std::chrono::microseconds(50),
+            uint64_t{3} << 30, 64};
+  }
+
+  /** @return a network attached cloud block volume: about a millisecond per I/O, shallow queue, ~250 MB/s */
+  static auto CloudBlockStorage() -> SimulatedDevice {
+    return {std::chrono::microseconds(1000), std::chrono::microseconds(500), std::chrono::microseconds(2000),
+            uint64_t{250} << 20, 16};
+  }
+};
+
+/**
+ * DiskManagerSimulated keeps the pages in memory like DiskManagerMemory, but makes each I/O take as long as it would
+ * on a simulated device, so that tests and benchmarks see the I/O stalls of a real disk, repeatably on any machine.
+ *
+ * An I/O waits for one of the queue_depth_ slots of the device, then for its latency, random or sequential, then for
+ * its bytes to move through the device at bandwidth_, one I/O at a time, before the calling thread returns. I/Os in
+ * flight overlap their latencies but not their transfers. A run of pages read by ReadPages() or written by
+ * WritePages() is one I/O.
+ */
+class DiskManagerSimulated : public DiskManagerMemory {
+ public:
+  /**
+   * @brief Create a simulated disk of a number of pages.
+   * @param pages the number of pages the disk holds
+   * @param device the cost model of the disk
+   * @param page_size the size of the pages, as for DiskManager; an I/O moves num_pages * page_size bytes
+   */
+  DiskManagerSimulated(size_t pages, const SimulatedDevice &device, size_t page_size = BUSTUB_PAGE_SIZE);
+
+  auto WritePage(page_id_t page_id, const char *page_data) -> bool override;
+
+  auto WritePages(page_id_t first_page, const std::vector<const char *> &pages) -> bool override;
+
+  auto ReadPage(page_id_t page_id, char *page_data) -> bool override;
+
+  /** Read a run of consecutive pages as one I/O. */
+  auto ReadPages(page_id_t first_page, size_t num_pages, char *data) -> bool override;
+
+  void Sync() override;
+
+  /** @return the number of I/Os that started where the previous one ended */
+  auto GetNumSequentialIos() const -> size_t { return num_sequential_ios_; }
+
+  /** @return the number of I/Os that did not start where the previous one ended */
+  auto GetNumRandomIos() const -> size_t { return num_random_ios_; }
+
+ private:
+  /** Wait for a queue slot and for the time the device takes to move num_pages pages from first_page. */
+  void SimulateIo(page_id_t first_page, size_t num_pages);
+
+  SimulatedDevice device_;
+  std::mutex latch_;
+  std::condition_variable slot_freed_;
+  /** The number of I/Os in flight. Protected by latch_. */
+  size_t in_flight_{0};
+  /** The page after the last I/O issued. Protected by latch_. */
+  page_id_t next_sequential_page_{INVALID_PAGE_ID};
+  /** When the device is done moving the data of the I/Os issued so far. Protected by latch_. */
+  std::chrono::steady_clock::time_point transfer_done_;
+  std::atomic<size_t> num_sequential_ios_{0};
+  std::atomic<size_t> num_random_ios_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,141 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler.h
+//
+// Identification: src/include/storage/disk/disk_scheduler.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <future>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * A read or a write of a run of consecutive pages, handed to a DiskScheduler.
+ */
+struct DiskRequest {
+  /** True to write data_ to the pages, false to read the pages into data_. */
+  bool is_write_{false};
+  /** num_pages_ pages of page data, which the caller keeps alive until the request completes. */
+  char *data_{nullptr};
+  /** Id of the first page. */
+  page_id_t page_id_{INVALID_PAGE_ID};
+  size_t num_pages_{1};
+  /** Optional, called on an I/O thread when the request completes, with true if it succeeded. */
+  std::function<void(bool)> callback_;
+};
+
+/**
+ * DiskScheduler runs page I/O for its DiskManager asynchronously, so a caller can keep many requests in flight
+ * instead of blocking on one page at a time.
+ *
+ * If the disk manager exposes a file descriptor and the kernel supports io_uring, the requests are submitted to an
+ * io_uring of queue_depth entries by one I/O thread, which submits everything that was scheduled since its last
+ * submission with a single system call. Otherwise, e.g. for DiskManagerMemory, a pool of worker threads runs the
+ * requests through ReadPages() and WritePage(), at most queue_depth of them at a time.
+ *
+ * Each io_uring request goes to the file DiskManager::LocatePages() gives for its pages. Requests that span two
+ * segment files, reads of segment files that do not exist yet, and, with direct I/O, requests whose data is not page
+ * aligned run synchronously on the I/O thread instead, through the disk manager.
+ *
+ * Requests that are in flight together may complete in any order; a caller that needs an order, e.g. a write back
+ * before a read into the same frame, waits for the first request before scheduling the second.
+ */
+class DiskScheduler {
+ public:
+  /**
+   * @brief Start the I/O thread of the io_uring, or the worker threads.
+   * @param disk_manager the disk manager to do the I/O for
+   * @param queue_depth the maximum number of requests in flight
+   * @param num_workers the number of worker threads if io_uring is not used
+   * @param use_io_uring false to always use worker threads
+   */
+  explicit DiskScheduler(DiskManager *disk_manager, size_t queue_depth = DISK_SCHEDULER_QUEUE_DEPTH,
+                         size_t num_workers = DISK_SCHEDULER_WORKERS, bool use_io_uring = true);
+
+  /** @brief Finish the scheduled requests, then stop the I/O threads. */
+  ~DiskScheduler();
+
+  DISALLOW_COPY_AND_MOVE(DiskScheduler);
+
+  /**
+   * @brief Schedule a request.
+   * @param request the request
+   * @return a future that becomes true once the request succeeded, or false if it failed
+   */
+  auto Schedule(DiskRequest request) -> std::future<bool>;
+
+  /**
+   * @brief Schedule several requests, which are submitted together.
+   * @param requests the requests
+   * @return a future per request, in the order of requests
+   */
+  auto ScheduleBatch(std::vector<DiskRequest> requests) -> std::vector<std::future<bool>>;
+
+  /** @return true if the requests go through io_uring, false if they run on worker threads */
+  auto UsesIoUring() const -> bool { return ring_ != nullptr; }
+
+  auto GetQueueDepth() const -> size_t { return queue_depth_; }
+
+ private:
+  /** A scheduled request and the promise of its future. */
+  struct Pending {
+    DiskRequest request_;
+    std::promise<bool> promise_;
+  };
+
+  /** The io_uring and its mapped rings, defined next to the code that uses it. */
+  struct Ring;
+
+  /** @brief Set up an io_uring of queue_depth_ entries. */
+  auto SetUpRing() -> bool;
+
+  /** @brief Unmap the rings and close the io_uring. */
+  void TearDownRing();
+
+  /**
+   * @brief Body of the I/O thread: submit scheduled requests to the ring and complete the finished ones. If
+   * io_uring_enter keeps failing, the thread runs the requests through the disk manager like a worker thread.
+   */
+  void RingLoop();
+
+  /** @brief Body of a worker thread: run scheduled requests through the disk manager. */
+  void WorkerLoop();
+
+  /** @brief Run a request synchronously through the disk manager. @return true if it succeeded */
+  auto RunSync(const DiskRequest &request) -> bool;
+
+  /** @brief Call the callback of a finished request, fulfil its promise and free it. */
+  static void Complete(Pending *pending, bool success);
+
+  DiskManager *disk_manager_;
+  const size_t queue_depth_;
+  Ring *ring_{nullptr};
+
+  /** Protects queue_ and stop_. */
+  std::mutex latch_;
+  /** Signalled when a request is scheduled or the scheduler stops. */
+  std::condition_variable cv_;
+  /** Scheduled requests that were not picked up by an I/O thread yet. */
+  std::deque<Pending *> queue_;
+  bool stop_{false};
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extent_map.h
+//
+// Identification: src/include/storage/disk/extent_map.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ExtentMap records the extents of the objects of a database, e.g. its tables and indexes. An extent is a run of
+ * EXTENT_PAGES page ids reserved for one object, so that the pages the object allocates one by one end up next to
+ * each other in the database file instead of interleaved with the pages of other objects. The pages of an extent are
+ * first_page, first_page + stride, ...; the stride is the number of instances of a sharded buffer pool, so that all
+ * the pages of an extent belong to the instance that reserved it.
+ *
+ * An object is identified by a page id that is stable for it, e.g. its first page. The pages of an extent are handed
+ * out in order; a page that is deleted later goes to the FreePageMap and does not come back to its extent.
+ *
+ * The map can be kept in a file of BUSTUB_PAGE_SIZE pages: a header page with the number of extents, then the
+ * extents, packed. Flush() writes the pages that changed and syncs the file, so after a restart the map is the one of
+ * the last Flush().
+ */
+class ExtentMap {
+ public:
+  /** One extent, as it is stored in the file of the map. */
+  struct Extent {
+    page_id_t first_page_;
+    page_id_t owner_;
+    uint32_t stride_;
+    /** The number of pages of the extent handed out so far. */
+    uint32_t used_;
+  };
+
+  /** Create an empty map that is kept in memory only. */
+  ExtentMap() = default;
+
+  /** Closes the file of the map, without flushing it. */
+  ~ExtentMap();
+
+  DISALLOW_COPY_AND_MOVE(ExtentMap);
+
+  /**
+   * @brief Keep the map in a file, loading it from there if the file holds one.
+   * @param file_name the file of the map
+   * @param reset true to start with an empty map, e.g. because the database file is new
+   * @return false if the file cannot be opened
+   */
+  auto Open(const std::string &file_name, bool reset) -> bool;
+
+  /**
+   * @brief Take the next unused page of an extent of owner whose pages are offset modulo stride.
+   * @return the page id, or INVALID_PAGE_ID if every such extent of owner is used up
+   */
+  auto Allocate(page_id_t owner, size_t stride = 1, size_t offset = 0) -> page_id_t;
+
+  /** @brief Add the extent of the pages first_page, first_page + stride, ... to owner, none of them handed out yet. */
+  void AddExtent(page_id_t owner, page_id_t first_page, size_t stride = 1);
+
+  /** @return true if page_id belongs to an extent but was not handed out yet */
+  auto IsReserved(page_id_t page_id) -> bool;
+
+  /** @return the extents of owner, in the order they were added */
+  auto GetExtents(page_id_t owner) -> std::vector<Extent>;
+
+  /** @return the number of extents of all the objects */
+  auto GetNumExtents() -> size_t;
+
+  /**
+   * @brief Write the changed pages of the map to its file and sync it. Does nothing for a map kept in memory only.
+   * @return false on an I/O error
+   */
+  auto Flush() -> bool;
+
+  /** @brief Close the file of the map, without flushing it. */
+  void Close();
+
+ private:
+  static constexpr size_t EXTENTS_PER_PAGE = BUSTUB_PAGE_SIZE / sizeof(Extent);
+  /** Magic number at the start of the header page, "BEXT". */
+  static constexpr uint32_t MAGIC = 0x54584542;
+
+  /** Mark the page of the file that holds extent i as changed. Caller must hold latch_. */
+  void MarkDirty(size_t i);
+
+  std::mutex latch_;
+  std::vector<Extent> extents_;
+  /** The extents of each owner that still have unused pages, as indexes into extents_. */
+  std::unordered_map<page_id_t, std::vector<size_t>> open_;
+  /** dirty_[i] is true if page i of the extents changed since the last Flush(). */
+  std::vector<bool> dirty_;
+  /** The number of extents changed since the last Flush(). */
+  bool header_dirty_{false};
+  int fd_{-1};
+};
+
+}  // namespace bustub
@@ -0,0 +1,119 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_page_map.h
+//
+// Identification: src/include/storage/disk/free_page_map.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FreePageMap tracks the pages of a database that were deallocated and can be handed out again, and the next page id
+ * that was never allocated, so that new pages reuse freed ones before the database file grows.
+ *
+ * The map is a bitmap with one bit per page id. It can be kept in a file of BUSTUB_PAGE_SIZE pages: a header page with
+ * the next page id and the page size of the database, then the bitmap pages, each covering BUSTUB_PAGE_SIZE * 8 page
+ * ids. Flush() writes the pages that changed and syncs the file, so after a restart the map is the one of the last
+ * Flush().
+ */
+class FreePageMap {
+ public:
+  /** Create an empty map that is kept in memory only. */
+  FreePageMap() = default;
+
+  /** Closes the file of the map, without flushing it. */
+  ~FreePageMap();
+
+  DISALLOW_COPY_AND_MOVE(FreePageMap);
+
+  /**
+   * @brief Keep the map in a file, loading it from there if the file holds one.
+   * @param file_name the file of the map
+   * @param reset true to start with an empty map, e.g. because the database file is new
+   * @return false if the file cannot be opened
+   */
+  auto Open(const std::string &file_name, bool reset) -> bool;
+
+  /**
+   * @brief Take the lowest free page whose id is offset modulo stride, as pages of a sharded buffer pool are.
+   * @return the page id, or INVALID_PAGE_ID if there is no such free page
+   */
+  auto Allocate(size_t stride = 1, size_t offset = 0) -> page_id_t;
+
+  /**
+   * @brief Mark a page as free. Freeing a free page does nothing, and so does freeing a page id that was never
+   * allocated, i.e. one at or past GetNextPageId(): handing it out would give it a second time once the database
+   * grows to it.
+   */
+  void Free(page_id_t page_id);
+
+  /** @return true if the page is free */
+  auto IsFree(page_id_t page_id) -> bool;
+
+  /** @brief Record that page_id was allocated by extending the database, so the next page id is past it. */
+  void NoteAllocated(page_id_t page_id);
+
+  /** @return the lowest page id that was never allocated */
+  auto GetNextPageId() const -> page_id_t { return next_page_id_; }
+
+  /** @return the page size recorded for the database, 0 if none was, e.g. because the file predates it */
+  auto GetPageSize() const -> size_t { return page_size_; }
+
+  /** @brief Record the page size of the database; it is written by the next Flush(). */
+  void SetPageSize(size_t page_size);
+
+  /** @return the number of free pages */
+  auto GetNumFreePages() const -> size_t { return num_free_; }
+
+  /**
+   * @brief Write the changed pages of the map to its file and sync it. Does nothing for a map kept in memory only.
+   * @return false on an I/O error
+   */
+  auto Flush() -> bool;
+
+  /** @brief Close the file of the map, without flushing it. */
+  void Close();
+
+ private:
+  /** Page ids covered by one bitmap page of the file. */
+  static constexpr size_t PAGE_IDS_PER_PAGE = BUSTUB_PAGE_SIZE * 8;
+  static constexpr size_t WORDS_PER_PAGE = BUSTUB_PAGE_SIZE / sizeof(uint64_t);
+  /** Magic number at the start of the header page, "BFSM". */
+  static constexpr uint32_t MAGIC = 0x4d534642;
+
+  /** Grow the bitmap so that it covers page_id. Caller must hold latch_. */
+  void Cover(page_id_t page_id);
+
+  /** Protects bits_, dirty_ and first_word_. */
+  std::mutex latch_;
+  /** Bit page_id % 64 of word page_id / 64 is set if the page is free. */
+  std::vector<uint64_t> bits_;
+  /** dirty_[i] is true if bitmap page i changed since the last Flush(). */
+  std::vector<bool> dirty_;
+  /** Every word before this one is 0. */
+  size_t first_word_{0};
+  std::atomic<size_t> num_free_{0};
+  std::atomic<page_id_t> next_page_id_{0};
+  std::atomic<uint32_t> page_size_{0};
+  /** The next page id or the page size changed since the last Flush(). */
+  std::atomic<bool> header_dirty_{false};
+  int fd_{-1};
+};
+
+}  // namespace bustub
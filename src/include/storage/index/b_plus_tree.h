@@ -20,6 +20,7 @@
 #include "storage/page/b_plus_tree_internal_page.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 #include "storage/page/b_plus_tree_page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
@@ -44,8 +45,9 @@ class BPlusTree {
   // 由此引申出来内部节点和叶子节点的max_size是不一样的,因为pair的大小是不一样的
 
  public:
+  // leaf_max_size 和 internal_max_size 为 0 的时候取缓冲池的页面大小能够放下的个数
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = 0, int internal_max_size = 0);
 
   // Returns true if this B+ tree has no keys and values.
   auto IsEmpty() const -> bool;
@@ -62,6 +64,9 @@ class BPlusTree {
   // return the page id of the root node
   auto GetRootPageId() -> page_id_t;
 
+  // 按层遍历整棵树, 返回所有节点的页面号; 通过一个小的环形缓冲区读取, 不会淘汰其他页面
+  auto GetPageIds() -> std::vector<page_id_t>;
+
   // index iterator
   auto Begin() -> INDEXITERATOR_TYPE;
   auto Begin(const KeyType &key) -> INDEXITERATOR_TYPE;
@@ -90,9 +95,10 @@ class BPlusTree {
   auto Search(page_id_t root, const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr)
       -> bool;
 
+  // 创建并初始化一个新的节点, 返回的守卫持有这个新页面
   auto CreateNewLeafPage(page_id_t *page_id, page_id_t parent = INVALID_PAGE_ID, page_id_t next_page = INVALID_PAGE_ID)
-      -> bool;
-  auto CreateNewInternalPage(page_id_t *page_id, page_id_t parent = INVALID_PAGE_ID) -> bool;
+      -> BasicPageGuard;
+  auto CreateNewInternalPage(page_id_t *page_id, page_id_t parent = INVALID_PAGE_ID) -> BasicPageGuard;
   void DfsSplit(page_id_t cur, Transaction *transaction);
 
   // 该上锁比较粗颗粒
@@ -100,18 +106,20 @@ class BPlusTree {
   // 根据传入的key找到应该存储的 page_id_t 如果当前的page_id_t里面没有进行插入
   auto FindShouldLocalPage(const KeyType &key, Transaction *transaction = nullptr) -> page_id_t;
   // 根据传入的叶子节点,返回当前叶子节点的左兄弟节点,没有返回nullptr
-  auto FindLeafLeafData(LeafPage *cur) -> page_id_t;
+  auto FindLeafLeafData(const LeafPage *cur) -> page_id_t;
+  // 获取叶子节点, 页面不存在(比如 INVALID_PAGE_ID)时返回空的守卫
+  auto FetchLeafData(page_id_t page_id) -> BasicPageGuard;
 
-  // 根据传入的内部节点返回内部节点的左右兄弟节点
-  auto FindInternalLeafData(InternalPage *cur) -> InternalPage *;
-  auto FindInternalRightData(InternalPage *cur) -> InternalPage *;
+  // 根据传入的内部节点返回内部节点的左右兄弟节点, 没有的话返回空的守卫
+  auto FindInternalLeafData(const InternalPage *cur) -> BasicPageGuard;
+  auto FindInternalRightData(const InternalPage *cur) -> BasicPageGuard;
 
   // 根据传入的当前节点判断当前的内部节点是否需要进行借或者合并,递归的向上进行遍历
   void DfsShouldCombine(page_id_t c, Transaction *transaction);
 
   // 获取第一个叶子和获取最后一个叶子节点
-  auto GetFirstLeafData(page_id_t root) -> LeafPage *;
-  auto GetLastLeafData(page_id_t root) -> LeafPage *;
+  auto GetFirstLeafData(page_id_t root) -> BasicPageGuard;
+  auto GetLastLeafData(page_id_t root) -> BasicPageGuard;
 
   // 删除queue中的所有page的锁
   void DeleteUnlock(int type, Transaction *transaction);
@@ -121,6 +129,8 @@ class BPlusTree {
   // 当前的变量保存这根节点的页面、缓冲池的指针、一个比较器、叶节点的最大容量、内部节点的最大容量
   std::string index_name_;
   page_id_t root_page_id_;
+  // 树的页面都从这个对象的区里分配, 第一次分配页面之前是 INVALID_PAGE_ID
+  page_id_t extent_owner_{INVALID_PAGE_ID};
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
   int leaf_max_size_;
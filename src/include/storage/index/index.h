@@ -175,6 +175,13 @@ class Index {
    */
   virtual void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) = 0;
 
+  /**
+   * Collect the ids of the pages the index is stored in, e.g. to count how many of them are resident in the buffer
+   * pool. The default implementation returns none.
+   * @return the page ids of the index
+   */
+  virtual auto GetPageIds() -> std::vector<page_id_t> { return {}; }
+
  private:
   /** The Index structure owns its metadata */
   std::unique_ptr<IndexMetadata> metadata_;
@@ -11,6 +11,7 @@
 #pragma once
 
 #include <queue>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "common/config.h"
@@ -21,8 +22,9 @@ namespace bustub {
 #define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
 // 每一个页面的头部标识所需要的字节数
 #define INTERNAL_PAGE_HEADER_SIZE 24
-// 每一页的大小是4096减去内部页面头部的24字节，在除以MappingType(pair<K,V>的大小)获得一个页面能够存储的MappingType
-#define INTERNAL_PAGE_SIZE ((BUSTUB_PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))
+// 页面大小减去内部页面头部的24字节，在除以MappingType(pair<K,V>的大小)获得一个页面能够存储的MappingType
+#define INTERNAL_PAGE_CAPACITY(page_size) (((page_size)-INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))
+#define INTERNAL_PAGE_SIZE INTERNAL_PAGE_CAPACITY(BUSTUB_PAGE_SIZE)
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
@@ -48,26 +50,28 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   void SetKeyAt(int index, const KeyType &key);
   auto ValueAt(int index) const -> ValueType;
 
-  auto GetNextPageId(const KeyType &key, const KeyComparator &comp) -> page_id_t;
+  auto GetNextPageId(const KeyType &key, const KeyComparator &comp) const -> page_id_t;
   void SetIndexKeyValue(int index, const KeyType &key, const ValueType &val);
   // 将一个节点的内部array_一般的元素,移动到另一个next中
   // 一般是对于满的节点的操作
   void Insert(const KeyType &key, const ValueType &val, const KeyComparator &comp);
 
   auto Split(B_PLUS_TREE_INTERNAL_PAGE_TYPE *other, const KeyComparator &comp, BufferPoolManager *buffer) -> KeyType;
+  // 将 children 的父节点都设置为 parent, 所有的孩子用一次批量获取从缓冲池中取出, 缓冲池放不下的时候逐个修改
+  static void SetChildrenParent(const std::vector<page_id_t> &children, page_id_t parent, BufferPoolManager *buffer);
 
   // 根据传入的val进行删除array_,如果有则将删除的节点删除并返回返回
   auto DeleteArrayVal(const ValueType &val) -> MappingType;
   // 查找父节点的oldkey将其修改成newkey,返回true设置成功
   auto ChangePos0Key(const KeyType &oldkey, const KeyType &newkey, const KeyComparator &comp) -> bool;
   // 根据传入的val的值返回val的对应的下标
-  auto AccordValFindValPos(const ValueType &val) -> int;
+  auto AccordValFindValPos(const ValueType &val) const -> int;
 
   void AddKeyTo1ValTo0(const KeyType &key, const ValueType &val);
   auto DeleteKey1Val0() -> MappingType;
 
  private:
-  // Flexible array member for page data.
-  MappingType array_[INTERNAL_PAGE_SIZE];
+  // Flexible array member for page data, INTERNAL_PAGE_CAPACITY(page size) pairs.
+  MappingType array_[0];
 };
 }  // namespace bustub
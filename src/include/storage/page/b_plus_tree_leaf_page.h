@@ -22,7 +22,9 @@ namespace bustub {
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
 // 多出一个next_page_id
 #define LEAF_PAGE_HEADER_SIZE 28
-#define LEAF_PAGE_SIZE ((BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+// 页面大小为 page_size 的叶子节点能够存储的 MappingType 的个数
+#define LEAF_PAGE_CAPACITY(page_size) (((page_size)-LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+#define LEAF_PAGE_SIZE LEAF_PAGE_CAPACITY(BUSTUB_PAGE_SIZE)
 
 /**
  * Store indexed key and record id(record id = page id combined with slot id,
@@ -60,18 +62,18 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   auto Split(B_PLUS_TREE_LEAF_PAGE_TYPE *other, const KeyComparator &comp) -> KeyType;
 
   // 根据传入的Key找到相应的值
-  auto FindValueAddVector(const KeyType &key, std::vector<ValueType> *result, const KeyComparator &comp) -> bool;
+  auto FindValueAddVector(const KeyType &key, std::vector<ValueType> *result, const KeyComparator &comp) const -> bool;
 
   // 根据传入的key对当前的叶子节点进行删除,如果删除的是第一个pair那么需要return true,and return second KeyType
   auto DeleteKey(const KeyType &key, const KeyComparator &comp) -> std::pair<bool, KeyType>;
 
   // 根据传入的keys返回当前key的下标,return -1 没有找到
-  auto FindIndexKey(const KeyType &key, const KeyComparator &comp) -> int;
+  auto FindIndexKey(const KeyType &key, const KeyComparator &comp) const -> int;
 
  private:
   // 保存下一个页面的索引
   page_id_t next_page_id_;
-  // Flexible array member for page data.
-  MappingType array_[LEAF_PAGE_SIZE];
+  // Flexible array member for page data, LEAF_PAGE_CAPACITY(page size) pairs.
+  MappingType array_[0];
 };
 }  // namespace bustub
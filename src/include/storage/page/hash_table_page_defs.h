@@ -25,6 +25,9 @@
  * key/value pair, we need two additional bits for occupied_ and readable_. 4 * BUSTUB_PAGE_SIZE / (4 * sizeof
  * (MappingType) + 1) = BUSTUB_PAGE_SIZE/(sizeof (MappingType) + 0.25) because 0.25 bytes = 2 bits is the space required
  * to maintain the occupied and readable flags for a key value pair.
+ *
+ * The hash table pages keep their bitmaps and pairs in fixed-size arrays, so they are sized for the smallest page
+ * size, BUSTUB_PAGE_SIZE, and fit in the pages of a database of any page size.
  */
 #define BLOCK_ARRAY_SIZE (4 * BUSTUB_PAGE_SIZE / (4 * sizeof(MappingType) + 1))
 
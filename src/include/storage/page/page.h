@@ -12,8 +12,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <memory>
 
 #include "common/config.h"
 #include "common/rwlatch.h"
@@ -24,14 +26,18 @@ namespace bustub {
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * The page data is not stored inline. The frames of the buffer pool point into one page-aligned arena of page data,
+ * while the Page objects themselves are cache-line aligned so that the book-keeping of neighbouring frames never
+ * shares a cache line.
  */
-class Page {
+class alignas(64) Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManagerInstance;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor of a standalone page, which owns its zeroed page data. */
+  Page() : owned_data_(new char[BUSTUB_PAGE_SIZE]{}), data_(owned_data_.get()) {}
 
   /** Default destructor. */
   ~Page() = default;
@@ -39,6 +45,9 @@ class Page {
   /** @return the actual data contained within this page */
   inline auto GetData() -> char * { return data_; }
 
+  /** @return the size of the page data in bytes, the page size of the database for a buffer pool frame */
+  inline auto GetSize() const -> size_t { return size_; }
+
   /** @return the page id of this page */
   inline auto GetPageId() -> page_id_t { return page_id_; }
 
@@ -75,17 +84,28 @@ class Page {
   static constexpr size_t OFFSET_LSN = 4;
 
  private:
+  /** Constructor of a buffer pool frame, whose page data lives in the frame arena of the buffer pool. */
+  Page(char *data, size_t size, frame_id_t frame_id) : data_(data), size_(size), frame_id_(frame_id) {}
+
   /** Zeroes out the data that is held within the page. */
-  inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, BUSTUB_PAGE_SIZE); }
-
-  /** The actual data that is stored within a page. */
-  char data_[BUSTUB_PAGE_SIZE]{};
-  /** The ID of this page. */
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, size_); }
+
+  /** The page data of a standalone page, nullptr for a buffer pool frame. */
+  std::unique_ptr<char[]> owned_data_;
+  /** The actual data that is stored within a page, size_ bytes. */
+  char *data_;
+  size_t size_{BUSTUB_PAGE_SIZE};
+  /** The frame of the buffer pool this page descriptor belongs to, -1 for a standalone page. */
+  frame_id_t frame_id_{-1};
+  /**
+   * The ID of this page. The book-keeping fields are atomic because the buffer pool pins and unpins resident pages
+   * without holding its latch.
+   */
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  /** The pin count of this page, -1 while the buffer pool is reassigning the frame. */
+  std::atomic<int> pin_count_{0};
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_{false};
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
 };
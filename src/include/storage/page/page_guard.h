@@ -0,0 +1,194 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/config.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class ReadPageGuard;
+class WritePageGuard;
+
+/**
+ * BasicPageGuard holds the pin of a page fetched or created by the buffer pool, and unpins it when it is dropped or
+ * destroyed. The guard remembers the frame of the page, so unpinning neither looks the page up in the page table nor
+ * takes the latch of the buffer pool; it also tracks whether the page was modified, so callers no longer pass the
+ * dirty flag to UnpinPage.
+ *
+ * A guard is move-only. A guard that holds no page, e.g. because the buffer pool had no free frame, converts to
+ * false.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  auto operator=(const BasicPageGuard &) -> BasicPageGuard & = delete;
+
+  /** Take over the page of that guard, which is left empty. */
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  /** Drop the page of this guard, then take over the page of that guard, which is left empty. */
+  auto operator=(BasicPageGuard &&that) noexcept -> BasicPageGuard &;
+
+  /** Unpin the page, marking it dirty if it was modified through this guard. The guard is empty afterwards. */
+  void Drop();
+
+  ~BasicPageGuard() { Drop(); }
+
+  /**
+   * Latch the page for reading and hand the pin over to a ReadPageGuard. This guard is empty afterwards.
+   * @return the read guard, empty if this guard was empty
+   */
+  auto UpgradeRead() -> ReadPageGuard;
+
+  /**
+   * Latch the page for writing and hand the pin over to a WritePageGuard. This guard is empty afterwards.
+   * @return the write guard, empty if this guard was empty
+   */
+  auto UpgradeWrite() -> WritePageGuard;
+
+  /** @return true if the guard holds a page */
+  explicit operator bool() const { return page_ != nullptr; }
+
+  /** @return the id of the page, INVALID_PAGE_ID if the guard is empty */
+  auto PageId() const -> page_id_t { return page_ == nullptr ? INVALID_PAGE_ID : page_->GetPageId(); }
+
+  /** @return the page itself, e.g. to use a TablePage; call SetDirty() after modifying it */
+  auto GetPage() -> Page * { return page_; }
+
+  /** Mark the page as modified, it is unpinned dirty. */
+  void SetDirty() { is_dirty_ = true; }
+
+  auto GetData() const -> const char * { return page_->GetData(); }
+
+  template <class T>
+  auto As() const -> const T * {
+    return reinterpret_cast<const T *>(GetData());
+  }
+
+  /** @return the page data for writing, which marks the page as modified */
+  auto GetDataMut() -> char * {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  template <class T>
+  auto AsMut() -> T * {
+    return reinterpret_cast<T *>(GetDataMut());
+  }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  /** The buffer pool that owns the frame of the page, for a parallel buffer pool the instance. */
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard holds the pin and the read latch of a page. Dropping the guard releases the latch, then the pin.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /** Take the read latch of the page pinned by bpm. */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page);
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  auto operator=(const ReadPageGuard &) -> ReadPageGuard & = delete;
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+  auto operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard &;
+
+  /** Release the read latch and unpin the page. The guard is empty afterwards. */
+  void Drop();
+
+  ~ReadPageGuard() { Drop(); }
+
+  explicit operator bool() const { return static_cast<bool>(guard_); }
+
+  auto PageId() const -> page_id_t { return guard_.PageId(); }
+
+  /** @return the page itself, e.g. to use a TablePage */
+  auto GetPage() -> Page * { return guard_.GetPage(); }
+
+  auto GetData() const -> const char * { return guard_.GetData(); }
+
+  template <class T>
+  auto As() const -> const T * {
+    return guard_.As<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard holds the pin and the write latch of a page. Dropping the guard releases the latch, then the pin.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /** Take the write latch of the page pinned by bpm. */
+  WritePageGuard(BufferPoolManager *bpm, Page *page);
+
+  WritePageGuard(const WritePageGuard &) = delete;
+  auto operator=(const WritePageGuard &) -> WritePageGuard & = delete;
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+  auto operator=(WritePageGuard &&that) noexcept -> WritePageGuard &;
+
+  /** Release the write latch and unpin the page, dirty if it was modified. The guard is empty afterwards. */
+  void Drop();
+
+  ~WritePageGuard() { Drop(); }
+
+  explicit operator bool() const { return static_cast<bool>(guard_); }
+
+  auto PageId() const -> page_id_t { return guard_.PageId(); }
+
+  /** @return the page itself, e.g. to use a TablePage; call SetDirty() after modifying it */
+  auto GetPage() -> Page * { return guard_.GetPage(); }
+
+  void SetDirty() { guard_.SetDirty(); }
+
+  auto GetData() const -> const char * { return guard_.GetData(); }
+
+  template <class T>
+  auto As() const -> const T * {
+    return guard_.As<T>();
+  }
+
+  auto GetDataMut() -> char * { return guard_.GetDataMut(); }
+
+  template <class T>
+  auto AsMut() -> T * {
+    return guard_.AsMut<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+}  // namespace bustub
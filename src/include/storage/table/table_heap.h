@@ -55,9 +55,10 @@ class TableHeap {
    * @param tuple tuple to insert
    * @param[out] rid the rid of the inserted tuple
    * @param txn the transaction performing the insert
+   * @param strategy the buffer access strategy of a bulk insert, nullptr to use the whole buffer pool
    * @return true iff the insert is successful
    */
-  auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> bool;
+  auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, BufferAccessStrategy *strategy = nullptr) -> bool;
 
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
@@ -99,8 +100,13 @@ class TableHeap {
    */
   auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) -> bool;
 
-  /** @return the begin iterator of this table */
-  auto Begin(Transaction *txn) -> TableIterator;
+  /**
+   * @param txn the transaction performing the scan
+   * @param strategy the buffer access strategy of a large scan, nullptr to use the whole buffer pool. It must outlive
+   * the iterator.
+   * @return the begin iterator of this table
+   */
+  auto Begin(Transaction *txn, BufferAccessStrategy *strategy = nullptr) -> TableIterator;
 
   /** @return the end iterator of this table */
   auto End() -> TableIterator;
@@ -108,6 +114,13 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
 
+  /**
+   * Walk the page list of this table, through a small ring of frames so that the walk does not evict the pages of
+   * other tables.
+   * @return the ids of all the pages of this table
+   */
+  auto GetPageIds() -> std::vector<page_id_t>;
+
  private:
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
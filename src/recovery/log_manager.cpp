@@ -12,6 +12,10 @@
 
 #include "recovery/log_manager.h"
 
+#include <cstring>
+
+#include "common/exception.h"
+
 namespace bustub {
 /*
  * set enable_logging = true
@@ -22,33 +26,141 @@ namespace bustub {
  *
  * This thread runs forever until system shutdown/StopFlushThread
  */
-void LogManager::RunFlushThread() {}
+void LogManager::RunFlushThread() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (flush_thread_ != nullptr) {
+    return;
+  }
+  stop_ = false;
+  enable_logging = true;
+  flush_thread_ = new std::thread([this] {
+    std::unique_lock<std::mutex> lock(latch_);
+    while (true) {
+      // 超时, 缓冲区满了或者有人在等某个 LSN 持久化的时候刷盘
+      cv_.wait_for(lock, log_timeout, [this] { return stop_ || flush_requested_lsn_ > persistent_lsn_; });
+      FlushBuffer(&lock);
+      if (stop_ && log_buffer_size_ == 0) {
+        return;
+      }
+    }
+  });
+}
 
 /*
  * Stop and join the flush thread, set enable_logging = false
  */
-void LogManager::StopFlushThread() {}
+void LogManager::StopFlushThread() {
+  std::thread *flush_thread;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (flush_thread_ == nullptr) {
+      return;
+    }
+    // 刷盘线程退出之前会把缓冲区里剩下的日志都写下去
+    stop_ = true;
+    flush_thread = flush_thread_;
+  }
+  cv_.notify_one();
+  flush_thread->join();
+  delete flush_thread;
+  std::scoped_lock<std::mutex> lock(latch_);
+  flush_thread_ = nullptr;
+  stop_ = false;
+  enable_logging = false;
+  // 还在等待的 Flush() 自己刷盘
+  flushed_cv_.notify_all();
+}
 
 /*
  * append a log record into log buffer
  * you MUST set the log record's lsn within this method
  * @return: lsn that is assigned to this log record
- *
- *
- * example below
- * // First, serialize the must have fields(20 bytes in total)
- * log_record.lsn_ = next_lsn_++;
- * memcpy(log_buffer_ + offset_, &log_record, 20);
- * int pos = offset_ + 20;
- *
- * if (log_record.log_record_type_ == LogRecordType::INSERT) {
- *    memcpy(log_buffer_ + pos, &log_record.insert_rid_, sizeof(RID));
- *    pos += sizeof(RID);
- *    // we have provided serialize function for tuple class
- *    log_record.insert_tuple_.SerializeTo(log_buffer_ + pos);
- *  }
- *
  */
-auto LogManager::AppendLogRecord(LogRecord *log_record) -> lsn_t { return INVALID_LSN; }
+auto LogManager::AppendLogRecord(LogRecord *log_record) -> lsn_t {
+  auto size = static_cast<size_t>(log_record->size_);
+  if (size > static_cast<size_t>(LOG_BUFFER_SIZE)) {
+    throw Exception("the log record is larger than the log buffer");
+  }
+  std::unique_lock<std::mutex> lock(latch_);
+  // 缓冲区放不下的时候让刷盘线程交换缓冲区, 没有刷盘线程的时候自己刷盘
+  while (log_buffer_size_ + size > static_cast<size_t>(LOG_BUFFER_SIZE)) {
+    if (flush_thread_ == nullptr) {
+      FlushBuffer(&lock);
+      continue;
+    }
+    flush_requested_lsn_ = std::max<lsn_t>(flush_requested_lsn_, next_lsn_ - 1);
+    cv_.notify_one();
+    flushed_cv_.wait(lock);
+  }
+  // LSN 在 latch_ 下分配, 缓冲区里的记录按 LSN 排序
+  log_record->lsn_ = next_lsn_++;
+  char *data = log_buffer_ + log_buffer_size_;
+  memcpy(data, log_record, LogRecord::HEADER_SIZE);
+  size_t pos = LogRecord::HEADER_SIZE;
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      memcpy(data + pos, &log_record->insert_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->insert_tuple_.SerializeTo(data + pos);
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      memcpy(data + pos, &log_record->delete_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->delete_tuple_.SerializeTo(data + pos);
+      break;
+    case LogRecordType::UPDATE:
+      memcpy(data + pos, &log_record->update_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->old_tuple_.SerializeTo(data + pos);
+      pos += sizeof(int32_t) + log_record->old_tuple_.GetLength();
+      log_record->new_tuple_.SerializeTo(data + pos);
+      break;
+    case LogRecordType::NEWPAGE:
+      memcpy(data + pos, &log_record->prev_page_id_, sizeof(page_id_t));
+      memcpy(data + pos + sizeof(page_id_t), &log_record->page_id_, sizeof(page_id_t));
+      break;
+    default:
+      break;
+  }
+  log_buffer_size_ += size;
+  return log_record->lsn_;
+}
+
+void LogManager::Flush(lsn_t lsn) {
+  std::unique_lock<std::mutex> lock(latch_);
+  lsn = std::min<lsn_t>(lsn, next_lsn_ - 1);
+  // 等覆盖 lsn 的那一次刷盘; 同时在等的事务共用一次写入和同步
+  while (persistent_lsn_ < lsn) {
+    if (flush_thread_ == nullptr) {
+      FlushBuffer(&lock);
+      continue;
+    }
+    flush_requested_lsn_ = std::max(flush_requested_lsn_, lsn);
+    cv_.notify_one();
+    flushed_cv_.wait(lock);
+  }
+}
+
+void LogManager::FlushBuffer(std::unique_lock<std::mutex> *lock) {
+  flushed_cv_.wait(*lock, [this] { return !flushing_; });
+  if (log_buffer_size_ == 0) {
+    return;
+  }
+  // 交换缓冲区之后追加日志和写日志文件可以同时进行
+  std::swap(log_buffer_, flush_buffer_);
+  size_t size = log_buffer_size_;
+  lsn_t lsn = next_lsn_ - 1;
+  log_buffer_size_ = 0;
+  flushing_ = true;
+  flushed_cv_.notify_all();
+  lock->unlock();
+  disk_manager_->WriteLog(flush_buffer_, static_cast<int>(size));
+  lock->lock();
+  flushing_ = false;
+  persistent_lsn_ = lsn;
+  flushed_cv_.notify_all();
+}
 
 }  // namespace bustub
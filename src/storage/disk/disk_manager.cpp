@@ -10,11 +10,17 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <climits>
 #include <cstring>
 #include <iostream>
-#include <mutex>  // NOLINT
+#include <limits>
 #include <string>
 #include <thread>  // NOLINT
 
@@ -26,11 +32,29 @@ namespace bustub {
 
 static char *buffer_used;
 
+auto AllocateAlignedPages(size_t num_pages, size_t page_size) -> AlignedBuffer {
+  size_t bytes = std::max<size_t>(num_pages, 1) * page_size;
+  auto *data = static_cast<char *>(std::aligned_alloc(BUSTUB_PAGE_SIZE, bytes));
+  if (data == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate aligned pages");
+  }
+  return AlignedBuffer(data);
+}
+
+/** Throw if page_size is not a power of two from BUSTUB_PAGE_SIZE to BUSTUB_MAX_PAGE_SIZE. */
+static void CheckPageSize(size_t page_size) {
+  if (page_size < BUSTUB_PAGE_SIZE || page_size > BUSTUB_MAX_PAGE_SIZE || (page_size & (page_size - 1)) != 0) {
+    throw Exception("invalid page size " + std::to_string(page_size));
+  }
+}
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+DiskManager::DiskManager(const std::string &db_file, bool direct_io, size_t segment_pages, size_t page_size)
+    : page_size_(page_size), file_name_(db_file), segment_pages_(segment_pages) {
+  CheckPageSize(page_size_);
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
@@ -48,78 +72,342 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
       throw Exception("can't open dblog file");
     }
   }
+  // 日志流只负责写入, 持久化用这个描述符上的 fdatasync
+  log_fd_ = open(log_name_.c_str(), O_RDWR);
+  if (log_fd_ < 0) {
+    throw Exception("can't open dblog file");
+  }
 
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
+  // 每个段文件最多 segment_pages_ 个页面, 段的个数要能覆盖所有的页面号, 但不超过 DISK_MAX_SEGMENTS
+  num_segments_ = 1;
+  if (segment_pages_ > 0) {
+    auto max_pages = static_cast<size_t>(std::numeric_limits<page_id_t>::max()) + 1;
+    num_segments_ = std::min<size_t>((max_pages + segment_pages_ - 1) / segment_pages_, DISK_MAX_SEGMENTS);
+  }
+  segments_ = std::make_unique<Segment[]>(num_segments_);
+
+  int fd = -1;
+  if (direct_io) {
+    fd = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    // 文件系统不支持 O_DIRECT (比如 tmpfs) 时退回到经过页缓存的读写
+    if (fd < 0 && errno == EINVAL) {
+      LOG_INFO("O_DIRECT is not supported for %s, using buffered I/O", db_file.c_str());
     }
+    direct_io_ = fd >= 0;
+  }
+  if (fd < 0) {
+    fd = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
   }
+  if (fd < 0) {
+    throw Exception("can't open db file");
+  }
+  segments_[0].fd_ = fd;
+  open_segments_ = 1;
+  // 打开已经存在的段文件, 数据库的大小由最后一个段文件决定
+  while (open_segments_ < num_segments_) {
+    fd = open(SegmentFileName(open_segments_).c_str(), O_RDWR | (direct_io_ ? O_DIRECT : 0));
+    if (fd < 0) {
+      break;
+    }
+    segments_[open_segments_++].fd_ = fd;
+  }
+  struct stat stat_buf;
+  int64_t last_segment_size = 0;
+  if (fstat(segments_[open_segments_ - 1].fd_, &stat_buf) == 0) {
+    last_segment_size = stat_buf.st_size;
+  }
+  bool is_new = open_segments_ == 1 && last_segment_size == 0;
+  // 空闲页面表放在 .fsm 文件里, 区表放在 .ext 文件里; 新的数据库文件不沿用旧的表
+  free_page_map_.Open(file_name_.substr(0, n) + ".fsm", is_new);
+  extent_map_.Open(file_name_.substr(0, n) + ".ext", is_new);
+  // 已有的数据库用创建时的页面大小, 没有记录页面大小的旧数据库都是 BUSTUB_PAGE_SIZE;
+  // 新的数据库把页面大小记在空闲页面表的表头里并马上持久化
+  if (!is_new) {
+    page_size_ = free_page_map_.GetPageSize() != 0 ? free_page_map_.GetPageSize() : BUSTUB_PAGE_SIZE;
+  }
+  free_page_map_.SetPageSize(page_size_);
+  if (is_new) {
+    free_page_map_.Flush();
+  }
+  db_file_size_ = static_cast<int64_t>(open_segments_ - 1) * SegmentBytes() + last_segment_size;
   buffer_used = nullptr;
 }
 
+DiskManager::DiskManager(size_t page_size) : page_size_(page_size) { CheckPageSize(page_size_); }
+
+DiskManager::~DiskManager() {
+  CloseSegments();
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+  }
+}
+
 /**
- * Close all file streams
+ * Sync the db file, then close all file resources
  */
 void DiskManager::ShutDown() {
-  {
-    std::scoped_lock scoped_db_io_latch(db_io_latch_);
-    db_io_.close();
+  if (segments_ != nullptr && segments_[0].fd_ >= 0) {
+    Sync();
+    CloseSegments();
+    free_page_map_.Close();
+    extent_map_.Close();
   }
   log_io_.close();
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+    log_fd_ = -1;
+  }
+}
+
+void DiskManager::CloseSegments() {
+  for (size_t i = 0; segments_ != nullptr && i < open_segments_; i++) {
+    int fd = segments_[i].fd_.exchange(-1);
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+}
+
+/**
+ * Make the pages written so far durable. Concurrent writes may or may not be covered by this sync.
+ */
+void DiskManager::Sync() {
+  if (segments_ == nullptr || segments_[0].fd_ < 0) {
+    return;
+  }
+  if (needs_sync_.exchange(false)) {
+    // 不知道哪些段文件被写过, 所有打开的段文件都要同步
+    for (size_t i = 0; i < open_segments_; i++) {
+      int fd = segments_[i].fd_;
+      if (fd >= 0 && fdatasync(fd) != 0) {
+        // 没有同步成功, 下一次 Sync() 需要重新同步
+        needs_sync_ = true;
+        LOG_DEBUG("I/O error while syncing: %s", strerror(errno));
+        return;
+      }
+    }
+    num_syncs_ += 1;
+  }
+  // 数据页面持久化之后再写空闲页面表和区表, 表里的页面号不会超前于数据文件
+  free_page_map_.Flush();
+  extent_map_.Flush();
+}
+
+auto DiskManager::SegmentFileName(size_t segment) const -> std::string {
+  return segment == 0 ? file_name_ : file_name_ + "." + std::to_string(segment);
+}
+
+auto DiskManager::PagesLeftInSegment(page_id_t page_id) const -> size_t {
+  return segment_pages_ == 0 ? std::numeric_limits<size_t>::max() : segment_pages_ - page_id % segment_pages_;
+}
+
+auto DiskManager::LocatePages(page_id_t first_page, size_t num_pages, bool create, int64_t *offset) -> int {
+  if (segments_ == nullptr || first_page < 0 || num_pages > PagesLeftInSegment(first_page)) {
+    return -1;
+  }
+  size_t segment = segment_pages_ == 0 ? 0 : first_page / segment_pages_;
+  if (segment >= num_segments_) {
+    LOG_DEBUG("page %d is past the last segment of the database file", first_page);
+    return -1;
+  }
+  *offset = (static_cast<int64_t>(first_page) - static_cast<int64_t>(segment * segment_pages_)) * page_size_;
+  int fd = segments_[segment].fd_;
+  if (fd < 0 && create && GetFileDescriptor() >= 0) {
+    // 创建这个段文件和它前面所有还不存在的段文件, 重新打开数据库的时候才能找到所有的段文件
+    std::scoped_lock<std::mutex> lock(segments_latch_);
+    while (open_segments_ <= segment) {
+      int flags = O_RDWR | O_CREAT | (direct_io_ ? O_DIRECT : 0);
+      int new_fd = open(SegmentFileName(open_segments_).c_str(), flags, 0644);
+      if (new_fd < 0) {
+        LOG_DEBUG("can't create segment %zu of the database file: %s", open_segments_.load(), strerror(errno));
+        return -1;
+      }
+      segments_[open_segments_].fd_ = new_fd;
+      open_segments_++;
+    }
+    fd = segments_[segment].fd_;
+  }
+  if (fd >= 0 && create) {
+    Preallocate(&segments_[segment], fd, *offset + static_cast<int64_t>(num_pages) * page_size_);
+  }
+  return fd;
+}
+
+void DiskManager::Preallocate(Segment *segment, int fd, int64_t end) {
+  int64_t allocated = segment->allocated_.load();
+  if (end <= allocated) {
+    return;
+  }
+  // 按 DISK_PREALLOCATE_PAGES 个页面一块向后预分配, 不改变文件的大小; 谁把 allocated_ 推进了谁负责分配这一段
+  int64_t chunk = static_cast<int64_t>(DISK_PREALLOCATE_PAGES) * page_size_;
+  int64_t new_allocated = (end + chunk - 1) / chunk * chunk;
+  if (segment_pages_ > 0) {
+    new_allocated = std::min(new_allocated, SegmentBytes());
+  }
+  while (allocated < end) {
+    if (segment->allocated_.compare_exchange_weak(allocated, new_allocated)) {
+      // 文件系统不支持 fallocate 的时候直接写入, 由写操作分配空间
+      fallocate(fd, FALLOC_FL_KEEP_SIZE, allocated, new_allocated - allocated);
+      return;
+    }
+  }
 }
 
 /**
  * Write the contents of the specified page into disk file
  */
-void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
-  // set write cursor to offset
+auto DiskManager::WritePage(page_id_t page_id, const char *page_data) -> bool {
+  // O_DIRECT 要求缓冲区按页对齐, 没有对齐的数据先复制到对齐的缓冲区
+  AlignedBuffer bounce;
+  if (direct_io_ && !IsPageAligned(page_data)) {
+    bounce = AllocateAlignedPages(1, page_size_);
+    memcpy(bounce.get(), page_data, page_size_);
+    page_data = bounce.get();
+  }
+  int64_t offset = 0;
+  int fd = LocatePages(page_id, 1, true, &offset);
+  if (fd < 0) {
+    LOG_DEBUG("I/O error while writing: page %d has no file", page_id);
+    return false;
+  }
+  size_t written = 0;
+  while (written < page_size_) {
+    ssize_t n = pwrite(fd, page_data + written, page_size_ - written, offset + written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    // check for I/O error
+    if (n <= 0) {
+      LOG_DEBUG("I/O error while writing: %s", strerror(errno));
+      return false;
+    }
+    written += n;
+  }
+  OnPageWritten(page_id);
+  return true;
+}
+
+/**
+ * Write a run of consecutive pages with as few pwritev calls as IOV_MAX and the segments allow
+ */
+auto DiskManager::WritePages(page_id_t first_page, const std::vector<const char *> &pages) -> bool {
+  bool unaligned =
+      direct_io_ && std::any_of(pages.begin(), pages.end(), [](const char *data) { return !IsPageAligned(data); });
+  // 没有文件描述符的子类 (比如 DiskManagerMemory) 和需要复制到对齐缓冲区的页面逐页写
+  if (GetFileDescriptor() < 0 || unaligned) {
+    for (size_t i = 0; i < pages.size(); i++) {
+      if (!WritePage(first_page + static_cast<page_id_t>(i), pages[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+  std::vector<iovec> iov;
+  for (size_t done = 0; done < pages.size();) {
+    auto page_id = first_page + static_cast<page_id_t>(done);
+    size_t count = std::min({pages.size() - done, static_cast<size_t>(IOV_MAX), PagesLeftInSegment(page_id)});
+    int64_t offset = 0;
+    int fd = LocatePages(page_id, count, true, &offset);
+    if (fd < 0) {
+      LOG_DEBUG("I/O error while writing: page %d has no file", page_id);
+      return false;
+    }
+    iov.resize(count);
+    size_t bytes = count * page_size_;
+    size_t written = 0;
+    while (written < bytes) {
+      // 部分写入之后从第一个没写完的页面接着写
+      size_t first = written / page_size_;
+      for (size_t i = first; i < count; i++) {
+        iov[i].iov_base = const_cast<char *>(pages[done + i]);  // NOLINT
+        iov[i].iov_len = page_size_;
+      }
+      iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + written % page_size_;
+      iov[first].iov_len -= written % page_size_;
+      ssize_t n = pwritev(fd, iov.data() + first, static_cast<int>(count - first), offset + written);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      // check for I/O error
+      if (n <= 0) {
+        LOG_DEBUG("I/O error while writing: %s", strerror(errno));
+        return false;
+      }
+      written += n;
+    }
+    for (size_t i = 0; i < count; i++) {
+      OnPageWritten(page_id + static_cast<page_id_t>(i));
+    }
+    done += count;
+  }
+  return true;
+}
+
+void DiskManager::OnPageWritten(page_id_t page_id) {
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, BUSTUB_PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
-    return;
+  needs_sync_ = true;
+  // 文件大小只会变大, 并发的写入取最大的结束位置
+  int64_t end = (static_cast<int64_t>(page_id) + 1) * page_size_;
+  int64_t size = db_file_size_.load();
+  while (size < end && !db_file_size_.compare_exchange_weak(size, end)) {
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
-void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * BUSTUB_PAGE_SIZE;
+auto DiskManager::ReadPage(page_id_t page_id, char *page_data) -> bool { return ReadPages(page_id, 1, page_data); }
+
+/**
+ * Read a run of consecutive pages into the given memory area, with one read per segment it spans.
+ */
+auto DiskManager::ReadPages(page_id_t first_page, size_t num_pages, char *data) -> bool {
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (static_cast<int64_t>(first_page * page_size_) >= db_file_size_) {
     LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, BUSTUB_PAGE_SIZE);
-    if (db_io_.bad()) {
-      LOG_DEBUG("I/O error while reading");
-      return;
+    memset(data, 0, num_pages * page_size_);
+    return true;
+  }
+  for (size_t done = 0; done < num_pages;) {
+    auto page_id = first_page + static_cast<page_id_t>(done);
+    size_t count = std::min(num_pages - done, PagesLeftInSegment(page_id));
+    int64_t offset = 0;
+    int fd = LocatePages(page_id, count, false, &offset);
+    if (!ReadAt(fd, offset, data + done * page_size_, count * page_size_)) {
+      return false;
     }
-    // if file ends before reading BUSTUB_PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < BUSTUB_PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+    done += count;
+  }
+  return true;
+}
+
+auto DiskManager::ReadAt(int fd, int64_t offset, char *data, size_t size) -> bool {
+  if (direct_io_ && !IsPageAligned(data)) {
+    AlignedBuffer bounce = AllocateAlignedPages((size + BUSTUB_PAGE_SIZE - 1) / BUSTUB_PAGE_SIZE);
+    bool success = ReadAt(fd, offset, bounce.get(), size);
+    memcpy(data, bounce.get(), size);
+    return success;
+  }
+  size_t read_count = 0;
+  // 还没有创建的段文件读作 0
+  while (fd >= 0 && read_count < size) {
+    ssize_t n = pread(fd, data + read_count, size - read_count, offset + read_count);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      LOG_DEBUG("I/O error while reading: %s", strerror(errno));
+      memset(data + read_count, 0, size - read_count);
+      return false;
+    }
+    // the file ends before size bytes
+    if (n == 0) {
+      break;
     }
+    read_count += n;
   }
+  memset(data + read_count, 0, size - read_count);
+  return true;
 }
 
 /**
@@ -153,6 +441,10 @@ void DiskManager::WriteLog(char *log_data, int size) {
   }
   // needs to flush to keep disk file in sync
   log_io_.flush();
+  // 一次刷盘对应一次同步, 同一批提交的事务共用这一次 fdatasync
+  if (log_fd_ >= 0 && fdatasync(log_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing log: %s", strerror(errno));
+  }
   flush_log_ = false;
 }
 
@@ -161,7 +453,7 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * Always read from the beginning and perform sequence read
  * @return: false means already reach the end
  */
-auto DiskManager::ReadLog(char *log_data, int size, int offset) -> bool {
+auto DiskManager::ReadLog(char *log_data, int size, int64_t offset) -> bool {
   if (offset >= GetFileSize(log_name_)) {
     // LOG_DEBUG("end of log file");
     // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
@@ -202,10 +494,10 @@ auto DiskManager::GetFlushState() const -> bool { return flush_log_; }
 /**
  * Private helper function to get disk file size
  */
-auto DiskManager::GetFileSize(const std::string &file_name) -> int {
+auto DiskManager::GetFileSize(const std::string &file_name) -> int64_t {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
+  return rc == 0 ? static_cast<int64_t>(stat_buf.st_size) : -1;
 }
 
 }  // namespace bustub
@@ -0,0 +1,238 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_compressed.cpp
+//
+// Identification: src/storage/disk/disk_manager_compressed.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager_compressed.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "common/util/lz4_codec.h"
+
+namespace bustub {
+
+/** The header page of the page map. */
+struct PageMapHeader {
+  uint32_t magic_;
+  uint32_t num_pages_;
+};
+
+/** pwrite all of size bytes, retrying short writes. */
+static auto WriteAll(int fd, const char *data, size_t size, int64_t offset) -> bool {
+  size_t written = 0;
+  while (written < size) {
+    ssize_t n = pwrite(fd, data + written, size - written, offset + written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      LOG_DEBUG("I/O error while writing: %s", strerror(errno));
+      return false;
+    }
+    written += n;
+  }
+  return true;
+}
+
+DiskManagerCompressed::DiskManagerCompressed(const std::string &db_file, size_t page_size)
+    : DiskManager(db_file, false, 0, page_size) {
+  std::string::size_type n = file_name_.rfind('.');
+  if (n != std::string::npos) {
+    OpenPageMap(file_name_.substr(0, n) + ".pmap", db_file_size_ == 0);
+  }
+}
+
+DiskManagerCompressed::~DiskManagerCompressed() {
+  if (page_map_fd_ >= 0) {
+    close(page_map_fd_);
+  }
+}
+
+void DiskManagerCompressed::OpenPageMap(const std::string &file_name, bool reset) {
+  page_map_fd_ = open(file_name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (page_map_fd_ < 0) {
+    throw Exception("can't open the page map");
+  }
+  PageMapHeader header{};
+  // 新的数据库文件不沿用旧的页面表
+  if (reset || pread(page_map_fd_, &header, sizeof(header), 0) != sizeof(header) || header.magic_ != MAGIC) {
+    if (ftruncate(page_map_fd_, 0) != 0) {
+      LOG_DEBUG("can't truncate the page map: %s", strerror(errno));
+    }
+    header = {MAGIC, 0};
+  }
+  slots_.assign(header.num_pages_, Slot{-1, 0, 0});
+  size_t bytes = slots_.size() * sizeof(Slot);
+  if (bytes > 0 && pread(page_map_fd_, slots_.data(), bytes, BUSTUB_PAGE_SIZE) != static_cast<ssize_t>(bytes)) {
+    throw Exception("the page map of the compressed database is truncated");
+  }
+  dirty_.assign((slots_.size() + SLOTS_PER_PAGE - 1) / SLOTS_PER_PAGE, false);
+  // 页面表里的槽之间的空隙都是空闲的
+  std::vector<std::pair<int64_t, uint32_t>> used;
+  for (const Slot &slot : slots_) {
+    if (slot.offset_ >= 0) {
+      used.emplace_back(slot.offset_, slot.capacity_);
+      stored_bytes_ += slot.capacity_;
+    }
+  }
+  std::sort(used.begin(), used.end());
+  for (const auto &[offset, capacity] : used) {
+    if (offset > file_end_) {
+      AddFreeSlot(file_end_, static_cast<uint32_t>(offset - file_end_));
+    }
+    file_end_ = std::max(file_end_, offset + capacity);
+  }
+}
+
+auto DiskManagerCompressed::AllocateSlot(uint32_t capacity) -> int64_t {
+  // 取够大的最小的空闲槽, 剩下的部分还是空闲的; 没有的话追加到文件的末尾
+  auto it = free_slots_.lower_bound(capacity);
+  if (it == free_slots_.end()) {
+    int64_t offset = file_end_;
+    file_end_ += capacity;
+    return offset;
+  }
+  auto [free_capacity, offset] = *it;
+  free_slots_.erase(it);
+  if (free_capacity > capacity) {
+    AddFreeSlot(offset + capacity, free_capacity - capacity);
+  }
+  return offset;
+}
+
+void DiskManagerCompressed::AddFreeSlot(int64_t offset, uint32_t capacity) { free_slots_.emplace(capacity, offset); }
+
+auto DiskManagerCompressed::WritePage(page_id_t page_id, const char *page_data) -> bool {
+  // 压缩之后至少要省下一个槽, 否则按原样存储
+  std::vector<char> compressed(page_size_);
+  size_t length = Lz4Codec::Compress(page_data, page_size_, compressed.data(), page_size_ - COMPRESSED_SLOT_SIZE);
+  const char *stored = compressed.data();
+  if (length == 0) {
+    length = page_size_;
+    stored = page_data;
+  }
+  auto capacity =
+      static_cast<uint32_t>((length + COMPRESSED_SLOT_SIZE - 1) / COMPRESSED_SLOT_SIZE * COMPRESSED_SLOT_SIZE);
+  int64_t offset;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    offset = AllocateSlot(capacity);
+  }
+  // 写到新的槽里, 写完之后才修改页面表, 这样 Sync() 看到的页面表只指向写完的槽
+  if (!WriteAll(segments_[0].fd_, stored, length, offset)) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    AddFreeSlot(offset, capacity);
+    return false;
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (slots_.size() <= static_cast<size_t>(page_id)) {
+    slots_.resize(page_id + 1, Slot{-1, 0, 0});
+    dirty_.resize((slots_.size() + SLOTS_PER_PAGE - 1) / SLOTS_PER_PAGE, true);
+  }
+  Slot &slot = slots_[page_id];
+  if (slot.offset_ >= 0) {
+    released_slots_.emplace_back(slot.offset_, slot.capacity_);
+    stored_bytes_ -= slot.capacity_;
+  }
+  slot = {offset, capacity, static_cast<uint32_t>(length)};
+  stored_bytes_ += capacity;
+  dirty_[page_id / SLOTS_PER_PAGE] = true;
+  num_writes_ += 1;
+  needs_sync_ = true;
+  return true;
+}
+
+auto DiskManagerCompressed::ReadPage(page_id_t page_id, char *page_data) -> bool {
+  Slot slot{-1, 0, 0};
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (page_id >= 0 && static_cast<size_t>(page_id) < slots_.size()) {
+      slot = slots_[page_id];
+    }
+  }
+  // 从来没有写过的页面读作 0
+  if (slot.offset_ < 0) {
+    memset(page_data, 0, page_size_);
+    return true;
+  }
+  if (slot.length_ == page_size_) {
+    return ReadAt(segments_[0].fd_, slot.offset_, page_data, page_size_);
+  }
+  std::vector<char> compressed(slot.length_);
+  if (!ReadAt(segments_[0].fd_, slot.offset_, compressed.data(), slot.length_)) {
+    memset(page_data, 0, page_size_);
+    return false;
+  }
+  if (Lz4Codec::Decompress(compressed.data(), slot.length_, page_data, page_size_) != page_size_) {
+    LOG_DEBUG("page %d is corrupted", page_id);
+    memset(page_data, 0, page_size_);
+    return false;
+  }
+  return true;
+}
+
+auto DiskManagerCompressed::ReadPages(page_id_t first_page, size_t num_pages, char *data) -> bool {
+  for (size_t i = 0; i < num_pages; i++) {
+    if (!ReadPage(first_page + static_cast<page_id_t>(i), data + i * page_size_)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void DiskManagerCompressed::Sync() {
+  // 持有 latch_ 的时候页面表只指向已经写完的槽, 同步数据文件之后页面表才能持久化
+  std::scoped_lock<std::mutex> lock(latch_);
+  DiskManager::Sync();
+  if (needs_sync_ || !FlushPageMap()) {
+    return;
+  }
+  // 持久化的页面表不再指向被替换的槽, 它们现在可以重用了
+  for (const auto &[offset, capacity] : released_slots_) {
+    AddFreeSlot(offset, capacity);
+  }
+  released_slots_.clear();
+}
+
+auto DiskManagerCompressed::FlushPageMap() -> bool {
+  if (page_map_fd_ < 0) {
+    return true;
+  }
+  bool pages_written = false;
+  for (size_t i = 0; i < dirty_.size(); i++) {
+    if (!dirty_[i]) {
+      continue;
+    }
+    size_t first = i * SLOTS_PER_PAGE;
+    size_t count = std::min(SLOTS_PER_PAGE, slots_.size() - first);
+    const auto *data = reinterpret_cast<const char *>(slots_.data() + first);
+    if (!WriteAll(page_map_fd_, data, count * sizeof(Slot), static_cast<int64_t>(i + 1) * BUSTUB_PAGE_SIZE)) {
+      return false;
+    }
+    dirty_[i] = false;
+    pages_written = true;
+  }
+  if (!pages_written) {
+    return true;
+  }
+  char page[BUSTUB_PAGE_SIZE] = {0};
+  PageMapHeader header{MAGIC, static_cast<uint32_t>(slots_.size())};
+  memcpy(page, &header, sizeof(header));
+  return fdatasync(page_map_fd_) == 0 && WriteAll(page_map_fd_, page, BUSTUB_PAGE_SIZE, 0) &&
+         fdatasync(page_map_fd_) == 0;
+}
+
+}  // namespace bustub
@@ -27,24 +27,45 @@ namespace bustub {
 /**
  * Constructor: used for memory based manager
  */
-DiskManagerMemory::DiskManagerMemory(size_t pages) { memory_ = new char[pages * BUSTUB_PAGE_SIZE]; }
+DiskManagerMemory::DiskManagerMemory(size_t pages, size_t page_size) : DiskManager(page_size), pages_(pages) {
+  memory_ = new char[pages * page_size_];
+}
 
 /**
  * Write the contents of the specified page into disk file
  */
-void DiskManagerMemory::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
+auto DiskManagerMemory::WritePage(page_id_t page_id, const char *page_data) -> bool {
+  if (page_id < 0 || static_cast<size_t>(page_id) >= pages_) {
+    LOG_DEBUG("I/O error while writing: page %d is out of range", page_id);
+    return false;
+  }
+  size_t offset = static_cast<size_t>(page_id) * page_size_;
   // set write cursor to offset
   num_writes_ += 1;
-  memcpy(memory_ + offset, page_data, BUSTUB_PAGE_SIZE);
+  memcpy(memory_ + offset, page_data, page_size_);
+  return true;
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
-void DiskManagerMemory::ReadPage(page_id_t page_id, char *page_data) {
-  int64_t offset = static_cast<int64_t>(page_id) * BUSTUB_PAGE_SIZE;
-  memcpy(page_data, memory_ + offset, BUSTUB_PAGE_SIZE);
+auto DiskManagerMemory::ReadPage(page_id_t page_id, char *page_data) -> bool {
+  if (page_id < 0 || static_cast<size_t>(page_id) >= pages_) {
+    LOG_DEBUG("I/O error while reading: page %d is out of range", page_id);
+    return false;
+  }
+  int64_t offset = static_cast<int64_t>(page_id) * page_size_;
+  memcpy(page_data, memory_ + offset, page_size_);
+  return true;
+}
+
+auto DiskManagerMemory::ReadPages(page_id_t first_page, size_t num_pages, char *data) -> bool {
+  for (size_t i = 0; i < num_pages; i++) {
+    if (!ReadPage(first_page + static_cast<page_id_t>(i), data + i * page_size_)) {
+      return false;
+    }
+  }
+  return true;
 }
 
 }  // namespace bustub
@@ -0,0 +1,89 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_simulated.cpp
+//
+// Identification: src/storage/disk/disk_manager_simulated.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager_simulated.h"
+
+#include <algorithm>
+#include <thread>  // NOLINT
+
+namespace bustub {
+
+DiskManagerSimulated::DiskManagerSimulated(size_t pages, const SimulatedDevice &device, size_t page_size)
+    : DiskManagerMemory(pages, page_size), device_(device) {
+  device_.queue_depth_ = std::max<size_t>(device_.queue_depth_, 1);
+}
+
+auto DiskManagerSimulated::WritePage(page_id_t page_id, const char *page_data) -> bool {
+  SimulateIo(page_id, 1);
+  return DiskManagerMemory::WritePage(page_id, page_data);
+}
+
+auto DiskManagerSimulated::WritePages(page_id_t first_page, const std::vector<const char *> &pages) -> bool {
+  SimulateIo(first_page, pages.size());
+  for (size_t i = 0; i < pages.size(); i++) {
+    if (!DiskManagerMemory::WritePage(first_page + static_cast<page_id_t>(i), pages[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto DiskManagerSimulated::ReadPage(page_id_t page_id, char *page_data) -> bool {
+  SimulateIo(page_id, 1);
+  return DiskManagerMemory::ReadPage(page_id, page_data);
+}
+
+auto DiskManagerSimulated::ReadPages(page_id_t first_page, size_t num_pages, char *data) -> bool {
+  SimulateIo(first_page, num_pages);
+  for (size_t i = 0; i < num_pages; i++) {
+    if (!DiskManagerMemory::ReadPage(first_page + static_cast<page_id_t>(i), data + i * page_size_)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void DiskManagerSimulated::Sync() {
+  std::this_thread::sleep_for(device_.sync_latency_);
+  DiskManagerMemory::Sync();
+}
+
+void DiskManagerSimulated::SimulateIo(page_id_t first_page, size_t num_pages) {
+  using std::chrono::steady_clock;
+  steady_clock::time_point done;
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    // 设备的队列满了的时候等待一个 I/O 完成
+    slot_freed_.wait(lock, [&] { return in_flight_ < device_.queue_depth_; });
+    in_flight_++;
+    bool sequential = first_page == next_sequential_page_;
+    next_sequential_page_ = first_page + static_cast<page_id_t>(num_pages);
+    (sequential ? num_sequential_ios_ : num_random_ios_)++;
+    // 延迟可以和其他的 I/O 重叠, 数据传输按照带宽一个接一个地进行
+    steady_clock::time_point start = steady_clock::now() + (sequential ? device_.sequential_latency_
+                                                                          : device_.random_latency_);
+    done = std::max(start, transfer_done_);
+    if (device_.bandwidth_ > 0) {
+      uint64_t bytes = num_pages * page_size_;
+      done += std::chrono::nanoseconds(bytes * 1000000000 / device_.bandwidth_);
+    }
+    transfer_done_ = done;
+  }
+  std::this_thread::sleep_until(done);
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    in_flight_--;
+  }
+  slot_freed_.notify_one();
+}
+
+}  // namespace bustub
@@ -0,0 +1,412 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler.cpp
+//
+// Identification: src/storage/disk/disk_scheduler.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_scheduler.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <cstring>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "common/logger.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define BUSTUB_HAVE_IO_URING 1
+#endif
+
+namespace bustub {
+
+#ifdef BUSTUB_HAVE_IO_URING
+
+/** user_data of the poll on the eventfd that wakes the I/O thread up for new requests. */
+static constexpr uint64_t WAKEUP_USER_DATA = UINT64_MAX;
+/** Consecutive failed io_uring_enter calls after which the I/O thread stops using the ring. */
+static constexpr int MAX_ENTER_FAILURES = 8;
+/** The longest the I/O thread waits before it calls io_uring_enter again after a failure. */
+static constexpr std::chrono::milliseconds MAX_ENTER_BACKOFF{100};
+
+struct DiskScheduler::Ring {
+  int ring_fd_{-1};
+  /** Written by Schedule() to wake the I/O thread up while it waits for completions. */
+  int event_fd_{-1};
+  void *sq_ptr_{MAP_FAILED};
+  size_t sq_size_{0};
+  void *cq_ptr_{MAP_FAILED};
+  size_t cq_size_{0};
+  io_uring_sqe *sqes_{static_cast<io_uring_sqe *>(MAP_FAILED)};
+  size_t sqes_size_{0};
+  unsigned *sq_head_;
+  unsigned *sq_tail_;
+  unsigned *sq_mask_;
+  unsigned *sq_array_;
+  unsigned *cq_head_;
+  unsigned *cq_tail_;
+  unsigned *cq_mask_;
+  io_uring_cqe *cqes_;
+
+  /** Fill the next submission queue entry; it is handed to the kernel by the next io_uring_enter. */
+  void Push(uint8_t opcode, int fd, uint64_t offset, void *addr, uint32_t len, uint64_t user_data) {
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->off = offset;
+    sqe->addr = reinterpret_cast<uint64_t>(addr);
+    sqe->len = len;
+    sqe->user_data = user_data;
+    if (opcode == IORING_OP_POLL_ADD) {
+      sqe->poll32_events = POLLIN;
+    }
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  }
+};
+
+/** @return true if the io_uring ring_fd supports every operation the I/O thread submits */
+static auto SupportsOps(int ring_fd) -> bool {
+  constexpr unsigned num_ops = 256;
+  std::vector<char> buffer(sizeof(io_uring_probe) + num_ops * sizeof(io_uring_probe_op), 0);
+  auto *probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+  // IORING_REGISTER_PROBE 和 IORING_OP_READ/WRITE 都是 5.6 加入的, 更老的内核上这个调用就会失败
+  if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, num_ops) < 0) {
+    return false;
+  }
+  for (int op : {IORING_OP_READ, IORING_OP_WRITE, IORING_OP_POLL_ADD}) {
+    if (op > probe->last_op || (probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto DiskScheduler::SetUpRing() -> bool {
+  auto *ring = new Ring();
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  // 多出来的一个位置留给 eventfd 上的 poll
+  ring->ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth_ + 1, &params));
+  ring_ = ring;
+  if (ring->ring_fd_ < 0) {
+    LOG_DEBUG("io_uring is not available: %s", strerror(errno));
+    TearDownRing();
+    return false;
+  }
+  // 支持 io_uring 却不支持这些操作的内核上每个请求都会以 -EINVAL 完成, 这时改用工作线程
+  if (!SupportsOps(ring->ring_fd_)) {
+    LOG_DEBUG("io_uring does not support the read, write and poll operations");
+    TearDownRing();
+    return false;
+  }
+  ring->sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    ring->sq_size_ = std::max(ring->sq_size_, ring->cq_size_);
+  }
+  ring->sq_ptr_ = mmap(nullptr, ring->sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->ring_fd_,
+                       IORING_OFF_SQ_RING);
+  if (ring->sq_ptr_ != MAP_FAILED && !single_mmap) {
+    ring->cq_ptr_ = mmap(nullptr, ring->cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->ring_fd_,
+                         IORING_OFF_CQ_RING);
+  }
+  ring->sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  ring->sqes_ = static_cast<io_uring_sqe *>(mmap(nullptr, ring->sqes_size_, PROT_READ | PROT_WRITE,
+                                                 MAP_SHARED | MAP_POPULATE, ring->ring_fd_, IORING_OFF_SQES));
+  ring->event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  void *cq_ptr = single_mmap ? ring->sq_ptr_ : ring->cq_ptr_;
+  if (ring->sq_ptr_ == MAP_FAILED || cq_ptr == MAP_FAILED || ring->sqes_ == MAP_FAILED || ring->event_fd_ < 0) {
+    LOG_DEBUG("failed to set up io_uring: %s", strerror(errno));
+    TearDownRing();
+    return false;
+  }
+  auto *sq = static_cast<char *>(ring->sq_ptr_);
+  ring->sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  ring->sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  ring->sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  ring->sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  auto *cq = static_cast<char *>(cq_ptr);
+  ring->cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  ring->cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  ring->cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  ring->cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+  return true;
+}
+
+void DiskScheduler::TearDownRing() {
+  if (ring_ == nullptr) {
+    return;
+  }
+  if (ring_->sqes_ != MAP_FAILED) {
+    munmap(ring_->sqes_, ring_->sqes_size_);
+  }
+  if (ring_->cq_ptr_ != MAP_FAILED) {
+    munmap(ring_->cq_ptr_, ring_->cq_size_);
+  }
+  if (ring_->sq_ptr_ != MAP_FAILED) {
+    munmap(ring_->sq_ptr_, ring_->sq_size_);
+  }
+  if (ring_->event_fd_ >= 0) {
+    close(ring_->event_fd_);
+  }
+  if (ring_->ring_fd_ >= 0) {
+    close(ring_->ring_fd_);
+  }
+  delete ring_;
+  ring_ = nullptr;
+}
+
+void DiskScheduler::RingLoop() {
+  // slots[i] 是 user_data 为 i 的请求
+  std::vector<Pending *> slots(queue_depth_, nullptr);
+  std::vector<uint64_t> free_slots;
+  for (size_t i = queue_depth_; i > 0; i--) {
+    free_slots.push_back(i - 1);
+  }
+  uint64_t wakeup_count = 0;
+  bool wakeup_armed = false;
+  int failures = 0;
+  std::chrono::milliseconds backoff{1};
+  const bool direct_io = disk_manager_->IsDirectIo();
+  while (true) {
+    std::vector<Pending *> batch;
+    {
+      std::scoped_lock<std::mutex> lock(latch_);
+      if (stop_ && queue_.empty() && free_slots.size() == queue_depth_) {
+        return;
+      }
+      // 取出所有能放进 io_uring 的请求, 用一次系统调用一起提交
+      while (!queue_.empty() && batch.size() < free_slots.size()) {
+        batch.push_back(queue_.front());
+        queue_.pop_front();
+      }
+    }
+    unsigned to_submit = 0;
+    std::vector<Pending *> sync_batch;
+    for (Pending *pending : batch) {
+      const DiskRequest &request = pending->request_;
+      int64_t offset = 0;
+      int fd = disk_manager_->LocatePages(request.page_id_, request.num_pages_, request.is_write_, &offset);
+      // 跨越两个段文件或者段文件还不存在的请求, 以及 O_DIRECT 的文件上没有按页对齐的缓冲区, 不能交给 io_uring,
+      // 在这个线程上经过磁盘管理器同步读写
+      if (fd < 0 || (direct_io && !IsPageAligned(request.data_))) {
+        sync_batch.push_back(pending);
+        continue;
+      }
+      uint64_t slot = free_slots.back();
+      free_slots.pop_back();
+      slots[slot] = pending;
+      auto len = static_cast<uint32_t>(request.num_pages_ * disk_manager_->GetPageSize());
+      ring_->Push(request.is_write_ ? IORING_OP_WRITE : IORING_OP_READ, fd, offset, request.data_, len, slot);
+      to_submit++;
+    }
+    for (Pending *pending : sync_batch) {
+      Complete(pending, RunSync(pending->request_));
+    }
+    // 等待完成的时候, 新的请求通过 eventfd 上的 poll 唤醒这个线程
+    if (!wakeup_armed) {
+      ring_->Push(IORING_OP_POLL_ADD, ring_->event_fd_, 0, nullptr, 0, WAKEUP_USER_DATA);
+      to_submit++;
+      wakeup_armed = true;
+    }
+    // 同步完成了请求的时候队列里可能还有请求, 不等待完成, 马上回来取
+    unsigned min_complete = sync_batch.empty() ? 1 : 0;
+    // 上一次没有被内核全部取走的请求也在这一次提交
+    to_submit = *ring_->sq_tail_ - __atomic_load_n(ring_->sq_head_, __ATOMIC_ACQUIRE);
+    int ret = static_cast<int>(
+        syscall(__NR_io_uring_enter, ring_->ring_fd_, to_submit, min_complete, IORING_ENTER_GETEVENTS, nullptr, 0));
+    if (ret < 0 && errno != EINTR) {
+      LOG_DEBUG("io_uring_enter failed: %s", strerror(errno));
+      // 内核没有取走的请求收回来在这个线程上同步完成, 不让它们一直等下去
+      unsigned sq_head = __atomic_load_n(ring_->sq_head_, __ATOMIC_ACQUIRE);
+      for (unsigned i = sq_head; i != *ring_->sq_tail_; i++) {
+        const io_uring_sqe &sqe = ring_->sqes_[ring_->sq_array_[i & *ring_->sq_mask_]];
+        if (sqe.user_data == WAKEUP_USER_DATA) {
+          wakeup_armed = false;
+          continue;
+        }
+        Pending *pending = slots[sqe.user_data];
+        slots[sqe.user_data] = nullptr;
+        free_slots.push_back(sqe.user_data);
+        Complete(pending, RunSync(pending->request_));
+      }
+      __atomic_store_n(ring_->sq_tail_, sq_head, __ATOMIC_RELEASE);
+      // 一直出错的时候退避而不是空转; 没有请求还在内核里的时候放弃 io_uring, 这个线程改为工作线程
+      if (++failures >= MAX_ENTER_FAILURES && free_slots.size() == queue_depth_) {
+        LOG_DEBUG("io_uring keeps failing, running the requests on the I/O thread instead");
+        WorkerLoop();
+        return;
+      }
+      std::this_thread::sleep_for(backoff);
+      backoff = std::min(backoff * 2, MAX_ENTER_BACKOFF);
+    } else {
+      failures = 0;
+      backoff = std::chrono::milliseconds(1);
+    }
+
+    unsigned head = *ring_->cq_head_;
+    unsigned tail = __atomic_load_n(ring_->cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+      io_uring_cqe cqe = ring_->cqes_[head & *ring_->cq_mask_];
+      if (cqe.user_data == WAKEUP_USER_DATA) {
+        wakeup_armed = false;
+        while (read(ring_->event_fd_, &wakeup_count, sizeof(wakeup_count)) > 0) {
+        }
+        continue;
+      }
+      Pending *pending = slots[cqe.user_data];
+      slots[cqe.user_data] = nullptr;
+      free_slots.push_back(cqe.user_data);
+      const DiskRequest &request = pending->request_;
+      size_t len = request.num_pages_ * disk_manager_->GetPageSize();
+      bool success = cqe.res >= 0;
+      if (!success) {
+        LOG_DEBUG("I/O error on page %d: %s", request.page_id_, strerror(-cqe.res));
+      } else if (request.is_write_ && static_cast<size_t>(cqe.res) < len) {
+        // 很少见的部分写入, 直接同步重写整个请求
+        success = RunSync(request);
+      } else if (request.is_write_) {
+        for (size_t i = 0; i < request.num_pages_; i++) {
+          disk_manager_->OnPageWritten(request.page_id_ + static_cast<page_id_t>(i));
+        }
+      } else {
+        // 文件末尾之后的部分读作 0
+        memset(request.data_ + cqe.res, 0, len - cqe.res);
+      }
+      Complete(pending, success);
+    }
+    __atomic_store_n(ring_->cq_head_, head, __ATOMIC_RELEASE);
+  }
+}
+
+#else
+
+struct DiskScheduler::Ring {};
+
+auto DiskScheduler::SetUpRing() -> bool { return false; }
+
+void DiskScheduler::TearDownRing() {}
+
+void DiskScheduler::RingLoop() {}
+
+#endif
+
+DiskScheduler::DiskScheduler(DiskManager *disk_manager, size_t queue_depth, size_t num_workers, bool use_io_uring)
+    : disk_manager_(disk_manager), queue_depth_(std::max<size_t>(queue_depth, 1)) {
+  if (use_io_uring && disk_manager_->GetFileDescriptor() >= 0 && SetUpRing()) {
+    threads_.emplace_back([this] { RingLoop(); });
+    return;
+  }
+  size_t workers = std::max<size_t>(std::min(num_workers, queue_depth_), 1);
+  for (size_t i = 0; i < workers; i++) {
+    threads_.emplace_back([this] { WorkerLoop(); });
+  }
+}
+
+DiskScheduler::~DiskScheduler() {
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+#ifdef BUSTUB_HAVE_IO_URING
+  if (ring_ != nullptr) {
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = write(ring_->event_fd_, &one, sizeof(one));
+  }
+#endif
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+  TearDownRing();
+}
+
+auto DiskScheduler::Schedule(DiskRequest request) -> std::future<bool> {
+  std::vector<DiskRequest> requests;
+  requests.push_back(std::move(request));
+  return std::move(ScheduleBatch(std::move(requests))[0]);
+}
+
+auto DiskScheduler::ScheduleBatch(std::vector<DiskRequest> requests) -> std::vector<std::future<bool>> {
+  std::vector<std::future<bool>> futures;
+  if (requests.empty()) {
+    return futures;
+  }
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (auto &request : requests) {
+      auto *pending = new Pending{std::move(request), std::promise<bool>()};
+      futures.push_back(pending->promise_.get_future());
+      queue_.push_back(pending);
+    }
+  }
+#ifdef BUSTUB_HAVE_IO_URING
+  if (ring_ != nullptr) {
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = write(ring_->event_fd_, &one, sizeof(one));
+  }
+#endif
+  // 放弃了 io_uring 的 I/O 线程和工作线程一样在 cv_ 上等待
+  cv_.notify_all();
+  return futures;
+}
+
+void DiskScheduler::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+    Pending *pending = queue_.front();
+    queue_.pop_front();
+    lock.unlock();
+    Complete(pending, RunSync(pending->request_));
+    lock.lock();
+  }
+}
+
+auto DiskScheduler::RunSync(const DiskRequest &request) -> bool {
+  if (request.is_write_) {
+    size_t page_size = disk_manager_->GetPageSize();
+    for (size_t i = 0; i < request.num_pages_; i++) {
+      if (!disk_manager_->WritePage(request.page_id_ + static_cast<page_id_t>(i), request.data_ + i * page_size)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  if (request.num_pages_ == 1) {
+    return disk_manager_->ReadPage(request.page_id_, request.data_);
+  }
+  return disk_manager_->ReadPages(request.page_id_, request.num_pages_, request.data_);
+}
+
+void DiskScheduler::Complete(Pending *pending, bool success) {
+  if (pending->request_.callback_) {
+    pending->request_.callback_(success);
+  }
+  pending->promise_.set_value(success);
+  delete pending;
+}
+
+}  // namespace bustub
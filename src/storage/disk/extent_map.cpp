@@ -0,0 +1,202 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extent_map.cpp
+//
+// Identification: src/storage/disk/extent_map.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/extent_map.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+/** The header page of the file of a map. */
+struct ExtentMapHeader {
+  uint32_t magic_;
+  uint32_t num_extents_;
+};
+
+/** pwrite all of size bytes, retrying short writes. */
+static auto WriteAll(int fd, const char *data, size_t size, int64_t offset) -> bool {
+  size_t written = 0;
+  while (written < size) {
+    ssize_t n = pwrite(fd, data + written, size - written, offset + written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      LOG_DEBUG("I/O error while writing the extent map: %s", strerror(errno));
+      return false;
+    }
+    written += n;
+  }
+  return true;
+}
+
+ExtentMap::~ExtentMap() { Close(); }
+
+auto ExtentMap::Open(const std::string &file_name, bool reset) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  fd_ = open(file_name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    LOG_DEBUG("can't open the extent map %s: %s", file_name.c_str(), strerror(errno));
+    return false;
+  }
+  ExtentMapHeader header{};
+  if (reset || pread(fd_, &header, sizeof(header), 0) != sizeof(header) || header.magic_ != MAGIC) {
+    if (ftruncate(fd_, 0) != 0) {
+      LOG_DEBUG("can't truncate the extent map: %s", strerror(errno));
+    }
+    header = {MAGIC, 0};
+  }
+  extents_.assign(header.num_extents_, Extent{});
+  size_t bytes = extents_.size() * sizeof(Extent);
+  if (bytes > 0 && pread(fd_, extents_.data(), bytes, BUSTUB_PAGE_SIZE) != static_cast<ssize_t>(bytes)) {
+    // 读不全的时候宁可不用这些区, 也不能把已经分配出去的页面再分配一次
+    LOG_DEBUG("the extent map %s is truncated, starting an empty one", file_name.c_str());
+    extents_.clear();
+  }
+  open_.clear();
+  for (size_t i = 0; i < extents_.size(); i++) {
+    if (extents_[i].used_ < EXTENT_PAGES) {
+      open_[extents_[i].owner_].push_back(i);
+    }
+  }
+  dirty_.assign((extents_.size() + EXTENTS_PER_PAGE - 1) / EXTENTS_PER_PAGE, false);
+  header_dirty_ = true;
+  return true;
+}
+
+void ExtentMap::Close() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+void ExtentMap::MarkDirty(size_t i) {
+  size_t page = i / EXTENTS_PER_PAGE;
+  if (dirty_.size() <= page) {
+    dirty_.resize(page + 1, false);
+  }
+  dirty_[page] = true;
+}
+
+auto ExtentMap::Allocate(page_id_t owner, size_t stride, size_t offset) -> page_id_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto it = open_.find(owner);
+  if (it == open_.end()) {
+    return INVALID_PAGE_ID;
+  }
+  // 按照添加的顺序使用这个对象的区, 用完的区不再留在 open_ 里
+  std::vector<size_t> &open = it->second;
+  for (size_t j = 0; j < open.size(); j++) {
+    Extent &extent = extents_[open[j]];
+    if (extent.stride_ != stride || static_cast<size_t>(extent.first_page_) % stride != offset) {
+      continue;
+    }
+    auto page_id = static_cast<page_id_t>(extent.first_page_ + extent.used_ * extent.stride_);
+    extent.used_++;
+    MarkDirty(open[j]);
+    if (extent.used_ == EXTENT_PAGES) {
+      open.erase(open.begin() + j);
+      if (open.empty()) {
+        open_.erase(it);
+      }
+    }
+    return page_id;
+  }
+  return INVALID_PAGE_ID;
+}
+
+void ExtentMap::AddExtent(page_id_t owner, page_id_t first_page, size_t stride) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  extents_.push_back({first_page, owner, static_cast<uint32_t>(stride), 0});
+  open_[owner].push_back(extents_.size() - 1);
+  MarkDirty(extents_.size() - 1);
+  header_dirty_ = true;
+}
+
+auto ExtentMap::IsReserved(page_id_t page_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  // 还没有分配出去的页面只可能在没有用完的区里
+  for (const auto &[owner, open] : open_) {
+    for (size_t i : open) {
+      const Extent &extent = extents_[i];
+      page_id_t offset = page_id - extent.first_page_;
+      if (offset >= 0 && offset % static_cast<page_id_t>(extent.stride_) == 0) {
+        auto index = static_cast<uint32_t>(offset / static_cast<page_id_t>(extent.stride_));
+        if (index >= extent.used_ && index < EXTENT_PAGES) {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+auto ExtentMap::GetExtents(page_id_t owner) -> std::vector<Extent> {
+  std::scoped_lock<std::mutex> lock(latch_);
+  std::vector<Extent> extents;
+  std::copy_if(extents_.begin(), extents_.end(), std::back_inserter(extents),
+               [owner](const Extent &extent) { return extent.owner_ == owner; });
+  return extents;
+}
+
+auto ExtentMap::GetNumExtents() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return extents_.size();
+}
+
+auto ExtentMap::Flush() -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (fd_ < 0) {
+    return true;
+  }
+  bool pages_written = false;
+  // 第 i 页的区在文件的第 i + 1 页, 第 0 页是表头; 最后一页可能只写了一部分
+  for (size_t i = 0; i < dirty_.size(); i++) {
+    if (!dirty_[i]) {
+      continue;
+    }
+    size_t first = i * EXTENTS_PER_PAGE;
+    size_t count = std::min(EXTENTS_PER_PAGE, extents_.size() - first);
+    const auto *data = reinterpret_cast<const char *>(extents_.data() + first);
+    if (!WriteAll(fd_, data, count * sizeof(Extent), static_cast<int64_t>(i + 1) * BUSTUB_PAGE_SIZE)) {
+      return false;
+    }
+    dirty_[i] = false;
+    pages_written = true;
+  }
+  if (!header_dirty_ && !pages_written) {
+    return true;
+  }
+  // 区持久化之后才写表头, 表头里的区数不会超过文件里已经写好的区
+  if (pages_written && fdatasync(fd_) != 0) {
+    return false;
+  }
+  char page[BUSTUB_PAGE_SIZE] = {0};
+  ExtentMapHeader header{MAGIC, static_cast<uint32_t>(extents_.size())};
+  memcpy(page, &header, sizeof(header));
+  if (!WriteAll(fd_, page, BUSTUB_PAGE_SIZE, 0) || fdatasync(fd_) != 0) {
+    return false;
+  }
+  header_dirty_ = false;
+  return true;
+}
+
+}  // namespace bustub
@@ -0,0 +1,208 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_page_map.cpp
+//
+// Identification: src/storage/disk/free_page_map.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/free_page_map.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+/** The header page of the file of a map. */
+struct FreePageMapHeader {
+  uint32_t magic_;
+  page_id_t next_page_id_;
+  uint32_t num_pages_;
+  /** 0 in files written before the page size was recorded, which all have BUSTUB_PAGE_SIZE pages. */
+  uint32_t page_size_;
+};
+
+/** pwrite all of size bytes, retrying short writes. */
+static auto WriteAll(int fd, const char *data, size_t size, int64_t offset) -> bool {
+  size_t written = 0;
+  while (written < size) {
+    ssize_t n = pwrite(fd, data + written, size - written, offset + written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      LOG_DEBUG("I/O error while writing the free page map: %s", strerror(errno));
+      return false;
+    }
+    written += n;
+  }
+  return true;
+}
+
+FreePageMap::~FreePageMap() { Close(); }
+
+auto FreePageMap::Open(const std::string &file_name, bool reset) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  fd_ = open(file_name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    LOG_DEBUG("can't open the free page map %s: %s", file_name.c_str(), strerror(errno));
+    return false;
+  }
+  FreePageMapHeader header{};
+  // 数据库文件是新的时候, 旧的空闲页面表 (比如上一次留下的) 没有意义
+  if (reset || pread(fd_, &header, sizeof(header), 0) != sizeof(header) || header.magic_ != MAGIC) {
+    if (ftruncate(fd_, 0) != 0) {
+      LOG_DEBUG("can't truncate the free page map: %s", strerror(errno));
+    }
+    header = {MAGIC, 0, 0, 0};
+  }
+  bits_.assign(static_cast<size_t>(header.num_pages_) * WORDS_PER_PAGE, 0);
+  dirty_.assign(header.num_pages_, false);
+  size_t bytes = bits_.size() * sizeof(uint64_t);
+  if (bytes > 0 && pread(fd_, bits_.data(), bytes, BUSTUB_PAGE_SIZE) != static_cast<ssize_t>(bytes)) {
+    // 读不全的表不能用, 宁可不重用页面也不能把使用中的页面当作空闲的
+    LOG_DEBUG("the free page map %s is truncated, starting an empty one", file_name.c_str());
+    bits_.assign(bits_.size(), 0);
+    dirty_.assign(dirty_.size(), true);
+  }
+  size_t num_free = 0;
+  for (uint64_t word : bits_) {
+    num_free += __builtin_popcountll(word);
+  }
+  num_free_ = num_free;
+  first_word_ = 0;
+  next_page_id_ = header.next_page_id_;
+  page_size_ = header.page_size_;
+  header_dirty_ = true;
+  return true;
+}
+
+void FreePageMap::Close() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+void FreePageMap::Cover(page_id_t page_id) {
+  size_t pages = static_cast<size_t>(page_id) / PAGE_IDS_PER_PAGE + 1;
+  if (dirty_.size() < pages) {
+    bits_.resize(pages * WORDS_PER_PAGE, 0);
+    dirty_.resize(pages, true);
+  }
+}
+
+auto FreePageMap::Allocate(size_t stride, size_t offset) -> page_id_t {
+  // 没有空闲页面的时候不用加锁
+  if (num_free_ == 0) {
+    return INVALID_PAGE_ID;
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  while (first_word_ < bits_.size() && bits_[first_word_] == 0) {
+    first_word_++;
+  }
+  for (size_t word = first_word_; word < bits_.size(); word++) {
+    uint64_t bits = bits_[word];
+    while (bits != 0) {
+      int bit = __builtin_ctzll(bits);
+      bits &= bits - 1;
+      size_t page_id = word * 64 + bit;
+      if (page_id % stride != offset) {
+        continue;
+      }
+      bits_[word] &= ~(uint64_t{1} << bit);
+      dirty_[page_id / PAGE_IDS_PER_PAGE] = true;
+      num_free_--;
+      return static_cast<page_id_t>(page_id);
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+void FreePageMap::Free(page_id_t page_id) {
+  if (page_id < 0 || page_id >= next_page_id_) {
+    return;
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  Cover(page_id);
+  size_t word = static_cast<size_t>(page_id) / 64;
+  uint64_t mask = uint64_t{1} << (page_id % 64);
+  if ((bits_[word] & mask) != 0) {
+    return;
+  }
+  bits_[word] |= mask;
+  dirty_[static_cast<size_t>(page_id) / PAGE_IDS_PER_PAGE] = true;
+  first_word_ = std::min(first_word_, word);
+  num_free_++;
+}
+
+auto FreePageMap::IsFree(page_id_t page_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  size_t word = static_cast<size_t>(page_id) / 64;
+  return page_id >= 0 && word < bits_.size() && (bits_[word] & (uint64_t{1} << (page_id % 64))) != 0;
+}
+
+void FreePageMap::NoteAllocated(page_id_t page_id) {
+  page_id_t next = next_page_id_.load();
+  while (next <= page_id) {
+    if (next_page_id_.compare_exchange_weak(next, page_id + 1)) {
+      header_dirty_ = true;
+      return;
+    }
+  }
+}
+
+void FreePageMap::SetPageSize(size_t page_size) {
+  page_size_ = static_cast<uint32_t>(page_size);
+  header_dirty_ = true;
+}
+
+auto FreePageMap::Flush() -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (fd_ < 0) {
+    return true;
+  }
+  bool changed = header_dirty_.exchange(false);
+  bool pages_written = false;
+  // 第 i 个位图页面在文件的第 i + 1 页, 第 0 页是表头
+  for (size_t i = 0; i < dirty_.size(); i++) {
+    if (!dirty_[i]) {
+      continue;
+    }
+    const auto *data = reinterpret_cast<const char *>(bits_.data() + i * WORDS_PER_PAGE);
+    if (!WriteAll(fd_, data, BUSTUB_PAGE_SIZE, static_cast<int64_t>(i + 1) * BUSTUB_PAGE_SIZE)) {
+      header_dirty_ = true;
+      return false;
+    }
+    dirty_[i] = false;
+    pages_written = true;
+  }
+  if (!changed && !pages_written) {
+    return true;
+  }
+  // 位图页面持久化之后才写表头, 表头里的页数不会超过文件里已经写好的位图页面
+  if (pages_written && fdatasync(fd_) != 0) {
+    header_dirty_ = true;
+    return false;
+  }
+  char page[BUSTUB_PAGE_SIZE] = {0};
+  FreePageMapHeader header{MAGIC, next_page_id_, static_cast<uint32_t>(dirty_.size()), page_size_};
+  memcpy(page, &header, sizeof(header));
+  if (!WriteAll(fd_, page, BUSTUB_PAGE_SIZE, 0) || fdatasync(fd_) != 0) {
+    header_dirty_ = true;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace bustub
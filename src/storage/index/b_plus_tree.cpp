@@ -35,8 +35,11 @@ BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manag
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
-      leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {
+      leaf_max_size_(leaf_max_size > 0 ? leaf_max_size
+                                        : static_cast<int>(LEAF_PAGE_CAPACITY(buffer_pool_manager->GetPageSize()))),
+      internal_max_size_(internal_max_size > 0
+                             ? internal_max_size
+                             : static_cast<int>(INTERNAL_PAGE_CAPACITY(buffer_pool_manager->GetPageSize()))) {
   // LOG_INFO("internal max is [%d] leaf max is [%d]", internal_max_size, leaf_max_size);
 }
 
@@ -58,10 +61,8 @@ INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) -> bool {
   // std::cout << "Getvalue " << key << std::endl;
   page_id_t leaf_page = FindShouldLocalPage(key, transaction);
-  auto leaf_data = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(leaf_page));
-  auto v = leaf_data->FindValueAddVector(key, result, comparator_);
-  buffer_pool_manager_->UnpinPage(leaf_data->GetPageId(), false);
-  return v;
+  BasicPageGuard leaf_guard = buffer_pool_manager_->FetchPageBasic(leaf_page);
+  return leaf_guard.As<LeafPage>()->FindValueAddVector(key, result, comparator_);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -70,43 +71,38 @@ auto BPLUSTREE_TYPE::FindShouldLocalPage(const KeyType &key, Transaction *transa
   if (root_page_id_ == INVALID_PAGE_ID) {
     throw std::runtime_error("root_page_id is INVALID_PAGE_ID");
   }
-  auto *data = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(root_page_id_));
+  BasicPageGuard guard = buffer_pool_manager_->FetchPageBasic(root_page_id_);
+  auto *data = guard.As<BPlusTreePage>();
   while (!data->IsLeafPage()) {
-    auto internal_data = reinterpret_cast<InternalPage *>(data);
+    auto internal_data = reinterpret_cast<const InternalPage *>(data);
     page_id_t next_page = internal_data->GetNextPageId(key, comparator_);
-    buffer_pool_manager_->UnpinPage(data->GetPageId(), false);
     // LOG_INFO("cur page is [%d],next page is [%d]", data->GetPageId(), next_page);
-    data = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(next_page));
+    guard = buffer_pool_manager_->FetchPageBasic(next_page);
+    data = guard.As<BPlusTreePage>();
   }
-  auto page_id = data->GetPageId();
-  buffer_pool_manager_->UnpinPage(page_id, false);
   // LOG_INFO("leaf page is [%d]", data->GetPageId());
-  return page_id;
+  return data->GetPageId();
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::CreateNewLeafPage(page_id_t *page_id, page_id_t parent, page_id_t next_page) -> bool {
-  auto page = buffer_pool_manager_->NewPage(page_id);
-  if (page == nullptr) {
+auto BPLUSTREE_TYPE::CreateNewLeafPage(page_id_t *page_id, page_id_t parent, page_id_t next_page) -> BasicPageGuard {
+  BasicPageGuard guard = buffer_pool_manager_->NewPageInExtentGuarded(page_id, &extent_owner_);
+  if (!guard) {
     throw std::runtime_error("out of memory");
   }
-  auto data = reinterpret_cast<LeafPage *>(page);
   // 对于根节点进行set函数,设置大小、父页面、当前页面、当前类别
-  data->Init(*page_id, parent, leaf_max_size_, next_page);
-  buffer_pool_manager_->UnpinPage(*page_id, true);
-  return true;
+  guard.AsMut<LeafPage>()->Init(*page_id, parent, leaf_max_size_, next_page);
+  return guard;
 }
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::CreateNewInternalPage(page_id_t *page_id, page_id_t parent) -> bool {
-  auto page = buffer_pool_manager_->NewPage(page_id);
-  if (page == nullptr) {
+auto BPLUSTREE_TYPE::CreateNewInternalPage(page_id_t *page_id, page_id_t parent) -> BasicPageGuard {
+  BasicPageGuard guard = buffer_pool_manager_->NewPageInExtentGuarded(page_id, &extent_owner_);
+  if (!guard) {
     throw std::runtime_error("out of memory");
   }
-  auto data = reinterpret_cast<InternalPage *>(page);
   // 对于根节点进行set函数,设置大小、父页面、当前页面、当前类别
-  data->Init(*page_id, parent, internal_max_size_);
-  buffer_pool_manager_->UnpinPage(*page_id, true);
-  return true;
+  guard.AsMut<InternalPage>()->Init(*page_id, parent, internal_max_size_);
+  return guard;
 }
 
 /*****************************************************************************
@@ -130,14 +126,16 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
     UpdateRootPageId();
   }
   page_id_t leaf_page = FindShouldLocalPage(key, transaction);
-  auto data = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(leaf_page));
-  auto v = data->Insert(key, value, comparator_);
-  if (!v) {  // 当前的key存在
-    // LOG_INFO("insert index is find in tree return false");
-    buffer_pool_manager_->UnpinPage(leaf_page, false);
-    return false;
-  }
-  buffer_pool_manager_->UnpinPage(leaf_page, true);
+  {
+    BasicPageGuard guard = buffer_pool_manager_->FetchPageBasic(leaf_page);
+    // 当前的key存在的时候页面没有被修改, 不需要标记为脏页
+    auto data = reinterpret_cast<LeafPage *>(guard.GetPage()->GetData());
+    if (!data->Insert(key, value, comparator_)) {
+      // LOG_INFO("insert index is find in tree return false");
+      return false;
+    }
+    guard.SetDirty();
+  }
   DfsSplit(leaf_page, transaction);
   // Print(buffer_pool_manager_);
   return true;
@@ -153,60 +151,61 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::DfsSplit(page_id_t cur, Transaction *transaction) {
   // 如果当前是叶子节点判断是IsFull,但是如果是内部节点则不是 需要GetSize() == GetMaxSize() + 1才分裂
-  auto child = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(cur));
-  if (child->IsLeafPage()) {
-    if (!child->IsFull()) {
-      buffer_pool_manager_->UnpinPage(cur, false);
+  BasicPageGuard child_guard = buffer_pool_manager_->FetchPageBasic(cur);
+  auto node = child_guard.As<BPlusTreePage>();
+  if (node->IsLeafPage()) {
+    if (!node->IsFull()) {
       return;
     }
   } else {
-    if (child->GetSize() != child->GetMaxSize() + 1) {
-      buffer_pool_manager_->UnpinPage(cur, false);
+    if (node->GetSize() != node->GetMaxSize() + 1) {
       return;
     }
   }
+  auto child = child_guard.AsMut<BPlusTreePage>();
   // 如果一直递归到root那么进行更换root
   if (child->GetParentPageId() == INVALID_PAGE_ID) {  // 当前已经递归到根节点了,child是满的
     // 根据递归我们会发现child页面已经满了,但是parent是无效的
     page_id_t root;
-    CreateNewInternalPage(&root);  // 创建一个新的root当作新节点
-    auto data = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(root));
+    BasicPageGuard root_guard = CreateNewInternalPage(&root);  // 创建一个新的root当作新节点
+    auto data = root_guard.AsMut<InternalPage>();
     data->SetIndexKeyValue(0, KeyType{}, child->GetPageId());
     data->IncreaseSize(1);
     // assert(data->GetSize() <= data->GetMaxSize());
     root_page_id_ = root;  // 修改当前的root_page_id_
     child->SetParentPageId(root);
-    buffer_pool_manager_->UnpinPage(root_page_id_, true);
+    root_guard.Drop();
     UpdateRootPageId();
   }
   // 如果当前的孩子满了需要进行拆分,由于上面的根节点的设置,我们始终可以保证移动到上面的是有节点可以插入的
   // 需要对当前child节点进行拆分,然后递归执行parent节点
-  auto parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(child->GetParentPageId()));
+  page_id_t parent_page = child->GetParentPageId();
+  BasicPageGuard parent_guard = buffer_pool_manager_->FetchPageBasic(parent_page);
+  auto parent = parent_guard.AsMut<InternalPage>();
   page_id_t other;
   if (child->IsLeafPage()) {
     // LOG_INFO("leaf split");
     auto child_data = reinterpret_cast<LeafPage *>(child);
-    CreateNewLeafPage(&other, child->GetParentPageId(), child_data->GetNextPageId());
-    auto other_data = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(other));
+    BasicPageGuard other_guard = CreateNewLeafPage(&other, parent_page, child_data->GetNextPageId());
+    auto other_data = other_guard.AsMut<LeafPage>();
     child_data->SetNextPageId(other);
     KeyType mid_key = child_data->Split(other_data, comparator_);
-    parent->Insert(mid_key, other_data->GetPageId(), comparator_);
+    parent->Insert(mid_key, other, comparator_);
     /* LOG_INFO("child_data size is [%d],other size is [%d] parent size is [%d]", child_data->GetSize(),
              other_data->GetSize(), parent->GetSize()); */
   } else {
     // LOG_INFO("internal split");
-    CreateNewInternalPage(&other, child->GetParentPageId());
-    auto other_data = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(other));
+    BasicPageGuard other_guard = CreateNewInternalPage(&other, parent_page);
+    auto other_data = other_guard.AsMut<InternalPage>();
     auto child_data = reinterpret_cast<InternalPage *>(child);
     // 注意当前的内部节点分裂需要将子结点的父节点进行修改
     KeyType mid_key = child_data->Split(other_data, comparator_, buffer_pool_manager_);
-    parent->Insert(mid_key, other_data->GetPageId(), comparator_);
+    parent->Insert(mid_key, other, comparator_);
   }
   // LOG_INFO("cur split over");
-  buffer_pool_manager_->UnpinPage(other, true);
-  buffer_pool_manager_->UnpinPage(cur, true);
-  buffer_pool_manager_->UnpinPage(child->GetParentPageId(), true);
-  DfsSplit(child->GetParentPageId(), transaction);
+  parent_guard.Drop();
+  child_guard.Drop();
+  DfsSplit(parent_page, transaction);
 }
 
 /*****************************************************************************
@@ -226,14 +225,17 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
     return;
   }
   page_id_t leaf_page = FindShouldLocalPage(key, transaction);
-  auto leaf_data = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(leaf_page));
+  BasicPageGuard leaf_guard = buffer_pool_manager_->FetchPageBasic(leaf_page);
+  auto leaf_data = leaf_guard.AsMut<LeafPage>();
   std::pair<bool, KeyType> cur = leaf_data->DeleteKey(key, comparator_);
   if (leaf_data->IsRootPage()) {  // 如果当前节点是根节点直接删除
     if (leaf_data->GetSize() == 0) {
       root_page_id_ = INVALID_PAGE_ID;
       UpdateRootPageId();
+      // 空树不再需要根节点的页面
+      leaf_guard.Drop();
+      buffer_pool_manager_->DeletePage(leaf_page);
     }
-    buffer_pool_manager_->UnpinPage(leaf_page, true);
     // Print(buffer_pool_manager_);
     return;
   }
@@ -242,152 +244,156 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
     if (cur.first) {                                      // 查看删除的是不是第一个
       DfsChangePos0(leaf_data->GetParentPageId(), key, cur.second, transaction);
     }
-    buffer_pool_manager_->UnpinPage(leaf_page, true);
     // Print(buffer_pool_manager_);
-  } else {  // 删除之后的情况,也就是需要查找相关的左右节点进行借取或者合并
-    // 借左兄弟的节点
-    page_id_t leaf_leaf_page = FindLeafLeafData(leaf_data);
-    auto leaf_leaf_data = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(leaf_leaf_page));
-    if (leaf_leaf_data && leaf_leaf_data->GetSize() > leaf_leaf_data->GetMinSize() &&
-        leaf_data->GetParentPageId() == leaf_leaf_data->GetParentPageId()) {
-      // 获取左兄弟的第一个节点的最后一个值,获取当前节点的第一个数组值(为了修改父节点),删除左面最后一个值,将该值插入到右面的节点中
-      // LOG_INFO("借左兄弟节点");
-      MappingType leaf_right = leaf_leaf_data->GetKeyAndValue(leaf_leaf_data->GetSize() - 1);
-      // 需要根据当前的page_id来获取父节点的key,然后修改修改父节点的key
-      auto parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(leaf_data->GetParentPageId()));
-      auto olderkey = parent->KeyAt(parent->AccordValFindValPos(leaf_data->GetPageId()));
-      leaf_leaf_data->DeleteKey(leaf_right.first, comparator_);
-      leaf_data->Insert(leaf_right.first, leaf_right.second, comparator_);
-      // 因为获取的是左边的节点,必定放到当前节点的第一个位置,需要进行修改父节点的第一个位置
-      DfsChangePos0(leaf_data->GetParentPageId(), olderkey, leaf_right.first, transaction);
-      buffer_pool_manager_->UnpinPage(leaf_data->GetParentPageId(), true);
-      buffer_pool_manager_->UnpinPage(leaf_page, true);
-      buffer_pool_manager_->UnpinPage(leaf_leaf_page, true);
-      // Print(buffer_pool_manager_);
-      return;
+    return;
+  }
+  // 删除之后的情况,也就是需要查找相关的左右节点进行借取或者合并
+  // 借左兄弟的节点
+  page_id_t leaf_leaf_page = FindLeafLeafData(leaf_data);
+  BasicPageGuard leaf_leaf_guard = FetchLeafData(leaf_leaf_page);
+  auto leaf_leaf_data = leaf_leaf_guard ? leaf_leaf_guard.As<LeafPage>() : nullptr;
+  if (leaf_leaf_data && leaf_leaf_data->GetSize() > leaf_leaf_data->GetMinSize() &&
+      leaf_data->GetParentPageId() == leaf_leaf_data->GetParentPageId()) {
+    // 获取左兄弟的第一个节点的最后一个值,获取当前节点的第一个数组值(为了修改父节点),删除左面最后一个值,将该值插入到右面的节点中
+    // LOG_INFO("借左兄弟节点");
+    auto left_data = leaf_leaf_guard.AsMut<LeafPage>();
+    MappingType leaf_right = left_data->GetKeyAndValue(left_data->GetSize() - 1);
+    // 需要根据当前的page_id来获取父节点的key,然后修改修改父节点的key
+    KeyType olderkey;
+    {
+      BasicPageGuard parent_guard = buffer_pool_manager_->FetchPageBasic(leaf_data->GetParentPageId());
+      auto parent = parent_guard.As<InternalPage>();
+      olderkey = parent->KeyAt(parent->AccordValFindValPos(leaf_page));
     }
-    // 借右兄弟的节点
-    auto right_data = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(leaf_data->GetNextPageId()));
-    if (right_data && right_data->GetSize() > right_data->GetMinSize() &&
-        right_data->GetParentPageId() == leaf_data->GetParentPageId()) {
-      // 获取右节点的第一个进行放到左节点的右边,修改右边节点的第一个为第二个索引
-      // 首先需要删除右节点的第一个节点,并返回删除之后的下标0节点用于修改父节点的索引
-      // 之后将当前获取的节点放到当前的节点上面,查看是否需要修改当前的节点的父节点(当前的min==1,删除之后是0的情况)
-      // LOG_INFO("借右兄弟节点");
-      MappingType pos0 = right_data->GetKeyAndValue(0);
-      auto begin = Begin(key);
-      ++begin;          // begin 获取当前节点的后继节点
-      if (cur.first) {  // 如果删除的是第一个节点那么需要将后继节点和当前key进行修改
-        MappingType cur = *begin;
-        DfsChangePos0(right_data->GetParentPageId(), key, cur.first, transaction);
-      }
-      std::pair<bool, KeyType> right_delete = right_data->DeleteKey(right_data->KeyAt(0), comparator_);
-      // 修改右面节点的索引
-      DfsChangePos0(right_data->GetParentPageId(), pos0.first, right_delete.second, transaction);
-      leaf_data->Insert(pos0.first, pos0.second, comparator_);
-      buffer_pool_manager_->UnpinPage(right_data->GetPageId(), true);
-      buffer_pool_manager_->UnpinPage(leaf_data->GetPageId(), true);
-      if (leaf_leaf_data != nullptr) {
-        buffer_pool_manager_->UnpinPage(leaf_leaf_data->GetPageId(), false);
-      }
-      // Print(buffer_pool_manager_);
-      return;
+    left_data->DeleteKey(leaf_right.first, comparator_);
+    leaf_data->Insert(leaf_right.first, leaf_right.second, comparator_);
+    // 因为获取的是左边的节点,必定放到当前节点的第一个位置,需要进行修改父节点的第一个位置
+    DfsChangePos0(leaf_data->GetParentPageId(), olderkey, leaf_right.first, transaction);
+    // Print(buffer_pool_manager_);
+    return;
+  }
+  // 借右兄弟的节点
+  BasicPageGuard right_guard = FetchLeafData(leaf_data->GetNextPageId());
+  auto right = right_guard ? right_guard.As<LeafPage>() : nullptr;
+  if (right && right->GetSize() > right->GetMinSize() && right->GetParentPageId() == leaf_data->GetParentPageId()) {
+    // 获取右节点的第一个进行放到左节点的右边,修改右边节点的第一个为第二个索引
+    // 首先需要删除右节点的第一个节点,并返回删除之后的下标0节点用于修改父节点的索引
+    // 之后将当前获取的节点放到当前的节点上面,查看是否需要修改当前的节点的父节点(当前的min==1,删除之后是0的情况)
+    // LOG_INFO("借右兄弟节点");
+    auto right_data = right_guard.AsMut<LeafPage>();
+    MappingType pos0 = right_data->GetKeyAndValue(0);
+    auto begin = Begin(key);
+    ++begin;          // begin 获取当前节点的后继节点
+    if (cur.first) {  // 如果删除的是第一个节点那么需要将后继节点和当前key进行修改
+      MappingType cur = *begin;
+      DfsChangePos0(right_data->GetParentPageId(), key, cur.first, transaction);
     }
-    // 将当前节点合并到左面的节点,删除当前节点的父节点的索引,修改前面的节点的next指向当前节点的next的索引
-    if (leaf_leaf_data && leaf_leaf_data->GetParentPageId() == leaf_data->GetParentPageId()) {
-      // 当前节点合并到左边的节点
-      // LOG_INFO("当前节点合并到左边");
-      while (leaf_data->GetSize() != 0) {
-        auto arr = leaf_data->GetKeyAndValue(0);
-        leaf_leaf_data->Insert(arr.first, arr.second, comparator_);
-        leaf_data->DeleteKey(arr.first, comparator_);
-      }
-      // 修改前面的节点的next执行当前节点的next
-      leaf_leaf_data->SetNextPageId(leaf_data->GetNextPageId());
-      // 此处应该删除父节点一个关键字删除的是page_id = leaf_data->GetPageId()，继续向上递归的进行
-      page_id_t father_page = leaf_data->GetParentPageId();
-      auto father_data = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(father_page));
-      father_data->DeleteArrayVal(leaf_page);
-      buffer_pool_manager_->UnpinPage(leaf_page, true);
-      buffer_pool_manager_->UnpinPage(father_page, true);
-      buffer_pool_manager_->UnpinPage(leaf_leaf_page, true);
-      if (right_data != nullptr) {
-        buffer_pool_manager_->UnpinPage(right_data->GetPageId(), false);
-      }
-      // 需要判断当前的父节点是不是根节点,如果是根节点范围是最低2,如果是1的话,将孩子节点提取到根节点
-      DfsShouldCombine(father_page, transaction);
-      // Print(buffer_pool_manager_);
-      return;
+    std::pair<bool, KeyType> right_delete = right_data->DeleteKey(right_data->KeyAt(0), comparator_);
+    // 修改右面节点的索引
+    DfsChangePos0(right_data->GetParentPageId(), pos0.first, right_delete.second, transaction);
+    leaf_data->Insert(pos0.first, pos0.second, comparator_);
+    // Print(buffer_pool_manager_);
+    return;
+  }
+  // 将当前节点合并到左面的节点,删除当前节点的父节点的索引,修改前面的节点的next指向当前节点的next的索引
+  if (leaf_leaf_data && leaf_leaf_data->GetParentPageId() == leaf_data->GetParentPageId()) {
+    // 当前节点合并到左边的节点
+    // LOG_INFO("当前节点合并到左边");
+    auto left_data = leaf_leaf_guard.AsMut<LeafPage>();
+    while (leaf_data->GetSize() != 0) {
+      auto arr = leaf_data->GetKeyAndValue(0);
+      left_data->Insert(arr.first, arr.second, comparator_);
+      leaf_data->DeleteKey(arr.first, comparator_);
     }
-    // 右边节点和并到当前节点
-    if (right_data && right_data->GetParentPageId() == leaf_data->GetParentPageId()) {
-      // 如果删除的是第一个节点,获取当前节点的直接后继节点进行修改父节点的索引
-      // LOG_INFO("右节点合并到当前");
-      if (cur.first) {
-        auto begin = Begin(key);
-        ++begin;
-        MappingType data = *begin;
-        DfsChangePos0(right_data->GetParentPageId(), key, data.first, transaction);
-      }
-      // 将右面节点的值合并到当前节点
-      while (right_data->GetSize() != 0) {
-        auto arr = right_data->GetKeyAndValue(0);
-        leaf_data->Insert(arr.first, arr.second, comparator_);
-        right_data->DeleteKey(arr.first, comparator_);
-      }
-      // 修改当前节点的next指向右面节点的next
-      leaf_data->SetNextPageId(right_data->GetNextPageId());
-      // 此处应该删除父节点一个关键字，根据右面节点的page_id 进行向上面查找value的值，继续向上递归的进行
-      auto parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(right_data->GetParentPageId()));
-      // 右边节点删除了一个值,需要递归的修改父节点的值
-      parent->DeleteArrayVal(right_data->GetPageId());
-      buffer_pool_manager_->UnpinPage(parent->GetPageId(), true);
-      buffer_pool_manager_->UnpinPage(right_data->GetPageId(), true);
-      buffer_pool_manager_->UnpinPage(leaf_page, true);
-      // leaf_leaf_data 必定是空的不用释放
-      DfsShouldCombine(parent->GetPageId(), transaction);
-      // Print(buffer_pool_manager_);
-      return;
+    // 修改前面的节点的next执行当前节点的next
+    left_data->SetNextPageId(leaf_data->GetNextPageId());
+    // 此处应该删除父节点一个关键字删除的是page_id = leaf_data->GetPageId()，继续向上递归的进行
+    page_id_t father_page = leaf_data->GetParentPageId();
+    buffer_pool_manager_->FetchPageBasic(father_page).AsMut<InternalPage>()->DeleteArrayVal(leaf_page);
+    leaf_guard.Drop();
+    leaf_leaf_guard.Drop();
+    right_guard.Drop();
+    // 合并之后当前节点是空的, 释放它的页面
+    buffer_pool_manager_->DeletePage(leaf_page);
+    // 需要判断当前的父节点是不是根节点,如果是根节点范围是最低2,如果是1的话,将孩子节点提取到根节点
+    DfsShouldCombine(father_page, transaction);
+    // Print(buffer_pool_manager_);
+    return;
+  }
+  // 右边节点和并到当前节点
+  if (right && right->GetParentPageId() == leaf_data->GetParentPageId()) {
+    // 如果删除的是第一个节点,获取当前节点的直接后继节点进行修改父节点的索引
+    // LOG_INFO("右节点合并到当前");
+    if (cur.first) {
+      auto begin = Begin(key);
+      ++begin;
+      MappingType data = *begin;
+      DfsChangePos0(right->GetParentPageId(), key, data.first, transaction);
+    }
+    // 将右面节点的值合并到当前节点
+    auto right_data = right_guard.AsMut<LeafPage>();
+    while (right_data->GetSize() != 0) {
+      auto arr = right_data->GetKeyAndValue(0);
+      leaf_data->Insert(arr.first, arr.second, comparator_);
+      right_data->DeleteKey(arr.first, comparator_);
     }
+    // 修改当前节点的next指向右面节点的next
+    leaf_data->SetNextPageId(right_data->GetNextPageId());
+    // 此处应该删除父节点一个关键字，根据右面节点的page_id 进行向上面查找value的值，继续向上递归的进行
+    page_id_t parent_page = right_data->GetParentPageId();
+    // 右边节点删除了一个值,需要递归的修改父节点的值
+    page_id_t right_page = right_data->GetPageId();
+    buffer_pool_manager_->FetchPageBasic(parent_page).AsMut<InternalPage>()->DeleteArrayVal(right_page);
+    right_guard.Drop();
+    leaf_guard.Drop();
+    buffer_pool_manager_->DeletePage(right_page);
+    // leaf_leaf_data 必定是空的不用释放
+    DfsShouldCombine(parent_page, transaction);
+    // Print(buffer_pool_manager_);
+    return;
   }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::DfsShouldCombine(page_id_t c, Transaction *transaction) {
   // 如果当前的节点是根节点需要进行操作
-  auto cur = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(c));
-  if (cur->IsRootPage()) {
-    if (cur->GetSize() < 2) {  // 当前的根节点只有一个节点也就是0,修改根节点
+  BasicPageGuard cur_guard = buffer_pool_manager_->FetchPageBasic(c);
+  auto node = cur_guard.As<InternalPage>();
+  if (node->IsRootPage()) {
+    if (node->GetSize() < 2) {  // 当前的根节点只有一个节点也就是0,修改根节点
       // LOG_INFO("remove change root");
-      root_page_id_ = cur->ValueAt(0);
+      root_page_id_ = node->ValueAt(0);
       // 修改当前的root的parent节点是-1
-      auto root = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(root_page_id_));
-      root->SetParentPageId(INVALID_PAGE_ID);
-      buffer_pool_manager_->UnpinPage(root_page_id_, true);
+      buffer_pool_manager_->FetchPageBasic(root_page_id_).AsMut<BPlusTreePage>()->SetParentPageId(INVALID_PAGE_ID);
       UpdateRootPageId();
+      // 旧的根节点已经没有用了
+      cur_guard.Drop();
+      buffer_pool_manager_->DeletePage(c);
     }
-    buffer_pool_manager_->UnpinPage(cur->GetPageId(), false);
     return;
   }
-  if (cur->GetSize() >= cur->GetMinSize() && cur->GetSize() >= 2) {
+  if (node->GetSize() >= node->GetMinSize() && node->GetSize() >= 2) {
     // 不是根节点那么需要严格的比较min_size
     // 注意边界是2的情况此时比如说max=3,那么cur internal可能是1但是内部节点不可能没有分界点
     // LOG_INFO("cur page is [%d] internal size is [%d] 大于 [%d] 不用合并", c, cur->GetSize(), cur->GetMinSize());
-    buffer_pool_manager_->UnpinPage(cur->GetPageId(), false);
     return;
   }
   // LOG_INFO("cur page is [%d] size is [%d] min size is [%d]需要借或者是合并", c, cur->GetSize(), cur->GetMinSize());
   // 依旧是需要进行左右节点的借取或者是左右节点的合并
-  auto leaf = FindInternalLeafData(cur);
+  auto cur = cur_guard.AsMut<InternalPage>();
+  BasicPageGuard leaf_guard = FindInternalLeafData(cur);
+  auto leaf = leaf_guard ? leaf_guard.As<InternalPage>() : nullptr;
   // 当前节点向左边的内部节点借
   if (leaf && leaf->GetSize() > leaf->GetMinSize() && leaf->GetSize() > 2) {
     // LOG_INFO("当前节点向左节点借");
+    auto left = leaf_guard.AsMut<InternalPage>();
     // 获取父节点
-    auto father = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(leaf->GetParentPageId()));
+    BasicPageGuard father_guard = buffer_pool_manager_->FetchPageBasic(left->GetParentPageId());
+    auto father = father_guard.AsMut<InternalPage>();
     // 获取左边最后一个节点的key,value,并删除
-    KeyType key = leaf->KeyAt(leaf->GetSize() - 1);
-    page_id_t val = leaf->ValueAt(leaf->GetSize() - 1);
-    leaf->DeleteArrayVal(val);
+    KeyType key = left->KeyAt(left->GetSize() - 1);
+    page_id_t val = left->ValueAt(left->GetSize() - 1);
+    left->DeleteArrayVal(val);
     // 当前节点对应于的父节点的index,需要获得父节点的key放到cur中
     // 将左边节点的key放到父节点中,将左边节点的val放到cur节点中
     int index = father->AccordValFindValPos(cur->GetPageId());
@@ -397,150 +403,149 @@ void BPLUSTREE_TYPE::DfsShouldCombine(page_id_t c, Transaction *transaction) {
     // 其余的位置向后移动
     cur->AddKeyTo1ValTo0(father_key, val);
     // 移动过去的节点需要修改父节点的值
-    auto n = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(val));
-    n->SetParentPageId(cur->GetPageId());
-    buffer_pool_manager_->UnpinPage(val, true);
-    // 修改leaf,cur,father的值
-    buffer_pool_manager_->UnpinPage(leaf->GetParentPageId(), true);
-    buffer_pool_manager_->UnpinPage(leaf->GetPageId(), true);
-    buffer_pool_manager_->UnpinPage(cur->GetPageId(), true);
+    buffer_pool_manager_->FetchPageBasic(val).AsMut<BPlusTreePage>()->SetParentPageId(cur->GetPageId());
     return;
   }
-  auto right = FindInternalRightData(cur);
+  BasicPageGuard right_guard = FindInternalRightData(cur);
+  auto right = right_guard ? right_guard.As<InternalPage>() : nullptr;
   // 当前节点向右边的内部节点借
   if (right && right->GetSize() > right->GetMinSize() && right->GetSize() > 2) {
     // LOG_INFO("当前节点向右节点借");
-    auto father = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(cur->GetParentPageId()));
+    auto right_data = right_guard.AsMut<InternalPage>();
+    BasicPageGuard father_guard = buffer_pool_manager_->FetchPageBasic(cur->GetParentPageId());
+    auto father = father_guard.AsMut<InternalPage>();
     // 获取右边节点的第一个节点需要将其放到当前,并删除右边节点
-    auto nn = right->DeleteKey1Val0();
+    auto nn = right_data->DeleteKey1Val0();
     // 当前节点对应于的父节点的index+1(注意是index+1),需要获得父节点的key放到cur中
     // 将左边节点的key放到父节点中,将左边节点的val放到cur节点中
-    int index = father->AccordValFindValPos(right->GetPageId());
+    int index = father->AccordValFindValPos(right_data->GetPageId());
     KeyType father_key = father->KeyAt(index);
     father->SetKeyAt(index, nn.first);
     cur->Insert(father_key, nn.second, comparator_);
     // 修改移动过去的节点的父节点的值
-    auto n = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(nn.second));
-    n->SetParentPageId(cur->GetPageId());
-    buffer_pool_manager_->UnpinPage(nn.second, true);
-    // 修改right,cur,father
-    buffer_pool_manager_->UnpinPage(right->GetParentPageId(), true);
-    buffer_pool_manager_->UnpinPage(right->GetPageId(), true);
-    buffer_pool_manager_->UnpinPage(cur->GetPageId(), true);
-    if (leaf != nullptr) {
-      buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
-    }
+    page_id_t moved = nn.second;
+    buffer_pool_manager_->FetchPageBasic(moved).AsMut<BPlusTreePage>()->SetParentPageId(cur->GetPageId());
     return;
   }
   // 向左边的内部节点进行合并
   if (leaf) {
     // cur节点的父节点拉下来放到左边节点,将当前节点的所有的数据合并到左边
     // LOG_INFO("当前节点向左节点合并");
-    auto father = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(leaf->GetParentPageId()));
+    auto left = leaf_guard.AsMut<InternalPage>();
+    BasicPageGuard father_guard = buffer_pool_manager_->FetchPageBasic(left->GetParentPageId());
+    auto father = father_guard.AsMut<InternalPage>();
     int index = father->AccordValFindValPos(cur->GetPageId());
     KeyType father_key = father->KeyAt(index);  // key是父节点的key,value是右边的第一个
     // 父亲节点删除对应的key
     father->DeleteArrayVal(cur->GetPageId());
     // 将内部节点的cur所有的数据,放到leaf中,其中第一个key{} 应该改为key变量
     int cnt = cur->GetSize();
+    std::vector<page_id_t> children;
     for (int i = 0; i < cnt; i++) {
       KeyType key = cur->KeyAt(0);
       page_id_t val = cur->ValueAt(0);
-      auto nn = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(val));
-      nn->SetParentPageId(cur->GetPageId());
-      buffer_pool_manager_->UnpinPage(val, true);
+      children.push_back(val);
       if (i == 0) {
         key = father_key;
       }
       cur->DeleteArrayVal(val);
-      leaf->Insert(key, val, comparator_);
-    }
-    buffer_pool_manager_->UnpinPage(leaf->GetParentPageId(), true);
-    buffer_pool_manager_->UnpinPage(leaf->GetPageId(), true);
-    buffer_pool_manager_->UnpinPage(cur->GetPageId(), true);
-    if (right != nullptr) {
-      buffer_pool_manager_->UnpinPage(right->GetPageId(), false);
+      left->Insert(key, val, comparator_);
     }
+    // 合并到左边节点的孩子, 父节点变成了左边的节点
+    InternalPage::SetChildrenParent(children, left->GetPageId(), buffer_pool_manager_);
     // Print(buffer_pool_manager_);
-    DfsShouldCombine(cur->GetParentPageId(), transaction);
+    page_id_t parent_page = cur->GetParentPageId();
+    father_guard.Drop();
+    leaf_guard.Drop();
+    right_guard.Drop();
+    cur_guard.Drop();
+    buffer_pool_manager_->DeletePage(c);
+    DfsShouldCombine(parent_page, transaction);
     return;
   }
   // 右面节点向cur进行合并
   if (right) {
     // cur节点的父节点拉下来放到左边节点,将当前节点的所有的数据合并到左边
     // LOG_INFO("右节点向当前节点合并");
-    auto father = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(right->GetParentPageId()));
+    auto right_data = right_guard.AsMut<InternalPage>();
+    BasicPageGuard father_guard = buffer_pool_manager_->FetchPageBasic(right_data->GetParentPageId());
+    auto father = father_guard.AsMut<InternalPage>();
     int index = father->AccordValFindValPos(cur->GetPageId()) + 1;
     KeyType father_key = father->KeyAt(index);  // key是父节点的key,value是右边的第一个
     // 父亲节点删除对应的key
-    father->DeleteArrayVal(right->GetPageId());
+    father->DeleteArrayVal(right_data->GetPageId());
     // 将内部节点的cur所有的数据,放到leaf中,其中第一个key{} 应该改为key变量
-    int cnt = right->GetSize();
+    int cnt = right_data->GetSize();
+    std::vector<page_id_t> children;
     for (int i = 0; i < cnt; i++) {
-      KeyType key = right->KeyAt(0);
-      page_id_t val = right->ValueAt(0);
-      auto nn = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(val));
-      nn->SetParentPageId(cur->GetPageId());
-      buffer_pool_manager_->UnpinPage(val, true);
+      KeyType key = right_data->KeyAt(0);
+      page_id_t val = right_data->ValueAt(0);
+      children.push_back(val);
       if (i == 0) {
         key = father_key;
       }
-      right->DeleteArrayVal(val);
+      right_data->DeleteArrayVal(val);
       cur->Insert(key, val, comparator_);
     }
-    buffer_pool_manager_->UnpinPage(right->GetParentPageId(), true);
-    buffer_pool_manager_->UnpinPage(cur->GetPageId(), true);
-    buffer_pool_manager_->UnpinPage(right->GetPageId(), true);
+    InternalPage::SetChildrenParent(children, cur->GetPageId(), buffer_pool_manager_);
     // Print(buffer_pool_manager_);
-    DfsShouldCombine(cur->GetParentPageId(), transaction);
+    page_id_t parent_page = cur->GetParentPageId();
+    page_id_t right_page = right_data->GetPageId();
+    father_guard.Drop();
+    right_guard.Drop();
+    cur_guard.Drop();
+    buffer_pool_manager_->DeletePage(right_page);
+    DfsShouldCombine(parent_page, transaction);
     return;
   }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::FindInternalLeafData(InternalPage *cur) -> InternalPage * {
+auto BPLUSTREE_TYPE::FetchLeafData(page_id_t page_id) -> BasicPageGuard {
+  if (page_id == INVALID_PAGE_ID) {
+    return {};
+  }
+  return buffer_pool_manager_->FetchPageBasic(page_id);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindInternalLeafData(const InternalPage *cur) -> BasicPageGuard {
   if (cur->IsRootPage()) {
-    return nullptr;
+    return {};
   }
-  auto parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(cur->GetParentPageId()));
+  BasicPageGuard parent_guard = buffer_pool_manager_->FetchPageBasic(cur->GetParentPageId());
+  auto parent = parent_guard.As<InternalPage>();
   int index = parent->AccordValFindValPos(cur->GetPageId()) - 1;
   if (index < 0) {
-    buffer_pool_manager_->UnpinPage(cur->GetParentPageId(), false);
-    return nullptr;
+    return {};
   }
-  page_id_t pre = parent->ValueAt(index);
-  buffer_pool_manager_->UnpinPage(cur->GetParentPageId(), false);
-  return reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(pre));
+  return buffer_pool_manager_->FetchPageBasic(parent->ValueAt(index));
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::FindInternalRightData(InternalPage *cur) -> InternalPage * {
+auto BPLUSTREE_TYPE::FindInternalRightData(const InternalPage *cur) -> BasicPageGuard {
   if (cur->IsRootPage()) {
-    return nullptr;
+    return {};
   }
   // 当前节点不是根节点必定有父亲节点
-  auto parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(cur->GetParentPageId()));
+  BasicPageGuard parent_guard = buffer_pool_manager_->FetchPageBasic(cur->GetParentPageId());
+  auto parent = parent_guard.As<InternalPage>();
   int index = parent->AccordValFindValPos(cur->GetPageId()) + 1;
   if (index >= parent->GetSize()) {
-    buffer_pool_manager_->UnpinPage(cur->GetParentPageId(), false);
-    return nullptr;
+    return {};
   }
-  page_id_t right = parent->ValueAt(index);
-  buffer_pool_manager_->UnpinPage(cur->GetParentPageId(), false);
-  return reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(right));
+  return buffer_pool_manager_->FetchPageBasic(parent->ValueAt(index));
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::FindLeafLeafData(LeafPage *cur) -> page_id_t {
-  auto father = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(cur->GetParentPageId()));
+auto BPLUSTREE_TYPE::FindLeafLeafData(const LeafPage *cur) -> page_id_t {
+  BasicPageGuard father_guard = buffer_pool_manager_->FetchPageBasic(cur->GetParentPageId());
+  auto father = father_guard.As<InternalPage>();
   int index = father->AccordValFindValPos(cur->GetPageId()) - 1;
   if (index < 0) {
-    buffer_pool_manager_->UnpinPage(cur->GetParentPageId(), false);
     return INVALID_PAGE_ID;
   }
-  page_id_t val = father->ValueAt(index);
-  buffer_pool_manager_->UnpinPage(cur->GetParentPageId(), false);
-  return val;
+  return father->ValueAt(index);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -550,15 +555,17 @@ void BPLUSTREE_TYPE::DfsChangePos0(page_id_t father, const KeyType &oldkey, cons
   if (father == INVALID_PAGE_ID) {
     return;
   }
-  auto page_data = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(father));
+  BasicPageGuard guard = buffer_pool_manager_->FetchPageBasic(father);
+  auto page_data = reinterpret_cast<InternalPage *>(guard.GetPage()->GetData());
   // 查看在当前的根节点是否找到对应的目标值
   if (page_data->ChangePos0Key(oldkey, newkey, comparator_)) {  // 如果找到了可以不用递归了
-    buffer_pool_manager_->UnpinPage(father, true);
+    guard.SetDirty();
     return;
   }
   // 没有找到,不用修改当前的页面
-  buffer_pool_manager_->UnpinPage(father, false);
-  DfsChangePos0(page_data->GetParentPageId(), oldkey, newkey, transaction);
+  page_id_t parent_page = page_data->GetParentPageId();
+  guard.Drop();
+  DfsChangePos0(parent_page, oldkey, newkey, transaction);
 }
 
 /*****************************************************************************
@@ -571,34 +578,33 @@ void BPLUSTREE_TYPE::DfsChangePos0(page_id_t father, const KeyType &oldkey, cons
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
-  auto leaf = GetFirstLeafData(root_page_id_);
-  page_id_t cur = leaf->GetPageId();
-  buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
-  return INDEXITERATOR_TYPE(cur, 0, buffer_pool_manager_);
+  BasicPageGuard leaf = GetFirstLeafData(root_page_id_);
+  return INDEXITERATOR_TYPE(leaf.PageId(), 0, buffer_pool_manager_);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::GetFirstLeafData(page_id_t root) -> LeafPage * {
+auto BPLUSTREE_TYPE::GetFirstLeafData(page_id_t root) -> BasicPageGuard {
   // 获取第一个叶子节点
-  auto data = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(root));
+  BasicPageGuard guard = buffer_pool_manager_->FetchPageBasic(root);
+  auto data = guard.As<BPlusTreePage>();
   if (data->IsLeafPage()) {
-    return reinterpret_cast<LeafPage *>(data);
+    return guard;
   }
-  auto internal = reinterpret_cast<InternalPage *>(data);
-  page_id_t temp = internal->ValueAt(0);
-  buffer_pool_manager_->UnpinPage(root, false);
+  page_id_t temp = reinterpret_cast<const InternalPage *>(data)->ValueAt(0);
+  guard.Drop();
   return GetFirstLeafData(temp);
 }
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::GetLastLeafData(page_id_t root) -> LeafPage * {
+auto BPLUSTREE_TYPE::GetLastLeafData(page_id_t root) -> BasicPageGuard {
   // 获取第一个叶子节点
-  auto data = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(root));
+  BasicPageGuard guard = buffer_pool_manager_->FetchPageBasic(root);
+  auto data = guard.As<BPlusTreePage>();
   if (data->IsLeafPage()) {
-    return reinterpret_cast<LeafPage *>(data);
+    return guard;
   }
-  auto internal = reinterpret_cast<InternalPage *>(data);
+  auto internal = reinterpret_cast<const InternalPage *>(data);
   page_id_t temp = internal->ValueAt(internal->GetSize() - 1);
-  buffer_pool_manager_->UnpinPage(root, false);
+  guard.Drop();
   return GetLastLeafData(temp);
 }
 
@@ -610,9 +616,8 @@ auto BPLUSTREE_TYPE::GetLastLeafData(page_id_t root) -> LeafPage * {
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
   page_id_t page = FindShouldLocalPage(key);
-  auto leaf = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(page));
-  auto index = leaf->FindIndexKey(key, comparator_);
-  buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
+  BasicPageGuard guard = buffer_pool_manager_->FetchPageBasic(page);
+  auto index = guard.As<LeafPage>()->FindIndexKey(key, comparator_);
   return INDEXITERATOR_TYPE(page, index, buffer_pool_manager_);
 }
 
@@ -623,10 +628,8 @@ auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE {
-  auto last = GetLastLeafData(root_page_id_);
-  page_id_t cur = last->GetPageId();
-  buffer_pool_manager_->UnpinPage(last->GetPageId(), false);
-  return INDEXITERATOR_TYPE(cur, last->GetSize(), buffer_pool_manager_);
+  BasicPageGuard last = GetLastLeafData(root_page_id_);
+  return INDEXITERATOR_TYPE(last.PageId(), last.As<LeafPage>()->GetSize(), buffer_pool_manager_);
 }
 
 /**
@@ -635,6 +638,30 @@ auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE {
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetRootPageId() -> page_id_t { return root_page_id_; }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetPageIds() -> std::vector<page_id_t> {
+  std::vector<page_id_t> page_ids;
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    return page_ids;
+  }
+  BufferAccessStrategy strategy(RING_BUFFER_SIZE);
+  page_ids.push_back(root_page_id_);
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    BasicPageGuard guard = buffer_pool_manager_->FetchPageBasic(page_ids[i], &strategy);
+    if (!guard) {
+      break;
+    }
+    auto node = guard.As<BPlusTreePage>();
+    if (!node->IsLeafPage()) {
+      auto internal = reinterpret_cast<const InternalPage *>(node);
+      for (int j = 0; j < internal->GetSize(); j++) {
+        page_ids.push_back(internal->ValueAt(j));
+      }
+    }
+  }
+  return page_ids;
+}
+
 /*****************************************************************************
  * UTILITIES AND DEBUG
  *****************************************************************************/
@@ -648,7 +675,8 @@ auto BPLUSTREE_TYPE::GetRootPageId() -> page_id_t { return root_page_id_; }
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  auto *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  BasicPageGuard guard = buffer_pool_manager_->FetchPageBasic(HEADER_PAGE_ID);
+  auto *header_page = static_cast<HeaderPage *>(guard.GetPage());
   if (insert_record != 0) {
     // create a new record<index_name + root_page_id> in header_page
     header_page->InsertRecord(index_name_, root_page_id_);
@@ -656,7 +684,7 @@ void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
+  guard.SetDirty();
 }
 
 /*
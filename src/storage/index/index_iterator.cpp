@@ -21,28 +21,29 @@ INDEXITERATOR_TYPE::IndexIterator(page_id_t page, int index, BufferPoolManager *
 
 INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::IsEnd() -> bool {
-  auto cur = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(page_));
+  auto guard = buffer_pool_manager_->FetchPageRead(page_);
+  auto cur = guard.As<LeafPage>();
   return cur->GetNextPageId() == INVALID_PAGE_ID && index_ == cur->GetSize() - 1;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::operator*() -> const MappingType & {
-  auto cur = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(page_));
-  const MappingType &c = cur->GetKeyAndValue(index_);
-  buffer_pool_manager_->UnpinPage(page_, false);
-  return c;
+  // 返回的引用指向页面里面的数据, 和之前一样依赖于调用者在页面被替换之前使用它
+  auto guard = buffer_pool_manager_->FetchPageRead(page_);
+  return guard.As<LeafPage>()->GetKeyAndValue(index_);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
   index_++;
-  auto leaf = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(page_));
+  auto guard = buffer_pool_manager_->FetchPageRead(page_);
+  auto leaf = guard.As<LeafPage>();
   if (index_ == leaf->GetSize() && leaf->GetNextPageId() != INVALID_PAGE_ID) {
     auto next_page = leaf->GetNextPageId();
-    buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
-    leaf = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(next_page));
+    guard = buffer_pool_manager_->FetchPageRead(next_page);
+    // 进入新的叶子节点的时候预读它的下一个叶子节点, 让磁盘读取和遍历当前节点重叠
+    buffer_pool_manager_->PrefetchPages({guard.As<LeafPage>()->GetNextPageId()});
     page_ = next_page;
-    buffer_pool_manager_->UnpinPage(next_page, false);
     index_ = 0;
   }
   return *this;
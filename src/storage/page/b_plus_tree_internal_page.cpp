@@ -78,7 +78,7 @@ INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType { return array_[index].second; }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetNextPageId(const KeyType &key, const KeyComparator &comp) -> page_id_t {
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetNextPageId(const KeyType &key, const KeyComparator &comp) const -> page_id_t {
   // 根据当前的key进行在内部节点中进行查找,获取到ValueType也就是下一个页面的值
   // LOG_INFO("cur page is [%d] max size is [%d] cur size is [%d]", GetPageId(), GetMaxSize(), GetSize());
   assert(GetSize() <= GetMaxSize());
@@ -141,19 +141,32 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Split(B_PLUS_TREE_INTERNAL_PAGE_TYPE *other
   /* LOG_INFO("set father is [%d] this size is [%d] next page id is [%d]", other->GetPageId(), GetSize(),
            array_[GetMinSize() + 1].second); */
   other->Insert(KeyType{}, array_[GetMinSize() + 1].second, comp);
-  auto in = reinterpret_cast<InternalPage *>(buffer->FetchPage(array_[GetMinSize() + 1].second));
-  in->SetParentPageId(other->GetPageId());
-  buffer->UnpinPage(array_[GetMinSize() + 1].second, true);
+  // 移动到 other 的孩子节点需要修改父节点
+  std::vector<page_id_t> children{array_[GetMinSize() + 1].second};
   for (int size = GetMinSize() + 2; size <= GetMaxSize(); size++) {
     other->Insert(array_[size].first, array_[size].second, comp);
-    auto internal = reinterpret_cast<InternalPage *>(buffer->FetchPage(array_[size].second));
-    internal->SetParentPageId(other->GetPageId());
-    buffer->UnpinPage(array_[size].second, true);
+    children.push_back(array_[size].second);
   }
+  SetChildrenParent(children, other->GetPageId(), buffer);
   IncreaseSize(GetMinSize() - GetMaxSize());
   return array_[GetMinSize() + 1].first;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetChildrenParent(const std::vector<page_id_t> &children, page_id_t parent,
+                                                       BufferPoolManager *buffer) {
+  std::vector<BasicPageGuard> guards = buffer->FetchPagesBasic(children);
+  if (guards.empty()) {
+    for (page_id_t child : children) {
+      buffer->FetchPageBasic(child).AsMut<BPlusTreePage>()->SetParentPageId(parent);
+    }
+    return;
+  }
+  for (auto &guard : guards) {
+    guard.AsMut<BPlusTreePage>()->SetParentPageId(parent);
+  }
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ChangePos0Key(const KeyType &oldkey, const KeyType &newkey,
                                                    const KeyComparator &comp) -> bool {
@@ -169,7 +182,7 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ChangePos0Key(const KeyType &oldkey, const
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::AccordValFindValPos(const ValueType &val) -> int {
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::AccordValFindValPos(const ValueType &val) const -> int {
   int i = GetSize() - 1;
   while (i != -1) {
     if (array_[i].second == val) {
@@ -65,7 +65,7 @@ INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetKeyAndValue(int index) const -> const MappingType & { return array_[index]; }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::FindIndexKey(const KeyType &key, const KeyComparator &comp) -> int {
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::FindIndexKey(const KeyType &key, const KeyComparator &comp) const -> int {
   int i = GetSize() - 1;
   while (i > 0 && comp(array_[i].first, key) == 0) {
     i--;
@@ -103,7 +103,7 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::Split(B_PLUS_TREE_LEAF_PAGE_TYPE *other, const
 }
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::FindValueAddVector(const KeyType &key, std::vector<ValueType> *result,
-                                                    const KeyComparator &comp) -> bool {
+                                                    const KeyComparator &comp) const -> bool {
   bool ans = false;
   for (int i = 0; i < GetSize(); i++) {
     if (comp(array_[i].first, key) == 0) {
@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include <cassert>
+#include <utility>
 
 #include "common/logger.h"
 #include "storage/table/table_heap.h"
@@ -27,65 +28,61 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_m
 TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
                      Transaction *txn)
     : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager), log_manager_(log_manager) {
-  // Initialize the first table page.
-  auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(&first_page_id_));
-  BUSTUB_ASSERT(first_page != nullptr,
+  // Initialize the first table page, in a new extent. The table is the owner of its extents by its first page id.
+  page_id_t extent_owner = INVALID_PAGE_ID;
+  auto first_guard = buffer_pool_manager_->NewPageInExtentGuarded(&first_page_id_, &extent_owner).UpgradeWrite();
+  BUSTUB_ASSERT(first_guard,
                 "Couldn't create a page for the table heap. Have you completed the buffer pool manager project?");
-  first_page->WLatch();
-  first_page->Init(first_page_id_, BUSTUB_PAGE_SIZE, INVALID_LSN, log_manager_, txn);
-  first_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(first_page_id_, true);
+  auto first_page = static_cast<TablePage *>(first_guard.GetPage());
+  first_page->Init(first_page_id_, buffer_pool_manager_->GetPageSize(), INVALID_LSN, log_manager_, txn);
+  first_guard.SetDirty();
 }
 
-auto TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> bool {
-  if (tuple.size_ + 32 > BUSTUB_PAGE_SIZE) {  // larger than one page size
+auto TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, BufferAccessStrategy *strategy) -> bool {
+  if (tuple.size_ + 32 > buffer_pool_manager_->GetPageSize()) {  // larger than one page size
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
 
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
-  if (cur_page == nullptr) {
+  auto cur_guard = buffer_pool_manager_->FetchPageWrite(first_page_id_, strategy);
+  if (!cur_guard) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
+  auto cur_page = static_cast<TablePage *>(cur_guard.GetPage());
 
-  cur_page->WLatch();
   // Insert into the first page with enough space. If no such page exists, create a new page and insert into that.
-  // INVARIANT: cur_page is WLatched if you leave the loop normally.
   while (!cur_page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_)) {
     auto next_page_id = cur_page->GetNextPageId();
     // If the next page is a valid page,
     if (next_page_id != INVALID_PAGE_ID) {
-      // Unlatch and unpin the current page.
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
-      // And repeat the process with the next page.
-      cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
-      cur_page->WLatch();
+      // Unlatch and unpin the current page, and repeat the process with the next page.
+      cur_guard.Drop();
+      cur_guard = buffer_pool_manager_->FetchPageWrite(next_page_id, strategy);
+      cur_page = static_cast<TablePage *>(cur_guard.GetPage());
     } else {
-      // Otherwise we have run out of valid pages. We need to create a new page.
-      auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(&next_page_id));
+      // Otherwise we have run out of valid pages. We need to create a new page, next to the other pages of the table.
+      page_id_t extent_owner = first_page_id_;
+      auto new_guard =
+          buffer_pool_manager_->NewPageInExtentGuarded(&next_page_id, &extent_owner, strategy).UpgradeWrite();
       // If we could not create a new page,
-      if (new_page == nullptr) {
+      if (!new_guard) {
         // Then life sucks and we abort the transaction.
-        cur_page->WUnlatch();
-        buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
         txn->SetState(TransactionState::ABORTED);
         return false;
       }
-      // Otherwise we were able to create a new page. We initialize it now.
-      new_page->WLatch();
+      // Otherwise we were able to create a new page. We initialize it now, and link it in while both are latched.
+      auto new_page = static_cast<TablePage *>(new_guard.GetPage());
       cur_page->SetNextPageId(next_page_id);
-      new_page->Init(next_page_id, BUSTUB_PAGE_SIZE, cur_page->GetTablePageId(), log_manager_, txn);
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
+      cur_guard.SetDirty();
+      new_page->Init(next_page_id, buffer_pool_manager_->GetPageSize(), cur_page->GetTablePageId(), log_manager_, txn);
+      new_guard.SetDirty();
+      cur_guard = std::move(new_guard);
       cur_page = new_page;
     }
   }
-  // This line has caused most of us to double-take and "whoa double unlatch".
-  // We are not, in fact, double unlatching. See the invariant above.
-  cur_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
+  cur_guard.SetDirty();
+  cur_guard.Drop();
   // Update the transaction's write set.
   txn->GetWriteSet()->emplace_back(*rid, WType::INSERT, Tuple{}, this);
   return true;
@@ -94,17 +91,16 @@ auto TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> b
 auto TableHeap::MarkDelete(const RID &rid, Transaction *txn) -> bool {
   // TODO(Amadou): remove empty page
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  auto guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
   // If the page could not be found, then abort the transaction.
-  if (page == nullptr) {
+  if (!guard) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
   // Otherwise, mark the tuple as deleted.
-  page->WLatch();
-  page->MarkDelete(rid, txn, lock_manager_, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  static_cast<TablePage *>(guard.GetPage())->MarkDelete(rid, txn, lock_manager_, log_manager_);
+  guard.SetDirty();
+  guard.Drop();
   // Update the transaction's write set.
   txn->GetWriteSet()->emplace_back(rid, WType::DELETE, Tuple{}, this);
   return true;
@@ -112,18 +108,20 @@ auto TableHeap::MarkDelete(const RID &rid, Transaction *txn) -> bool {
 
 auto TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn) -> bool {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  auto guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
   // If the page could not be found, then abort the transaction.
-  if (page == nullptr) {
+  if (!guard) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
   // Update the tuple; but first save the old value for rollbacks.
   Tuple old_tuple;
-  page->WLatch();
-  bool is_updated = page->UpdateTuple(tuple, &old_tuple, rid, txn, lock_manager_, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), is_updated);
+  bool is_updated =
+      static_cast<TablePage *>(guard.GetPage())->UpdateTuple(tuple, &old_tuple, rid, txn, lock_manager_, log_manager_);
+  if (is_updated) {
+    guard.SetDirty();
+  }
+  guard.Drop();
   // Update the transaction's write set.
   if (is_updated && txn->GetState() != TransactionState::ABORTED) {
     txn->GetWriteSet()->emplace_back(rid, WType::UPDATE, old_tuple, this);
@@ -133,61 +131,73 @@ auto TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn
 
 void TableHeap::ApplyDelete(const RID &rid, Transaction *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
+  auto guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  BUSTUB_ASSERT(guard, "Couldn't find a page containing that RID.");
   // Delete the tuple from the page.
-  page->WLatch();
-  page->ApplyDelete(rid, txn, log_manager_);
+  static_cast<TablePage *>(guard.GetPage())->ApplyDelete(rid, txn, log_manager_);
   lock_manager_->Unlock(txn, rid);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  guard.SetDirty();
 }
 
 void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
+  auto guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  BUSTUB_ASSERT(guard, "Couldn't find a page containing that RID.");
   // Rollback the delete.
-  page->WLatch();
-  page->RollbackDelete(rid, txn, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  static_cast<TablePage *>(guard.GetPage())->RollbackDelete(rid, txn, log_manager_);
+  guard.SetDirty();
 }
 
 auto TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) -> bool {
   // Find the page which contains the tuple.
-  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  auto guard = buffer_pool_manager_->FetchPageRead(rid.GetPageId());
   // If the page could not be found, then abort the transaction.
-  if (page == nullptr) {
+  if (!guard) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
   // Read the tuple from the page.
-  page->RLatch();
-  bool res = page->GetTuple(rid, tuple, txn, lock_manager_);
-  page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
-  return res;
+  return static_cast<TablePage *>(guard.GetPage())->GetTuple(rid, tuple, txn, lock_manager_);
 }
 
-auto TableHeap::Begin(Transaction *txn) -> TableIterator {
+auto TableHeap::Begin(Transaction *txn, BufferAccessStrategy *strategy) -> TableIterator {
   // Start an iterator from the first page.
   // TODO(Wuwen): Hacky fix for now. Removing empty pages is a better way to handle this.
   RID rid;
   auto page_id = first_page_id_;
   while (page_id != INVALID_PAGE_ID) {
-    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
-    page->RLatch();
+    auto guard = buffer_pool_manager_->FetchPageRead(page_id, strategy);
+    auto page = static_cast<TablePage *>(guard.GetPage());
     // If this fails because there is no tuple, then RID will be the default-constructed value, which means EOF.
     auto found_tuple = page->GetFirstTupleRid(&rid);
-    page->RUnlatch();
-    buffer_pool_manager_->UnpinPage(page_id, false);
+    auto next_page_id = page->GetNextPageId();
+    guard.Drop();
     if (found_tuple) {
+      // The scan starts on this page, start reading the next one, unless the scan is confined to a ring (see
+      // TableIterator::operator++).
+      if (strategy == nullptr) {
+        buffer_pool_manager_->PrefetchPages({next_page_id});
+      }
+      break;
+    }
+    page_id = next_page_id;
+  }
+  return {this, rid, txn, strategy};
+}
+
+auto TableHeap::GetPageIds() -> std::vector<page_id_t> {
+  std::vector<page_id_t> page_ids;
+  BufferAccessStrategy strategy(RING_BUFFER_SIZE);
+  auto page_id = first_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    auto guard = buffer_pool_manager_->FetchPageRead(page_id, &strategy);
+    if (!guard) {
       break;
     }
-    page_id = page->GetNextPageId();
+    page_ids.push_back(page_id);
+    page_id = static_cast<TablePage *>(guard.GetPage())->GetNextPageId();
   }
-  return {this, rid, txn};
+  return page_ids;
 }
 
 auto TableHeap::End() -> TableIterator { return {this, RID(INVALID_PAGE_ID, 0), nullptr}; }
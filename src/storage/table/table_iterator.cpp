@@ -16,8 +16,8 @@
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferAccessStrategy *strategy)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn), strategy_(strategy) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
   }
@@ -35,19 +35,23 @@ auto TableIterator::operator->() -> Tuple * {
 
 auto TableIterator::operator++() -> TableIterator & {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  cur_page->RLatch();
-  assert(cur_page != nullptr);  // all pages are pinned
+  auto cur_guard = buffer_pool_manager->FetchPageRead(tuple_->rid_.GetPageId(), strategy_);
+  assert(cur_guard);  // all pages are pinned
+  auto cur_page = static_cast<TablePage *>(cur_guard.GetPage());
 
   RID next_tuple_rid;
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  &next_tuple_rid)) {  // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
+      // Latch the next page before the current one is released.
+      cur_guard = buffer_pool_manager->FetchPageRead(cur_page->GetNextPageId(), strategy_);
+      cur_page = static_cast<TablePage *>(cur_guard.GetPage());
+      // Read the page after the one we just entered ahead of time, so its I/O overlaps the scan of this page. A scan
+      // confined to a ring does not prefetch: the page would be loaded into a frame of the whole pool, and the fetch
+      // would then find it resident and never use the ring.
+      if (strategy_ == nullptr) {
+        buffer_pool_manager->PrefetchPages({cur_page->GetNextPageId()});
+      }
       if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
         break;
       }
@@ -59,8 +63,6 @@ auto TableIterator::operator++() -> TableIterator & {
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
   }
   // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
   return *this;
 }
 
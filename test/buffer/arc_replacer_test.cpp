@@ -0,0 +1,101 @@
+/**
+ * arc_replacer_test.cpp
+ */
+
+#include "buffer/arc_replacer.h"
+
+#include <vector>
+#include "common/exception.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(ArcReplacerTest, SampleTest) {
+  ArcReplacer arc_replacer(4);
+
+  // Scenario: frames [0,1,2,3] hold pages [10,11,12,13], all of them seen once, so they are all in T1.
+  for (int i = 0; i < 4; ++i) {
+    arc_replacer.RecordAccess(i, 10 + i);
+  }
+  ASSERT_EQ(4, arc_replacer.Size());
+  ASSERT_EQ(0, arc_replacer.GetTarget());
+
+  // Scenario: T1 is over its target, its LRU frame goes and page 10 is remembered in B1.
+  int value;
+  ASSERT_TRUE(arc_replacer.Evict(&value));
+  ASSERT_EQ(0, value);
+  ASSERT_EQ(3, arc_replacer.Size());
+
+  // Scenario: frame 1 is hit again and moves to T2. Page 10 is loaded again, a hit in B1 grows the target of T1 and
+  // puts the page into T2. T1 is [3,2] and T2 is [0,1], most recent first.
+  arc_replacer.RecordAccess(1, 11);
+  arc_replacer.RecordAccess(0, 10);
+  ASSERT_EQ(1, arc_replacer.GetTarget());
+  ASSERT_EQ(4, arc_replacer.Size());
+
+  // Scenario: T1 has two frames and a target of one, so frame 2 goes first; then T1 is at its target and the LRU
+  // frame of T2 goes.
+  ASSERT_EQ((std::vector<frame_id_t>{2, 1, 0, 3}), arc_replacer.EvictionOrder(4));
+  ASSERT_TRUE(arc_replacer.Evict(&value));
+  ASSERT_EQ(2, value);
+  ASSERT_TRUE(arc_replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+
+  // Scenario: page 11 comes back, a hit in B2 shrinks the target of T1 again.
+  arc_replacer.RecordAccess(1, 11);
+  ASSERT_EQ(0, arc_replacer.GetTarget());
+
+  // Scenario: the only frame of T1 is pinned, so the LRU frame of T2 is evicted instead.
+  arc_replacer.SetEvictable(3, false);
+  ASSERT_EQ(2, arc_replacer.Size());
+  ASSERT_EQ((std::vector<frame_id_t>{0, 1}), arc_replacer.EvictionOrder(4));
+  ASSERT_TRUE(arc_replacer.Evict(&value));
+  ASSERT_EQ(0, value);
+  ASSERT_TRUE(arc_replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+  ASSERT_FALSE(arc_replacer.Evict(&value));
+
+  arc_replacer.SetEvictable(3, true);
+  ASSERT_EQ(1, arc_replacer.Size());
+  arc_replacer.Remove(3);
+  ASSERT_EQ(0, arc_replacer.Size());
+}
+
+TEST(ArcReplacerTest, ScanResistanceTest) {
+  const int num_frames = 8;
+  ArcReplacer arc_replacer(num_frames);
+
+  // Scenario: pages [0,1,2,3] are accessed twice, so they sit in T2.
+  for (int i = 0; i < 4; ++i) {
+    arc_replacer.RecordAccess(i, i);
+    arc_replacer.RecordAccess(i, i);
+  }
+
+  // Scenario: a long scan of pages that are seen once only ever replaces the frames of the scan.
+  for (int page_id = 100; page_id < 200; ++page_id) {
+    int frame_id = 4 + page_id % 4;
+    if (page_id >= 104) {
+      int value;
+      ASSERT_TRUE(arc_replacer.Evict(&value));
+      ASSERT_GE(value, 4);
+      frame_id = value;
+    }
+    arc_replacer.RecordAccess(frame_id, page_id);
+  }
+  ASSERT_EQ(num_frames, arc_replacer.Size());
+}
+
+TEST(ArcReplacerTest, InvalidFrameTest) {
+  ArcReplacer arc_replacer(2);
+  EXPECT_THROW(arc_replacer.RecordAccess(2, 0), Exception);
+  EXPECT_THROW(arc_replacer.SetEvictable(-1, true), Exception);
+
+  arc_replacer.RecordAccess(0, 0);
+  arc_replacer.SetEvictable(0, false);
+  EXPECT_THROW(arc_replacer.Remove(0), Exception);
+  // Removing an untracked frame does nothing.
+  arc_replacer.Remove(1);
+  ASSERT_EQ(0, arc_replacer.Size());
+}
+
+}  // namespace bustub
@@ -12,13 +12,23 @@
 
 #include "../../src/include/buffer/buffer_pool_manager_instance.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
 #include <cstdio>
+#include <cstring>
+#include <future>  // NOLINT
+#include <mutex>  // NOLINT
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "common/logger.h"
 
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
 
 namespace bustub {
 
@@ -84,6 +94,9 @@ TEST(BufferPoolManagerInstanceTest, BinaryDataTest) {
   // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+  remove("test.ext");
 
   delete bpm;
   delete disk_manager;
@@ -141,9 +154,1344 @@ TEST(BufferPoolManagerInstanceTest, SampleTest) {
   // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+  remove("test.ext");
 
   delete bpm;
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, BackgroundWriterTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t k = 5;
+  const auto interval = std::chrono::milliseconds(5);
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k);
+
+  // Wait until the disk manager has seen the expected number of writes, or give up after a while.
+  auto wait_for_writes = [&](int expected) {
+    for (int i = 0; i < 1000 && disk_manager->GetNumWrites() < expected; i++) {
+      std::this_thread::sleep_for(interval);
+    }
+  };
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+  }
+  // Pages {0, ..., 5} are dirty, all of the pages are unpinned.
+  for (int i = 0; i < static_cast<int>(buffer_pool_size); ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, i < 6));
+  }
+
+  // Scenario: fewer dirty frames than the threshold, the writer leaves them alone.
+  bpm->StartBackgroundWriter(interval, 2, 0.9);
+  std::this_thread::sleep_for(interval * 20);
+  bpm->StopBackgroundWriter();
+  EXPECT_EQ(0, disk_manager->GetNumWrites());
+
+  // Scenario: the writer cleans two pages a round, in eviction order, until less than half the frames are dirty.
+  bpm->StartBackgroundWriter(interval, 2, 0.5);
+  wait_for_writes(2);
+  std::this_thread::sleep_for(interval * 20);
+  bpm->StopBackgroundWriter();
+  EXPECT_EQ(2, disk_manager->GetNumWrites());
+
+  // Scenario: without a threshold every dirty page gets written, and only once.
+  bpm->StartBackgroundWriter(interval, 2, 0.0);
+  wait_for_writes(6);
+  std::this_thread::sleep_for(interval * 20);
+  EXPECT_EQ(6, disk_manager->GetNumWrites());
+
+  // Scenario: the pages stayed resident, and evicting them later does not write them again.
+  for (int i = 0; i < 6; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_FALSE(page->IsDirty());
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  EXPECT_EQ(6, disk_manager->GetNumWrites());
+  bpm->StopBackgroundWriter();
+
+  // Scenario: the data the writer put on disk is what was in the frames.
+  char data[BUSTUB_PAGE_SIZE];
+  for (int i = 0; i < 6; ++i) {
+    disk_manager->ReadPage(i, data);
+    EXPECT_EQ(std::string("page ") + std::to_string(i), std::string(data));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+  remove("test.ext");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+/** A disk manager whose reads, or writes, of one page block until the test releases them. */
+class BlockingDiskManager : public DiskManagerMemory {
+ public:
+  explicit BlockingDiskManager(size_t pages) : DiskManagerMemory(pages) {}
+
+  auto ReadPage(page_id_t page_id, char *page_data) -> bool override {
+    Wait(page_id, false);
+    reads_++;
+    return DiskManagerMemory::ReadPage(page_id, page_data);
+  }
+
+  auto WritePage(page_id_t page_id, const char *page_data) -> bool override {
+    Wait(page_id, true);
+    return DiskManagerMemory::WritePage(page_id, page_data);
+  }
+
+  auto ReadPages(page_id_t first_page, size_t num_pages, char *data) -> bool override {
+    batched_reads_++;
+    return DiskManagerMemory::ReadPages(first_page, num_pages, data);
+  }
+
+  void Block(page_id_t page_id, bool writes = false) {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    blocked_page_ = page_id;
+    block_writes_ = writes;
+  }
+
+  void Release() {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    blocked_page_ = INVALID_PAGE_ID;
+    cv_.notify_all();
+  }
+
+  void WaitUntilBlocked() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&] { return blocked_ > 0; });
+  }
+
+  std::atomic<int> reads_{0};
+  std::atomic<int> batched_reads_{0};
+
+ private:
+  void Wait(page_id_t page_id, bool write) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (page_id == blocked_page_ && write == block_writes_) {
+      blocked_++;
+      cv_.notify_all();
+      cv_.wait(lock, [&] { return blocked_page_ != page_id; });
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  page_id_t blocked_page_{INVALID_PAGE_ID};
+  bool block_writes_{false};
+  int blocked_{0};
+};
+
+/** A disk manager whose reads and writes of some pages fail. */
+class FailingDiskManager : public DiskManagerMemory {
+ public:
+  explicit FailingDiskManager(size_t pages) : DiskManagerMemory(pages) {}
+
+  auto ReadPage(page_id_t page_id, char *page_data) -> bool override {
+    if (Fails(page_id)) {
+      return false;
+    }
+    return DiskManagerMemory::ReadPage(page_id, page_data);
+  }
+
+  auto WritePage(page_id_t page_id, const char *page_data) -> bool override {
+    if (Fails(page_id)) {
+      return false;
+    }
+    return DiskManagerMemory::WritePage(page_id, page_data);
+  }
+
+  void Fail(std::vector<page_id_t> page_ids) {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    failing_ = std::move(page_ids);
+  }
+
+ private:
+  auto Fails(page_id_t page_id) -> bool {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    return std::find(failing_.begin(), failing_.end(), page_id) != failing_.end();
+  }
+
+  std::mutex mutex_;
+  std::vector<page_id_t> failing_;
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, IoOutsideLatchTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t k = 2;
+
+  auto *disk_manager = new BlockingDiskManager(16);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k);
+
+  page_id_t page_id_temp;
+  for (int i = 0; i < 8; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  // Pages {4, 5, 6, 7} are resident, pages {0, 1, 2, 3} have been written back.
+  EXPECT_EQ(4, disk_manager->GetNumWrites());
+  EXPECT_EQ(0, disk_manager->reads_);
+
+  // Scenario: a miss blocked in the disk manager does not block hits on other pages.
+  disk_manager->Block(0);
+  Page *miss_page = nullptr;
+  std::thread miss([&] { miss_page = bpm->FetchPage(0); });
+  disk_manager->WaitUntilBlocked();
+  for (int i = 5; i < 8; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::string("page ") + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  // Scenario: a second fetch of the page in flight waits for the first read instead of reading it again.
+  Page *second_page = nullptr;
+  std::thread second([&] { second_page = bpm->FetchPage(0); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(0, disk_manager->reads_);
+  disk_manager->Release();
+  miss.join();
+  second.join();
+  ASSERT_NE(nullptr, miss_page);
+  EXPECT_EQ(miss_page, second_page);
+  EXPECT_EQ(1, disk_manager->reads_);
+  EXPECT_EQ(2, miss_page->GetPinCount());
+  EXPECT_EQ(std::string("page 0"), std::string(miss_page->GetData()));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+
+  // Scenario: a new page never sees the data of the dirty page its frame held.
+  for (int i = 0; i < static_cast<int>(buffer_pool_size); ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, page->GetData()[0]);
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ConcurrentFetchTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t k = 2;
+  const int num_pages = 24;
+  const int num_threads = 4;
+
+  auto *disk_manager = new DiskManagerMemory(num_pages + buffer_pool_size);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k);
+
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Threads hammer a few hot pages, which mostly hit, and the rest of the pages, which keep evicting frames under
+  // the hits. Every fetched page must hold its own data.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      std::mt19937 rng(t);
+      for (int i = 0; i < 5000; i++) {
+        auto page_id = static_cast<page_id_t>(rng() % 4 != 0 ? rng() % 3 : rng() % num_pages);
+        Page *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        ASSERT_EQ(page_id, page->GetPageId());
+        page->RLatch();
+        ASSERT_EQ(std::string("page ") + std::to_string(page_id), std::string(page->GetData()));
+        page->RUnlatch();
+        ASSERT_TRUE(bpm->UnpinPage(page_id, i % 7 == 0));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Scenario: every pin was released, so the whole pool can be reused.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PrefetchTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t k = 2;
+
+  auto *disk_manager = new BlockingDiskManager(16);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k);
+
+  // Wait until the disk manager has seen the expected number of reads, or give up after a while.
+  auto wait_for_reads = [&](int expected) {
+    for (int i = 0; i < 1000 && disk_manager->reads_ < expected; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+  };
+
+  page_id_t page_id_temp;
+  for (int i = 0; i < 8; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: prefetched pages are read in the background, and fetching them afterwards does not read again.
+  bpm->Prefetch(0, 3);
+  wait_for_reads(3);
+  EXPECT_EQ(3, disk_manager->reads_);
+  for (int i = 0; i < 3; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::string("page ") + std::to_string(i), std::string(page->GetData()));
+  }
+  EXPECT_EQ(3, disk_manager->reads_);
+
+  // Scenario: prefetching a resident page does nothing.
+  bpm->PrefetchPages({0, 1, INVALID_PAGE_ID});
+
+  // Scenario: prefetch only uses free or evictable frames and never takes a pinned one.
+  auto *page3 = bpm->FetchPage(3);
+  ASSERT_NE(nullptr, page3);
+  EXPECT_EQ(4, disk_manager->reads_);
+  bpm->PrefetchPages({4, 5});
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(4, disk_manager->reads_);
+
+  // Scenario: prefetched pages are not pinned, so their frames can be reused right away.
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  bpm->PrefetchPages({4});
+  wait_for_reads(5);
+  EXPECT_EQ(5, disk_manager->reads_);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, BufferAccessStrategyTest) {
+  const size_t buffer_pool_size = 16;
+  const size_t k = 2;
+  const int num_hot_pages = 8;
+  const int num_cold_pages = 64;
+
+  auto *disk_manager = new BlockingDiskManager(num_hot_pages + 2 * num_cold_pages);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k);
+
+  // Scenario: a bulk load through a ring of 4 frames only ever uses those frames.
+  BufferAccessStrategy strategy(4);
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_hot_pages + num_cold_pages; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp, strategy);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  EXPECT_EQ(num_hot_pages + num_cold_pages - 4, disk_manager->GetNumWrites());
+
+  // Pages {0, ..., 7} are the working set of other transactions. They were accessed only once, so a scan that went
+  // through the whole pool would evict them before its own pages.
+  for (int i = 0; i < num_hot_pages; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  int reads = disk_manager->reads_;
+
+  // Scenario: a scan of the cold pages through a ring reads each of them and leaves the hot pages alone.
+  BufferAccessStrategy scan(4);
+  for (int i = num_hot_pages; i < num_hot_pages + num_cold_pages; ++i) {
+    auto *page = bpm->FetchPage(i, scan);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::string("page ") + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  EXPECT_LE(reads + num_cold_pages - 4, disk_manager->reads_);
+  reads = disk_manager->reads_;
+  for (int i = 0; i < num_hot_pages; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::string("page ") + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(reads, disk_manager->reads_);
+
+  // Scenario: a ring frame that is still pinned is not recycled, the scan takes another frame instead.
+  BufferAccessStrategy pinned_scan(1);
+  auto *first = bpm->FetchPage(num_hot_pages, pinned_scan);
+  auto *second = bpm->FetchPage(num_hot_pages + 1, pinned_scan);
+  ASSERT_NE(nullptr, first);
+  ASSERT_NE(nullptr, second);
+  EXPECT_NE(first, second);
+  EXPECT_EQ(std::string("page ") + std::to_string(num_hot_pages), std::string(first->GetData()));
+  EXPECT_EQ(true, bpm->UnpinPage(num_hot_pages, false));
+  EXPECT_EQ(true, bpm->UnpinPage(num_hot_pages + 1, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, EvictionPolicyTest) {
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 40;
+
+  for (auto policy : {EvictionPolicyType::LRU_K, EvictionPolicyType::ARC, EvictionPolicyType::TWO_QUEUE,
+                      EvictionPolicyType::CLOCK_PRO}) {
+    auto *disk_manager = new DiskManagerMemory(num_pages);
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, LRUK_REPLACER_K, nullptr, policy);
+
+    page_id_t page_id_temp;
+    for (int i = 0; i < num_pages; ++i) {
+      auto *page = bpm->NewPage(&page_id_temp);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+      EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    }
+
+    // Scenario: a skewed workload, a quarter of the accesses go to pages {0, 1, 2}, always reads what was written.
+    std::mt19937 gen(static_cast<uint32_t>(policy));
+    std::uniform_int_distribution<int> any_page(0, num_pages - 1);
+    std::uniform_int_distribution<int> hot_page(0, 2);
+    for (int i = 0; i < 1000; ++i) {
+      page_id_t page_id = i % 4 == 0 ? hot_page(gen) : any_page(gen);
+      auto *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(std::string("page ") + std::to_string(page_id), std::string(page->GetData()));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    }
+
+    // Scenario: pinned pages are never evicted, whatever the policy.
+    std::vector<Page *> pinned;
+    for (int i = 0; i < static_cast<int>(buffer_pool_size); ++i) {
+      pinned.push_back(bpm->FetchPage(i));
+      ASSERT_NE(nullptr, pinned.back());
+    }
+    EXPECT_EQ(nullptr, bpm->FetchPage(num_pages - 1));
+    for (int i = 0; i < static_cast<int>(buffer_pool_size); ++i) {
+      EXPECT_EQ(std::string("page ") + std::to_string(i), std::string(pinned[i]->GetData()));
+      EXPECT_EQ(true, bpm->UnpinPage(i, false));
+    }
+    EXPECT_NE(nullptr, bpm->FetchPage(num_pages - 1));
+    EXPECT_EQ(true, bpm->UnpinPage(num_pages - 1, false));
+
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ResizeTest) {
+  const int num_pages = 8;
+  auto *disk_manager = new DiskManagerMemory(num_pages);
+  auto *bpm = new BufferPoolManagerInstance(4, disk_manager);
+
+  // Scenario: the pool is full of pinned pages, growing it makes room for new ones.
+  page_id_t page_id_temp;
+  for (int i = 0; i < 4; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(true, bpm->Resize(8));
+  EXPECT_EQ(8, bpm->GetPoolSize());
+  for (int i = 4; i < num_pages; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+  }
+  for (int i = 0; i < num_pages; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+
+  // Scenario: page 5 sits in frame 5 and is pinned, so the pool cannot shrink below 6 frames.
+  ASSERT_NE(nullptr, bpm->FetchPage(5));
+  EXPECT_EQ(false, bpm->Resize(2));
+  EXPECT_EQ(8, bpm->GetPoolSize());
+  EXPECT_EQ(true, bpm->UnpinPage(5, false));
+
+  // Scenario: shrinking writes the dirty pages back, and they read back fine through the smaller pool.
+  EXPECT_EQ(true, bpm->Resize(2));
+  EXPECT_EQ(2, bpm->GetPoolSize());
+  EXPECT_LE(6, disk_manager->GetNumWrites());
+  for (int i = 0; i < num_pages; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::string("page ") + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  EXPECT_EQ(nullptr, bpm->FetchPage(2));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  EXPECT_EQ(true, bpm->UnpinPage(1, false));
+
+  // Scenario: growing again reuses the frames that were kept and adds new ones.
+  EXPECT_EQ(true, bpm->Resize(6));
+  std::vector<Page *> pinned;
+  for (int i = 0; i < 6; ++i) {
+    pinned.push_back(bpm->FetchPage(i));
+    ASSERT_NE(nullptr, pinned.back());
+    EXPECT_EQ(std::string("page ") + std::to_string(i), std::string(pinned.back()->GetData()));
+  }
+  EXPECT_EQ(nullptr, bpm->FetchPage(6));
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ConcurrentResizeTest) {
+  const int num_pages = 32;
+  const int num_threads = 4;
+  auto *disk_manager = new DiskManagerMemory(num_pages);
+  auto *bpm = new BufferPoolManagerInstance(8, disk_manager);
+
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: readers keep fetching pages while the pool is grown and shrunk under them.
+  std::atomic<bool> stop{false};
+  std::atomic<int> fetches{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t] {
+      std::mt19937 gen(t);
+      std::uniform_int_distribution<int> dis(0, num_pages - 1);
+      while (!stop) {
+        page_id_t page_id = dis(gen);
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ(std::string("page ") + std::to_string(page_id), std::string(page->GetData()));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+        fetches++;
+      }
+    });
+  }
+  // Shrinking fails while a reader pins one of the frames to release, keep going until it worked often enough.
+  int shrunk = 0;
+  while (shrunk < 50 || fetches < 1000) {
+    EXPECT_EQ(true, bpm->Resize(24));
+    shrunk += bpm->Resize(8) ? 1 : 0;
+    std::this_thread::yield();
+  }
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ResizeIoTest) {
+  auto *disk_manager = new BlockingDiskManager(16);
+  auto *bpm = new BufferPoolManagerInstance(4, disk_manager);
+  page_id_t page_id_temp;
+  for (int i = 0; i < 4; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: while shrinking writes back a dropped page, the latch is free, so a miss on the rest of the pool goes
+  // on; the dropped page reads back written once the shrink is done.
+  page_id_t dropped = bpm->GetPageInFrame(3)->GetPageId();
+  disk_manager->Block(dropped, true);
+  std::thread resize([&] { EXPECT_EQ(true, bpm->Resize(2)); });
+  disk_manager->WaitUntilBlocked();
+  auto new_page = std::async(std::launch::async, [&] {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    return page == nullptr ? INVALID_PAGE_ID : page_id;
+  });
+  EXPECT_EQ(std::future_status::ready, new_page.wait_for(std::chrono::seconds(10)));
+  disk_manager->Release();
+  resize.join();
+  page_id_t page_id = new_page.get();
+  ASSERT_NE(INVALID_PAGE_ID, page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  EXPECT_EQ(2, bpm->GetPoolSize());
+  auto *page = bpm->FetchPage(dropped);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ("page " + std::to_string(dropped), std::string(page->GetData()));
+  EXPECT_EQ(true, bpm->UnpinPage(dropped, false));
+  delete bpm;
+  delete disk_manager;
+
+  // Scenario: shrinking fails if a dirty page cannot be written back, and the page stays resident and dirty.
+  auto *failing = new FailingDiskManager(16);
+  bpm = new BufferPoolManagerInstance(4, failing);
+  for (int i = 0; i < 4; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  std::vector<page_id_t> dropped_pages{bpm->GetPageInFrame(2)->GetPageId(), bpm->GetPageInFrame(3)->GetPageId()};
+  failing->Fail(dropped_pages);
+  EXPECT_EQ(false, bpm->Resize(2));
+  EXPECT_EQ(4, bpm->GetPoolSize());
+  EXPECT_EQ(4, bpm->GetResidentPages().size());
+  failing->Fail({});
+  EXPECT_EQ(true, bpm->Resize(2));
+  char buf[BUSTUB_PAGE_SIZE];
+  for (page_id_t page_id : dropped_pages) {
+    ASSERT_TRUE(failing->ReadPage(page_id, buf));
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(buf));
+  }
+  delete bpm;
+  delete failing;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, WarmStartTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t k = 2;
+  const std::string warm_start_file = "bpm_warm_start_test.bpm";
+
+  auto *disk_manager = new BlockingDiskManager(32);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k);
+  page_id_t page_id_temp;
+  for (int i = 0; i < 16; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  // Pages 8..15 are resident; 12 and 13 are hot, and 8 is the coldest page.
+  for (int i = 0; i < 2; ++i) {
+    for (page_id_t page_id : {12, 13}) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    }
+  }
+  bpm->FlushAllPages();
+  EXPECT_EQ(true, bpm->SaveResidentPages(warm_start_file));
+  delete bpm;
+
+  // Scenario: a missing or corrupt sidecar file is rejected.
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k);
+  EXPECT_EQ(false, bpm->WarmStart("bpm_warm_start_test_missing.bpm"));
+  delete bpm;
+
+  // Scenario: after a restart the saved pages come back with one batched read, without evicting anything.
+  int reads = disk_manager->reads_;
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k);
+  EXPECT_EQ(true, bpm->WarmStart(warm_start_file));
+  bpm->WaitForWarmStart();
+  EXPECT_EQ(reads + 8, disk_manager->reads_);
+  EXPECT_EQ(1, disk_manager->batched_reads_);
+  for (int i = 8; i < 16; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::string("page ") + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(reads + 8, disk_manager->reads_);
+
+  // Scenario: the allocator skips the reloaded pages.
+  auto *page = bpm->NewPage(&page_id_temp);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(16, page_id_temp);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  delete bpm;
+
+  // Scenario: the replayed history evicts the cold pages before the hot ones.
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k);
+  EXPECT_EQ(true, bpm->WarmStart(warm_start_file));
+  bpm->WaitForWarmStart();
+  for (int i = 0; i < 6; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  reads = disk_manager->reads_;
+  for (page_id_t page_id : {12, 13}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(reads, disk_manager->reads_);
+  delete bpm;
+
+  remove(warm_start_file.c_str());
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, WarmStartIoErrorTest) {
+  const size_t buffer_pool_size = 4;
+  const std::string warm_start_file = "bpm_warm_start_io_error_test.bpm";
+
+  auto *disk_manager = new FailingDiskManager(16);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  for (int i = 0; i < 4; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+  EXPECT_EQ(true, bpm->SaveResidentPages(warm_start_file));
+  delete bpm;
+
+  // Scenario: pages whose warm start read fails are not published as resident, and their frames stay free.
+  disk_manager->Fail({1});
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  EXPECT_EQ(true, bpm->WarmStart(warm_start_file));
+  bpm->WaitForWarmStart();
+  EXPECT_TRUE(bpm->GetResidentPages().empty());
+  disk_manager->Fail({});
+  for (int i = 0; i < 4; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+  }
+  delete bpm;
+
+  remove(warm_start_file.c_str());
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FrameArenaTest) {
+  const size_t buffer_pool_size = 600;
+  auto *disk_manager = new DiskManagerMemory(buffer_pool_size);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: the frames of one allocation share a page aligned arena, and their descriptors are cache line aligned.
+  auto check_frames = [&](size_t first_frame, size_t last_frame) {
+    char *first_data = bpm->GetPageInFrame(static_cast<frame_id_t>(first_frame))->GetData();
+    for (size_t i = first_frame; i < last_frame; ++i) {
+      Page *page = bpm->GetPageInFrame(static_cast<frame_id_t>(i));
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % BUSTUB_PAGE_SIZE);
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page) % 64);
+      EXPECT_EQ(first_data + (i - first_frame) * BUSTUB_PAGE_SIZE, page->GetData());
+    }
+  };
+  check_frames(0, buffer_pool_size);
+
+  // Scenario: the page data is zeroed and round trips through the disk.
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+  ASSERT_NE(nullptr, page0);
+  for (int i = 0; i < BUSTUB_PAGE_SIZE; ++i) {
+    ASSERT_EQ(0, page0->GetData()[i]);
+  }
+  snprintf(page0->GetData(), BUSTUB_PAGE_SIZE, "Hello");
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  EXPECT_EQ(true, bpm->FlushPage(page_id_temp));
+
+  // Scenario: frames added by growing the pool get an aligned arena of their own.
+  EXPECT_EQ(true, bpm->Resize(buffer_pool_size + 8));
+  check_frames(buffer_pool_size, buffer_pool_size + 8);
+  EXPECT_EQ(true, bpm->Resize(8));
+  page0 = bpm->FetchPage(page_id_temp);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, StatsTest) {
+  const size_t buffer_pool_size = 2;
+  auto *disk_manager = new DiskManagerMemory(16);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  auto total = [](const LatencyHistogram::Buckets &buckets) {
+    uint64_t sum = 0;
+    for (auto count : buckets) {
+      sum += count;
+    }
+    return sum;
+  };
+
+  // Scenario: two dirty pages fill the pool, fetching one of them again is a hit.
+  page_id_t page_ids[3];
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_ids[i]));
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], true));
+  }
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[0]));
+  EXPECT_EQ(true, bpm->UnpinPage(page_ids[0], false));
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(buffer_pool_size, stats.pool_size_);
+  EXPECT_EQ(2, stats.resident_pages_);
+  EXPECT_EQ(2, stats.dirty_pages_);
+  EXPECT_EQ(1, stats.hits_);
+  EXPECT_EQ(0, stats.misses_);
+  EXPECT_EQ(0, stats.evictions_);
+
+  // Scenario: a third page evicts a dirty page, which is written back.
+  ASSERT_NE(nullptr, bpm->NewPage(&page_ids[2]));
+  EXPECT_EQ(true, bpm->UnpinPage(page_ids[2], false));
+  stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.evictions_);
+  EXPECT_EQ(1, stats.dirty_writebacks_);
+  EXPECT_EQ(1, stats.dirty_pages_);
+  EXPECT_EQ(1, total(stats.write_latency_));
+
+  // Scenario: fetching the first page that is still resident hits, reading the evicted one back evicts the clean page.
+  auto resident = bpm->GetResidentPages();
+  ASSERT_EQ(2, resident.size());
+  bool first_resident = std::find(resident.begin(), resident.end(), page_ids[0]) != resident.end();
+  page_id_t hit_page = first_resident ? page_ids[0] : page_ids[1];
+  page_id_t miss_page = first_resident ? page_ids[1] : page_ids[0];
+  ASSERT_NE(nullptr, bpm->FetchPage(hit_page));
+  ASSERT_NE(nullptr, bpm->FetchPage(miss_page));
+  stats = bpm->GetStats();
+  EXPECT_EQ(2, stats.hits_);
+  EXPECT_EQ(1, stats.misses_);
+  EXPECT_EQ(2, stats.evictions_);
+  EXPECT_EQ(1, stats.dirty_writebacks_);
+  EXPECT_EQ(1, total(stats.read_latency_));
+  EXPECT_DOUBLE_EQ(2.0 / 3.0, stats.HitRatio());
+
+  // Scenario: with every frame pinned there is no frame for another page.
+  page_id_t page_id_temp;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(nullptr, bpm->FetchPage(page_ids[2]));
+  EXPECT_EQ(2, bpm->GetStats().no_free_frames_);
+
+  // Scenario: flushing counts as a flush, not as an eviction.
+  EXPECT_EQ(true, bpm->UnpinPage(page_ids[0], true));
+  EXPECT_EQ(true, bpm->UnpinPage(page_ids[1], true));
+  bpm->FlushAllPages();
+  stats = bpm->GetStats();
+  EXPECT_EQ(2, stats.flushes_);
+  EXPECT_EQ(0, stats.dirty_pages_);
+  EXPECT_EQ(2, stats.evictions_);
+  // The two pages are consecutive, so the flush writes them with one disk write.
+  EXPECT_EQ(2, total(stats.write_latency_));
+  resident = bpm->GetResidentPages();
+  std::sort(resident.begin(), resident.end());
+  EXPECT_EQ((std::vector<page_id_t>{page_ids[0], page_ids[1]}), resident);
+
+  EXPECT_EQ("<1us", LatencyHistogram::BucketLabel(0));
+  EXPECT_EQ("<512us", LatencyHistogram::BucketLabel(9));
+  EXPECT_EQ("<1.0ms", LatencyHistogram::BucketLabel(10));
+  EXPECT_EQ(">=16.3ms", LatencyHistogram::BucketLabel(LatencyHistogram::NUM_BUCKETS - 1));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, BatchFetchTest) {
+  const size_t buffer_pool_size = 8;
+  auto *disk_manager = new DiskManagerMemory(32);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  auto reads = [bpm] {
+    uint64_t sum = 0;
+    for (auto count : bpm->GetStats().read_latency_) {
+      sum += count;
+    }
+    return sum;
+  };
+
+  // Scenario: NewPages creates all the pages at once, or none of them.
+  auto pages = bpm->NewPages(buffer_pool_size);
+  ASSERT_EQ(buffer_pool_size, pages.size());
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_EQ(static_cast<page_id_t>(i), pages[i]->GetPageId());
+    EXPECT_EQ(1, pages[i]->GetPinCount());
+    snprintf(pages[i]->GetData(), BUSTUB_PAGE_SIZE, "page %zu", i);
+  }
+  EXPECT_TRUE(bpm->NewPages(1).empty());
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(static_cast<page_id_t>(i), true));
+  }
+
+  // Scenario: a second batch evicts the first one, whose pages are written back.
+  pages = bpm->NewPages(buffer_pool_size);
+  ASSERT_EQ(buffer_pool_size, pages.size());
+  EXPECT_EQ(static_cast<page_id_t>(buffer_pool_size), pages[0]->GetPageId());
+  EXPECT_EQ(buffer_pool_size, bpm->GetStats().dirty_writebacks_);
+  for (auto *page : pages) {
+    EXPECT_EQ(true, bpm->UnpinPage(page->GetPageId(), false));
+  }
+
+  // Scenario: consecutive misses are read with one request, and a repeated page is pinned once per occurrence.
+  uint64_t before = reads();
+  std::vector<page_id_t> page_ids{3, 0, 1, 2, 0};
+  pages = bpm->FetchPages(page_ids);
+  ASSERT_EQ(page_ids.size(), pages.size());
+  EXPECT_EQ(before + 1, reads());
+  for (size_t i = 0; i < page_ids.size(); ++i) {
+    EXPECT_EQ(page_ids[i], pages[i]->GetPageId());
+    EXPECT_EQ("page " + std::to_string(page_ids[i]), std::string(pages[i]->GetData()));
+  }
+  EXPECT_EQ(pages[1], pages[4]);
+  EXPECT_EQ(2, pages[1]->GetPinCount());
+  EXPECT_EQ(1, pages[0]->GetPinCount());
+
+  // Scenario: a batch of resident pages is pinned without reading anything.
+  auto guards = bpm->FetchPagesBasic({1, 2});
+  ASSERT_EQ(2, guards.size());
+  EXPECT_EQ(before + 1, reads());
+  EXPECT_EQ(2, guards[0].GetPage()->GetPinCount());
+  guards.clear();
+  EXPECT_EQ(1, pages[2]->GetPinCount());
+
+  // Scenario: four frames are pinned, so a batch with five misses pins nothing and gives the claimed frames back.
+  EXPECT_TRUE(bpm->FetchPages({3, 4, 5, 6, 7, 16}).empty());
+  EXPECT_EQ(1, pages[0]->GetPinCount());
+  auto more = bpm->FetchPages({4, 5, 6, 7});
+  ASSERT_EQ(4, more.size());
+  for (size_t i = 0; i < more.size(); ++i) {
+    EXPECT_EQ("page " + std::to_string(i + 4), std::string(more[i]->GetData()));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, BatchIoErrorTest) {
+  const size_t buffer_pool_size = 4;
+  auto *disk_manager = new FailingDiskManager(32);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  for (int i = 0; i < 8; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: a batch with a page that cannot be read fails as a whole, and leaves no pin and no frame behind.
+  disk_manager->Fail({2});
+  EXPECT_TRUE(bpm->FetchPages({0, 1, 2, 1}).empty());
+  auto resident = bpm->GetResidentPages();
+  EXPECT_EQ(resident.end(), std::find(resident.begin(), resident.end(), 2));
+  disk_manager->Fail({});
+  auto pages = bpm->FetchPages({0, 1, 2, 3});
+  ASSERT_EQ(4, pages.size());
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(1, pages[i]->GetPinCount());
+    EXPECT_EQ("page " + std::to_string(i), std::string(pages[i]->GetData()));
+    snprintf(pages[i]->GetData(), BUSTUB_PAGE_SIZE, "new page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+
+  // Scenario: NewPages fails as a whole when a dirty victim cannot be written back, and the victims stay resident and
+  // dirty, so they are written back once the disk works again.
+  disk_manager->Fail({0, 1, 2, 3});
+  EXPECT_TRUE(bpm->NewPages(2).empty());
+  resident = bpm->GetResidentPages();
+  std::sort(resident.begin(), resident.end());
+  EXPECT_EQ((std::vector<page_id_t>{0, 1, 2, 3}), resident);
+  disk_manager->Fail({});
+  pages = bpm->NewPages(4);
+  ASSERT_EQ(4, pages.size());
+  EXPECT_EQ(8, pages[0]->GetPageId());
+  char buf[BUSTUB_PAGE_SIZE];
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(disk_manager->ReadPage(i, buf));
+    EXPECT_EQ("new page " + std::to_string(i), std::string(buf));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, IoErrorTest) {
+  const size_t buffer_pool_size = 2;
+  auto *disk_manager = new FailingDiskManager(16);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  for (int i = 0; i < 4; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: a fetch of a page that cannot be read fails instead of returning a zeroed page, and gives the frame
+  // back.
+  disk_manager->Fail({0});
+  EXPECT_EQ(nullptr, bpm->FetchPage(0));
+  auto resident = bpm->GetResidentPages();
+  EXPECT_EQ(resident.end(), std::find(resident.begin(), resident.end(), 0));
+  disk_manager->Fail({});
+  for (int i = 0; i < 2; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "new page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+
+  // Scenario: NewPage fails when its dirty victim cannot be written back; the victim stays resident and dirty.
+  disk_manager->Fail({0, 1});
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  resident = bpm->GetResidentPages();
+  std::sort(resident.begin(), resident.end());
+  EXPECT_EQ((std::vector<page_id_t>{0, 1}), resident);
+  disk_manager->Fail({});
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  char buf[BUSTUB_PAGE_SIZE];
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_TRUE(disk_manager->ReadPage(i, buf));
+    EXPECT_EQ("new page " + std::to_string(i), std::string(buf));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PageGuardTest) {
+  const size_t buffer_pool_size = 2;
+  const size_t k = 2;
+
+  auto *disk_manager = new DiskManagerMemory(10);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k);
+
+  // Scenario: a guard unpins its page when it goes out of scope, and writing through it marks the page dirty.
+  page_id_t page_id0;
+  {
+    auto guard = bpm->NewPageGuarded(&page_id0);
+    ASSERT_TRUE(guard);
+    EXPECT_EQ(page_id0, guard.PageId());
+    EXPECT_EQ(1, guard.GetPage()->GetPinCount());
+    snprintf(guard.GetDataMut(), BUSTUB_PAGE_SIZE, "Hello");
+  }
+  Page *page0 = bpm->FetchPage(page_id0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(1, page0->GetPinCount());
+  EXPECT_TRUE(page0->IsDirty());
+  EXPECT_EQ(true, bpm->UnpinPage(page_id0, false));
+
+  // Scenario: moving a guard hands over the pin, only the last owner unpins the page.
+  {
+    auto guard = bpm->FetchPageBasic(page_id0);
+    BasicPageGuard moved = std::move(guard);
+    EXPECT_FALSE(guard);  // NOLINT
+    EXPECT_EQ(INVALID_PAGE_ID, guard.PageId());  // NOLINT
+    EXPECT_EQ(1, moved.GetPage()->GetPinCount());
+    EXPECT_EQ(0, strcmp(moved.As<char>(), "Hello"));
+    moved.Drop();
+    EXPECT_FALSE(moved);
+    EXPECT_EQ(0, page0->GetPinCount());
+  }
+
+  // Scenario: with every frame held by a guard there is no frame for another page, and the guard is empty.
+  page_id_t page_id1;
+  page_id_t page_id_temp;
+  {
+    auto guard0 = bpm->FetchPageRead(page_id0);
+    auto guard1 = bpm->NewPageGuarded(&page_id1).UpgradeWrite();
+    ASSERT_TRUE(guard0);
+    ASSERT_TRUE(guard1);
+    EXPECT_FALSE(bpm->NewPageGuarded(&page_id_temp));
+    EXPECT_FALSE(bpm->FetchPageRead(page_id1 + 1));
+  }
+  EXPECT_TRUE(bpm->NewPageGuarded(&page_id_temp));
+
+  // Scenario: a write guard excludes readers of the page until it is dropped.
+  std::atomic<bool> read{false};
+  auto write_guard = bpm->FetchPageWrite(page_id1);
+  ASSERT_TRUE(write_guard);
+  std::thread reader([&] {
+    auto read_guard = bpm->FetchPageRead(page_id1);
+    EXPECT_EQ(0, strcmp(read_guard.GetData(), "World"));
+    read = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(read);
+  snprintf(write_guard.GetDataMut(), BUSTUB_PAGE_SIZE, "World");
+  write_guard.Drop();
+  reader.join();
+  EXPECT_TRUE(read);
+
+  // Scenario: all guards are gone, so both pages can be evicted.
+  EXPECT_TRUE(bpm->NewPageGuarded(&page_id_temp));
+  EXPECT_TRUE(bpm->NewPageGuarded(&page_id_temp));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+/** A disk manager that records the runs of pages given to WritePages. */
+class RecordingDiskManager : public DiskManagerMemory {
+ public:
+  explicit RecordingDiskManager(size_t pages) : DiskManagerMemory(pages) {}
+
+  auto WritePages(page_id_t first_page, const std::vector<const char *> &pages) -> bool override {
+    runs_.emplace_back(first_page, pages.size());
+    return DiskManagerMemory::WritePages(first_page, pages);
+  }
+
+  std::vector<std::pair<page_id_t, size_t>> runs_;
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, CoalescedFlushTest) {
+  const size_t buffer_pool_size = 128;
+  auto *disk_manager = new RecordingDiskManager(128);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: pages 0 to 99 are dirty, except page 50.
+  page_id_t page_id;
+  for (int i = 0; i < 100; ++i) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", i);
+  }
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, i != 50));
+  }
+  bpm->FlushAllPages();
+
+  // The dirty pages are written in batches of FLUSH_BATCH_SIZE, one write per run of consecutive pages in a batch.
+  std::vector<std::pair<page_id_t, size_t>> expected{{0, 50}, {51, FLUSH_BATCH_SIZE - 50}, {FLUSH_BATCH_SIZE + 1, 35}};
+  EXPECT_EQ(expected, disk_manager->runs_);
+  EXPECT_EQ(99, bpm->GetStats().flushes_);
+  char buf[BUSTUB_PAGE_SIZE];
+  for (int i = 0; i < 100; ++i) {
+    if (i != 50) {
+      disk_manager->ReadPage(i, buf);
+      EXPECT_EQ("page " + std::to_string(i), std::string(buf));
+    }
+  }
+
+  // Scenario: a second flush has no dirty pages to write.
+  disk_manager->runs_.clear();
+  bpm->FlushAllPages();
+  EXPECT_TRUE(disk_manager->runs_.empty());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ReusePageTest) {
+  const std::string db_name = "reuse_page_test.db";
+  remove(db_name.c_str());
+  remove("reuse_page_test.fsm");
+  remove("reuse_page_test.ext");
+  const size_t buffer_pool_size = 5;
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  for (int i = 0; i < 10; ++i) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ(i, page_id);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: deleted pages are reused, lowest first, before new page ids, whether or not they were resident.
+  EXPECT_EQ(true, bpm->DeletePage(8));
+  EXPECT_EQ(true, bpm->DeletePage(2));
+  Page *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(2, page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(8, page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(10, page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+
+  // Scenario: a reused page reads back zeroed after eviction, not with the content it had before it was deleted.
+  for (int i = 3; i < 8; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  page = bpm->FetchPage(2);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, page->GetData()[0]);
+  EXPECT_EQ(true, bpm->UnpinPage(2, false));
+
+  // Scenario: the free pages and the next page id survive a restart once the pages are flushed.
+  EXPECT_EQ(true, bpm->DeletePage(4));
+  bpm->FlushAllPages();
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  disk_manager = new DiskManager(db_name);
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(4, page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(11, page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  page = bpm->FetchPage(9);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ("page 9", std::string(page->GetData()));
+  EXPECT_EQ(true, bpm->UnpinPage(9, false));
+
+  // Scenario: deleting a page id that was never allocated does not make it free, so it is not handed out before the
+  // database grows to it, and then only once.
+  EXPECT_EQ(true, bpm->DeletePage(14));
+  std::vector<page_id_t> new_pages;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    new_pages.push_back(page_id);
+  }
+  EXPECT_EQ((std::vector<page_id_t>{12, 13, 14, 15}), new_pages);
+
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove(db_name.c_str());
+  remove("reuse_page_test.fsm");
+  remove("reuse_page_test.ext");
+  remove("reuse_page_test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ExtentTest) {
+  const size_t buffer_pool_size = 10;
+  auto *disk_manager = new DiskManagerMemory(1000);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  const auto extent_pages = static_cast<page_id_t>(EXTENT_PAGES);
+
+  // Scenario: two objects growing at the same time each get runs of consecutive pages.
+  page_id_t table = INVALID_PAGE_ID;
+  page_id_t index = INVALID_PAGE_ID;
+  page_id_t page_id;
+  for (page_id_t i = 0; i < extent_pages + 1; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id, &table));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    EXPECT_EQ(i < extent_pages ? i : 2 * extent_pages + 1, page_id);
+    ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id, &index));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    EXPECT_EQ(i < extent_pages ? extent_pages + i : 3 * extent_pages + 1, page_id);
+    if (i == 0) {
+      // A page of no object is allocated past the extents.
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      EXPECT_EQ(2 * extent_pages, page_id);
+    }
+  }
+  EXPECT_EQ(0, table);
+  EXPECT_EQ(extent_pages, index);
+
+  auto extents = disk_manager->GetExtentMap()->GetExtents(table);
+  ASSERT_EQ(2, extents.size());
+  EXPECT_EQ(0, extents[0].first_page_);
+  EXPECT_EQ(EXTENT_PAGES, extents[0].used_);
+  EXPECT_EQ(2 * extent_pages + 1, extents[1].first_page_);
+  EXPECT_EQ(1, extents[1].used_);
+
+  // Scenario: deleting a page of an extent that was not handed out yet does not free it, so the extent and NewPage
+  // do not both hand it out.
+  EXPECT_EQ(true, bpm->DeletePage(2 * extent_pages + 2));
+  EXPECT_EQ(0, disk_manager->GetFreePageMap()->GetNumFreePages());
+  ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id, &table));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  EXPECT_EQ(2 * extent_pages + 2, page_id);
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  EXPECT_EQ(4 * extent_pages + 1, page_id);
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PageSizeTest) {
+  const size_t page_size = 16 * 1024;
+  const size_t buffer_pool_size = 4;
+  const std::string db_name = "page_size_bpm_test.db";
+  auto *disk_manager = new DiskManager(db_name, false, 0, page_size);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  EXPECT_EQ(page_size, bpm->GetPageSize());
+
+  // Scenario: the frames hold pages of the database's page size, written back whole on eviction.
+  page_id_t page_id;
+  for (int i = 0; i < 8; ++i) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_size, page->GetSize());
+    snprintf(page->GetData(), page_size, "page %d", i);
+    snprintf(page->GetData() + page_size - 8, 8, "tail %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: a run of evicted pages is read back with one batch read.
+  auto pages = bpm->FetchPages({0, 1, 2});
+  ASSERT_EQ(3, pages.size());
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ("page " + std::to_string(i), std::string(pages[i]->GetData()));
+    EXPECT_EQ("tail " + std::to_string(i), std::string(pages[i]->GetData() + page_size - 8));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  for (const char *file : {"page_size_bpm_test.db", "page_size_bpm_test.log", "page_size_bpm_test.fsm",
+                           "page_size_bpm_test.ext"}) {
+    remove(file);
+  }
+}
+
 }  // namespace bustub
@@ -0,0 +1,80 @@
+/**
+ * clock_pro_replacer_test.cpp
+ */
+
+#include "buffer/clock_pro_replacer.h"
+
+#include <vector>
+#include "common/exception.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(ClockProReplacerTest, SampleTest) {
+  // m = 4, m_c starts at 1, so the first three pages become hot while the pool fills up.
+  ClockProReplacer clock_pro_replacer(4);
+  for (int i = 0; i < 4; ++i) {
+    clock_pro_replacer.RecordAccess(i, i);
+  }
+  ASSERT_EQ(4, clock_pro_replacer.Size());
+  ASSERT_EQ(1, clock_pro_replacer.GetColdTarget());
+  ASSERT_EQ(3, clock_pro_replacer.EvictionOrder(4)[0]);
+
+  // Scenario: page 3 is the only cold page, it is evicted during its test period and stays as a non-resident page.
+  int value;
+  ASSERT_TRUE(clock_pro_replacer.Evict(&value));
+  ASSERT_EQ(3, value);
+  ASSERT_EQ(3, clock_pro_replacer.Size());
+
+  // Scenario: page 3 is loaded again during its test period, so the cold target grows and page 3 becomes hot. The
+  // hot hand demotes the hot pages with a clear reference bit until there are only m - m_c = 2 of them left.
+  clock_pro_replacer.RecordAccess(1, 1);
+  clock_pro_replacer.RecordAccess(3, 3);
+  ASSERT_EQ(2, clock_pro_replacer.GetColdTarget());
+  ASSERT_EQ(4, clock_pro_replacer.Size());
+
+  // Scenario: frame 0 was demoted, it is cold and unreferenced so it is the next victim.
+  ASSERT_TRUE(clock_pro_replacer.Evict(&value));
+  ASSERT_EQ(0, value);
+}
+
+TEST(ClockProReplacerTest, ScanResistanceTest) {
+  ClockProReplacer clock_pro_replacer(4);
+  for (int i = 0; i < 4; ++i) {
+    clock_pro_replacer.RecordAccess(i, i);
+  }
+
+  // Scenario: a long scan of pages that are only seen once never replaces the hot pages [0,1,2].
+  for (int page_id = 100; page_id < 200; ++page_id) {
+    int value;
+    ASSERT_TRUE(clock_pro_replacer.Evict(&value));
+    ASSERT_EQ(3, value);
+    clock_pro_replacer.RecordAccess(value, page_id);
+  }
+  ASSERT_EQ(1, clock_pro_replacer.GetColdTarget());
+}
+
+TEST(ClockProReplacerTest, PinnedTest) {
+  // m = 2: page 0 is hot and page 1 is cold.
+  ClockProReplacer clock_pro_replacer(2);
+  clock_pro_replacer.RecordAccess(0, 0);
+  clock_pro_replacer.RecordAccess(1, 1);
+
+  // Scenario: the only cold page is pinned, the hot page is evicted instead.
+  clock_pro_replacer.SetEvictable(1, false);
+  ASSERT_EQ(1, clock_pro_replacer.Size());
+  ASSERT_EQ((std::vector<frame_id_t>{0}), clock_pro_replacer.EvictionOrder(2));
+  int value;
+  ASSERT_TRUE(clock_pro_replacer.Evict(&value));
+  ASSERT_EQ(0, value);
+  ASSERT_FALSE(clock_pro_replacer.Evict(&value));
+
+  EXPECT_THROW(clock_pro_replacer.Remove(1), Exception);
+  EXPECT_THROW(clock_pro_replacer.RecordAccess(2, 2), Exception);
+  clock_pro_replacer.SetEvictable(1, true);
+  clock_pro_replacer.Remove(1);
+  ASSERT_EQ(0, clock_pro_replacer.Size());
+  ASSERT_FALSE(clock_pro_replacer.Evict(&value));
+}
+
+}  // namespace bustub
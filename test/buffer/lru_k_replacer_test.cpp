@@ -11,6 +11,7 @@
 #include <set>
 #include <thread>  // NOLINT
 #include <vector>
+#include "common/exception.h"
 #include "common/logger.h"
 #include "gtest/gtest.h"
 
@@ -96,4 +97,121 @@ TEST(LRUKReplacerTest, SampleTest) {
   lru_replacer.Remove(1);
   ASSERT_EQ(0, lru_replacer.Size());
 }
+
+TEST(LRUKReplacerTest, BackwardKDistanceTest) {
+  LRUKReplacer lru_replacer(4, 2);
+
+  // Scenario: frame 1 is accessed at t0 and t3, frame 2 at t1 and t2. Both have two accesses, but the second to last
+  // access of frame 1 is older, so frame 1 has the larger backward k-distance and is evicted first.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(2);
+  lru_replacer.RecordAccess(2);
+  lru_replacer.RecordAccess(1);
+  // Frame 3 only has a single access, so its backward k-distance is +inf even though it is the most recent one.
+  lru_replacer.RecordAccess(3);
+  ASSERT_EQ(3, lru_replacer.Size());
+
+  int value;
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(3, value);
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(2, value);
+  ASSERT_EQ(false, lru_replacer.Evict(&value));
+
+  // Scenario: an evicted frame loses its history and starts over with +inf backward k-distance.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(2);
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(2, value);
+
+  // Scenario: out of range frame ids are rejected.
+  EXPECT_THROW(lru_replacer.RecordAccess(4), Exception);
+  EXPECT_THROW(lru_replacer.SetEvictable(-1, true), Exception);
+}
+
+TEST(LRUKReplacerTest, RandomizedTest) {
+  const size_t num_frames = 64;
+  const size_t k = 3;
+  LRUKReplacer lru_replacer(num_frames, k);
+
+  // Reference model: the full access history of every tracked frame.
+  std::vector<std::vector<size_t>> history(num_frames);
+  std::vector<bool> evictable(num_frames, false);
+  size_t now = 0;
+
+  std::mt19937 rng(42);
+  for (int round = 0; round < 20000; round++) {
+    auto frame_id = static_cast<frame_id_t>(rng() % num_frames);
+    switch (rng() % 4) {
+      case 0:
+      case 1:
+        if (history[frame_id].empty()) {
+          evictable[frame_id] = true;
+        }
+        history[frame_id].push_back(now++);
+        lru_replacer.RecordAccess(frame_id);
+        break;
+      case 2:
+        if (!history[frame_id].empty()) {
+          bool set_evictable = rng() % 2 == 0;
+          evictable[frame_id] = set_evictable;
+          lru_replacer.SetEvictable(frame_id, set_evictable);
+        }
+        break;
+      default: {
+        // Pick the victim by brute force: +inf frames by earliest access first, then the oldest k-th access.
+        frame_id_t expected = -1;
+        std::pair<bool, size_t> best{true, 0};
+        for (size_t i = 0; i < num_frames; i++) {
+          if (history[i].empty() || !evictable[i]) {
+            continue;
+          }
+          bool has_k = history[i].size() >= k;
+          size_t ts = has_k ? history[i][history[i].size() - k] : history[i].front();
+          std::pair<bool, size_t> key{has_k, ts};
+          if (expected == -1 || key < best) {
+            best = key;
+            expected = static_cast<frame_id_t>(i);
+          }
+        }
+        frame_id_t victim;
+        ASSERT_EQ(expected != -1, lru_replacer.Evict(&victim));
+        if (expected != -1) {
+          ASSERT_EQ(expected, victim);
+          history[victim].clear();
+          evictable[victim] = false;
+        }
+      }
+    }
+    size_t size = 0;
+    for (size_t i = 0; i < num_frames; i++) {
+      size += !history[i].empty() && evictable[i] ? 1 : 0;
+    }
+    ASSERT_EQ(size, lru_replacer.Size());
+  }
+}
+
+TEST(LRUKReplacerTest, ResizeTest) {
+  LRUKReplacer lru_replacer(2, 2);
+  EXPECT_THROW(lru_replacer.RecordAccess(3), Exception);
+
+  // Scenario: frames added by growing the replacer can be tracked and evicted like the others.
+  lru_replacer.Resize(4);
+  lru_replacer.RecordAccess(3);
+  lru_replacer.RecordAccess(0);
+  ASSERT_EQ(2, lru_replacer.Size());
+  int value;
+  ASSERT_TRUE(lru_replacer.Evict(&value));
+  ASSERT_EQ(3, value);
+
+  // Scenario: after shrinking, the released frames are out of range again.
+  lru_replacer.Resize(2);
+  EXPECT_THROW(lru_replacer.RecordAccess(3), Exception);
+  ASSERT_EQ(1, lru_replacer.Size());
+}
+
 }  // namespace bustub
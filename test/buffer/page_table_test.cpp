@@ -0,0 +1,126 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table_test.cpp
+//
+// Identification: test/buffer/page_table_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(PageTableTest, SampleTest) {
+  PageTable table(4);
+  frame_id_t frame;
+
+  EXPECT_FALSE(table.Find(0, &frame));
+  table.Insert(0, 3);
+  table.Insert(100, 1);
+  table.Insert(7, 2);
+  ASSERT_TRUE(table.Find(0, &frame));
+  EXPECT_EQ(3, frame);
+  ASSERT_TRUE(table.Find(100, &frame));
+  EXPECT_EQ(1, frame);
+
+  // Inserting a mapped page replaces its frame.
+  table.Insert(100, 0);
+  ASSERT_TRUE(table.Find(100, &frame));
+  EXPECT_EQ(0, frame);
+
+  EXPECT_TRUE(table.Remove(0));
+  EXPECT_FALSE(table.Remove(0));
+  EXPECT_FALSE(table.Find(0, &frame));
+  ASSERT_TRUE(table.Find(7, &frame));
+  EXPECT_EQ(2, frame);
+  table.Insert(8, 3);
+  ASSERT_TRUE(table.Find(8, &frame));
+  EXPECT_EQ(3, frame);
+}
+
+// Compare against std::unordered_map under a random mix of inserts and removes, which exercises the backward
+// shifting of removes on long probe sequences.
+TEST(PageTableTest, RandomizedTest) {
+  const size_t max_entries = 64;
+  PageTable table(max_entries);
+  std::unordered_map<page_id_t, frame_id_t> reference;
+  std::mt19937 rng(15445);
+  std::uniform_int_distribution<page_id_t> page_dist(0, 255);
+
+  for (int i = 0; i < 20000; i++) {
+    page_id_t page_id = page_dist(rng);
+    if (reference.count(page_id) > 0 || reference.size() == max_entries) {
+      EXPECT_EQ(reference.erase(page_id) > 0, table.Remove(page_id));
+    } else {
+      auto frame = static_cast<frame_id_t>(rng() % max_entries);
+      reference[page_id] = frame;
+      table.Insert(page_id, frame);
+    }
+    for (page_id_t p = 0; p < 256; p += 17) {
+      frame_id_t frame;
+      auto it = reference.find(p);
+      ASSERT_EQ(it != reference.end(), table.Find(p, &frame));
+      if (it != reference.end()) {
+        ASSERT_EQ(it->second, frame);
+      }
+    }
+  }
+}
+
+// Readers run concurrently with a writer. A reader may miss an entry, but whatever it finds must be a mapping
+// the writer actually made.
+TEST(PageTableTest, ConcurrentReadTest) {
+  const size_t max_entries = 32;
+  PageTable table(max_entries);
+  std::atomic<bool> done{false};
+
+  // Page p is only ever mapped to frame p % max_entries.
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 2; t++) {
+    readers.emplace_back([&] {
+      while (!done) {
+        for (page_id_t p = 0; p < 128; p++) {
+          frame_id_t frame;
+          if (table.Find(p, &frame)) {
+            ASSERT_EQ(static_cast<frame_id_t>(p % max_entries), frame);
+          }
+        }
+      }
+    });
+  }
+
+  std::mt19937 rng(15445);
+  std::vector<page_id_t> resident;
+  for (int i = 0; i < 20000; i++) {
+    if (resident.size() == max_entries || (!resident.empty() && rng() % 2 == 0)) {
+      size_t victim = rng() % resident.size();
+      EXPECT_TRUE(table.Remove(resident[victim]));
+      resident.erase(resident.begin() + victim);
+    } else {
+      auto page_id = static_cast<page_id_t>(rng() % 128);
+      if (std::find(resident.begin(), resident.end(), page_id) == resident.end()) {
+        table.Insert(page_id, static_cast<frame_id_t>(page_id % max_entries));
+        resident.push_back(page_id);
+      }
+    }
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,249 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager_test.cpp
+//
+// Identification: test/buffer/parallel_buffer_pool_manager_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+  const size_t num_instances = 5;
+  const size_t k = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager, k);
+  EXPECT_EQ(num_instances * buffer_pool_size, bpm->GetPoolSize());
+
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+
+  // Scenario: The buffer pool is empty. We should be able to create a new page.
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, page_id_temp);
+
+  // Scenario: Once we have a page, we should be able to read and write content.
+  snprintf(page0->GetData(), BUSTUB_PAGE_SIZE, "Hello");
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+
+  // Scenario: We should be able to create new pages until we fill up the buffer pool. Pages are allocated round
+  // robin, so every page id maps back to the instance that created it.
+  std::vector<page_id_t> page_ids{page_id_temp};
+  for (size_t i = 1; i < buffer_pool_size * num_instances; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    page_ids.push_back(page_id_temp);
+  }
+  std::set<BufferPoolManagerInstance *> first_round;
+  for (size_t i = 0; i < num_instances; ++i) {
+    first_round.insert(bpm->GetBufferPoolManager(page_ids[i]));
+  }
+  EXPECT_EQ(num_instances, first_round.size());
+
+  // Scenario: Once the buffer pool is full, we should not be able to create any new pages.
+  for (size_t i = 0; i < buffer_pool_size * num_instances; ++i) {
+    EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  // Scenario: After unpinning every page we should be able to create new pages in every instance again.
+  for (auto page_id : page_ids) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  for (size_t i = 0; i < num_instances; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+
+  // Scenario: We should be able to fetch the data we wrote a while ago.
+  page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+  EXPECT_EQ(true, bpm->UnpinPage(0, true));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+  remove("test.ext");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ConcurrentTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t num_instances = 4;
+  const int num_threads = 4;
+  const int pages_per_thread = 20;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, tid]() {
+      std::vector<page_id_t> page_ids;
+      for (int i = 0; i < pages_per_thread; i++) {
+        page_id_t page_id;
+        auto *page = bpm->NewPage(&page_id);
+        ASSERT_NE(nullptr, page);
+        snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d-%d", tid, page_id);
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+        page_ids.push_back(page_id);
+      }
+      for (auto page_id : page_ids) {
+        auto *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(0, strcmp(page->GetData(), (std::to_string(tid) + "-" + std::to_string(page_id)).c_str()));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+  remove("test.ext");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, BatchFetchTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t num_instances = 2;
+
+  auto *disk_manager = new DiskManagerMemory(32);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Scenario: a batch of new pages is created in one instance.
+  std::vector<page_id_t> page_ids;
+  for (size_t round = 0; round < num_instances; ++round) {
+    auto pages = bpm->NewPages(3);
+    ASSERT_EQ(3, pages.size());
+    for (auto *page : pages) {
+      EXPECT_EQ(bpm->GetBufferPoolManager(pages[0]->GetPageId()), bpm->GetBufferPoolManager(page->GetPageId()));
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page->GetPageId());
+      page_ids.push_back(page->GetPageId());
+    }
+  }
+  for (auto page_id : page_ids) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: a batch spanning the instances comes back in the order it was asked for.
+  std::reverse(page_ids.begin(), page_ids.end());
+  auto pages = bpm->FetchPages(page_ids);
+  ASSERT_EQ(page_ids.size(), pages.size());
+  for (size_t i = 0; i < page_ids.size(); ++i) {
+    EXPECT_EQ(page_ids[i], pages[i]->GetPageId());
+    EXPECT_EQ("page " + std::to_string(page_ids[i]), std::string(pages[i]->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], false));
+  }
+
+  // Scenario: if one instance cannot hold its part of the batch, the part fetched from the other one is unpinned.
+  EXPECT_TRUE(bpm->FetchPages({0, 2, 1, 3, 5, 7, 9}).empty());
+  auto *page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(1, page0->GetPinCount());
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ExtentTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t num_instances = 3;
+  auto *disk_manager = new DiskManagerMemory(1000);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Scenario: the pages of an object come from the extents of the instance of its first page.
+  page_id_t owner = INVALID_PAGE_ID;
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id, &owner));
+  EXPECT_EQ(owner, page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  for (int i = 1; i < 10; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id, &owner));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    EXPECT_EQ(owner + static_cast<page_id_t>(num_instances) * i, page_id);
+  }
+
+  // Scenario: if that instance has no free frame, another instance reserves an extent for the object.
+  std::vector<page_id_t> pinned;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id, &owner));
+    pinned.push_back(page_id);
+  }
+  ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id, &owner));
+  EXPECT_NE(bpm->GetBufferPoolManager(owner), bpm->GetBufferPoolManager(page_id));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  for (auto pinned_page : pinned) {
+    EXPECT_EQ(true, bpm->UnpinPage(pinned_page, false));
+  }
+  EXPECT_EQ(2, disk_manager->GetExtentMap()->GetExtents(owner).size());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, InvalidPageIdTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t num_instances = 3;
+  auto *disk_manager = new DiskManagerMemory(1000);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  BufferAccessStrategy strategy(2);
+
+  // Scenario: a negative page id belongs to no instance, so every operation on it fails instead of being routed.
+  EXPECT_EQ(nullptr, bpm->FetchPage(INVALID_PAGE_ID));
+  EXPECT_EQ(nullptr, bpm->FetchPage(INVALID_PAGE_ID, strategy));
+  EXPECT_FALSE(static_cast<bool>(bpm->FetchPageRead(INVALID_PAGE_ID)));
+  EXPECT_EQ(false, bpm->UnpinPage(INVALID_PAGE_ID, false));
+  EXPECT_EQ(false, bpm->FlushPage(INVALID_PAGE_ID));
+  EXPECT_EQ(false, bpm->DeletePage(INVALID_PAGE_ID));
+  bpm->PrefetchPages({INVALID_PAGE_ID});
+
+  // Scenario: a batch with a negative page id fetches nothing and leaves the other pages unpinned.
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  EXPECT_TRUE(bpm->FetchPages({page_id, INVALID_PAGE_ID}).empty());
+  EXPECT_EQ(false, bpm->UnpinPage(page_id, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,91 @@
+/**
+ * two_queue_replacer_test.cpp
+ */
+
+#include "buffer/two_queue_replacer.h"
+
+#include <vector>
+#include "common/exception.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(TwoQueueReplacerTest, SampleTest) {
+  // Kin = 2, Kout = 4.
+  TwoQueueReplacer two_queue_replacer(8);
+
+  // Scenario: frames [0,...,7] hold pages [0,...,7], all of them go into A1in.
+  for (int i = 0; i < 8; ++i) {
+    two_queue_replacer.RecordAccess(i, i);
+  }
+  ASSERT_EQ(8, two_queue_replacer.Size());
+
+  // Scenario: A1in is a FIFO over Kin, a second access to frame 2 does not save it.
+  int value;
+  ASSERT_TRUE(two_queue_replacer.Evict(&value));
+  ASSERT_EQ(0, value);
+  ASSERT_TRUE(two_queue_replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+  two_queue_replacer.RecordAccess(2, 2);
+  ASSERT_TRUE(two_queue_replacer.Evict(&value));
+  ASSERT_EQ(2, value);
+
+  // Scenario: pages 0 and 1 are remembered in A1out, loading them again puts them into Am. A hit in Am makes frame 0
+  // the most recently used one.
+  two_queue_replacer.RecordAccess(0, 0);
+  two_queue_replacer.RecordAccess(1, 1);
+  two_queue_replacer.RecordAccess(0, 0);
+
+  // Scenario: A1in is drained down to Kin first, then Am is evicted in LRU order, then the rest of A1in.
+  ASSERT_EQ((std::vector<frame_id_t>{3, 4, 5, 1, 0, 6, 7}), two_queue_replacer.EvictionOrder(8));
+  for (frame_id_t expected : {3, 4, 5, 1}) {
+    ASSERT_TRUE(two_queue_replacer.Evict(&value));
+    ASSERT_EQ(expected, value);
+  }
+
+  // Scenario: pinned frames are skipped.
+  two_queue_replacer.SetEvictable(0, false);
+  ASSERT_EQ(2, two_queue_replacer.Size());
+  ASSERT_TRUE(two_queue_replacer.Evict(&value));
+  ASSERT_EQ(6, value);
+  ASSERT_TRUE(two_queue_replacer.Evict(&value));
+  ASSERT_EQ(7, value);
+  ASSERT_FALSE(two_queue_replacer.Evict(&value));
+}
+
+TEST(TwoQueueReplacerTest, GhostQueueTest) {
+  // Kin = 1, Kout = 2.
+  TwoQueueReplacer two_queue_replacer(4);
+  int value;
+
+  // Scenario: pages [0,...,5] pass through frame 0 and go into A1out, which only remembers the last two.
+  for (int page_id = 0; page_id < 6; ++page_id) {
+    two_queue_replacer.RecordAccess(0, page_id);
+    two_queue_replacer.RecordAccess(1, 100 + page_id);
+    ASSERT_TRUE(two_queue_replacer.Evict(&value));
+    ASSERT_EQ(0, value);
+    ASSERT_TRUE(two_queue_replacer.Evict(&value));
+    ASSERT_EQ(1, value);
+  }
+
+  // Scenario: page 105 is still in A1out and goes into Am, page 0 was forgotten and goes into A1in.
+  two_queue_replacer.RecordAccess(0, 105);
+  two_queue_replacer.RecordAccess(1, 0);
+  two_queue_replacer.RecordAccess(2, 1000);
+  ASSERT_EQ((std::vector<frame_id_t>{1, 0, 2}), two_queue_replacer.EvictionOrder(4));
+}
+
+TEST(TwoQueueReplacerTest, InvalidFrameTest) {
+  TwoQueueReplacer two_queue_replacer(2);
+  EXPECT_THROW(two_queue_replacer.RecordAccess(2, 0), Exception);
+  EXPECT_THROW(two_queue_replacer.Remove(-1), Exception);
+
+  two_queue_replacer.RecordAccess(0, 0);
+  two_queue_replacer.SetEvictable(0, false);
+  EXPECT_THROW(two_queue_replacer.Remove(0), Exception);
+  two_queue_replacer.SetEvictable(0, true);
+  two_queue_replacer.Remove(0);
+  ASSERT_EQ(0, two_queue_replacer.Size());
+}
+
+}  // namespace bustub
@@ -59,6 +59,8 @@ TEST(CatalogTest, DISABLED_CreateTable1) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  remove("catalog_test.fsm");
+  remove("catalog_test.ext");
 }
 
 TEST(CatalogTest, DISABLED_CreateTable2) {
@@ -87,6 +89,8 @@ TEST(CatalogTest, DISABLED_CreateTable2) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  remove("catalog_test.fsm");
+  remove("catalog_test.ext");
 }
 
 TEST(CatalogTest, DISABLED_CreateTable3) {
@@ -119,6 +123,8 @@ TEST(CatalogTest, DISABLED_CreateTable3) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  remove("catalog_test.fsm");
+  remove("catalog_test.ext");
 }
 
 TEST(CatalogTest, DISABLED_CreateTableTest) {
@@ -215,6 +221,8 @@ TEST(CatalogTest, DISABLED_CreateIndex1) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  remove("catalog_test.fsm");
+  remove("catalog_test.ext");
 }
 
 // Attempts to create an index with duplicate name should fail
@@ -264,6 +272,8 @@ TEST(CatalogTest, DISABLED_CreateIndex2) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  remove("catalog_test.fsm");
+  remove("catalog_test.ext");
 }
 
 TEST(CatalogTest, DISABLED_CreateIndex3) {
@@ -338,6 +348,8 @@ TEST(CatalogTest, DISABLED_QueryIndex1) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  remove("catalog_test.fsm");
+  remove("catalog_test.ext");
 }
 
 // Vanilla index queries by index OID
@@ -388,6 +400,8 @@ TEST(CatalogTest, DISABLED_QueryIndex2) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  remove("catalog_test.fsm");
+  remove("catalog_test.ext");
 }
 
 // Query for nonexistent index on table should fail
@@ -410,6 +424,8 @@ TEST(CatalogTest, DISABLED_FailedQuery1) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  remove("catalog_test.fsm");
+  remove("catalog_test.ext");
 }
 
 // Query for index on nonexistent table should fail
@@ -423,6 +439,8 @@ TEST(CatalogTest, DISABLED_FailedQuery2) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  remove("catalog_test.fsm");
+  remove("catalog_test.ext");
 }
 
 // Query for nonexistent index OID should throw
@@ -437,6 +455,8 @@ TEST(CatalogTest, DISABLED_FailedQuery3) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  remove("catalog_test.fsm");
+  remove("catalog_test.ext");
 }
 
 // Query for all indexes on nonexistent table should give empty collection
@@ -451,6 +471,8 @@ TEST(CatalogTest, DISABLED_FailedQuery4) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  remove("catalog_test.fsm");
+  remove("catalog_test.ext");
 }
 
 // Query for all indexes on existing table with no
@@ -475,6 +497,8 @@ TEST(CatalogTest, DISABLED_FailedQuery5) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  remove("catalog_test.fsm");
+  remove("catalog_test.ext");
 }
 
 // Should be able to create and interact with an index with a single BIGINT key
@@ -527,6 +551,8 @@ TEST(CatalogTest, DISABLED_IndexInteraction0) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  remove("catalog_test.fsm");
+  remove("catalog_test.ext");
 }
 
 // Should be able to create and interact with an index that is keyed by two INTEGER values
@@ -579,6 +605,8 @@ TEST(CatalogTest, DISABLED_IndexInteraction1) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  remove("catalog_test.fsm");
+  remove("catalog_test.ext");
 }
 
 // Should be able to create and interact with an index that is keyed by a single INTEGER column
@@ -631,6 +659,8 @@ TEST(CatalogTest, DISABLED_IndexInteraction2) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  remove("catalog_test.fsm");
+  remove("catalog_test.ext");
 }
 
 TEST(CatalogTest, DISABLED_IndexInteraction3) {
@@ -686,6 +716,8 @@ TEST(CatalogTest, DISABLED_IndexInteraction3) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  remove("catalog_test.fsm");
+  remove("catalog_test.ext");
 }
 
 }  // namespace bustub
@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz4_codec_test.cpp
+//
+// Identification: test/common/lz4_codec_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/util/lz4_codec.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+/** Compress data, check that it shrinks to at most max_size bytes, and decompress it back. */
+static void RoundTrip(const std::vector<char> &data, size_t max_size) {
+  std::vector<char> compressed(data.size() + data.size() / 255 + 16);
+  size_t size = Lz4Codec::Compress(data.data(), data.size(), compressed.data(), compressed.size());
+  ASSERT_NE(0, size);
+  EXPECT_LE(size, max_size);
+  std::vector<char> decompressed(data.size());
+  ASSERT_EQ(data.size(), Lz4Codec::Decompress(compressed.data(), size, decompressed.data(), decompressed.size()));
+  EXPECT_EQ(data, decompressed);
+}
+
+// NOLINTNEXTLINE
+TEST(Lz4CodecTest, RoundTripTest) {
+  // Scenario: a page of zeros is one long match.
+  RoundTrip(std::vector<char>(4096, 0), 32);
+
+  // Scenario: repeated records, like the tuples of a table page.
+  std::vector<char> records;
+  for (int i = 0; records.size() < 4096; i++) {
+    std::string record = "id=" + std::to_string(i) + ";name=customer;balance=1000;";
+    records.insert(records.end(), record.begin(), record.end());
+  }
+  records.resize(4096);
+  RoundTrip(records, 2048);
+
+  // Scenario: random bytes do not compress, but still round trip when there is room for them.
+  std::mt19937 generator(15445);
+  std::vector<char> random(4096);
+  for (auto &byte : random) {
+    byte = static_cast<char>(generator());
+  }
+  RoundTrip(random, 4096 + 32);
+
+  // Scenario: inputs too short to hold a match.
+  RoundTrip({'a'}, 2);
+  RoundTrip(std::vector<char>(12, 'b'), 13);
+}
+
+// NOLINTNEXTLINE
+TEST(Lz4CodecTest, LimitTest) {
+  std::mt19937 generator(15445);
+  std::vector<char> random(4096);
+  for (auto &byte : random) {
+    byte = static_cast<char>(generator());
+  }
+  std::vector<char> buffer(8192);
+
+  // Scenario: output that does not fit in the capacity is reported as 0 bytes.
+  EXPECT_EQ(0, Lz4Codec::Compress(random.data(), random.size(), buffer.data(), 4000));
+
+  // Scenario: corrupted or truncated data, and data that decompresses past the capacity, are rejected.
+  std::vector<char> zeros(4096, 0);
+  size_t size = Lz4Codec::Compress(zeros.data(), zeros.size(), buffer.data(), buffer.size());
+  ASSERT_NE(0, size);
+  std::vector<char> out(4096);
+  EXPECT_EQ(0, Lz4Codec::Decompress(buffer.data(), size, out.data(), 4095));
+  EXPECT_EQ(0, Lz4Codec::Decompress(buffer.data(), size - 1, out.data(), out.size()));
+  buffer[2] = 0x7f;  // an offset past the start of the output
+  buffer[3] = 0x7f;
+  EXPECT_EQ(0, Lz4Codec::Decompress(buffer.data(), size, out.data(), out.size()));
+}
+
+}  // namespace bustub
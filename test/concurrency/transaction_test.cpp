@@ -58,7 +58,12 @@ class TransactionTest : public ::testing::Test {
   }
 
   // This function is called after every test.
-  void TearDown() override { remove("executor_test.db"); };
+  void TearDown() override {
+    remove("executor_test.db");
+    remove("executor_test.log");
+    remove("executor_test.fsm");
+    remove("executor_test.ext");
+  };
 
   std::unique_ptr<BustubInstance> bustub_;
 };
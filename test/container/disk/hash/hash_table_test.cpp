@@ -113,6 +113,9 @@ TEST(HashTableTest, DISABLED_SampleTest) {
 
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+  remove("test.ext");
   delete disk_manager;
   delete bpm;
 }
@@ -0,0 +1,149 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_manager_test.cpp
+//
+// Identification: test/recovery/log_manager_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "gtest/gtest.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+class LogManagerTest : public ::testing::Test {
+ protected:
+  // This function is called before every test.
+  void SetUp() override { RemoveFiles(); }
+
+  // This function is called after every test.
+  void TearDown() override { RemoveFiles(); }
+
+  static void RemoveFiles() {
+    remove("log_manager_test.db");
+    remove("log_manager_test.log");
+    remove("log_manager_test.fsm");
+    remove("log_manager_test.ext");
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, AppendTest) {
+  DiskManager disk_manager("log_manager_test.db");
+  LogManager log_manager(&disk_manager);
+
+  LogRecord begin(0, INVALID_LSN, LogRecordType::BEGIN);
+  EXPECT_EQ(0, log_manager.AppendLogRecord(&begin));
+  LogRecord new_page(0, begin.GetLSN(), LogRecordType::NEWPAGE, INVALID_PAGE_ID, 1);
+  EXPECT_EQ(1, log_manager.AppendLogRecord(&new_page));
+  LogRecord commit(0, new_page.GetLSN(), LogRecordType::COMMIT);
+  EXPECT_EQ(2, log_manager.AppendLogRecord(&commit));
+
+  // Scenario: nothing is durable until the log is flushed, and one flush covers all the appended records.
+  EXPECT_EQ(INVALID_LSN, log_manager.GetPersistentLSN());
+  EXPECT_EQ(0, disk_manager.GetNumFlushes());
+  log_manager.Flush(commit.GetLSN());
+  EXPECT_EQ(2, log_manager.GetPersistentLSN());
+  EXPECT_EQ(1, disk_manager.GetNumFlushes());
+
+  // Scenario: flushing a durable LSN, or one that was not handed out yet, does not write the log again.
+  log_manager.Flush(1);
+  log_manager.Flush(100);
+  EXPECT_EQ(1, disk_manager.GetNumFlushes());
+
+  // Scenario: the log file holds the records in LSN order, each one starting with its header.
+  std::vector<char> log(begin.GetSize() + new_page.GetSize() + commit.GetSize());
+  ASSERT_TRUE(disk_manager.ReadLog(log.data(), static_cast<int>(log.size()), 0));
+  int32_t offset = 0;
+  for (auto *record : {&begin, &new_page, &commit}) {
+    int32_t header[5];
+    memcpy(header, log.data() + offset, sizeof(header));
+    EXPECT_EQ(record->GetSize(), header[0]);
+    EXPECT_EQ(record->GetLSN(), header[1]);
+    EXPECT_EQ(record->GetPrevLSN(), header[3]);
+    EXPECT_EQ(static_cast<int32_t>(record->GetLogRecordType()), header[4]);
+    offset += record->GetSize();
+  }
+  // the header of a record is its size, LSN, transaction id, previous LSN and type
+  page_id_t page_ids[2];
+  memcpy(page_ids, log.data() + begin.GetSize() + 5 * sizeof(int32_t), sizeof(page_ids));
+  EXPECT_EQ(INVALID_PAGE_ID, page_ids[0]);
+  EXPECT_EQ(1, page_ids[1]);
+
+  disk_manager.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, FullBufferTest) {
+  DiskManager disk_manager("log_manager_test.db");
+  LogManager log_manager(&disk_manager);
+
+  // Scenario: without a flush thread, the appender that finds the buffer full flushes it itself.
+  LogRecord record(0, INVALID_LSN, LogRecordType::BEGIN);
+  int records = LOG_BUFFER_SIZE / record.GetSize() + 1;
+  for (int i = 0; i < records; i++) {
+    ASSERT_EQ(i, log_manager.AppendLogRecord(&record));
+  }
+  EXPECT_EQ(1, disk_manager.GetNumFlushes());
+  EXPECT_EQ(records - 2, log_manager.GetPersistentLSN());
+
+  log_manager.Flush(records - 1);
+  EXPECT_EQ(records - 1, log_manager.GetPersistentLSN());
+  EXPECT_EQ(2, disk_manager.GetNumFlushes());
+
+  disk_manager.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, GroupCommitTest) {
+  DiskManager disk_manager("log_manager_test.db");
+  auto log_manager = std::make_unique<LogManager>(&disk_manager);
+  log_manager->RunFlushThread();
+  ASSERT_TRUE(enable_logging);
+
+  // Scenario: every commit waits until its record is durable, and concurrent commits share the flushes.
+  const int num_threads = 8;
+  const int num_commits = 100;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&log_manager, tid] {
+      for (int i = 0; i < num_commits; i++) {
+        LogRecord begin(tid, INVALID_LSN, LogRecordType::BEGIN);
+        lsn_t lsn = log_manager->AppendLogRecord(&begin);
+        LogRecord commit(tid, lsn, LogRecordType::COMMIT);
+        lsn = log_manager->AppendLogRecord(&commit);
+        log_manager->Flush(lsn);
+        ASSERT_GE(log_manager->GetPersistentLSN(), lsn);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(2 * num_threads * num_commits, log_manager->GetNextLSN());
+  EXPECT_LT(disk_manager.GetNumFlushes(), num_threads * num_commits);
+
+  // Scenario: stopping the flush thread writes what is left in the buffer and disables logging.
+  LogRecord record(0, INVALID_LSN, LogRecordType::BEGIN);
+  lsn_t lsn = log_manager->AppendLogRecord(&record);
+  log_manager->StopFlushThread();
+  EXPECT_FALSE(enable_logging);
+  EXPECT_EQ(lsn, log_manager->GetPersistentLSN());
+
+  log_manager.reset();
+  disk_manager.ShutDown();
+}
+
+}  // namespace bustub
@@ -38,6 +38,8 @@ class RecoveryTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    remove("test.fsm");
+    remove("test.ext");
   }
 
   // This function is called after every test.
@@ -45,6 +47,8 @@ class RecoveryTest : public ::testing::Test {
     LOG_INFO("Tearing down the system..");
     remove("test.db");
     remove("test.log");
+    remove("test.fsm");
+    remove("test.ext");
   };
 };
 
@@ -258,13 +262,13 @@ TEST_F(RecoveryTest, DISABLED_CheckpointTest) {
   bustub_instance->checkpoint_manager_->EndCheckpoint();
 
   // Hacky
-  Page *pages = dynamic_cast<BufferPoolManagerInstance *>(bustub_instance->buffer_pool_manager_)->GetPages();
+  auto *bpm = dynamic_cast<BufferPoolManagerInstance *>(bustub_instance->buffer_pool_manager_);
   size_t pool_size = bustub_instance->buffer_pool_manager_->GetPoolSize();
 
   // make sure that all pages in the buffer pool are marked as non-dirty
   bool all_pages_clean = true;
   for (size_t i = 0; i < pool_size; i++) {
-    Page *page = &pages[i];
+    Page *page = bpm->GetPageInFrame(static_cast<frame_id_t>(i));
     page_id_t page_id = page->GetPageId();
 
     if (page_id != INVALID_PAGE_ID && page->IsDirty()) {
@@ -279,7 +283,7 @@ TEST_F(RecoveryTest, DISABLED_CheckpointTest) {
   bool all_pages_match = true;
   auto *disk_data = new char[BUSTUB_PAGE_SIZE];
   for (size_t i = 0; i < pool_size; i++) {
-    Page *page = &pages[i];
+    Page *page = bpm->GetPageInFrame(static_cast<frame_id_t>(i));
     page_id_t page_id = page->GetPageId();
 
     if (page_id != INVALID_PAGE_ID) {
@@ -302,7 +306,7 @@ TEST_F(RecoveryTest, DISABLED_CheckpointTest) {
   // verify log was flushed and each page's LSN <= persistent lsn
   bool all_pages_lte = true;
   for (size_t i = 0; i < pool_size; i++) {
-    Page *page = &pages[i];
+    Page *page = bpm->GetPageInFrame(static_cast<frame_id_t>(i));
     page_id_t page_id = page->GetPageId();
 
     if (page_id != INVALID_PAGE_ID && page->GetLSN() > persistent_lsn) {
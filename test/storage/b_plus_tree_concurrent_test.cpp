@@ -150,6 +150,8 @@ TEST(BPlusTreeConcurrentTest, InsertTest1) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.fsm");
+  remove("test.ext");
 }
 
 TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest2) {
@@ -201,6 +203,8 @@ TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest2) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.fsm");
+  remove("test.ext");
 }
 
 TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest1) {
@@ -243,6 +247,8 @@ TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest1) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.fsm");
+  remove("test.ext");
 }
 
 TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest2) {
@@ -286,6 +292,8 @@ TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest2) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.fsm");
+  remove("test.ext");
 }
 
 TEST(BPlusTreeConcurrentTest, DISABLED_MixTest) {
@@ -331,6 +339,8 @@ TEST(BPlusTreeConcurrentTest, DISABLED_MixTest) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.fsm");
+  remove("test.ext");
 }
 
 }  // namespace bustub
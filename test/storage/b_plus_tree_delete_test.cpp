@@ -104,6 +104,8 @@ TEST(BPlusTreeTests, DeleteTest1) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.fsm");
+  remove("test.ext");
 }
 
 TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
@@ -176,5 +178,7 @@ TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.fsm");
+  remove("test.ext");
 }
 }  // namespace bustub
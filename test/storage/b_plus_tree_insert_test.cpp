@@ -13,6 +13,8 @@
 #include <algorithm>
 #include <cstdint>
 #include <cstdio>
+#include <random>
+#include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "common/logger.h"
@@ -64,6 +66,8 @@ TEST(BPlusTreeTests, DISABLED_InsertTest1) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.fsm");
+  remove("test.ext");
 }
 
 TEST(BPlusTreeTests, DISABLED_InsertTest2) {
@@ -127,6 +131,8 @@ TEST(BPlusTreeTests, DISABLED_InsertTest2) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.fsm");
+  remove("test.ext");
 }
 
 TEST(BPlusTreeTests, InsertTest3) {
@@ -196,5 +202,62 @@ TEST(BPlusTreeTests, InsertTest3) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.fsm");
+  remove("test.ext");
+}
+
+TEST(BPlusTreeTests, LargePageTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  // Its own file, as it is created with 64 KiB pages.
+  auto *disk_manager = new DiskManager("large_page_test.db", false, 0, BUSTUB_MAX_PAGE_SIZE);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ASSERT_EQ(BUSTUB_MAX_PAGE_SIZE, bpm->GetPageSize());
+  // The nodes are as wide as the pages of the database.
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
+  GenericKey<8> index_key;
+  RID rid;
+  auto *transaction = new Transaction(0);
+
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  ASSERT_EQ(page_id, HEADER_PAGE_ID);
+  (void)header_page;
+
+  // Scenario: more keys than fit in a leaf of a 4 KiB page stay in the root leaf.
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= 5000; key++) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  for (size_t i = 0; i < keys.size(); i++) {
+    rid.Set(0, static_cast<uint32_t>(keys[i]));
+    index_key.SetFromInteger(keys[i]);
+    tree.Insert(index_key, rid, transaction);
+    if (i == 1000) {
+      auto *root = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(tree.GetRootPageId())->GetData());
+      EXPECT_TRUE(root->IsLeafPage());
+      bpm->UnpinPage(tree.GetRootPageId(), false);
+    }
+  }
+
+  // Scenario: splits of the wide nodes keep every key.
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    tree.GetValue(index_key, &rids);
+    ASSERT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+  delete disk_manager;
+  for (const char *file : {"large_page_test.db", "large_page_test.log", "large_page_test.fsm", "large_page_test.ext"}) {
+    remove(file);
+  }
 }
 }  // namespace bustub
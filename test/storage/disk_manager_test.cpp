@@ -10,11 +10,24 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_compressed.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/disk/disk_manager_simulated.h"
 
 namespace bustub {
 
@@ -24,12 +37,16 @@ class DiskManagerTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    remove("test.fsm");
+    remove("test.ext");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    remove("test.fsm");
+    remove("test.ext");
   };
 };
 
@@ -55,6 +72,295 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ReadPagesTest) {
+  char buf[4 * BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  for (int i = 0; i < 3; i++) {
+    snprintf(data, sizeof(data), "page %d", i);
+    dm.WritePage(i, data);
+  }
+
+  // Pages past the end of the file read as zeros.
+  std::memset(buf, 1, sizeof(buf));
+  dm.ReadPages(1, 4, buf);
+  EXPECT_STREQ("page 1", buf);
+  EXPECT_STREQ("page 2", buf + BUSTUB_PAGE_SIZE);
+  for (size_t i = 2 * BUSTUB_PAGE_SIZE; i < sizeof(buf); i++) {
+    ASSERT_EQ(0, buf[i]);
+  }
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, WritePagesTest) {
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  // More pages than one pwritev takes, scattered in memory.
+  const size_t num_pages = IOV_MAX + 3;
+  std::vector<std::unique_ptr<char[]>> data;
+  std::vector<const char *> pages;
+  for (size_t i = 0; i < num_pages; i++) {
+    data.emplace_back(new char[BUSTUB_PAGE_SIZE]());
+    snprintf(data.back().get(), BUSTUB_PAGE_SIZE, "page %zu", i + 2);
+    pages.push_back(data.back().get());
+  }
+  dm.WritePages(2, pages);
+  EXPECT_EQ(num_pages, dm.GetNumWrites());
+
+  char buf[BUSTUB_PAGE_SIZE];
+  for (size_t i = 0; i < num_pages + 2; i++) {
+    dm.ReadPage(i, buf);
+    EXPECT_EQ(i < 2 ? "" : "page " + std::to_string(i), std::string(buf));
+  }
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LargeOffsetTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  // Its own file, as the test reopens it.
+  std::string db_file("large_offset_test.db");
+  auto dm = DiskManager(db_file);
+  // A page past 4 GiB, in a sparse file.
+  const page_id_t page_id = 1100000;
+  std::strncpy(data, "far away", sizeof(data));
+  dm.WritePage(page_id, data);
+  dm.ReadPage(page_id, buf);
+  EXPECT_STREQ("far away", buf);
+  dm.ReadPage(page_id - 1, buf);
+  EXPECT_STREQ("", buf);
+  dm.ShutDown();
+
+  // The size of the file is known again after reopening it.
+  auto reopened = DiskManager(db_file);
+  reopened.ReadPage(page_id, buf);
+  EXPECT_STREQ("far away", buf);
+  reopened.ShutDown();
+  remove("large_offset_test.db");
+  remove("large_offset_test.log");
+  remove("large_offset_test.fsm");
+  remove("large_offset_test.ext");
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, SegmentTest) {
+  char buf[8 * BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("segment_test.db");
+  auto dm = DiskManager(db_file, false, 4);
+  EXPECT_EQ(4, dm.GetSegmentPages());
+  std::vector<std::unique_ptr<char[]>> data;
+  std::vector<const char *> pages;
+  for (int i = 0; i < 10; i++) {
+    data.emplace_back(new char[BUSTUB_PAGE_SIZE]());
+    snprintf(data.back().get(), BUSTUB_PAGE_SIZE, "page %d", i);
+    pages.push_back(data.back().get());
+  }
+  // Scenario: a run of pages over three segments, and a page that creates the two segments before its own.
+  dm.WritePages(0, pages);
+  dm.WritePage(21, pages[1]);
+  for (int segment = 1; segment <= 5; segment++) {
+    FILE *file = fopen((db_file + "." + std::to_string(segment)).c_str(), "r");
+    EXPECT_NE(nullptr, file);
+    if (file != nullptr) {
+      fclose(file);
+    }
+  }
+  int64_t offset = -1;
+  EXPECT_LE(0, dm.LocatePages(5, 3, false, &offset));
+  EXPECT_EQ(BUSTUB_PAGE_SIZE, offset);
+  EXPECT_EQ(-1, dm.LocatePages(3, 2, false, &offset));
+
+  // Scenario: a read over segments, the last of which has no data for its pages.
+  std::memset(buf, 1, sizeof(buf));
+  dm.ReadPages(6, 8, buf);
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ("page " + std::to_string(6 + i), std::string(buf + i * BUSTUB_PAGE_SIZE));
+  }
+  for (size_t i = 4 * BUSTUB_PAGE_SIZE; i < sizeof(buf); i++) {
+    ASSERT_EQ(0, buf[i]);
+  }
+  dm.Sync();
+  EXPECT_EQ(1, dm.GetNumSyncs());
+  dm.ShutDown();
+
+  // Scenario: reopening finds all the segments.
+  auto reopened = DiskManager(db_file, false, 4);
+  reopened.ReadPage(21, buf);
+  EXPECT_STREQ("page 1", buf);
+  reopened.ReadPage(9, buf);
+  EXPECT_STREQ("page 9", buf);
+  reopened.ShutDown();
+
+  remove("segment_test.db");
+  remove("segment_test.log");
+  remove("segment_test.fsm");
+  remove("segment_test.ext");
+  for (int segment = 1; segment <= 5; segment++) {
+    remove((db_file + "." + std::to_string(segment)).c_str());
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PageSizeTest) {
+  const size_t page_size = 4 * BUSTUB_PAGE_SIZE;
+  std::vector<char> data(2 * page_size);
+  std::vector<char> buf(2 * page_size);
+  std::snprintf(data.data(), page_size, "page 5");
+  std::snprintf(data.data() + page_size - 8, 8, "tail 5");
+  std::snprintf(data.data() + page_size, page_size, "page 6");
+  // Its own file, as the test reopens it.
+  std::string db_file("page_size_test.db");
+  auto dm = std::make_unique<DiskManager>(db_file, false, 0, page_size);
+  EXPECT_EQ(page_size, dm->GetPageSize());
+
+  // Scenario: pages are page_size bytes apart in the file.
+  dm->WritePages(5, {data.data(), data.data() + page_size});
+  dm->ReadPages(5, 2, buf.data());
+  EXPECT_EQ(data, buf);
+  dm->ShutDown();
+
+  // Scenario: the database keeps the page size it was created with, whatever a reopen asks for.
+  dm = std::make_unique<DiskManager>(db_file);
+  EXPECT_EQ(page_size, dm->GetPageSize());
+  dm->ReadPage(6, buf.data());
+  EXPECT_STREQ("page 6", buf.data());
+  dm->ReadPage(5, buf.data());
+  EXPECT_STREQ("tail 5", buf.data() + page_size - 8);
+  dm->ShutDown();
+  dm.reset();
+  for (const char *file : {"page_size_test.db", "page_size_test.log", "page_size_test.fsm", "page_size_test.ext"}) {
+    remove(file);
+  }
+
+  // Scenario: page sizes that are not a power of two from 4 KiB to 64 KiB are rejected.
+  EXPECT_THROW(DiskManager("page_size_test.db", false, 0, 2048), Exception);
+  EXPECT_THROW(DiskManager("page_size_test.db", false, 0, 12288), Exception);
+  EXPECT_THROW(DiskManager("page_size_test.db", false, 0, 2 * BUSTUB_MAX_PAGE_SIZE), Exception);
+
+  // Scenario: an in-memory disk takes the same page sizes.
+  DiskManagerMemory memory(8, page_size);
+  EXPECT_EQ(page_size, memory.GetPageSize());
+  std::fill(buf.begin(), buf.end(), 0);
+  EXPECT_TRUE(memory.WritePages(5, {data.data(), data.data() + page_size}));
+  EXPECT_TRUE(memory.ReadPages(5, 2, buf.data()));
+  EXPECT_EQ(data, buf);
+  EXPECT_FALSE(memory.ReadPage(8, buf.data()));
+  EXPECT_THROW(DiskManagerMemory(8, 12288), Exception);
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ConcurrentReadWriteTest) {
+  const int num_threads = 4;
+  const int pages_per_thread = 64;
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  // Every thread writes and reads back its own pages, interleaved with the other threads.
+  std::vector<std::thread> threads;
+  std::atomic<int> mismatches{0};
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&dm, &mismatches, t] {
+      char data[BUSTUB_PAGE_SIZE] = {0};
+      char buf[BUSTUB_PAGE_SIZE] = {0};
+      for (int i = 0; i < pages_per_thread; i++) {
+        page_id_t page_id = i * num_threads + t;
+        snprintf(data, sizeof(data), "page %d", page_id);
+        dm.WritePage(page_id, data);
+        dm.ReadPage(page_id, buf);
+        if (std::memcmp(buf, data, sizeof(buf)) != 0) {
+          mismatches++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, mismatches);
+  EXPECT_EQ(num_threads * pages_per_thread, dm.GetNumWrites());
+
+  // Scenario: the cached file size covers every page that was written.
+  char buf[2 * BUSTUB_PAGE_SIZE];
+  page_id_t last = num_threads * pages_per_thread - 1;
+  std::memset(buf, 1, sizeof(buf));
+  dm.ReadPages(last, 2, buf);
+  EXPECT_EQ("page " + std::to_string(last), std::string(buf));
+  for (size_t i = BUSTUB_PAGE_SIZE; i < sizeof(buf); i++) {
+    ASSERT_EQ(0, buf[i]);
+  }
+
+  // Scenario: only a sync after a write reaches the disk.
+  EXPECT_EQ(0, dm.GetNumSyncs());
+  dm.Sync();
+  EXPECT_EQ(1, dm.GetNumSyncs());
+  dm.Sync();
+  EXPECT_EQ(1, dm.GetNumSyncs());
+  dm.WritePage(0, buf);
+  dm.ShutDown();
+  EXPECT_EQ(2, dm.GetNumSyncs());
+
+  // Scenario: a new disk manager picks up the size of the existing file.
+  auto reopened = DiskManager(db_file);
+  std::memset(buf, 0, sizeof(buf));
+  reopened.ReadPage(last, buf);
+  EXPECT_EQ("page " + std::to_string(last), std::string(buf));
+  reopened.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIoTest) {
+  // Its own file, as the test reopens it.
+  std::string db_file("direct_io_test.db");
+  auto dm = DiskManager(db_file, true);
+  // Aligned buffers go straight to the file, the others through an aligned copy.
+  AlignedBuffer aligned = AllocateAlignedPages(3);
+  EXPECT_TRUE(IsPageAligned(aligned.get()));
+  auto unaligned_storage = std::make_unique<char[]>(3 * BUSTUB_PAGE_SIZE + 1);
+  char *unaligned = IsPageAligned(unaligned_storage.get()) ? unaligned_storage.get() + 1 : unaligned_storage.get();
+  ASSERT_FALSE(IsPageAligned(unaligned));
+
+  std::memset(aligned.get(), 0, BUSTUB_PAGE_SIZE);
+  std::strncpy(aligned.get(), "aligned", BUSTUB_PAGE_SIZE);
+  dm.WritePage(0, aligned.get());
+  std::memset(unaligned, 0, BUSTUB_PAGE_SIZE);
+  std::strncpy(unaligned, "unaligned", BUSTUB_PAGE_SIZE);
+  dm.WritePage(1, unaligned);
+
+  std::memset(aligned.get(), 1, 3 * BUSTUB_PAGE_SIZE);
+  dm.ReadPages(0, 3, aligned.get());
+  EXPECT_STREQ("aligned", aligned.get());
+  EXPECT_STREQ("unaligned", aligned.get() + BUSTUB_PAGE_SIZE);
+  for (size_t i = 2 * BUSTUB_PAGE_SIZE; i < 3 * BUSTUB_PAGE_SIZE; i++) {
+    ASSERT_EQ(0, aligned.get()[i]);
+  }
+  std::memset(unaligned, 1, 3 * BUSTUB_PAGE_SIZE);
+  dm.ReadPages(0, 3, unaligned);
+  EXPECT_STREQ("aligned", unaligned);
+  EXPECT_STREQ("unaligned", unaligned + BUSTUB_PAGE_SIZE);
+  for (size_t i = 2 * BUSTUB_PAGE_SIZE; i < 3 * BUSTUB_PAGE_SIZE; i++) {
+    ASSERT_EQ(0, unaligned[i]);
+  }
+
+  dm.ShutDown();
+  // Reopening with buffered I/O sees the same pages.
+  auto buffered = DiskManager(db_file);
+  EXPECT_FALSE(buffered.IsDirectIo());
+  char buf[BUSTUB_PAGE_SIZE];
+  buffered.ReadPage(1, buf);
+  EXPECT_STREQ("unaligned", buf);
+  buffered.ShutDown();
+  remove("direct_io_test.db");
+  remove("direct_io_test.log");
+  remove("direct_io_test.fsm");
+  remove("direct_io_test.ext");
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
@@ -72,6 +378,128 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, SimulatedDiskTest) {
+  using std::chrono::milliseconds;
+  using std::chrono::steady_clock;
+  SimulatedDevice device;
+  device.random_latency_ = milliseconds(5);
+  device.sequential_latency_ = milliseconds(0);
+  device.bandwidth_ = BUSTUB_PAGE_SIZE * 1000;  // a page per millisecond
+  device.queue_depth_ = 4;
+  DiskManagerSimulated dm(64, device);
+  char data[4 * BUSTUB_PAGE_SIZE] = {0};
+  char buf[4 * BUSTUB_PAGE_SIZE] = {0};
+  for (int i = 0; i < 4; i++) {
+    snprintf(data + i * BUSTUB_PAGE_SIZE, BUSTUB_PAGE_SIZE, "page %d", 10 + i);
+  }
+
+  // Scenario: a random write pays the random latency, the sequential writes after it only the transfer.
+  auto start = steady_clock::now();
+  dm.WritePage(10, data);
+  EXPECT_GE(steady_clock::now() - start, milliseconds(6));
+  start = steady_clock::now();
+  dm.WritePages(11, {data + BUSTUB_PAGE_SIZE, data + 2 * BUSTUB_PAGE_SIZE, data + 3 * BUSTUB_PAGE_SIZE});
+  EXPECT_GE(steady_clock::now() - start, milliseconds(3));
+  EXPECT_EQ(1, dm.GetNumRandomIos());
+  EXPECT_EQ(1, dm.GetNumSequentialIos());
+
+  // Scenario: a run of pages is read back as one random I/O.
+  start = steady_clock::now();
+  dm.ReadPages(10, 4, buf);
+  EXPECT_GE(steady_clock::now() - start, milliseconds(9));
+  EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+  EXPECT_EQ(2, dm.GetNumRandomIos());
+
+  // Scenario: concurrent I/Os overlap their latencies but share the bandwidth.
+  start = steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&dm, i] {
+      char page[BUSTUB_PAGE_SIZE];
+      dm.ReadPage(20 + 2 * i, page);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_GE(steady_clock::now() - start, milliseconds(9));
+  EXPECT_EQ(6, dm.GetNumRandomIos());
+
+  // Scenario: a disk of 64 KiB pages moves 64 KiB per page, so the same bandwidth takes 16 times as long per page.
+  const size_t page_size = BUSTUB_MAX_PAGE_SIZE;
+  SimulatedDevice large_device;
+  large_device.bandwidth_ = page_size * 100;  // a page per 10 milliseconds
+  DiskManagerSimulated large(8, large_device, page_size);
+  EXPECT_EQ(page_size, large.GetPageSize());
+  std::vector<char> pages(2 * page_size);
+  std::vector<char> pages_read(2 * page_size);
+  snprintf(pages.data(), page_size, "page 3");
+  snprintf(pages.data() + 2 * page_size - 8, 8, "tail 4");
+  start = steady_clock::now();
+  EXPECT_TRUE(large.WritePages(3, {pages.data(), pages.data() + page_size}));
+  EXPECT_TRUE(large.ReadPages(3, 2, pages_read.data()));
+  EXPECT_GE(steady_clock::now() - start, milliseconds(40));
+  EXPECT_EQ(pages, pages_read);
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, CompressedTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char text[BUSTUB_PAGE_SIZE] = {0};
+  char random[BUSTUB_PAGE_SIZE] = {0};
+  for (size_t i = 0; i + 16 < sizeof(text); i += 16) {
+    snprintf(text + i, 17, "tuple %10zu", i);
+  }
+  std::srand(15445);
+  for (char &byte : random) {
+    byte = static_cast<char>(std::rand());
+  }
+  // Its own file, as the test reopens it.
+  std::string db_file("compressed_test.db");
+  auto dm = std::make_unique<DiskManagerCompressed>(db_file);
+
+  // Scenario: compressible and incompressible pages read back as written, and unwritten pages as zeros.
+  for (page_id_t page_id = 0; page_id < 8; page_id++) {
+    dm->WritePage(page_id, text);
+  }
+  dm->WritePage(8, random);
+  dm->ReadPage(3, buf);
+  EXPECT_EQ(0, std::memcmp(buf, text, sizeof(buf)));
+  dm->ReadPage(8, buf);
+  EXPECT_EQ(0, std::memcmp(buf, random, sizeof(buf)));
+  dm->ReadPage(9, buf);
+  EXPECT_STREQ("", buf);
+  EXPECT_LT(dm->GetStoredBytes(), 9 * BUSTUB_PAGE_SIZE);
+
+  // Scenario: a rewritten page reads back its new contents, and the old slot is reused after Sync().
+  dm->WritePage(3, random);
+  dm->ReadPage(3, buf);
+  EXPECT_EQ(0, std::memcmp(buf, random, sizeof(buf)));
+  dm->Sync();
+  uint64_t stored_bytes = dm->GetStoredBytes();
+  dm->WritePage(8, text);
+  dm->Sync();
+  EXPECT_LT(dm->GetStoredBytes(), stored_bytes);
+  dm->ShutDown();
+  dm.reset();
+
+  // Scenario: the pages are the same after reopening the database.
+  dm = std::make_unique<DiskManagerCompressed>(db_file);
+  std::vector<char> pages(9 * BUSTUB_PAGE_SIZE);
+  dm->ReadPages(0, 9, pages.data());
+  for (page_id_t page_id = 0; page_id < 9; page_id++) {
+    const char *expected = page_id == 3 ? random : text;
+    EXPECT_EQ(0, std::memcmp(pages.data() + page_id * BUSTUB_PAGE_SIZE, expected, BUSTUB_PAGE_SIZE));
+  }
+  dm->ShutDown();
+  dm.reset();
+  for (const char *file : {"compressed_test.db", "compressed_test.log", "compressed_test.pmap", "compressed_test.fsm",
+                           "compressed_test.ext"}) {
+    remove(file);
+  }
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
@@ -0,0 +1,255 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler_test.cpp
+//
+// Identification: test/storage/disk_scheduler_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <future>  // NOLINT
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/disk/disk_scheduler.h"
+
+namespace bustub {
+
+class DiskSchedulerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    remove("test.db");
+    remove("test.log");
+    remove("test.fsm");
+    remove("test.ext");
+  }
+
+  void TearDown() override {
+    remove("test.db");
+    remove("test.log");
+    remove("test.fsm");
+    remove("test.ext");
+  };
+};
+
+/** Write num_pages pages through the scheduler as one batch, read them back as another and check them. */
+static void WriteAndReadBack(DiskScheduler *scheduler, int num_pages) {
+  std::vector<std::unique_ptr<char[]>> data;
+  std::vector<DiskRequest> writes;
+  std::atomic<int> callbacks{0};
+  for (int i = 0; i < num_pages; i++) {
+    data.emplace_back(new char[BUSTUB_PAGE_SIZE]());
+    snprintf(data.back().get(), BUSTUB_PAGE_SIZE, "page %d", i);
+    DiskRequest request;
+    request.is_write_ = true;
+    request.data_ = data.back().get();
+    request.page_id_ = i;
+    request.callback_ = [&callbacks](bool success) {
+      if (success) {
+        callbacks++;
+      }
+    };
+    writes.push_back(std::move(request));
+  }
+  for (auto &future : scheduler->ScheduleBatch(std::move(writes))) {
+    EXPECT_TRUE(future.get());
+  }
+  EXPECT_EQ(num_pages, callbacks);
+
+  // Scenario: single page reads and one read of a run of pages, in flight together.
+  std::vector<std::unique_ptr<char[]>> buffers;
+  std::vector<DiskRequest> reads;
+  for (int i = 0; i < num_pages / 2; i++) {
+    buffers.emplace_back(new char[BUSTUB_PAGE_SIZE]());
+    DiskRequest request;
+    request.data_ = buffers.back().get();
+    request.page_id_ = i;
+    reads.push_back(std::move(request));
+  }
+  int run = num_pages - num_pages / 2;
+  auto run_buffer = std::make_unique<char[]>((run + 1) * BUSTUB_PAGE_SIZE);
+  memset(run_buffer.get(), 1, (run + 1) * BUSTUB_PAGE_SIZE);
+  DiskRequest run_request;
+  run_request.data_ = run_buffer.get();
+  run_request.page_id_ = num_pages / 2;
+  run_request.num_pages_ = run + 1;
+  reads.push_back(std::move(run_request));
+  for (auto &future : scheduler->ScheduleBatch(std::move(reads))) {
+    EXPECT_TRUE(future.get());
+  }
+  for (int i = 0; i < num_pages / 2; i++) {
+    EXPECT_EQ("page " + std::to_string(i), std::string(buffers[i].get()));
+  }
+  for (int i = 0; i < run; i++) {
+    EXPECT_EQ("page " + std::to_string(num_pages / 2 + i), std::string(run_buffer.get() + i * BUSTUB_PAGE_SIZE));
+  }
+  // The page past the end of the file reads as zeros.
+  for (int i = run * BUSTUB_PAGE_SIZE; i < (run + 1) * BUSTUB_PAGE_SIZE; i++) {
+    ASSERT_EQ(0, run_buffer[i]);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskSchedulerTest, FileTest) {
+  auto dm = DiskManager("test.db");
+  {
+    // More requests than the queue depth, so some wait for a free entry.
+    DiskScheduler scheduler(&dm, 8);
+    EXPECT_EQ(8, scheduler.GetQueueDepth());
+    WriteAndReadBack(&scheduler, 100);
+  }
+  // Pages written through io_uring are accounted like the ones written by WritePage.
+  EXPECT_EQ(100, dm.GetNumWrites());
+  dm.Sync();
+  EXPECT_EQ(1, dm.GetNumSyncs());
+  char buf[BUSTUB_PAGE_SIZE];
+  dm.ReadPage(99, buf);
+  EXPECT_STREQ("page 99", buf);
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskSchedulerTest, WorkerTest) {
+  auto dm = DiskManager("test.db");
+  DiskScheduler scheduler(&dm, 8, 3, false);
+  EXPECT_FALSE(scheduler.UsesIoUring());
+  WriteAndReadBack(&scheduler, 100);
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskSchedulerTest, DirectIoTest) {
+  // The buffers of WriteAndReadBack are not page aligned, so io_uring leaves them to the aligned copy of the disk
+  // manager.
+  auto dm = DiskManager("test.db", true);
+  {
+    DiskScheduler scheduler(&dm, 8);
+    WriteAndReadBack(&scheduler, 20);
+  }
+  // Page aligned buffers are read by io_uring directly.
+  AlignedBuffer buffer = AllocateAlignedPages(1);
+  {
+    DiskScheduler scheduler(&dm, 8);
+    DiskRequest read;
+    read.data_ = buffer.get();
+    read.page_id_ = 19;
+    EXPECT_TRUE(scheduler.Schedule(std::move(read)).get());
+  }
+  EXPECT_STREQ("page 19", buffer.get());
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskSchedulerTest, SegmentTest) {
+  // Runs that span two segments are left to the disk manager, the others go to the file of their segment.
+  auto dm = DiskManager("test.db", false, 8);
+  {
+    DiskScheduler scheduler(&dm, 8);
+    WriteAndReadBack(&scheduler, 30);
+  }
+  EXPECT_EQ(30, dm.GetNumWrites());
+  char buf[BUSTUB_PAGE_SIZE];
+  dm.ReadPage(29, buf);
+  EXPECT_STREQ("page 29", buf);
+  dm.ShutDown();
+  for (int segment = 1; segment <= 3; segment++) {
+    remove(("test.db." + std::to_string(segment)).c_str());
+  }
+}
+
+/** A disk manager whose reads and writes of some pages fail. */
+class FailingDiskManager : public DiskManagerMemory {
+ public:
+  FailingDiskManager(size_t pages, std::vector<page_id_t> failing)
+      : DiskManagerMemory(pages), failing_(std::move(failing)) {}
+
+  auto ReadPage(page_id_t page_id, char *page_data) -> bool override {
+    return !Fails(page_id) && DiskManagerMemory::ReadPage(page_id, page_data);
+  }
+
+  auto WritePage(page_id_t page_id, const char *page_data) -> bool override {
+    return !Fails(page_id) && DiskManagerMemory::WritePage(page_id, page_data);
+  }
+
+ private:
+  auto Fails(page_id_t page_id) const -> bool {
+    return std::find(failing_.begin(), failing_.end(), page_id) != failing_.end();
+  }
+
+  std::vector<page_id_t> failing_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(DiskSchedulerTest, WorkerFailureTest) {
+  FailingDiskManager dm(16, {3, 9});
+  DiskScheduler scheduler(&dm, 8, 2, false);
+  auto data = std::make_unique<char[]>(4 * BUSTUB_PAGE_SIZE);
+  auto buf = std::make_unique<char[]>(4 * BUSTUB_PAGE_SIZE);
+  snprintf(data.get(), BUSTUB_PAGE_SIZE, "Hello");
+  std::atomic<int> failures{0};
+  auto request = [&](bool is_write, page_id_t page_id, size_t num_pages) {
+    DiskRequest request;
+    request.is_write_ = is_write;
+    request.data_ = is_write ? data.get() : buf.get();
+    request.page_id_ = page_id;
+    request.num_pages_ = num_pages;
+    request.callback_ = [&failures](bool success) {
+      if (!success) {
+        failures++;
+      }
+    };
+    return request;
+  };
+
+  // Scenario: a request the disk manager fails resolves its future and its callback as failed, the others succeed.
+  std::vector<DiskRequest> batch;
+  batch.push_back(request(true, 2, 1));
+  batch.push_back(request(true, 3, 1));
+  batch.push_back(request(false, 8, 3));
+  batch.push_back(request(false, 16, 1));
+  auto futures = scheduler.ScheduleBatch(std::move(batch));
+  EXPECT_TRUE(futures[0].get());
+  EXPECT_FALSE(futures[1].get());
+  EXPECT_FALSE(futures[2].get());
+  // DiskManagerMemory fails pages past its end
+  EXPECT_FALSE(futures[3].get());
+  EXPECT_EQ(3, failures);
+
+  // Scenario: a write of a run fails if any of its pages fails.
+  EXPECT_FALSE(scheduler.Schedule(request(true, 1, 3)).get());
+  EXPECT_TRUE(scheduler.Schedule(request(false, 1, 1)).get());
+  EXPECT_STREQ("Hello", buf.get());
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskSchedulerTest, MemoryTest) {
+  DiskManagerMemory dm(128);
+  DiskScheduler scheduler(&dm);
+  // A disk manager without a file descriptor always runs on worker threads.
+  EXPECT_FALSE(scheduler.UsesIoUring());
+  char data[BUSTUB_PAGE_SIZE] = "Hello";
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  DiskRequest write;
+  write.is_write_ = true;
+  write.data_ = data;
+  write.page_id_ = 7;
+  EXPECT_TRUE(scheduler.Schedule(std::move(write)).get());
+  DiskRequest read;
+  read.data_ = buf;
+  read.page_id_ = 7;
+  EXPECT_TRUE(scheduler.Schedule(std::move(read)).get());
+  EXPECT_STREQ("Hello", buf);
+}
+
+}  // namespace bustub
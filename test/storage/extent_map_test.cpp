@@ -0,0 +1,104 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extent_map_test.cpp
+//
+// Identification: test/storage/extent_map_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "storage/disk/extent_map.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ExtentMapTest, AllocateTest) {
+  ExtentMap map;
+  EXPECT_EQ(INVALID_PAGE_ID, map.Allocate(0));
+
+  // Scenario: the pages of an extent are handed out in order, then the next extent of the owner is used.
+  map.AddExtent(0, 0);
+  map.AddExtent(0, 1000);
+  map.AddExtent(64, 64);
+  for (uint32_t i = 0; i < EXTENT_PAGES; i++) {
+    EXPECT_EQ(static_cast<page_id_t>(i), map.Allocate(0));
+  }
+  EXPECT_EQ(1000, map.Allocate(0));
+  EXPECT_EQ(64, map.Allocate(64));
+  EXPECT_EQ(INVALID_PAGE_ID, map.Allocate(1));
+
+  // Scenario: an extent with a stride only hands out the pages of its offset.
+  map.AddExtent(7, 3, 4);
+  EXPECT_EQ(INVALID_PAGE_ID, map.Allocate(7, 4, 0));
+  EXPECT_EQ(3, map.Allocate(7, 4, 3));
+  EXPECT_EQ(7, map.Allocate(7, 4, 3));
+
+  // Scenario: only the pages of an extent that were not handed out yet are reserved.
+  EXPECT_FALSE(map.IsReserved(0));
+  EXPECT_FALSE(map.IsReserved(1000));
+  EXPECT_TRUE(map.IsReserved(1001));
+  EXPECT_TRUE(map.IsReserved(1000 + static_cast<page_id_t>(EXTENT_PAGES) - 1));
+  EXPECT_FALSE(map.IsReserved(1000 + static_cast<page_id_t>(EXTENT_PAGES)));
+  EXPECT_TRUE(map.IsReserved(11));
+  EXPECT_FALSE(map.IsReserved(12));
+
+  auto extents = map.GetExtents(0);
+  ASSERT_EQ(2, extents.size());
+  EXPECT_EQ(EXTENT_PAGES, extents[0].used_);
+  EXPECT_EQ(1, extents[1].used_);
+  EXPECT_EQ(4, map.GetNumExtents());
+}
+
+// NOLINTNEXTLINE
+TEST(ExtentMapTest, PersistTest) {
+  const std::string file_name = "extent_map_test.ext";
+  remove(file_name.c_str());
+
+  {
+    ExtentMap map;
+    ASSERT_TRUE(map.Open(file_name, false));
+    // More extents than fit in one page of the file.
+    for (int i = 0; i < 1000; i++) {
+      map.AddExtent(i % 10, i * static_cast<page_id_t>(EXTENT_PAGES));
+    }
+    EXPECT_EQ(0, map.Allocate(0));
+    EXPECT_TRUE(map.Flush());
+    // Not flushed, so lost on restart.
+    EXPECT_EQ(1, map.Allocate(0));
+  }
+
+  // Scenario: the map is loaded back as of the last Flush().
+  {
+    ExtentMap map;
+    ASSERT_TRUE(map.Open(file_name, false));
+    EXPECT_EQ(1000, map.GetNumExtents());
+    EXPECT_EQ(1, map.Allocate(0));
+    EXPECT_EQ(9 * static_cast<page_id_t>(EXTENT_PAGES), map.Allocate(9));
+    EXPECT_TRUE(map.Flush());
+  }
+  {
+    ExtentMap map;
+    ASSERT_TRUE(map.Open(file_name, false));
+    EXPECT_EQ(2, map.Allocate(0));
+    EXPECT_EQ(9 * static_cast<page_id_t>(EXTENT_PAGES) + 1, map.Allocate(9));
+  }
+
+  // Scenario: a reset map starts empty.
+  {
+    ExtentMap map;
+    ASSERT_TRUE(map.Open(file_name, true));
+    EXPECT_EQ(0, map.GetNumExtents());
+    EXPECT_EQ(INVALID_PAGE_ID, map.Allocate(0));
+  }
+
+  remove(file_name.c_str());
+}
+
+}  // namespace bustub
@@ -0,0 +1,104 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_page_map_test.cpp
+//
+// Identification: test/storage/free_page_map_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "storage/disk/free_page_map.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FreePageMapTest, AllocateTest) {
+  FreePageMap map;
+  EXPECT_EQ(INVALID_PAGE_ID, map.Allocate());
+
+  // Scenario: a page id that was never allocated cannot be freed.
+  map.Free(7);
+  EXPECT_FALSE(map.IsFree(7));
+  map.NoteAllocated(100000);
+
+  // Scenario: freed pages are handed out lowest first, once each.
+  map.Free(7);
+  map.Free(3);
+  map.Free(3);
+  map.Free(100000);
+  EXPECT_EQ(3, map.GetNumFreePages());
+  EXPECT_TRUE(map.IsFree(7));
+  EXPECT_FALSE(map.IsFree(8));
+  EXPECT_EQ(3, map.Allocate());
+  EXPECT_FALSE(map.IsFree(3));
+
+  // Scenario: with a stride, only the pages of the given offset are handed out.
+  map.Free(4);
+  EXPECT_EQ(4, map.Allocate(2, 0));
+  EXPECT_EQ(100000, map.Allocate(2, 0));
+  EXPECT_EQ(INVALID_PAGE_ID, map.Allocate(2, 0));
+  EXPECT_EQ(7, map.Allocate(2, 1));
+  EXPECT_EQ(0, map.GetNumFreePages());
+  EXPECT_EQ(INVALID_PAGE_ID, map.Allocate());
+
+  // Scenario: the next page id only moves forward.
+  map.NoteAllocated(100010);
+  map.NoteAllocated(5);
+  EXPECT_EQ(100011, map.GetNextPageId());
+}
+
+// NOLINTNEXTLINE
+TEST(FreePageMapTest, PersistTest) {
+  const std::string file_name = "free_page_map_test.fsm";
+  remove(file_name.c_str());
+
+  {
+    FreePageMap map;
+    ASSERT_TRUE(map.Open(file_name, false));
+    map.NoteAllocated(70000);
+    map.Free(2);
+    map.Free(65536);
+    EXPECT_TRUE(map.Flush());
+    // Not flushed, so lost on restart.
+    map.Free(5);
+  }
+
+  // Scenario: the map is loaded back as of the last Flush().
+  {
+    FreePageMap map;
+    ASSERT_TRUE(map.Open(file_name, false));
+    EXPECT_EQ(70001, map.GetNextPageId());
+    EXPECT_EQ(2, map.GetNumFreePages());
+    EXPECT_TRUE(map.IsFree(2));
+    EXPECT_TRUE(map.IsFree(65536));
+    EXPECT_FALSE(map.IsFree(5));
+    EXPECT_EQ(2, map.Allocate());
+    EXPECT_TRUE(map.Flush());
+  }
+  {
+    FreePageMap map;
+    ASSERT_TRUE(map.Open(file_name, false));
+    EXPECT_EQ(1, map.GetNumFreePages());
+    EXPECT_EQ(65536, map.Allocate());
+  }
+
+  // Scenario: a reset map starts empty.
+  {
+    FreePageMap map;
+    ASSERT_TRUE(map.Open(file_name, true));
+    EXPECT_EQ(0, map.GetNextPageId());
+    EXPECT_EQ(0, map.GetNumFreePages());
+    EXPECT_EQ(INVALID_PAGE_ID, map.Allocate());
+  }
+
+  remove(file_name.c_str());
+}
+
+}  // namespace bustub
@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_heap_test.cpp
+//
+// Identification: test/table/table_heap_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/table/table_heap.h"
+#include "storage/table/tuple.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, RingScanTest) {
+  // the first page of the table, the ring of the load, the ring of the scan and the hot pages fill the pool exactly
+  const size_t buffer_pool_size = 17;
+  const size_t ring_size = 4;
+  const int num_hot_pages = 8;
+  const int num_tuples = 100;
+
+  auto *disk_manager = new DiskManagerMemory(1000);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+  Transaction txn(0);
+  Schema schema({Column{"a", TypeId::VARCHAR, 1000}});
+  Tuple tuple({ValueFactory::GetVarcharValue(std::string(1000, 'a'))}, &schema);
+
+  // A table of a few tuples per page, loaded through a ring so that most of its pages are not resident.
+  BufferAccessStrategy load(ring_size);
+  TableHeap table(bpm, nullptr, nullptr, &txn);
+  for (int i = 0; i < num_tuples; ++i) {
+    RID rid;
+    ASSERT_TRUE(table.InsertTuple(tuple, &rid, &txn, &load));
+  }
+
+  // Pages of other transactions, each accessed once, so a scan through the whole pool would evict them.
+  std::vector<page_id_t> hot_pages;
+  for (int i = 0; i < num_hot_pages; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    hot_pages.push_back(page_id);
+  }
+
+  // Scenario: a scan through a ring reads every tuple and does not prefetch pages into the rest of the pool, so the
+  // pages of other transactions stay resident. The scan is slowed down so that a prefetch would have time to land.
+  BufferAccessStrategy scan(ring_size);
+  int scanned = 0;
+  for (auto iter = table.Begin(&txn, &scan); iter != table.End(); ++iter) {
+    scanned++;
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  EXPECT_EQ(num_tuples, scanned);
+  auto resident = bpm->GetResidentPages();
+  for (page_id_t page_id : hot_pages) {
+    EXPECT_NE(resident.end(), std::find(resident.begin(), resident.end(), page_id)) << "page " << page_id;
+  }
+  EXPECT_GT(table.GetPageIds().size(), buffer_pool_size);
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
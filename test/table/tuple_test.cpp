@@ -66,6 +66,8 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   disk_manager->ShutDown();
   remove("test.db");  // remove db file
   remove("test.log");
+  remove("test.fsm");
+  remove("test.ext");
   delete table;
   delete buffer_pool_manager;
   delete disk_manager;
@@ -27,14 +27,55 @@ auto GetWidthOfUtf8(const void *beg, const void *end, size_t *width) -> int {
 auto main(int argc, char **argv) -> int {
   ft_set_u8strwid_func(&GetWidthOfUtf8);
 
-  auto bustub = std::make_unique<bustub::BustubInstance>("test.db");
-
   auto default_prompt = "bustub> ";
   auto emoji_prompt = "\U0001f6c1> ";  // the bathtub emoji
   bool use_emoji_prompt = false;
   bool disable_tty = false;
+  size_t bpm_instances = 1;
+  size_t pool_size = 128;
+  bool direct_io = false;
+  size_t segment_pages = 0;
+  bool compress = false;
+  size_t page_size = bustub::BUSTUB_PAGE_SIZE;
+  auto policy = bustub::EvictionPolicyType::LRU_K;
+  std::string warm_start_file;
 
   for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--bpm-instances") == 0 && i + 1 < argc) {
+      bpm_instances = std::stoul(argv[++i]);
+      continue;
+    }
+    if (strcmp(argv[i], "--pool-size") == 0 && i + 1 < argc) {
+      pool_size = std::stoul(argv[++i]);
+      continue;
+    }
+    if (strcmp(argv[i], "--direct-io") == 0) {
+      direct_io = true;
+      continue;
+    }
+    if (strcmp(argv[i], "--segment-pages") == 0 && i + 1 < argc) {
+      segment_pages = std::stoul(argv[++i]);
+      continue;
+    }
+    if (strcmp(argv[i], "--compress") == 0) {
+      compress = true;
+      continue;
+    }
+    if (strcmp(argv[i], "--page-size") == 0 && i + 1 < argc) {
+      page_size = std::stoul(argv[++i]);
+      continue;
+    }
+    if (strcmp(argv[i], "--replacer") == 0 && i + 1 < argc) {
+      if (!bustub::ParseEvictionPolicyType(argv[++i], &policy)) {
+        std::cerr << "unknown replacer " << argv[i] << ", expected one of lru-k, arc, 2q, clock-pro" << std::endl;
+        return 1;
+      }
+      continue;
+    }
+    if (strcmp(argv[i], "--warm-start") == 0 && i + 1 < argc) {
+      warm_start_file = argv[++i];
+      continue;
+    }
     if (strcmp(argv[i], "--emoji-prompt") == 0) {
       use_emoji_prompt = true;
       break;
@@ -45,6 +86,12 @@ auto main(int argc, char **argv) -> int {
     }
   }
 
+  auto bustub = std::make_unique<bustub::BustubInstance>("test.db", bpm_instances, policy, pool_size, direct_io,
+                                                        segment_pages, compress, page_size);
+  if (!warm_start_file.empty()) {
+    bustub->EnableWarmStart(warm_start_file);
+  }
+
   bustub->GenerateMockTable();
 
   if (bustub->buffer_pool_manager_ != nullptr) {